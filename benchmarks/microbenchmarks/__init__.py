@@ -1,5 +1,6 @@
 from .atomic_ops import AtomicOpsPlan
 from .fill import FillPlan
+from .launch import LaunchPlan
 from .math_opts import MathOpsPlan
 from .matrix_ops import MatrixOpsPlan
 from .memcpy import MemcpyPlan
@@ -9,6 +10,7 @@ from .stencil2d import Stencil2DPlan
 benchmark_plan_list = [
     AtomicOpsPlan,
     FillPlan,
+    LaunchPlan,
     MathOpsPlan,
     MatrixOpsPlan,
     MemcpyPlan,
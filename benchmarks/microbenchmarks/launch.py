@@ -0,0 +1,104 @@
+from microbenchmarks._items import BenchmarkItem
+from microbenchmarks._metric import MetricType
+from microbenchmarks._plan import BenchmarkPlan
+
+import taichi as ti
+
+
+def _empty_kernels(annotation):
+    # Kernels with empty bodies, so that the measured time is dominated by
+    # host-side launch cost (argument setting, launch and sync).
+    @ti.kernel
+    def launch_x1(a0: annotation):
+        pass
+
+    @ti.kernel
+    def launch_x4(a0: annotation, a1: annotation, a2: annotation, a3: annotation):
+        pass
+
+    @ti.kernel
+    def launch_x8(
+        a0: annotation,
+        a1: annotation,
+        a2: annotation,
+        a3: annotation,
+        a4: annotation,
+        a5: annotation,
+        a6: annotation,
+        a7: annotation,
+    ):
+        pass
+
+    return {1: launch_x1, 4: launch_x4, 8: launch_x8}
+
+
+def launch_none(arch, repeat, arg_kind, arg_count, get_metric):
+    @ti.kernel
+    def launch_x0():
+        pass
+
+    return get_metric(repeat, launch_x0)
+
+
+def launch_scalar(arch, repeat, arg_kind, arg_count, get_metric):
+    func = _empty_kernels(ti.i32)[arg_count]
+    args = [i for i in range(arg_count)]
+    return get_metric(repeat, func, *args)
+
+
+def launch_ndarray(arch, repeat, arg_kind, arg_count, get_metric):
+    func = _empty_kernels(ti.types.ndarray(dtype=ti.f32, ndim=1))[arg_count]
+    args = [ti.ndarray(ti.f32, shape=128) for _ in range(arg_count)]
+    return get_metric(repeat, func, *args)
+
+
+def launch_argpack(arch, repeat, arg_kind, arg_count, get_metric):
+    # A single argpack with |arg_count| scalar members.
+    members = {f"m{i}": ti.i32 for i in range(arg_count)}
+    pack_type = ti.types.argpack(**members)
+
+    @ti.kernel
+    def launch_pack(pack: pack_type):
+        pass
+
+    pack = pack_type(**{name: i for i, name in enumerate(members)})
+    return get_metric(repeat, launch_pack, pack)
+
+
+class ArgKind(BenchmarkItem):
+    name = "arg_kind"
+
+    def __init__(self):
+        self._items = {
+            "none": None,
+            "scalar": ti.i32,
+            "ndarray": ti.ndarray,
+            "argpack": ti.types.argpack,
+        }
+
+
+class ArgCount(BenchmarkItem):
+    name = "arg_count"
+
+    def __init__(self):
+        self._items = {
+            "x1": 1,
+            "x4": 4,
+            "x8": 8,
+        }
+
+
+class LaunchPlan(BenchmarkPlan):
+    def __init__(self, arch: str):
+        # Launch overhead is small, use a large repeat to amortize timer noise.
+        super().__init__("launch", arch, basic_repeat_times=1000)
+        self.create_plan(ArgKind(), ArgCount(), MetricType())
+        # Device-side time of an empty kernel is meaningless here.
+        self.remove_cases_with_tags(["kernel_elapsed_time_ms"])
+        # A kernel without arguments has only one configuration.
+        self.remove_cases_with_tags(["none", "x4"])
+        self.remove_cases_with_tags(["none", "x8"])
+        self.add_func(["none"], launch_none)
+        self.add_func(["scalar"], launch_scalar)
+        self.add_func(["ndarray"], launch_ndarray)
+        self.add_func(["argpack"], launch_argpack)
@@ -2,13 +2,27 @@ import numpy as np
 from taichi._lib import core as _ti_core
 from taichi.lang import impl
 from taichi.lang.enums import Layout
-from taichi.lang.exception import TaichiIndexError
+from taichi.lang.exception import TaichiIndexError, TaichiRuntimeError
 from taichi.lang.util import cook_dtype, get_traceback, python_scope, to_numpy_type
 from taichi.types import primitive_types
 from taichi.types.ndarray_type import NdarrayTypeMetadata
 from taichi.types.utils import is_real, is_signed
 
 
+def _create_ndarray_storage(dtype, shape, layout, mapped_file=None):
+    """Allocates the storage of an ndarray, or maps it from a file.
+
+    Args:
+        mapped_file (tuple): (path, offset, read_only, access_hint) of a memory-mapped ndarray.
+    """
+    prog = impl.get_runtime().prog
+    dbg_info = _ti_core.DebugInfo(get_traceback(2))
+    if mapped_file is None:
+        return prog.create_ndarray(dtype, shape, layout, zero_fill=True, dbg_info=dbg_info)
+    path, offset, read_only, access_hint = mapped_file
+    return prog.map_ndarray_file(dtype, shape, layout, path, offset, read_only, access_hint, dbg_info=dbg_info)
+
+
 class Ndarray:
     """Taichi ndarray class.
 
@@ -29,6 +43,10 @@ class Ndarray:
     def get_type(self):
         return NdarrayTypeMetadata(self.element_type, self.shape, self.grad is not None)
 
+    def _check_writable(self):
+        if self.arr.read_only:
+            raise TaichiRuntimeError("Cannot write to a read-only memory-mapped ndarray")
+
     @property
     def element_shape(self):
         """Gets ndarray element shape.
@@ -67,6 +85,7 @@ class Ndarray:
         Args:
             val (Union[int, float]): Value to fill.
         """
+        self._check_writable()
         if impl.current_cfg().arch != _ti_core.Arch.cuda and impl.current_cfg().arch != _ti_core.Arch.x64:
             self._fill_by_kernel(val)
         elif _ti_core.is_tensor(self.element_type):
@@ -116,6 +135,7 @@ class Ndarray:
         Args:
             arr (numpy.ndarray): The source numpy array.
         """
+        self._check_writable()
         if not isinstance(arr, np.ndarray):
             raise TypeError(f"{np.ndarray} expected, but {type(arr)} provided")
         if tuple(self.arr.total_shape()) != tuple(arr.shape):
@@ -135,6 +155,7 @@ class Ndarray:
         Args:
             arr (numpy.ndarray): The source numpy array.
         """
+        self._check_writable()
         if not isinstance(arr, np.ndarray):
             raise TypeError(f"{np.ndarray} expected, but {type(arr)} provided")
         if tuple(self.arr.total_shape()) != tuple(arr.shape):
@@ -179,6 +200,7 @@ class Ndarray:
         """
         assert isinstance(other, Ndarray)
         assert tuple(self.arr.shape) == tuple(other.arr.shape)
+        self._check_writable()
         from taichi._kernels import ndarray_to_ndarray  # pylint: disable=C0415
 
         ndarray_to_ndarray(self, other)
@@ -234,12 +256,10 @@ class ScalarNdarray(Ndarray):
         shape (Tuple[int]): Shape of the ndarray.
     """
 
-    def __init__(self, dtype, arr_shape):
+    def __init__(self, dtype, arr_shape, mapped_file=None):
         super().__init__()
         self.dtype = cook_dtype(dtype)
-        self.arr = impl.get_runtime().prog.create_ndarray(
-            self.dtype, arr_shape, layout=Layout.NULL, zero_fill=True, dbg_info=_ti_core.DebugInfo(get_traceback())
-        )
+        self.arr = _create_ndarray_storage(self.dtype, arr_shape, Layout.NULL, mapped_file)
         self.shape = tuple(self.arr.shape)
         self.element_type = dtype
 
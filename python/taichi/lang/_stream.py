@@ -0,0 +1,107 @@
+import ctypes
+import functools
+import numbers
+import operator
+
+import numpy as np
+from taichi._lib import core as _ti_core
+from taichi.lang.exception import TaichiRuntimeError
+from taichi.lang.matrix import MatrixType
+from taichi.lang.util import cook_dtype, python_scope, to_numpy_type
+from taichi.types.primitive_types import all_types
+
+
+class StreamedArray:
+    """A row-major array in a binary file, processed tile by tile by :func:`stream`
+    instead of being loaded at once.
+
+    Args:
+        filename (str): Path of the file.
+        dtype (Union[DataType, MatrixType]): Data type of each element.
+        shape (Union[int, tuple[int]]): Shape of the array. Tiles are made of
+            consecutive indices along the first axis.
+        mode (str): "r" to only read the file, "r+" to also write the tiles
+            back, or "w+" to create or overwrite the file.
+        offset (int): Offset in bytes of the first element in the file.
+    """
+
+    def __init__(self, filename, dtype, shape, mode="r", offset=0):
+        if mode not in ("r", "r+", "w+"):
+            raise TaichiRuntimeError(f'Unsupported stream mode "{mode}", expected "r", "r+" or "w+"')
+        if isinstance(shape, numbers.Number):
+            shape = (shape,)
+        self.filename = str(filename)
+        self.shape = tuple(shape)
+        self.mode = mode
+        self.offset = offset
+        if dtype in all_types:
+            self.element_shape = ()
+            self.np_dtype = to_numpy_type(cook_dtype(dtype))
+        elif isinstance(dtype, MatrixType):
+            self.element_shape = (dtype.n,) if dtype.ndim == 1 else (dtype.n, dtype.m)
+            self.np_dtype = to_numpy_type(dtype.dtype)
+        else:
+            raise TaichiRuntimeError(f"{dtype} is not supported as streamed array element type")
+        row_shape = self.shape[1:] + self.element_shape
+        self.row_bytes = functools.reduce(operator.mul, row_shape, 1) * np.dtype(self.np_dtype).itemsize
+
+    def _tile_view(self, tile, halo):
+        rows = tile.rows + 2 * halo
+        data = (ctypes.c_uint8 * (rows * self.row_bytes)).from_address(tile.data)
+        return np.frombuffer(data, dtype=self.np_dtype).reshape((rows,) + self.shape[1:] + self.element_shape)
+
+
+@python_scope
+def stream(kernel, arrays, tile_rows, halo=0, args=()):
+    """Runs a kernel over arrays too large for the memory, one tile of rows at a time.
+
+    For each tile, the kernel is called as ``kernel(*tiles, begin, *args)``,
+    where the tiles are numpy views of the rows ``[begin, begin + rows)`` of
+    each array. While the kernel runs, the next tiles are read and the
+    previous ones are written back on a background thread. On the CPU
+    backends, the tiles are passed to the kernel without copies.
+
+    Tiles of read-only arrays also hold ``halo`` rows on each side for
+    stencils: row ``i + halo`` of such a tile is row ``begin + i`` of the
+    array, and the rows out of the array are zero.
+
+    Args:
+        kernel (Callable): The kernel, taking an ndarray per streamed array.
+        arrays (List[StreamedArray]): The arrays, with the same first dimension.
+        tile_rows (int): Number of rows of a tile.
+        halo (int): Number of extra rows around the tiles of read-only arrays.
+        args (tuple): Extra arguments of the kernel.
+
+    Example::
+
+        >>> @ti.kernel
+        >>> def blur(src: ti.types.ndarray(ndim=3), dst: ti.types.ndarray(ndim=3), begin: int):
+        >>>     for i, j, k in dst:
+        >>>         dst[i, j, k] = (src[i, j, k] + src[i + 1, j, k] + src[i + 2, j, k]) / 3
+        >>>
+        >>> src = ti.StreamedArray("in.raw", ti.f32, shape=(4096, 4096, 4096))
+        >>> dst = ti.StreamedArray("out.raw", ti.f32, shape=(4096, 4096, 4096), mode="w+")
+        >>> ti.stream(blur, [src, dst], tile_rows=64, halo=1)
+    """
+    if not arrays:
+        raise TaichiRuntimeError("Nothing to stream")
+    num_rows = arrays[0].shape[0]
+    if any(a.shape[0] != num_rows for a in arrays):
+        raise TaichiRuntimeError("Streamed arrays must have the same first dimension")
+    streams = [
+        _ti_core.TileStream(
+            a.filename, a.offset, a.row_bytes, num_rows, tile_rows, halo if a.mode == "r" else 0, a.mode
+        )
+        for a in arrays
+    ]
+    for t in range(streams[0].num_tiles()):
+        tiles = [s.acquire(t) for s in streams]
+        views = [a._tile_view(tile, s.halo()) for a, s, tile in zip(arrays, streams, tiles)]
+        kernel(*views, tiles[0].begin, *args)
+        for s in streams:
+            s.release(t)
+    for s in streams:
+        s.flush()
+
+
+__all__ = ["StreamedArray", "stream"]
@@ -1309,19 +1309,115 @@ class ASTTransformer(Builder):
             ctx.ast_builder.end_frontend_range_for()
         return None
 
+    @staticmethod
+    def get_ndrange_tile_sizes(ctx, ndrange_var):
+        """Returns the tile sizes of an ndrange-for, or None if it is traversed in plain row-major order."""
+        ndim = len(ndrange_var.dimensions)
+        tile_sizes = ctx.ast_builder.get_loop_tile_sizes()
+        if tile_sizes is None:
+            cfg = impl.current_cfg()
+            if not cfg.auto_tile_ndrange or cfg.arch not in [_ti_core.Arch.x64, _ti_core.Arch.arm64]:
+                return None
+            tile_sizes = []
+        if ndim < 2:
+            return None
+        if len(tile_sizes) == 0:
+            # Keep a few cache lines of the innermost dimension per row of a tile.
+            tile_sizes = [16, 64] if ndim == 2 else [1] * (ndim - 3) + [4, 8, 64]
+        elif len(tile_sizes) != ndim:
+            raise TaichiSyntaxError(f"Expected {ndim} tile sizes for a {ndim}-D ndrange, found {len(tile_sizes)}")
+        # Tiles never need to be larger than the ndrange itself.
+        tile_sizes = [
+            min(t, max(d, 1)) if isinstance(d, (int, np.integer)) else t
+            for t, d in zip(tile_sizes, ndrange_var.dimensions)
+        ]
+        if all(t == 1 for t in tile_sizes[1:]):
+            # Whole rows are traversed in row-major order anyway.
+            return None
+        ctx.ast_builder.tile(tile_sizes)
+        return tile_sizes
+
+    @staticmethod
+    def begin_ndrange_for(ctx, node, ndrange_var):
+        """Begins the range-for of an ndrange-for.
+
+        Returns the ndrange indices of the current iteration, and a condition that tells whether they are inside the
+        ndrange (None if they always are).
+        """
+        tile_sizes = ASTTransformer.get_ndrange_tile_sizes(ctx, ndrange_var)
+        dimensions = ndrange_var.dimensions
+        ndim = len(dimensions)
+        if tile_sizes is None:
+            num_iterations = impl.subscript(ctx.ast_builder, ndrange_var.acc_dimensions, 0)
+        else:
+            num_tiles = [(d + t - 1) // t for d, t in zip(dimensions, tile_sizes)]
+            tile_volume = math.prod(tile_sizes)
+            num_iterations = math.prod(num_tiles) * tile_volume
+        ndrange_begin = ti_ops.cast(expr.Expr(0), primitive_types.i32)
+        ndrange_end = ti_ops.cast(expr.Expr(num_iterations), primitive_types.i32)
+        ndrange_loop_var = expr.Expr(ctx.ast_builder.make_id_expr(""))
+        for_di = _ti_core.DebugInfo(ctx.get_pos_info(node))
+        ctx.ast_builder.begin_frontend_range_for(ndrange_loop_var.ptr, ndrange_begin.ptr, ndrange_end.ptr, for_di)
+
+        I = impl.expr_init(ndrange_loop_var)
+        indices = []
+        if tile_sizes is None:
+            for i in range(ndim):
+                if i + 1 < ndim:
+                    target_tmp = impl.expr_init(I // ndrange_var.acc_dimensions[i + 1])
+                else:
+                    target_tmp = impl.expr_init(I)
+                indices.append(target_tmp)
+                if i + 1 < ndim:
+                    I._assign(I - target_tmp * ndrange_var.acc_dimensions[i + 1])
+            in_bounds = None
+        else:
+            # Both the tiles and the elements inside a tile are in row-major order.
+            tile_id = impl.expr_init(I // tile_volume)
+            tile_offset = impl.expr_init(I - tile_id * tile_volume)
+            tile_coords = [None] * ndim
+            element_coords = [None] * ndim
+            for i in reversed(range(ndim)):
+                if i > 0:
+                    tile_coords[i] = impl.expr_init(tile_id % num_tiles[i])
+                    tile_id._assign(tile_id // num_tiles[i])
+                    element_coords[i] = impl.expr_init(tile_offset % tile_sizes[i])
+                    tile_offset._assign(tile_offset // tile_sizes[i])
+                else:
+                    tile_coords[i] = tile_id
+                    element_coords[i] = tile_offset
+            in_bounds = None
+            for i in range(ndim):
+                index = impl.expr_init(tile_coords[i] * tile_sizes[i] + element_coords[i])
+                indices.append(index)
+                d = dimensions[i]
+                if isinstance(d, (int, np.integer)) and d % tile_sizes[i] == 0:
+                    continue
+                cond = index < d
+                in_bounds = cond if in_bounds is None else ti_ops.logical_and(in_bounds, cond)
+        return [
+            index + impl.subscript(ctx.ast_builder, impl.subscript(ctx.ast_builder, ndrange_var.bounds, i), 0)
+            for i, index in enumerate(indices)
+        ], in_bounds
+
+    @staticmethod
+    def build_ndrange_body(ctx, node, in_bounds):
+        if in_bounds is None:
+            build_stmts(ctx, node.body)
+            return
+        # Skip the parts of the partial tiles that are outside of the ndrange.
+        stmt_dbg_info = _ti_core.DebugInfo(ctx.get_pos_info(node))
+        impl.begin_frontend_if(ctx.ast_builder, in_bounds.ptr, stmt_dbg_info)
+        ctx.ast_builder.begin_frontend_if_true()
+        build_stmts(ctx, node.body)
+        ctx.ast_builder.pop_scope()
+        ctx.ast_builder.begin_frontend_if_false()
+        ctx.ast_builder.pop_scope()
+
     @staticmethod
     def build_ndrange_for(ctx, node):
         with ctx.variable_scope_guard():
             ndrange_var = impl.expr_init(build_stmt(ctx, node.iter))
-            ndrange_begin = ti_ops.cast(expr.Expr(0), primitive_types.i32)
-            ndrange_end = ti_ops.cast(
-                expr.Expr(impl.subscript(ctx.ast_builder, ndrange_var.acc_dimensions, 0)),
-                primitive_types.i32,
-            )
-            ndrange_loop_var = expr.Expr(ctx.ast_builder.make_id_expr(""))
-            for_di = _ti_core.DebugInfo(ctx.get_pos_info(node))
-            ctx.ast_builder.begin_frontend_range_for(ndrange_loop_var.ptr, ndrange_begin.ptr, ndrange_end.ptr, for_di)
-            I = impl.expr_init(ndrange_loop_var)
             targets = ASTTransformer.get_for_loop_targets(node)
             if len(targets) != len(ndrange_var.dimensions):
                 raise TaichiSyntaxError(
@@ -1330,25 +1426,10 @@ class ASTTransformer(Builder):
                     "Please check if the number of arguments of ti.ndrange() is equal to "
                     "the number of the loop variables."
                 )
-            for i, target in enumerate(targets):
-                if i + 1 < len(targets):
-                    target_tmp = impl.expr_init(I // ndrange_var.acc_dimensions[i + 1])
-                else:
-                    target_tmp = impl.expr_init(I)
-                ctx.create_variable(
-                    target,
-                    impl.expr_init(
-                        target_tmp
-                        + impl.subscript(
-                            ctx.ast_builder,
-                            impl.subscript(ctx.ast_builder, ndrange_var.bounds, i),
-                            0,
-                        )
-                    ),
-                )
-                if i + 1 < len(targets):
-                    I._assign(I - target_tmp * ndrange_var.acc_dimensions[i + 1])
-            build_stmts(ctx, node.body)
+            indices, in_bounds = ASTTransformer.begin_ndrange_for(ctx, node, ndrange_var)
+            for target, index in zip(targets, indices):
+                ctx.create_variable(target, impl.expr_init(index))
+            ASTTransformer.build_ndrange_body(ctx, node, in_bounds)
             ctx.ast_builder.end_frontend_range_for()
         return None
 
@@ -1356,33 +1437,19 @@ class ASTTransformer(Builder):
     def build_grouped_ndrange_for(ctx, node):
         with ctx.variable_scope_guard():
             ndrange_var = impl.expr_init(build_stmt(ctx, node.iter.args[0]))
-            ndrange_begin = ti_ops.cast(expr.Expr(0), primitive_types.i32)
-            ndrange_end = ti_ops.cast(
-                expr.Expr(impl.subscript(ctx.ast_builder, ndrange_var.acc_dimensions, 0)),
-                primitive_types.i32,
-            )
-            ndrange_loop_var = expr.Expr(ctx.ast_builder.make_id_expr(""))
-            for_di = _ti_core.DebugInfo(ctx.get_pos_info(node))
-            ctx.ast_builder.begin_frontend_range_for(ndrange_loop_var.ptr, ndrange_begin.ptr, ndrange_end.ptr, for_di)
-
             targets = ASTTransformer.get_for_loop_targets(node)
             if len(targets) != 1:
                 raise TaichiSyntaxError(f"Group for should have 1 loop target, found {len(targets)}")
+            indices, in_bounds = ASTTransformer.begin_ndrange_for(ctx, node, ndrange_var)
+
             target = targets[0]
             mat = matrix.make_matrix([0] * len(ndrange_var.dimensions), dt=primitive_types.i32)
             target_var = impl.expr_init(mat)
 
             ctx.create_variable(target, target_var)
-            I = impl.expr_init(ndrange_loop_var)
-            for i in range(len(ndrange_var.dimensions)):
-                if i + 1 < len(ndrange_var.dimensions):
-                    target_tmp = I // ndrange_var.acc_dimensions[i + 1]
-                else:
-                    target_tmp = I
-                impl.subscript(ctx.ast_builder, target_var, i)._assign(target_tmp + ndrange_var.bounds[i][0])
-                if i + 1 < len(ndrange_var.dimensions):
-                    I._assign(I - target_tmp * ndrange_var.acc_dimensions[i + 1])
-            build_stmts(ctx, node.body)
+            for i, index in enumerate(indices):
+                impl.subscript(ctx.ast_builder, target_var, i)._assign(index)
+            ASTTransformer.build_ndrange_body(ctx, node, in_bounds)
             ctx.ast_builder.end_frontend_range_for()
         return None
 
@@ -1490,6 +1557,9 @@ class ASTTransformer(Builder):
             with ctx.loop_scope_guard(is_static=True):
                 return ASTTransformer.build_static_for(ctx, node, double_decorator == "grouped")
         with ctx.loop_scope_guard():
+            is_ndrange = decorator == "ndrange" or (decorator == "grouped" and double_decorator == "ndrange")
+            if not is_ndrange and ctx.ast_builder.get_loop_tile_sizes() is not None:
+                raise TaichiSyntaxError("ti.loop_config(tile=...) only applies to ti.ndrange() loops")
             if decorator == "ndrange":
                 if double_decorator != "":
                     raise TaichiSyntaxError("No decorator is allowed inside 'ti.ndrange")
@@ -814,6 +814,29 @@ def field(dtype, *args, **kwargs):
     return _field(dtype, *args, **kwargs)
 
 
+def _ndarray(dtype, shape, mapped_file=None):
+    prog = get_runtime().prog
+    if prog is None:
+        raise TaichiRuntimeError("Cannont create ndarray, maybe you forgot to call `ti.init()` first?")
+
+    if isinstance(shape, numbers.Number):
+        shape = (shape,)
+    if not all((isinstance(x, int) or isinstance(x, np.integer)) and x > 0 and x <= 2**31 - 1 for x in shape):
+        raise TaichiRuntimeError(f"{shape} is not a valid shape for ndarray")
+    if dtype in all_types:
+        dt = cook_dtype(dtype)
+        x = ScalarNdarray(dt, shape, mapped_file)
+    elif isinstance(dtype, MatrixType):
+        if dtype.ndim == 1:
+            x = VectorNdarray(dtype.n, dtype.dtype, shape, mapped_file)
+        else:
+            x = MatrixNdarray(dtype.n, dtype.m, dtype.dtype, shape, mapped_file)
+        dt = dtype.dtype
+    else:
+        raise TaichiRuntimeError(f"{dtype} is not supported as ndarray element type")
+    return x, dt
+
+
 @python_scope
 def ndarray(dtype, shape, needs_grad=False):
     """Defines a Taichi ndarray with scalar elements.
@@ -832,25 +855,7 @@ def ndarray(dtype, shape, needs_grad=False):
             >>> z = ti.ndarray(matrix_ty, shape=(4, 5))  # ndarray of shape (4, 5), each element is a matrix of (3, 4) ti.float scalars.
     """
     # primal
-    prog = get_runtime().prog
-    if prog is None:
-        raise TaichiRuntimeError("Cannont create ndarray, maybe you forgot to call `ti.init()` first?")
-
-    if isinstance(shape, numbers.Number):
-        shape = (shape,)
-    if not all((isinstance(x, int) or isinstance(x, np.integer)) and x > 0 and x <= 2**31 - 1 for x in shape):
-        raise TaichiRuntimeError(f"{shape} is not a valid shape for ndarray")
-    if dtype in all_types:
-        dt = cook_dtype(dtype)
-        x = ScalarNdarray(dt, shape)
-    elif isinstance(dtype, MatrixType):
-        if dtype.ndim == 1:
-            x = VectorNdarray(dtype.n, dtype.dtype, shape)
-        else:
-            x = MatrixNdarray(dtype.n, dtype.m, dtype.dtype, shape)
-        dt = dtype.dtype
-    else:
-        raise TaichiRuntimeError(f"{dtype} is not supported as ndarray element type")
+    x, dt = _ndarray(dtype, shape)
     if needs_grad:
         if not _ti_core.is_real(dt):
             raise TaichiRuntimeError(f"{dt} is not supported for ndarray with `needs_grad=True` or `needs_dual=True`.")
@@ -859,6 +864,35 @@ def ndarray(dtype, shape, needs_grad=False):
     return x
 
 
+@python_scope
+def memmap(filename, dtype, shape, mode="r", offset=0, access="normal"):
+    """Defines a Taichi ndarray backed by a memory-mapped binary file, on the CPU backends.
+
+    The file is paged in on demand instead of being copied into the ndarray,
+    and the ndarray can be passed to kernels like any other. The file itself is
+    never written: the pages written by kernels are private copies in memory.
+
+    Args:
+        filename (str): Path of the file, holding the elements in row-major order.
+        dtype (Union[DataType, MatrixType]): Data type of each element.
+        shape (Union[int, tuple[int]]): Shape of the ndarray.
+        mode (str): "r" for read-only, where writing to the ndarray from Python
+            (`fill()`, `from_numpy()`, `__setitem__`...) raises an error; "c" for
+            copy-on-write, where the ndarray can be written like any other.
+        offset (int): Offset in bytes of the first element in the file.
+        access (str): The expected access pattern, "normal", "sequential", "random"
+            or "willneed", forwarded to the OS as a paging hint.
+
+    Example::
+
+        >>> volume = ti.memmap("volume.raw", ti.f32, shape=(512, 512, 512), access="sequential")
+    """
+    if mode not in ("r", "c"):
+        raise TaichiRuntimeError(f'Unsupported memmap mode "{mode}", expected "r" or "c"')
+    x, _ = _ndarray(dtype, shape, (str(filename), offset, mode == "r", access))
+    return x
+
+
 @taichi_scope
 def ti_format_list_to_content_entries(raw):
     # return a pair of [content, format]
@@ -1197,6 +1231,7 @@ __all__ = [
     "deactivate_all_snodes",
     "field",
     "grouped",
+    "memmap",
     "ndarray",
     "one",
     "root",
@@ -8,7 +8,7 @@ from taichi._lib import core as ti_python_core
 from taichi.lang import expr, impl
 from taichi.lang import ops as ops_mod
 from taichi.lang import runtime_ops
-from taichi.lang._ndarray import Ndarray, NdarrayHostAccess
+from taichi.lang._ndarray import Ndarray, NdarrayHostAccess, _create_ndarray_storage
 from taichi.lang.common_ops import TaichiOperations
 from taichi.lang.enums import Layout
 from taichi.lang.exception import (
@@ -20,7 +20,6 @@ from taichi.lang.exception import (
 from taichi.lang.field import Field, ScalarField, SNodeHostAccess
 from taichi.lang.util import (
     cook_dtype,
-    get_traceback,
     in_python_scope,
     python_scope,
     taichi_scope,
@@ -1660,7 +1659,7 @@ class MatrixNdarray(Ndarray):
         >>> arr = ti.MatrixNdarray(2, 2, ti.f32, shape=(3, 3))
     """
 
-    def __init__(self, n, m, dtype, shape):
+    def __init__(self, n, m, dtype, shape, mapped_file=None):
         self.n = n
         self.m = m
         super().__init__()
@@ -1671,13 +1670,7 @@ class MatrixNdarray(Ndarray):
         self.shape = tuple(shape)
         self.element_type = _type_factory.get_tensor_type((self.n, self.m), self.dtype)
         # TODO: we should pass in element_type, shape, layout instead.
-        self.arr = impl.get_runtime().prog.create_ndarray(
-            cook_dtype(self.element_type),
-            shape,
-            Layout.AOS,
-            zero_fill=True,
-            dbg_info=ti_python_core.DebugInfo(get_traceback()),
-        )
+        self.arr = _create_ndarray_storage(cook_dtype(self.element_type), shape, Layout.AOS, mapped_file)
 
     @property
     def element_shape(self):
@@ -1776,7 +1769,7 @@ class VectorNdarray(Ndarray):
         >>> a = ti.VectorNdarray(3, ti.f32, (3, 3))
     """
 
-    def __init__(self, n, dtype, shape):
+    def __init__(self, n, dtype, shape, mapped_file=None):
         self.n = n
         super().__init__()
         # TODO(zhanlue): remove self.dtype and migrate its usages to element_type
@@ -1785,13 +1778,7 @@ class VectorNdarray(Ndarray):
         self.layout = Layout.AOS
         self.shape = tuple(shape)
         self.element_type = _type_factory.get_tensor_type((n,), self.dtype)
-        self.arr = impl.get_runtime().prog.create_ndarray(
-            cook_dtype(self.element_type),
-            shape,
-            Layout.AOS,
-            zero_fill=True,
-            dbg_info=ti_python_core.DebugInfo(get_traceback()),
-        )
+        self.arr = _create_ndarray_storage(cook_dtype(self.element_type), shape, Layout.AOS, mapped_file)
 
     @property
     def element_shape(self):
@@ -4,7 +4,7 @@ import numpy as np
 from taichi._lib import core as _ti_core
 from taichi.lang import impl
 from taichi.lang.enums import Layout
-from taichi.lang.exception import TaichiSyntaxError
+from taichi.lang.exception import TaichiRuntimeError, TaichiSyntaxError
 from taichi.lang.field import Field, ScalarField
 from taichi.lang.matrix import Matrix, MatrixField
 from taichi.lang.struct import StructField
@@ -562,6 +562,37 @@ class Mesh:
     def generate_meta(data):
         return MeshMetadata(data)
 
+    @staticmethod
+    def build_meta(cells, x, reorder="rcm", max_cells_per_patch=256, relations=None):
+        """Builds the mesh metadata from the cells of a triangle or tetrahedral mesh.
+
+        The cells are reordered for locality and partitioned into patches,
+        which replaces the external patcher for meshes with poor element order.
+
+        Args:
+            cells (numpy.ndarray): The vertex indices of each cell, of shape (n, 3) for a
+                triangle mesh or (n, 4) for a tetrahedral mesh.
+            x (numpy.ndarray): The vertex positions, of shape (m, 3).
+            reorder (str): The cell ordering, "none", "rcm" (reverse Cuthill-McKee),
+                "morton" or "hilbert".
+            max_cells_per_patch (int): The maximum number of cells in a patch.
+            relations (list[str]): The relations to build, e.g. ["CV", "VV"], all by default.
+
+        Returns:
+            MeshMetadata: The metadata to build the mesh instance with.
+        """
+        cells = np.asarray(cells)
+        x = np.asarray(x)
+        if cells.ndim != 2 or cells.shape[1] not in (3, 4):
+            raise TaichiRuntimeError(f"Expected cells of shape (n, 3) or (n, 4), got {cells.shape}")
+        if x.ndim != 2 or x.shape[1] != 3:
+            raise TaichiRuntimeError(f"Expected vertex positions of shape (m, 3), got {x.shape}")
+        topology = MeshTopology.Triangle if cells.shape[1] == 3 else MeshTopology.Tetrahedron
+        relation_types = [getattr(MeshRelationType, name) for name in relations or []]
+        data = _ti_core.build_mesh_patches(topology, cells, x, reorder, max_cells_per_patch, relation_types)
+        data["attrs"] = {"x": x.reshape(-1)}
+        return MeshMetadata(data)
+
 
 def _TriMesh():
     """(Deprecated) Create a triangle mesh (a set of vert/edge/face elements, attributes, and connectivity) builder.
@@ -346,6 +346,8 @@ def init(
             https://github.com/taichi-dev/taichi/blob/master/taichi/program/compile_config.h.
 
             * ``cpu_max_num_threads`` (int): Sets the number of threads used by the CPU thread pool.
+            * ``cpu_huge_pages`` (str): Backs the large allocations on CPU with huge pages, one of ``"none"`` (default), ``"transparent"``, ``"explicit_2m"`` or ``"explicit_1g"``. Allocations of at least ``cpu_huge_page_min_size`` bytes (default 32 MB) are affected.
+            * ``device_allocation_cache_size`` (int): The bytes of the deleted ndarrays that the CPU, CUDA and AMDGPU backends keep for the following ndarrays of similar sizes (default 512 MB). ``0`` returns them immediately.
             * ``debug`` (bool): Enables the debug mode, under which Taichi does a few more things like boundary checks.
             * ``print_ir`` (bool): Prints the CHI IR of the Taichi kernels.
             *``offline_cache`` (bool): Enables offline cache of the compiled kernels. Default to True. When this is enabled Taichi will cache compiled kernel on your local disk to accelerate future calls.
@@ -609,6 +611,20 @@ def _bit_vectorize():
     get_runtime().compiling_callable.ast_builder().bit_vectorize()
 
 
+def _tile(tile):
+    """Traverse the next ndrange-for tile by tile."""
+    if tile == "auto":
+        tile_sizes = []
+    elif isinstance(tile, (list, tuple)) and len(tile) > 0:
+        tile_sizes = list(tile)
+        for size in tile_sizes:
+            if not isinstance(size, int) or size <= 0:
+                raise ValueError(f"Tile sizes should be positive integers, got {tile}")
+    else:
+        raise ValueError(f"tile should be 'auto' or a non-empty tuple of tile sizes, got {tile}")
+    get_runtime().compiling_callable.ast_builder().tile(tile_sizes)
+
+
 def loop_config(
     *,
     block_dim=None,
@@ -616,6 +632,7 @@ def loop_config(
     parallelize=None,
     block_dim_adaptive=True,
     bit_vectorize=False,
+    tile=None,
 ):
     """Sets directives for the next loop
 
@@ -625,6 +642,9 @@ def loop_config(
         parallelize (int): The number of threads to use on CPU
         block_dim_adaptive (bool): Whether to allow backends set block_dim adaptively, enabled by default
         bit_vectorize (bool): Whether to enable bit vectorization of struct fors on quant_arrays.
+        tile (Union[tuple, str]): Tile sizes of an ndrange-for, one per dimension. The ndrange is traversed tile by
+            tile so that neighboring iterations touch nearby data in every dimension. Use `"auto"` to let Taichi
+            pick the tile sizes.
 
     Examples::
 
@@ -662,6 +682,16 @@ def loop_config(
             # 32 bits, instead of 1 bit, will be copied at a time
             for i, j in x:
                 y[i, j] = x[i, j]
+
+        a = ti.field(ti.f32, shape=(1024, 1024))
+        b = ti.field(ti.f32, shape=(1024, 1024))
+        @ti.kernel
+        def transpose():
+            ti.loop_config(tile=(32, 32))
+            # Iterations are grouped into 32x32 tiles, so that both a and b
+            # are accessed in cache-friendly blocks
+            for i, j in ti.ndrange(1024, 1024):
+                b[j, i] = a[i, j]
     """
     if block_dim is not None:
         _block_dim(block_dim)
@@ -677,6 +707,9 @@ def loop_config(
     if bit_vectorize:
         _bit_vectorize()
 
+    if tile is not None:
+        _tile(tile)
+
 
 def global_thread_idx():
     """Returns the global thread id of this running thread,
@@ -4,3 +4,4 @@ from taichi.linalg.sparse_cg import SparseCG
 from taichi.linalg.sparse_matrix import *
 from taichi.linalg.sparse_solver import SparseSolver
 from taichi.linalg.matrixfree_cg import *
+from taichi.linalg.krylov_solver import KrylovSolver
@@ -0,0 +1,105 @@
+from taichi._lib import core as _ti_core
+from taichi.lang._ndarray import Ndarray, ScalarNdarray
+from taichi.lang.exception import TaichiRuntimeError, TaichiTypeError
+from taichi.lang.impl import get_runtime
+from taichi.linalg.matrixfree_cg import LinearOperator
+from taichi.linalg.sparse_matrix import SparseMatrix
+from taichi.types import f32, f64
+
+
+class KrylovSolver:
+    """Preconditioned Krylov solver for the CPU backends.
+
+    Solves the linear system Ax = b in place on Taichi ndarrays, with A either
+    an assembled SparseMatrix or a LinearOperator whose matvec kernel takes
+    two ndarrays.
+
+    Args:
+        method (str): "cg" for symmetric positive definite systems, or "bicgstab".
+        preconditioner (str): "none", "jacobi", "block_jacobi" or "ic0". Only "none"
+            and "jacobi" are supported for a LinearOperator.
+        max_iter (int): Maximum number of iterations.
+        atol (float): Tolerance(absolute) on the norm of the residual.
+        block_size (int): Number of rows of the diagonal blocks of "block_jacobi".
+        verbose (bool): Whether to print the number of iterations and the residual.
+
+    Example::
+
+        >>> solver = ti.linalg.KrylovSolver(method="cg", preconditioner="ic0")
+        >>> converged = solver.solve(A, b, x)
+    """
+
+    def __init__(self, method="cg", preconditioner="jacobi", max_iter=1000, atol=1e-6, block_size=3, verbose=False):
+        self.method = method
+        self.preconditioner = preconditioner
+        self.max_iter = max_iter
+        self.atol = atol
+        self.block_size = block_size
+        self.verbose = verbose
+        self.solvers = {}
+        self.last_solver = None
+
+    def _get_solver(self, dtype):
+        if dtype not in self.solvers:
+            if dtype == f32:
+                solver_class = _ti_core.KrylovSolverf
+            elif dtype == f64:
+                solver_class = _ti_core.KrylovSolverd
+            else:
+                raise TaichiTypeError(f"Unsupported KrylovSolver dtype: {dtype}")
+            self.solvers[dtype] = solver_class(
+                get_runtime().prog,
+                self.method,
+                self.preconditioner,
+                self.max_iter,
+                self.atol,
+                self.block_size,
+                self.verbose,
+            )
+        return self.solvers[dtype]
+
+    def solve(self, A, b, x, diagonal=None):
+        """Solves Ax = b, starting from the current value of x.
+
+        Args:
+            A (SparseMatrix, LinearOperator): The coefficient matrix of the linear system.
+            b (Ndarray): The right-hand side of the linear system.
+            x (Ndarray): The initial guess, overwritten by the solution.
+            diagonal (Ndarray): The diagonal of a LinearOperator, for the "jacobi" preconditioner.
+
+        Returns:
+            bool: Whether the solver converged.
+        """
+        if not isinstance(b, Ndarray) or not isinstance(x, Ndarray):
+            raise TaichiRuntimeError("KrylovSolver only supports Taichi ndarrays for b and x.")
+        if b.dtype != x.dtype:
+            raise TaichiTypeError(f"Dtype mismatch b.dtype({b.dtype}) != x.dtype({x.dtype}).")
+        if b.shape != x.shape:
+            raise TaichiRuntimeError(f"Dimension mismatch b.shape{b.shape} != x.shape{x.shape}.")
+        solver = self._get_solver(b.dtype)
+        self.last_solver = solver
+        if isinstance(A, SparseMatrix):
+            return solver.solve(A.matrix, b.arr, x.arr)
+        if isinstance(A, LinearOperator):
+            p = ScalarNdarray(b.dtype, b.shape)
+            Ap = ScalarNdarray(b.dtype, b.shape)
+            return solver.solve_matrix_free(
+                lambda: A.matvec(p, Ap),
+                p.arr,
+                Ap.arr,
+                diagonal.arr if diagonal is not None else None,
+                b.arr,
+                x.arr,
+            )
+        raise TaichiRuntimeError(f"Unsupported KrylovSolver operator type: {type(A)}")
+
+    def num_iterations(self):
+        """The number of iterations of the last solve."""
+        return self.last_solver.num_iterations() if self.last_solver else 0
+
+    def residual_norm(self):
+        """The norm of the residual after the last solve."""
+        return self.last_solver.residual_norm() if self.last_solver else 0.0
+
+
+__all__ = ["KrylovSolver"]
@@ -134,18 +134,21 @@ class SparseMatrix:
             assert (
                 self.m == other.n
             ), f"Dimension mismatch between sparse matrices ({self.n}, {self.m}) and ({other.n}, {other.m})"
-            sm = self.matrix.matmul(other.matrix)
+            if isinstance(self.matrix, _ti_core.CuSparseMatrix):
+                sm = self.matrix.matmul(other.matrix)
+            else:
+                sm = self.matrix.matmul(other.matrix, get_runtime().prog)
             return SparseMatrix(sm=sm)
         if isinstance(other, Field):
             assert (
                 self.m == other.shape[0]
             ), f"Dimension mismatch between sparse matrix ({self.n}, {self.m}) and vector ({other.shape})"
-            return self.matrix.mat_vec_mul(other.to_numpy())
+            return self.matrix.mat_vec_mul(other.to_numpy(), get_runtime().prog)
         if isinstance(other, np.ndarray):
             assert (
                 self.m == other.shape[0]
             ), f"Dimension mismatch between sparse matrix ({self.n}, {self.m}) and vector ({other.shape})"
-            return self.matrix.mat_vec_mul(other)
+            return self.matrix.mat_vec_mul(other, get_runtime().prog)
         if isinstance(other, Ndarray):
             if self.m != other.shape[0]:
                 raise TaichiRuntimeError(
@@ -158,6 +161,19 @@ class SparseMatrix:
             f"Sparse matrix-matrix/vector multiplication does not support {type(other)} for now. Supported types are SparseMatrix, ti.field, and numpy ndarray."
         )
 
+    def use_sell_c_sigma(self, chunk_size=8, sigma=256):
+        """Run sparse matrix-vector products in the SELL-C-sigma format. CPU only.
+
+        Rows are sorted by length within windows of `sigma` rows and packed into chunks of `chunk_size` rows, which
+        are processed in lockstep with SIMD instructions. This pays off for large matrices with rows of similar
+        lengths.
+
+        Args:
+            chunk_size (int): The number of rows per chunk, one of 4, 8, 16 and 32. 0 turns the format off.
+            sigma (int): The size of the windows in which rows are sorted.
+        """
+        self.matrix.use_sell_c_sigma(chunk_size, sigma)
+
     def __getitem__(self, indices):
         return self.matrix.get_element(indices[0], indices[1])
 
@@ -212,6 +228,13 @@ class SparseMatrix:
                 "Sparse matrix only supports building from [ti.ndarray, ti.Vector.ndarray, ti.Matrix.ndarray]"
             )
 
+    def pattern_fingerprint(self):
+        """A hash of the shape and of the positions of the non-zeros of the matrix. CPU only.
+
+        Matrices with the same sparsity pattern have the same fingerprint.
+        """
+        return self.matrix.pattern_fingerprint()
+
     def mmwrite(self, filename):
         """Writes the sparse matrix to Matrix Market file-like target.
 
@@ -279,10 +302,18 @@ class SparseMatrixBuilder:
         elif taichi_arch == _ti_core.Arch.cuda:
             self.ptr.print_triplets_cuda()
 
-    def build(self, dtype=f32, _format="CSR"):
-        """Create a sparse matrix using the triplets"""
+    def build(self, dtype=f32, _format="CSR", out=None):
+        """Create a sparse matrix using the triplets
+
+        Args:
+            out (SparseMatrix, optional): A sparse matrix with the same shape and dtype built earlier. It is rebuilt
+                in place and returned, and its storage is reused if the triplets fit in its sparsity pattern. CPU only.
+        """
         taichi_arch = get_runtime().prog.config().arch
         if taichi_arch in [_ti_core.Arch.x64, _ti_core.Arch.arm64]:
+            if out is not None:
+                self.ptr.build_into(out.matrix)
+                return out
             sm = self.ptr.build()
             return SparseMatrix(sm=sm, dtype=self.dtype)
         if taichi_arch == _ti_core.Arch.cuda:
@@ -15,14 +15,19 @@ class SparseSolver:
     Use this class to solve linear systems represented by sparse matrices.
 
     Args:
-        solver_type (str): The factorization type.
+        solver_type (str): The factorization type. "SupernodalLLT" is a Cholesky factorization that works on dense
+            blocks of columns and runs on the CPU thread pool, which pays off for large matrices.
         ordering (str): The method for matrices re-ordering.
+
+    The ordering and the symbolic factorization are reused as long as the matrices passed to the solver have the
+    sparsity pattern of the last analyzed one, so that calling `compute` on a matrix whose values changed only redoes
+    the numerical factorization.
     """
 
     def __init__(self, dtype=f32, solver_type="LLT", ordering="AMD"):
         self.matrix = None
         self.dtype = dtype
-        solver_type_list = ["LLT", "LDLT", "LU"]
+        solver_type_list = ["LLT", "LDLT", "LU", "SupernodalLLT"]
         solver_ordering = ["AMD", "COLAMD"]
         if solver_type in solver_type_list and ordering in solver_ordering:
             taichi_arch = taichi.lang.impl.get_runtime().prog.config().arch
@@ -32,9 +37,11 @@ class SparseSolver:
                 or taichi_arch == _ti_core.Arch.cuda
             ), "SparseSolver only supports CPU and CUDA for now."
             if taichi_arch == _ti_core.Arch.cuda:
+                if solver_type == "SupernodalLLT":
+                    raise TaichiRuntimeError("The SupernodalLLT solver is only supported on CPU.")
                 self.solver = _ti_core.make_cusparse_solver(dtype, solver_type, ordering)
             else:
-                self.solver = _ti_core.make_sparse_solver(dtype, solver_type, ordering)
+                self.solver = _ti_core.make_sparse_solver(dtype, solver_type, ordering, get_runtime().prog)
         else:
             raise TaichiRuntimeError(
                 f"The solver type {solver_type} with {ordering} is not supported for now. Only {solver_type_list} with {solver_ordering} are supported."
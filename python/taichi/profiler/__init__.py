@@ -1,4 +1,5 @@
 from taichi.profiler.kernel_metrics import *
 from taichi.profiler.kernel_profiler import *
+from taichi.profiler.launch_trace import *
 from taichi.profiler.memory_profiler import *
 from taichi.profiler.scoped_profiler import *
@@ -255,4 +255,38 @@ default_cupti_metrics = [dram_bytes_sum]
 Default to `dram_bytes_sum`.
 """
 
+# Hardware counters of the CPU backends, collected by the perf toolkit
+cpu_cycles = CuptiMetric(
+    name="cycles",
+    header="     cycles ",
+    val_format=" {:8.3f} M ",
+    scale=1.0 / 1000 / 1000,
+)
+
+cpu_instructions = CuptiMetric(
+    name="instructions",
+    header="      instr ",
+    val_format=" {:8.3f} M ",
+    scale=1.0 / 1000 / 1000,
+)
+
+llc_misses = CuptiMetric(
+    name="llc_misses",
+    header="   LLC miss ",
+    val_format=" {:8.3f} K ",
+    scale=1.0 / 1000,
+)
+
+branch_misses = CuptiMetric(
+    name="branch_misses",
+    header=" branch miss ",
+    val_format="  {:8.3f} K ",
+    scale=1.0 / 1000,
+)
+
+default_perf_metrics = [cpu_cycles, cpu_instructions, llc_misses, branch_misses]
+"""The metrics collected by the perf toolkit on the CPU backends by default,
+summed over the threads running each offloaded task.
+"""
+
 __all__ = ["CuptiMetric", "get_predefined_cupti_metrics"]
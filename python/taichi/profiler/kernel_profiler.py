@@ -1,8 +1,36 @@
+import csv
+import json
+import os
 from contextlib import contextmanager
 
 from taichi._lib import core as _ti_core
 from taichi.lang import impl
-from taichi.profiler.kernel_metrics import default_cupti_metrics
+from taichi.profiler.kernel_metrics import default_cupti_metrics, default_perf_metrics
+
+
+_exported_percentiles = [("50", 0.5), ("90", 0.9), ("99", 0.99), ("999", 0.999)]
+_exported_columns = ["name", "count", "total_ms", "mean_ms", "min_ms", "max_ms"] + [
+    f"p{label}_ms" for label, _ in _exported_percentiles
+]
+
+
+def _to_prometheus_text(rows):
+    """Formats kernel statistics as a summary in the Prometheus text exposition format, in seconds."""
+
+    def escape(name):
+        return name.replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n")
+
+    lines = [
+        "# HELP taichi_kernel_time_seconds Time of the kernels since the last reset.",
+        "# TYPE taichi_kernel_time_seconds summary",
+    ]
+    for row in rows:
+        kernel = f'kernel="{escape(row["name"])}"'
+        for label, q in _exported_percentiles:
+            lines.append(f'taichi_kernel_time_seconds{{{kernel},quantile="{q}"}} {row[f"p{label}_ms"] / 1000}')
+        lines.append(f"taichi_kernel_time_seconds_sum{{{kernel}}} {row['total_ms'] / 1000}")
+        lines.append(f"taichi_kernel_time_seconds_count{{{kernel}}} {row['count']}")
+    return "\n".join(lines) + "\n"
 
 
 class StatisticalResult:
@@ -44,7 +72,8 @@ class KernelProfiler:
     and prints the results to the console by :func:`~taichi.profiler.kernel_profiler.KernelProfiler.print_info`.
 
     ``KernelProfiler`` now support detailed low-level performance metrics (such as memory bandwidth consumption) in its advanced mode.
-    This mode is only available for the CUDA backend with CUPTI toolkit, i.e. you need ``ti.init(kernel_profiler=True, arch=ti.cuda)``.
+    This mode is available for the CUDA backend with CUPTI toolkit, i.e. you need ``ti.init(kernel_profiler=True, arch=ti.cuda)``,
+    and for the CPU backends with the perf toolkit, which reports hardware counters such as cycles and cache misses.
 
     Note:
         For details about using CUPTI in Taichi, please visit https://docs.taichi-lang.org/docs/profiler#advanced-mode.
@@ -76,6 +105,10 @@ class KernelProfiler:
             return False
         status = impl.get_runtime().prog.set_kernel_profiler_toolkit(toolkit_name)
         if status is True:
+            if toolkit_name == "perf":
+                self._metric_list = default_perf_metrics
+            elif self._profiling_toolkit == "perf":
+                self._metric_list = [default_cupti_metrics]
             self._profiling_toolkit = toolkit_name
         else:
             _ti_core.warn(
@@ -83,6 +116,66 @@ class KernelProfiler:
             )
         return status
 
+    def set_load_balance(self, enabled=True):
+        """For docstring of this function, see :func:`~taichi.profiler.set_kernel_profiler_load_balance`."""
+        if self._check_not_turned_on_with_warning_message():
+            return False
+        status = impl.get_runtime().prog.set_kernel_profiler_load_balance(enabled)
+        if status is not True:
+            _ti_core.warn("Thread load balance can only be recorded on the CPU backends.")
+        return status
+
+    def set_streaming(self, enabled=True):
+        """For docstring of this function, see :func:`~taichi.profiler.set_kernel_profiler_streaming`."""
+        if self._check_not_turned_on_with_warning_message():
+            return
+        impl.get_runtime().prog.set_kernel_profiler_streaming(enabled)
+
+    def get_statistics(self, reset=False):
+        """For docstring of this function, see :func:`~taichi.profiler.get_kernel_profiler_statistics`."""
+        if self._check_not_turned_on_with_warning_message():
+            return []
+        impl.get_runtime().prog.sync_kernel_profiler()
+        impl.get_runtime().prog.update_kernel_profiler()
+        return impl.get_runtime().prog.get_kernel_profiler_streaming_statistics(reset)
+
+    def export_statistics(self, filename, file_format=None, reset=False):
+        """For docstring of this function, see :func:`~taichi.profiler.export_kernel_profiler_statistics`."""
+        if file_format is None:
+            extension = os.path.splitext(filename)[1]
+            file_format = {".json": "json", ".csv": "csv", ".prom": "prometheus"}.get(extension)
+            if file_format is None:
+                raise ValueError(f"Cannot infer the format of {filename}, expected .json, .csv or .prom")
+        if file_format not in ("json", "csv", "prometheus"):
+            raise ValueError(f'Unsupported format "{file_format}", expected "json", "csv" or "prometheus"')
+        rows = [
+            {
+                "name": s.name,
+                "count": s.counter,
+                "total_ms": s.total,
+                "mean_ms": s.total / s.counter if s.counter else 0.0,
+                "min_ms": s.min,
+                "max_ms": s.max,
+                **{f"p{label}_ms": s.percentile(q) for label, q in _exported_percentiles},
+            }
+            for s in self.get_statistics(reset)
+        ]
+        # Written to a temporary file first, so that a scraper never reads a partial file.
+        temp_filename = f"{filename}.tmp"
+        with open(temp_filename, "w", newline="") as f:
+            if file_format == "json":
+                json.dump(rows, f, indent=2)
+            elif file_format == "csv":
+                writer = csv.DictWriter(f, fieldnames=_exported_columns)
+                writer.writeheader()
+                writer.writerows(rows)
+            else:
+                f.write(_to_prometheus_text(rows))
+        os.replace(temp_filename, filename)
+
+    def _default_metrics(self):
+        return default_perf_metrics if self._profiling_toolkit == "perf" else default_cupti_metrics
+
     def get_total_time(self):
         """Get elapsed time of all kernels recorded in KernelProfiler.
 
@@ -141,7 +234,7 @@ class KernelProfiler:
             return None
         self.set_metrics(metric_list)
         yield self
-        self.set_metrics()  # back to default metric list
+        self.set_metrics(self._default_metrics())  # back to default metric list
 
         return None
 
@@ -281,12 +374,16 @@ class KernelProfiler:
         # there is no corresponding implementation in other backends yet.
         # Profiler dose not print invalid kernel attributes info for now.
         kernel_attribute_state = self._traced_records[0].register_per_thread > 0
+        # Thread load balance is only recorded on the CPU backends when enabled.
+        load_balance_state = any(record.tasks_per_thread for record in self._traced_records)
 
         # headers
         table_header = self._make_table_header("trace")
         column_header = "[  start.time | kernel.time |"  # default
         if kernel_attribute_state:
             column_header += "   regs  |   shared mem | grid size | block size | occupancy |"  # kernel_attributes
+        if load_balance_state:
+            column_header += " imbalance |   idle.time | tasks/thread |"
         for idx in range(values_num):
             column_header += metric_list[idx].header + "|"
         column_header = (column_header + "] Kernel name").replace("|]", "]")
@@ -312,6 +409,15 @@ class KernelProfiler:
                     record.block_size,
                     record.active_blocks_per_multiprocessor,
                 ]
+            if load_balance_state:
+                tasks = record.tasks_per_thread or [0]
+                formatted_str += "   {:5.2f}x  |{:9.3f} ms |  {:4d} ~{:4d}  |"
+                values += [
+                    record.thread_imbalance_ratio,
+                    record.thread_idle_time,
+                    min(tasks),
+                    max(tasks),
+                ]
             for idx in range(values_num):
                 formatted_str += metric_list[idx].val_format + "|"
                 values += [record.metric_values[idx] * metric_list[idx].scale]
@@ -449,7 +555,12 @@ def get_kernel_profiler_total_time():
 def set_kernel_profiler_toolkit(toolkit_name="default"):
     """Set the toolkit used by KernelProfiler.
 
-    Currently, we only support toolkits: ``'default'`` and ``'cupti'``.
+    Currently, we support toolkits: ``'default'``, ``'cupti'`` on the CUDA backend,
+    and ``'perf'`` on the CPU backends. The ``'perf'`` toolkit counts cycles, instructions,
+    last level cache misses and branch misses of each offloaded task with the Linux
+    perf_event interface, summed over the threads running the task. It fails to be set
+    when hardware performance counters are unavailable, e.g. in a virtual machine or when
+    ``/proc/sys/kernel/perf_event_paranoid`` is larger than 2.
 
     Args:
         toolkit_name (str): string of toolkit name.
@@ -482,6 +593,105 @@ def set_kernel_profiler_toolkit(toolkit_name="default"):
     return get_default_kernel_profiler().set_toolkit(toolkit_name)
 
 
+def set_kernel_profiler_load_balance(enabled=True):
+    """Records how busy each thread of the CPU thread pool is in each offloaded task.
+
+    For each offloaded task, the records printed in ``'trace'`` mode then show:
+
+    - the imbalance ratio, i.e. the largest busy time of a thread over the average one,
+      which is 1.00x when the work is evenly distributed;
+    - the idle time of the threads summed, including waiting for stragglers;
+    - the smallest and the largest number of tasks (chunks of the loop) run by a thread.
+
+    The busy span of each thread in each task is also added to its lane of the timeline
+    saved by ``ti.lang.misc.timeline_save`` when ``ti.init(timeline=True)``, a lane named
+    ``cpu_worker_NN`` from the first recorded task on. Only available on the CPU backends.
+
+    Args:
+        enabled (bool): whether to record the load balance.
+
+    Returns:
+        status (bool): whether the setting is successful or not.
+
+    Example::
+
+        >>> import taichi as ti
+
+        >>> ti.init(arch=ti.cpu, kernel_profiler=True, timeline=True)
+        >>> x = ti.field(ti.f32, shape=1024*1024)
+
+        >>> @ti.kernel
+        >>> def fill():
+        >>>     for i in x:
+        >>>         x[i] = ti.sin(i) if i % 1024 < 16 else 0.0
+
+        >>> ti.profiler.set_kernel_profiler_load_balance(True)
+        >>> fill()
+        >>> ti.profiler.print_kernel_profiler_info('trace')
+        >>> ti.lang.misc.timeline_save('fill.json')
+    """
+    return get_default_kernel_profiler().set_load_balance(enabled)
+
+
+def set_kernel_profiler_streaming(enabled=True):
+    """Counts the kernel times in bounded memory instead of tracing each launch, for long-running programs.
+
+    In streaming mode, the times of each kernel are counted in a histogram whose percentiles are
+    within 1% of the recorded times, see :func:`~taichi.profiler.get_kernel_profiler_statistics`.
+    The launches are no longer traced, so ``print_kernel_profiler_info`` and
+    ``query_kernel_profiler_info`` only report the latest launch.
+
+    Args:
+        enabled (bool): whether to count the kernel times in streaming mode.
+
+    Example::
+
+        >>> import taichi as ti
+
+        >>> ti.init(ti.cpu, kernel_profiler=True)
+        >>> ti.profiler.set_kernel_profiler_streaming(True)
+        >>> while True:
+        >>>     step()
+        >>>     if frame % 1000 == 0:
+        >>>         ti.profiler.export_kernel_profiler_statistics('kernels.prom', reset=True)
+    """
+    get_default_kernel_profiler().set_streaming(enabled)
+
+
+def get_kernel_profiler_statistics(reset=False):
+    """Returns the statistics of each kernel counted in streaming mode, by decreasing total time.
+
+    Each ``KernelLatencyStatistics`` has the ``name`` of the kernel, the number of launches
+    ``counter``, the ``min``, ``max`` and ``total`` times in milliseconds, and ``percentile(q)``
+    returning the time in milliseconds below which the fraction ``q`` of the launches fall,
+    e.g. ``percentile(0.99)`` for the 99th percentile.
+
+    Args:
+        reset (bool): whether to restart counting afterwards, to report the statistics by interval.
+
+    Returns:
+        List[KernelLatencyStatistics]: the statistics of the kernels.
+    """
+    return get_default_kernel_profiler().get_statistics(reset)
+
+
+def export_kernel_profiler_statistics(filename, file_format=None, reset=False):
+    """Writes the statistics of each kernel counted in streaming mode to a file.
+
+    The count, the total, mean, min and max times and the 50th, 90th, 99th and 99.9th percentiles
+    are written as JSON or CSV in milliseconds, or as a summary in the Prometheus text format in
+    seconds, to be scraped e.g. by the textfile collector of the node exporter. The file is
+    replaced atomically.
+
+    Args:
+        filename (str): the file to write.
+        file_format (str): ``'json'``, ``'csv'`` or ``'prometheus'``, inferred from the ``.json``,
+            ``.csv`` or ``.prom`` extension by default.
+        reset (bool): whether to restart counting afterwards, to report the statistics by interval.
+    """
+    get_default_kernel_profiler().export_statistics(filename, file_format, reset)
+
+
 def set_kernel_profiler_metrics(metric_list=default_cupti_metrics):
     """Set metrics that will be collected by the CUPTI toolkit.
 
@@ -576,15 +786,19 @@ def collect_kernel_profiler_metrics(metric_list=default_cupti_metrics):
     """
     get_default_kernel_profiler().set_metrics(metric_list)
     yield get_default_kernel_profiler()
-    get_default_kernel_profiler().set_metrics()
+    get_default_kernel_profiler().set_metrics(get_default_kernel_profiler()._default_metrics())
 
 
 __all__ = [
     "clear_kernel_profiler_info",
     "collect_kernel_profiler_metrics",
+    "export_kernel_profiler_statistics",
+    "get_kernel_profiler_statistics",
     "get_kernel_profiler_total_time",
     "print_kernel_profiler_info",
     "query_kernel_profiler_info",
+    "set_kernel_profiler_load_balance",
     "set_kernel_profiler_metrics",
+    "set_kernel_profiler_streaming",
     "set_kernel_profiler_toolkit",
 ]
@@ -0,0 +1,61 @@
+from taichi.lang.impl import get_runtime
+
+
+def start_launch_trace():
+    """Starts recording the kernel launches into a launch trace.
+
+    Each launch records the offline cache key of its kernel, its scalar
+    arguments, the shapes of its arrays and the sizes of their buffers. The
+    trace is replayed by :func:`replay_launch_trace`, or by a C++ driver with
+    ``LaunchTraceReplayer``, to benchmark the launches without the Python
+    frontend.
+
+    The kernels are replayed from the offline cache, which must be on while
+    recording and is written when the program is reset or exits. Launches
+    with argpacks or textures are not recorded.
+    """
+    get_runtime().materialize()
+    get_runtime().prog.start_launch_trace()
+
+
+def stop_launch_trace(filename):
+    """Stops recording the kernel launches and saves them to a binary file.
+
+    Args:
+        filename (str): The file to save the launch trace to.
+
+    Returns:
+        int: The number of recorded launches.
+    """
+    get_runtime().materialize()
+    return get_runtime().prog.stop_launch_trace(filename)
+
+
+def replay_launch_trace(filename, repeats=1, synchronize_each=True):
+    """Replays a launch trace recorded by :func:`start_launch_trace`.
+
+    The program must run on the arch of the recording, with the same offline
+    cache path. The arrays are replaced with zero-filled buffers of the same
+    sizes and the fields are not recreated, so only the kernels over ndarrays
+    and scalars replay faithfully. LLVM backends only.
+
+    Args:
+        filename (str): The launch trace.
+        repeats (int): How many times the recorded sequence is launched.
+        synchronize_each (bool): Whether to time each launch up to its
+            completion, rather than only the whole replay.
+
+    Returns:
+        LaunchTraceReplayResult: The number of launches, the total time in
+        seconds and, when synchronizing each launch, the
+        ``KernelLatencyStatistics`` of each kernel in milliseconds.
+    """
+    get_runtime().materialize()
+    return get_runtime().prog.replay_launch_trace(filename, repeats, synchronize_each)
+
+
+__all__ = [
+    "start_launch_trace",
+    "stop_launch_trace",
+    "replay_launch_trace",
+]
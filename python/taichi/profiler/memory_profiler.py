@@ -10,4 +10,61 @@ def print_memory_profiler_info():
     get_runtime().prog.print_memory_profiler_info()
 
 
-__all__ = ["print_memory_profiler_info"]
+def query_memory_usage():
+    """Queries the memory reserved and used by the program.
+
+    The SNode fields are reported on the LLVM backends, for each SNode with
+    dynamically allocated cells: its active element list and, for sparse
+    SNodes, the data, free and recycled lists of its node allocator, in
+    ``reserved_bytes`` and ``used_bytes``. The usage also holds the size of
+    each ndarray and of the argpacks, the usage of the memory preallocated for
+    the runtime on CUDA and AMDGPU, and the chunks of the host memory pool
+    with their free space, the released allocations kept for reuse and the
+    memory backed by huge pages (see ``cpu_huge_pages`` in :func:`ti.init`).
+    ``device_allocation_cache`` reports the memory of the deleted ndarrays
+    kept by the device (see ``device_allocation_cache_size`` in
+    :func:`ti.init`).
+
+    Returns:
+        MemoryUsage: A snapshot of the memory usage.
+
+    Example::
+
+        >>> usage = ti.profiler.query_memory_usage()
+        >>> for snode in usage.snodes:
+        >>>     print(snode.name, snode.used_bytes, snode.reserved_bytes)
+    """
+    get_runtime().materialize()
+    return get_runtime().prog.query_memory_usage()
+
+
+def set_memory_sampling(enabled):
+    """Queries the memory usage after each kernel launch, for time series.
+
+    Each sample is labelled with the name of the kernel. Sampling synchronizes
+    the device after each kernel, so it is only meant for debugging, e.g.
+    finding the kernel after which a sparse field grows.
+
+    Args:
+        enabled (bool): Whether to sample the memory usage.
+    """
+    get_runtime().materialize()
+    get_runtime().prog.set_memory_sampling(enabled)
+
+
+def take_memory_samples():
+    """Returns the memory usage sampled since the last call, see :func:`set_memory_sampling`.
+
+    Returns:
+        List[MemoryUsage]: The samples, in launch order.
+    """
+    get_runtime().materialize()
+    return get_runtime().prog.take_memory_samples()
+
+
+__all__ = [
+    "print_memory_profiler_info",
+    "query_memory_usage",
+    "set_memory_sampling",
+    "take_memory_samples",
+]
@@ -57,6 +57,7 @@ static std::vector<std::uint8_t> get_offline_cache_key_of_compile_config(
   if (arch_is_cpu(config.arch)) {
     serializer(config.default_cpu_block_dim);
     serializer(config.cpu_max_num_threads);
+    serializer(config.cpu_vectorize_range_for);
   } else if (arch_is_gpu(config.arch)) {
     serializer(config.default_gpu_block_dim);
     serializer(config.gpu_max_reg);
@@ -65,6 +66,7 @@ static std::vector<std::uint8_t> get_offline_cache_key_of_compile_config(
   }
   serializer(config.ad_stack_size);
   serializer(config.default_ad_stack_size);
+  serializer(config.ad_stack_memory_budget);
   serializer(config.random_seed);
   if (config.arch == Arch::opengl || config.arch == Arch::gles) {
     serializer(config.allow_nv_shader_extension);
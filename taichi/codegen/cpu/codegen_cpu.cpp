@@ -68,12 +68,57 @@ class TaskCodeGenCPU : public TaskCodeGenLLVM {
 
     auto [begin, end] = get_range_for_bounds(stmt);
 
+    if (compile_config.cpu_vectorize_range_for && step == 1) {
+      auto *block_body = create_range_for_block_body(body);
+      call("cpu_parallel_range_for_blocked", get_arg(0),
+           tlctx->get_constant(stmt->num_cpu_threads), begin, end,
+           tlctx->get_constant(stmt->block_dim), tls_prologue, block_body,
+           epilogue, tlctx->get_constant(stmt->tls_size));
+      return;
+    }
+
     call("cpu_parallel_range_for", get_arg(0),
          tlctx->get_constant(stmt->num_cpu_threads), begin, end,
          tlctx->get_constant(step), tlctx->get_constant(stmt->block_dim),
          tls_prologue, body, epilogue, tlctx->get_constant(stmt->tls_size));
   }
 
+  // Creates a function that runs |body| for the indices [begin, end), which
+  // saves the indirect call per index. |body| is inlined into a plain counted
+  // loop; no SIMD code is requested for it.
+  llvm::Function *create_range_for_block_body(llvm::Function *body) {
+    body->addFnAttr(llvm::Attribute::AlwaysInline);
+    auto guard = get_function_creation_guard(
+        {llvm::PointerType::get(get_runtime_type("RuntimeContext"), 0),
+         llvm::Type::getInt8PtrTy(*llvm_context),
+         tlctx->get_data_type<int>(), tlctx->get_data_type<int>()});
+
+    auto *loop_test_bb =
+        llvm::BasicBlock::Create(*llvm_context, "block_loop_test", func);
+    auto *loop_body_bb =
+        llvm::BasicBlock::Create(*llvm_context, "block_loop_body", func);
+    auto *loop_exit_bb =
+        llvm::BasicBlock::Create(*llvm_context, "block_loop_exit", func);
+    auto *loop_index =
+        create_entry_block_alloca(llvm::Type::getInt32Ty(*llvm_context));
+    builder->CreateStore(get_arg(2), loop_index);
+    builder->CreateBr(loop_test_bb);
+
+    builder->SetInsertPoint(loop_test_bb);
+    auto *index = builder->CreateLoad(builder->getInt32Ty(), loop_index);
+    builder->CreateCondBr(builder->CreateICmpSLT(index, get_arg(3)),
+                          loop_body_bb, loop_exit_bb);
+
+    builder->SetInsertPoint(loop_body_bb);
+    builder->CreateCall(body, {get_arg(0), get_arg(1), index});
+    builder->CreateStore(builder->CreateAdd(index, tlctx->get_constant(1)),
+                         loop_index);
+    builder->CreateBr(loop_test_bb);
+
+    builder->SetInsertPoint(loop_exit_bb);
+    return guard.body;
+  }
+
   void create_offload_mesh_for(OffloadedStmt *stmt) override {
     auto *tls_prologue = create_mesh_xlogue(stmt->tls_prologue);
 
@@ -2442,12 +2442,14 @@ void TaskCodeGenLLVM::visit(AdStackAllocaStmt *stmt) {
 }
 
 void TaskCodeGenLLVM::visit(AdStackPopStmt *stmt) {
-  call("stack_pop", llvm_val[stmt->stack]);
+  call("stack_pop", get_context(), llvm_val[stmt->stack]);
 }
 
 void TaskCodeGenLLVM::visit(AdStackPushStmt *stmt) {
   auto stack = stmt->stack->as<AdStackAllocaStmt>();
-  call("stack_push", llvm_val[stack], tlctx->get_constant(stack->max_size),
+  // |max_size| entries are inline, the stack grows beyond them at runtime.
+  call("stack_push", get_context(), llvm_val[stack],
+       tlctx->get_constant(stack->max_size),
        tlctx->get_constant(stack->element_size_in_bytes()));
   auto primal_ptr = call("stack_top_primal", llvm_val[stack],
                          tlctx->get_constant(stack->element_size_in_bytes()));
@@ -74,13 +74,20 @@ const CompiledKernelData &KernelCompilationManager::load_or_compile(
     const Kernel &kernel_def) {
   auto cache_mode = get_cache_mode(compile_config, kernel_def);
   const auto kernel_key = make_kernel_key(compile_config, caps, kernel_def);
-  auto cached_kernel = try_load_cached_kernel(kernel_def, kernel_key,
-                                              compile_config.arch, cache_mode);
+  auto cached_kernel = try_load_cached_kernel(
+      kernel_def.get_name(), kernel_key, compile_config.arch, cache_mode);
   return cached_kernel ? *cached_kernel
                        : compile_and_cache_kernel(kernel_key, compile_config,
                                                   caps, kernel_def);
 }
 
+const CompiledKernelData *KernelCompilationManager::load_cached_kernel(
+    const std::string &kernel_key,
+    Arch arch) {
+  return try_load_cached_kernel(kernel_key, kernel_key, arch,
+                                CacheData::MemAndDiskCache);
+}
+
 void KernelCompilationManager::dump() {
   if (caching_kernels_.empty()) {
     return;
@@ -196,7 +203,7 @@ std::string KernelCompilationManager::make_kernel_key(
 }
 
 const CompiledKernelData *KernelCompilationManager::try_load_cached_kernel(
-    const Kernel &kernel_def,
+    const std::string &kernel_name,
     const std::string &kernel_key,
     Arch arch,
     CacheData::CacheMode cache_mode) {
@@ -205,7 +212,7 @@ const CompiledKernelData *KernelCompilationManager::try_load_cached_kernel(
     auto iter = kernels.find(kernel_key);
     if (iter != kernels.end()) {
       TI_DEBUG("Create kernel '{}' from in-memory cache (key='{}')",
-               kernel_def.get_name(), kernel_key);
+               kernel_name, kernel_key);
       return iter->second.compiled_kernel_data.get();
     }
   }
@@ -216,12 +223,12 @@ const CompiledKernelData *KernelCompilationManager::try_load_cached_kernel(
     if (iter != kernels.end()) {
       auto &k = iter->second;
       if (k.compiled_kernel_data) {
-        TI_DEBUG("Create kernel '{}' from cache (key='{}')",
-                 kernel_def.get_name(), kernel_key);
+        TI_DEBUG("Create kernel '{}' from cache (key='{}')", kernel_name,
+                 kernel_key);
         return k.compiled_kernel_data.get();
       } else if (auto loaded = load_ckd(kernel_key, arch)) {
-        TI_DEBUG("Create kernel '{}' from cache (key='{}')",
-                 kernel_def.get_name(), kernel_key);
+        TI_DEBUG("Create kernel '{}' from cache (key='{}')", kernel_name,
+                 kernel_key);
         TI_ASSERT(loaded->arch() == arch);
         k.last_used_at = std::time(nullptr);
         k.compiled_kernel_data = std::move(loaded);
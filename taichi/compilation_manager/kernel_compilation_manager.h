@@ -63,6 +63,10 @@ class KernelCompilationManager final {
                                             const DeviceCapabilityConfig &caps,
                                             const Kernel &kernel_def);
 
+  // Load from memory || Load from disk, nullptr if the kernel is not cached
+  const CompiledKernelData *load_cached_kernel(const std::string &kernel_key,
+                                               Arch arch);
+
   // Dump the cached data in memory to disk
   void dump();
 
@@ -84,7 +88,7 @@ class KernelCompilationManager final {
                               const Kernel &kernel_def) const;
 
   const CompiledKernelData *try_load_cached_kernel(
-      const Kernel &kernel_def,
+      const std::string &kernel_name,
       const std::string &kernel_key,
       Arch arch,
       CacheData::CacheMode cache_mode);
@@ -127,6 +127,14 @@ void FrontendForStmt::init_config(Arch arch, const ForLoopConfig &config) {
   strictly_serialized = config.strictly_serialized;
   mem_access_opt = config.mem_access_opt;
   block_dim = config.block_dim;
+  if (block_dim == 0 && config.tile_sizes && !config.tile_sizes->empty() &&
+      arch_is_cpu(arch)) {
+    // Let each CPU thread grab whole tiles.
+    block_dim = 1;
+    for (int size : *config.tile_sizes) {
+      block_dim *= size;
+    }
+  }
   if (arch == Arch::cuda || arch == Arch::amdgpu) {
     num_cpu_threads = 1;
     TI_ASSERT(block_dim <= taichi_max_gpu_block_dim);
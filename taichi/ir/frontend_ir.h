@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,10 @@ struct ForLoopConfig {
   MemoryAccessOptions mem_access_opt;
   int block_dim{0};
   bool uniform{false};
+  // Tile sizes of an ndrange-for. The ndrange is traversed tile by tile, with
+  // the tiles and the elements of each tile in row-major order. Empty if the
+  // tile sizes are left to the frontend.
+  std::optional<std::vector<int>> tile_sizes;
 };
 
 #define TI_DEFINE_CLONE_FOR_FRONTEND_IR                \
@@ -1027,6 +1032,7 @@ class ASTBuilder {
       config.mem_access_opt.clear();
       config.block_dim = 0;
       config.strictly_serialized = false;
+      config.tile_sizes.reset();
     }
   };
 
@@ -1178,6 +1184,17 @@ class ASTBuilder {
     for_loop_dec_.config.block_dim = v;
   }
 
+  void tile(const std::vector<int> &tile_sizes) {
+    for (int size : tile_sizes) {
+      TI_ASSERT(size > 0);
+    }
+    for_loop_dec_.config.tile_sizes = tile_sizes;
+  }
+
+  std::optional<std::vector<int>> get_loop_tile_sizes() const {
+    return for_loop_dec_.config.tile_sizes;
+  }
+
   void insert_snode_access_flag(SNodeAccessFlag v, const Expr &field) {
     for_loop_dec_.config.mem_access_opt.add_flag(field.snode(), v);
   }
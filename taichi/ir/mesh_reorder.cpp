@@ -0,0 +1,610 @@
+#include "taichi/ir/mesh_reorder.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+namespace taichi::lang {
+namespace mesh {
+
+namespace {
+
+// Local indices and relation offsets are stored as u16 by MeshMetadata.
+constexpr int kMaxLocalIndex = 65535;
+
+// Element-to-element relation in compressed rows.
+struct Csr {
+  std::vector<int> offsets{0};
+  std::vector<int> values;
+
+  int num_rows() const {
+    return (int)offsets.size() - 1;
+  }
+
+  const int *begin(int i) const {
+    return values.data() + offsets[i];
+  }
+
+  const int *end(int i) const {
+    return values.data() + offsets[i + 1];
+  }
+};
+
+Csr transpose(const Csr &a, int num_cols) {
+  Csr t;
+  t.offsets.assign(num_cols + 1, 0);
+  for (int v : a.values) {
+    t.offsets[v + 1]++;
+  }
+  std::partial_sum(t.offsets.begin(), t.offsets.end(), t.offsets.begin());
+  t.values.resize(a.values.size());
+  std::vector<int> fill(t.offsets.begin(), t.offsets.end() - 1);
+  for (int i = 0; i < a.num_rows(); i++) {
+    for (auto *v = a.begin(i); v != a.end(i); ++v) {
+      t.values[fill[*v]++] = i;
+    }
+  }
+  return t;
+}
+
+// The rows of a * b without the diagonal, i.e. the elements sharing an
+// element of the intermediate order.
+Csr two_hop(const Csr &a, const Csr &b) {
+  Csr c;
+  std::vector<int> marker(a.num_rows(), -1);
+  for (int i = 0; i < a.num_rows(); i++) {
+    marker[i] = i;
+    for (auto *k = a.begin(i); k != a.end(i); ++k) {
+      for (auto *j = b.begin(*k); j != b.end(*k); ++j) {
+        if (marker[*j] != i) {
+          marker[*j] = i;
+          c.values.push_back(*j);
+        }
+      }
+    }
+    c.offsets.push_back((int)c.values.size());
+  }
+  return c;
+}
+
+// Subsets of |k| out of |n| positions, in lexicographic order.
+std::vector<std::vector<int>> combinations(int n, int k) {
+  std::vector<std::vector<int>> result;
+  std::vector<int> current;
+  std::function<void(int)> visit = [&](int first) {
+    if ((int)current.size() == k) {
+      result.push_back(current);
+      return;
+    }
+    for (int i = first; i < n; i++) {
+      current.push_back(i);
+      visit(i + 1);
+      current.pop_back();
+    }
+  };
+  visit(0);
+  return result;
+}
+
+struct KeyHash {
+  std::size_t operator()(const std::array<int, 3> &key) const {
+    std::size_t h = 0;
+    for (int v : key) {
+      h = h * 1000003u ^ std::hash<int>()(v);
+    }
+    return h;
+  }
+};
+
+std::vector<std::array<uint32, 3>> quantize(
+    const std::vector<float64> &points) {
+  TI_ERROR_IF(points.size() % 3 != 0,
+              "Expected 3D points, got {} coordinates", points.size());
+  const int n = (int)points.size() / 3;
+  std::array<float64, 3> lower{}, upper{};
+  for (int d = 0; d < 3; d++) {
+    lower[d] = n ? points[d] : 0;
+    upper[d] = lower[d];
+  }
+  for (int i = 0; i < n; i++) {
+    for (int d = 0; d < 3; d++) {
+      lower[d] = std::min(lower[d], points[i * 3 + d]);
+      upper[d] = std::max(upper[d], points[i * 3 + d]);
+    }
+  }
+  // 21 bits per axis, so that a Morton or Hilbert key fits in 64 bits.
+  constexpr float64 kMaxCoord = (1 << 21) - 1;
+  std::vector<std::array<uint32, 3>> result(n);
+  for (int i = 0; i < n; i++) {
+    for (int d = 0; d < 3; d++) {
+      const float64 extent = upper[d] - lower[d];
+      result[i][d] =
+          extent > 0
+              ? uint32((points[i * 3 + d] - lower[d]) / extent * kMaxCoord)
+              : 0;
+    }
+  }
+  return result;
+}
+
+std::vector<int> sort_by_keys(const std::vector<uint64> &keys) {
+  std::vector<int> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return keys[a] < keys[b]; });
+  return order;
+}
+
+uint64 spread_bits(uint32 v) {
+  uint64 x = v & 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+// Skilling, Programming the Hilbert curve, AIP Conference Proceedings 2004.
+uint64 hilbert_key(std::array<uint32, 3> x) {
+  constexpr int kBits = 21;
+  // Inverse undo.
+  for (uint32 q = 1u << (kBits - 1); q > 1; q >>= 1) {
+    const uint32 p = q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (x[i] & q) {
+        x[0] ^= p;
+      } else {
+        const uint32 t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  // Gray encode.
+  for (int i = 1; i < 3; i++) {
+    x[i] ^= x[i - 1];
+  }
+  uint32 t = 0;
+  for (uint32 q = 1u << (kBits - 1); q > 1; q >>= 1) {
+    if (x[2] & q) {
+      t ^= q - 1;
+    }
+  }
+  uint64 key = 0;
+  for (int bit = kBits - 1; bit >= 0; bit--) {
+    for (int i = 0; i < 3; i++) {
+      key = key << 1 | (((x[i] ^ t) >> bit) & 1);
+    }
+  }
+  return key;
+}
+
+}  // namespace
+
+std::vector<int> reverse_cuthill_mckee(const std::vector<int> &offsets,
+                                       const std::vector<int> &neighbors) {
+  const int n = (int)offsets.size() - 1;
+  auto degree = [&](int i) { return offsets[i + 1] - offsets[i]; };
+  auto by_degree = [&](int a, int b) { return degree(a) < degree(b); };
+
+  // Breadth-first search within the unvisited nodes. Returns the
+  // eccentricity of |root| and the node of minimum degree in its last level.
+  std::vector<int> mark(n, -1), queue;
+  int num_searches = 0;
+  auto search = [&](int root, int &farthest) {
+    const int id = num_searches++;
+    queue.assign(1, root);
+    mark[root] = id;
+    int depth = 0;
+    for (std::size_t level = 0; level < queue.size();) {
+      const std::size_t level_end = queue.size();
+      farthest = *std::min_element(queue.begin() + level, queue.end(),
+                                   by_degree);
+      for (std::size_t k = level; k < level_end; k++) {
+        const int u = queue[k];
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+          const int v = neighbors[e];
+          if (mark[v] != id && mark[v] != -2) {
+            mark[v] = id;
+            queue.push_back(v);
+          }
+        }
+      }
+      level = level_end;
+      if (level < queue.size()) {
+        depth++;
+      }
+    }
+    return depth;
+  };
+
+  std::vector<int> seeds(n);
+  std::iota(seeds.begin(), seeds.end(), 0);
+  std::stable_sort(seeds.begin(), seeds.end(), by_degree);
+
+  std::vector<int> order;
+  order.reserve(n);
+  std::vector<int> next;
+  for (int seed : seeds) {
+    if (mark[seed] == -2) {
+      continue;
+    }
+    // George-Liu pseudo-peripheral node of the component of |seed|.
+    int root = seed, farthest = seed;
+    int eccentricity = search(root, farthest);
+    while (true) {
+      int candidate = farthest;
+      const int e = search(farthest, candidate);
+      if (e <= eccentricity) {
+        break;
+      }
+      root = farthest;
+      farthest = candidate;
+      eccentricity = e;
+    }
+
+    // Cuthill-McKee from |root|, visited nodes are marked -2.
+    std::size_t head = order.size();
+    order.push_back(root);
+    mark[root] = -2;
+    while (head < order.size()) {
+      const int u = order[head++];
+      next.clear();
+      for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+        const int v = neighbors[e];
+        if (mark[v] != -2) {
+          mark[v] = -2;
+          next.push_back(v);
+        }
+      }
+      std::stable_sort(next.begin(), next.end(), by_degree);
+      order.insert(order.end(), next.begin(), next.end());
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+std::vector<int> morton_order(const std::vector<float64> &points) {
+  auto coords = quantize(points);
+  std::vector<uint64> keys(coords.size());
+  for (std::size_t i = 0; i < coords.size(); i++) {
+    keys[i] = spread_bits(coords[i][0]) | spread_bits(coords[i][1]) << 1 |
+              spread_bits(coords[i][2]) << 2;
+  }
+  return sort_by_keys(keys);
+}
+
+std::vector<int> hilbert_order(const std::vector<float64> &points) {
+  auto coords = quantize(points);
+  std::vector<uint64> keys(coords.size());
+  for (std::size_t i = 0; i < coords.size(); i++) {
+    keys[i] = hilbert_key(coords[i]);
+  }
+  return sort_by_keys(keys);
+}
+
+std::vector<int> partition_patches(
+    const std::vector<int> &offsets,
+    const std::vector<int> &neighbors,
+    const std::vector<int> &order,
+    int max_patch_size,
+    std::vector<std::vector<int>> &patch_nodes) {
+  TI_ASSERT(max_patch_size > 0);
+  const int n = (int)offsets.size() - 1;
+  TI_ASSERT((int)order.size() == n);
+  std::vector<int> rank(n);
+  for (int i = 0; i < n; i++) {
+    rank[order[i]] = i;
+  }
+
+  using Entry = std::pair<int, int>;  // (rank, node)
+  std::vector<int> patch(n, -1), queued(n, -1);
+  patch_nodes.clear();
+  for (int seed : order) {
+    if (patch[seed] != -1) {
+      continue;
+    }
+    const int p = (int)patch_nodes.size();
+    auto &nodes = patch_nodes.emplace_back();
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+        frontier;
+    frontier.emplace(rank[seed], seed);
+    queued[seed] = p;
+    while (!frontier.empty() && (int)nodes.size() < max_patch_size) {
+      const int u = frontier.top().second;
+      frontier.pop();
+      patch[u] = p;
+      nodes.push_back(u);
+      for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+        const int v = neighbors[e];
+        if (patch[v] == -1 && queued[v] != p) {
+          queued[v] = p;
+          frontier.emplace(rank[v], v);
+        }
+      }
+    }
+  }
+  return patch;
+}
+
+MeshPatchData build_mesh_patches(
+    MeshTopology topology,
+    const std::vector<int> &cells,
+    const std::vector<float64> &positions,
+    const std::string &reorder,
+    int max_cells_per_patch,
+    const std::vector<MeshRelationType> &relations) {
+  const int top = topology == MeshTopology::Tetrahedron ? 3 : 2;
+  const int verts_per_cell = top + 1;
+  TI_ERROR_IF(cells.size() % verts_per_cell != 0,
+              "Expected {} vertices per cell, got {} indices in total",
+              verts_per_cell, cells.size());
+  TI_ERROR_IF(positions.size() % 3 != 0,
+              "Expected 3D vertex positions, got {} coordinates",
+              positions.size());
+  TI_ERROR_IF(max_cells_per_patch <= 0,
+              "max_cells_per_patch must be positive, got {}",
+              max_cells_per_patch);
+  const int num_verts = (int)positions.size() / 3;
+  for (int v : cells) {
+    TI_ERROR_IF(v < 0 || v >= num_verts,
+                "Cell vertex index {} out of range [0, {})", v, num_verts);
+  }
+
+  // The vertices of every element, |order + 1| per element.
+  std::vector<std::vector<int>> element_verts(top + 1);
+  element_verts[0].resize(num_verts);
+  std::iota(element_verts[0].begin(), element_verts[0].end(), 0);
+  element_verts[top] = cells;
+  std::vector<std::unordered_map<std::array<int, 3>, int, KeyHash>> ids(top);
+  auto key_of = [](const int *verts, const std::vector<int> &subset) {
+    std::array<int, 3> key{-1, -1, -1};
+    for (std::size_t k = 0; k < subset.size(); k++) {
+      key[k] = verts[subset[k]];
+    }
+    std::sort(key.begin(), key.begin() + subset.size());
+    return key;
+  };
+  for (int order = 1; order < top; order++) {
+    const auto subsets = combinations(verts_per_cell, order + 1);
+    for (std::size_t c = 0; c < cells.size(); c += verts_per_cell) {
+      for (const auto &subset : subsets) {
+        const auto key = key_of(cells.data() + c, subset);
+        const int id = (int)ids[order].size();
+        if (ids[order].emplace(key, id).second) {
+          element_verts[order].insert(element_verts[order].end(), key.begin(),
+                                      key.begin() + order + 1);
+        }
+      }
+    }
+  }
+  std::vector<int> num_elements(top + 1);
+  for (int order = 0; order <= top; order++) {
+    num_elements[order] = (int)element_verts[order].size() / (order + 1);
+  }
+
+  // rel[a][b] relates global elements of order a to those of order b.
+  std::vector<std::vector<Csr>> rel(top + 1, std::vector<Csr>(top + 1));
+  for (int a = 1; a <= top; a++) {
+    for (int b = 0; b < a; b++) {
+      const auto subsets = combinations(a + 1, b + 1);
+      Csr &down = rel[a][b];
+      for (int i = 0; i < num_elements[a]; i++) {
+        const int *verts = element_verts[a].data() + i * (a + 1);
+        for (const auto &subset : subsets) {
+          down.values.push_back(
+              b == 0 ? verts[subset[0]]
+                     : ids[b].find(key_of(verts, subset))->second);
+        }
+        down.offsets.push_back((int)down.values.size());
+      }
+      rel[b][a] = transpose(down, num_elements[b]);
+    }
+  }
+  // Vertices are adjacent through edges, higher elements through their
+  // facets.
+  rel[0][0] = two_hop(rel[0][1], rel[1][0]);
+  for (int a = 1; a <= top; a++) {
+    rel[a][a] = two_hop(rel[a][a - 1], rel[a - 1][a]);
+  }
+
+  const int num_cells = num_elements[top];
+  const Csr &cell_graph = rel[top][top];
+  std::vector<int> cell_order;
+  if (reorder == "none") {
+    cell_order.resize(num_cells);
+    std::iota(cell_order.begin(), cell_order.end(), 0);
+  } else if (reorder == "rcm") {
+    cell_order = reverse_cuthill_mckee(cell_graph.offsets, cell_graph.values);
+  } else if (reorder == "morton" || reorder == "hilbert") {
+    std::vector<float64> centroids(num_cells * 3, 0);
+    for (int c = 0; c < num_cells; c++) {
+      for (int k = 0; k < verts_per_cell; k++) {
+        const int v = cells[c * verts_per_cell + k];
+        for (int d = 0; d < 3; d++) {
+          centroids[c * 3 + d] += positions[v * 3 + d] / verts_per_cell;
+        }
+      }
+    }
+    cell_order = reorder == "morton" ? morton_order(centroids)
+                                     : hilbert_order(centroids);
+  } else {
+    TI_ERROR(
+        "Unknown mesh reordering '{}', expected one of none, rcm, morton and "
+        "hilbert",
+        reorder);
+  }
+  std::vector<std::vector<int>> patch_cells;
+  const auto cell_patch =
+      partition_patches(cell_graph.offsets, cell_graph.values, cell_order,
+                        max_cells_per_patch, patch_cells);
+  const int num_patches = (int)patch_cells.size();
+
+  // Each element is owned by the first patch of its cells, and comes in the
+  // reordered index space in the order its owner touches it.
+  std::vector<std::vector<int>> owned(top + 1), owned_offsets(top + 1);
+  std::vector<std::vector<int>> g2r(top + 1);
+  for (int order = 0; order <= top; order++) {
+    g2r[order].assign(num_elements[order], -1);
+  }
+  for (int p = 0; p < num_patches; p++) {
+    for (int order = 0; order <= top; order++) {
+      owned_offsets[order].push_back((int)owned[order].size());
+    }
+    for (int c : patch_cells[p]) {
+      g2r[top][c] = (int)owned[top].size();
+      owned[top].push_back(c);
+      for (int order = 0; order < top; order++) {
+        for (auto *e = rel[top][order].begin(c); e != rel[top][order].end(c);
+             ++e) {
+          if (g2r[order][*e] != -1) {
+            continue;
+          }
+          int owner = num_patches;
+          const Csr &up = rel[order][top];
+          for (auto *d = up.begin(*e); d != up.end(*e); ++d) {
+            owner = std::min(owner, cell_patch[*d]);
+          }
+          if (owner == p) {
+            g2r[order][*e] = (int)owned[order].size();
+            owned[order].push_back(*e);
+          }
+        }
+      }
+    }
+  }
+  for (int order = 0; order <= top; order++) {
+    owned_offsets[order].push_back((int)owned[order].size());
+  }
+
+  MeshPatchData data;
+  data.num_patches = num_patches;
+  data.elements.resize(top + 1);
+  for (int order = 0; order <= top; order++) {
+    auto &element = data.elements[order];
+    element.order = order;
+    element.num = num_elements[order];
+    element.owned_offsets.assign(owned_offsets[order].begin(),
+                                 owned_offsets[order].end());
+    element.total_offsets.push_back(0);
+    element.g2r_mapping.assign(g2r[order].begin(), g2r[order].end());
+  }
+  std::vector<std::pair<int, int>> emitted;
+  for (int a = 0; a <= top; a++) {
+    for (int b = 0; b <= top; b++) {
+      const auto type = relation_by_orders(a, b);
+      if (relations.empty() || std::find(relations.begin(), relations.end(),
+                                         type) != relations.end()) {
+        emitted.emplace_back(a, b);
+        auto &relation = data.relations.emplace_back();
+        relation.from_order = a;
+        relation.to_order = b;
+      }
+    }
+  }
+
+  // The local elements of a patch are its owned elements followed by the
+  // ribbon: the elements related to owned ones, closed under high-to-low
+  // relations so that those are defined for every local element.
+  std::vector<std::vector<int>> local(top + 1), local_index(top + 1),
+      stamp(top + 1);
+  for (int order = 0; order <= top; order++) {
+    local_index[order].resize(num_elements[order]);
+    stamp[order].assign(num_elements[order], -1);
+  }
+  std::vector<int> num_owned(top + 1);
+  for (int p = 0; p < num_patches; p++) {
+    auto add = [&](int order, int e) {
+      if (stamp[order][e] != p) {
+        stamp[order][e] = p;
+        local_index[order][e] = (int)local[order].size();
+        local[order].push_back(e);
+      }
+    };
+    for (int order = 0; order <= top; order++) {
+      local[order].clear();
+      for (int k = owned_offsets[order][p]; k < owned_offsets[order][p + 1];
+           k++) {
+        add(order, owned[order][k]);
+      }
+      num_owned[order] = (int)local[order].size();
+    }
+    for (int a = 0; a <= top; a++) {
+      for (int i = 0; i < num_owned[a]; i++) {
+        for (int b = 0; b <= top; b++) {
+          const int e = local[a][i];
+          for (auto *n = rel[a][b].begin(e); n != rel[a][b].end(e); ++n) {
+            add(b, *n);
+          }
+        }
+      }
+    }
+    for (int a = top; a > 0; a--) {
+      for (std::size_t i = 0; i < local[a].size(); i++) {
+        const int e = local[a][i];
+        for (int b = 0; b < a; b++) {
+          for (auto *n = rel[a][b].begin(e); n != rel[a][b].end(e); ++n) {
+            add(b, *n);
+          }
+        }
+      }
+    }
+
+    for (int order = 0; order <= top; order++) {
+      auto &element = data.elements[order];
+      const int total = (int)local[order].size();
+      TI_ERROR_IF(total > kMaxLocalIndex + 1,
+                  "Patch {} has {} local {}, more than the 16-bit local "
+                  "indices can address. Please reduce max_cells_per_patch.",
+                  p, total, element_type_name(MeshElementType(order)));
+      element.max_num_per_patch = std::max(element.max_num_per_patch, total);
+      element.l2g_mapping.insert(element.l2g_mapping.end(),
+                                 local[order].begin(), local[order].end());
+      element.total_offsets.push_back((uint32)element.l2g_mapping.size());
+    }
+    for (std::size_t r = 0; r < emitted.size(); r++) {
+      const auto [a, b] = emitted[r];
+      auto &relation = data.relations[r];
+      const Csr &csr = rel[a][b];
+      if (a > b) {
+        for (int e : local[a]) {
+          for (auto *n = csr.begin(e); n != csr.end(e); ++n) {
+            relation.value.push_back(local_index[b][*n]);
+          }
+        }
+        continue;
+      }
+      const std::size_t base = relation.value.size();
+      relation.patch_offset.push_back((uint32)base);
+      for (int i = 0; i < num_owned[a]; i++) {
+        const int e = local[a][i];
+        relation.offset.push_back(uint32(relation.value.size() - base));
+        for (auto *n = csr.begin(e); n != csr.end(e); ++n) {
+          relation.value.push_back(local_index[b][*n]);
+        }
+      }
+      relation.offset.push_back(uint32(relation.value.size() - base));
+      TI_ERROR_IF(relation.value.size() - base > kMaxLocalIndex,
+                  "Patch {} has {} entries of relation {}, more than the "
+                  "16-bit offsets can address. Please reduce "
+                  "max_cells_per_patch.",
+                  p, relation.value.size() - base,
+                  relation_type_name(relation_by_orders(a, b)));
+    }
+  }
+  for (auto &element : data.elements) {
+    element.l2r_mapping.resize(element.l2g_mapping.size());
+    for (std::size_t i = 0; i < element.l2g_mapping.size(); i++) {
+      element.l2r_mapping[i] = element.g2r_mapping[element.l2g_mapping[i]];
+    }
+  }
+  return data;
+}
+
+}  // namespace mesh
+}  // namespace taichi::lang
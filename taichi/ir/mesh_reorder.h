@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "taichi/ir/mesh.h"
+
+namespace taichi::lang {
+namespace mesh {
+
+// The orderings below return permutations |order| where order[i] is the old
+// index of the element placed at position i.
+
+// Reverse Cuthill-McKee ordering of the graph whose node |i| is adjacent to
+// neighbors[offsets[i]] ... neighbors[offsets[i + 1] - 1].
+std::vector<int> reverse_cuthill_mckee(const std::vector<int> &offsets,
+                                       const std::vector<int> &neighbors);
+
+// Orders 3D points (x0, y0, z0, x1, ...) along a space-filling curve.
+std::vector<int> morton_order(const std::vector<float64> &points);
+std::vector<int> hilbert_order(const std::vector<float64> &points);
+
+// Greedily grows patches of at most |max_patch_size| connected nodes, seeded
+// in |order| and always absorbing the frontier node that comes first in
+// |order|. Returns the patch of each node; the nodes of each patch are
+// appended to |patch_nodes| in the order they were absorbed.
+std::vector<int> partition_patches(const std::vector<int> &offsets,
+                                   const std::vector<int> &neighbors,
+                                   const std::vector<int> &order,
+                                   int max_patch_size,
+                                   std::vector<std::vector<int>> &patch_nodes);
+
+struct MeshPatchElement {
+  int order{0};
+  int num{0};
+  int max_num_per_patch{0};
+  std::vector<uint32> owned_offsets;
+  std::vector<uint32> total_offsets;
+  std::vector<uint32> l2g_mapping;
+  std::vector<uint32> l2r_mapping;
+  std::vector<uint32> g2r_mapping;
+};
+
+struct MeshPatchRelation {
+  int from_order{0};
+  int to_order{0};
+  std::vector<uint32> value;
+  // Only for low-to-high and same-order relations.
+  std::vector<uint32> offset;
+  std::vector<uint32> patch_offset;
+};
+
+// The patched mesh, in the layout of the MeshTaichi metadata.
+struct MeshPatchData {
+  int num_patches{0};
+  std::vector<MeshPatchElement> elements;
+  std::vector<MeshPatchRelation> relations;
+};
+
+/**
+ * Builds the patches, index mappings and local relations of a triangle or
+ * tetrahedral mesh given by the vertex indices of its cells.
+ *
+ * The cells are ordered with |reorder| ("none", "rcm", "morton" or
+ * "hilbert") and then partitioned into patches of at most
+ * |max_cells_per_patch| cells. The reordered index space stores the owned
+ * elements of each patch contiguously, in the order the patch first touches
+ * them, which is what optimize_mesh_reordered_mapping relies on.
+ *
+ * @param relations The relations to emit, all of them if empty.
+ */
+MeshPatchData build_mesh_patches(
+    MeshTopology topology,
+    const std::vector<int> &cells,
+    const std::vector<float64> &positions,
+    const std::string &reorder,
+    int max_cells_per_patch,
+    const std::vector<MeshRelationType> &relations = {});
+
+}  // namespace mesh
+}  // namespace taichi::lang
@@ -1762,7 +1762,8 @@ class TextureOpStmt : public Stmt {
 };
 
 /**
- * A local AD-stack.
+ * A local AD-stack. The first |max_size| entries are allocated with the
+ * stack, the LLVM backends grow it beyond them at runtime.
  */
 class AdStackAllocaStmt : public Stmt {
  public:
@@ -1783,8 +1784,10 @@ class AdStackAllocaStmt : public Stmt {
     return element_size_in_bytes() * 2;
   }
 
+  // The header (size and current segment) followed by the inline entries,
+  // see stack_push in the LLVM runtime.
   std::size_t size_in_bytes() const {
-    return sizeof(int32) + entry_size_in_bytes() * max_size;
+    return sizeof(int64) * 2 + entry_size_in_bytes() * max_size;
   }
 
   bool has_global_side_effect() const override {
@@ -25,6 +25,9 @@ class TI_DLL_EXPORT ArgPack {
   intptr_t get_device_allocation_ptr_as_int() const;
   DeviceAllocation get_device_allocation() const;
   std::size_t get_nelement() const;
+  std::size_t get_nbytes() const {
+    return alloc_size_;
+  }
 
   TypedConstant read(const std::vector<int> &I) const;
   void write(const std::vector<int> &I, TypedConstant val) const;
@@ -38,6 +41,7 @@ class TI_DLL_EXPORT ArgPack {
 
  private:
   Program *prog_{nullptr};
+  std::size_t alloc_size_{0};
 
   DataType get_element_dt(const std::vector<int> &i) const;
 };
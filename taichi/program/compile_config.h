@@ -32,6 +32,8 @@ struct CompileConfig {
   bool verbose_kernel_launches;
   bool kernel_profiler;
   bool timeline{false};
+  // Defer kernel launches from Python to fuse consecutive compatible ones.
+  bool lazy_kernel_fusion{false};
   bool verbose;
   bool fast_math;
   bool flatten_if;
@@ -42,22 +44,43 @@ struct CompileConfig {
   bool force_scalarize_matrix;
   bool half2_vectorization;
   bool make_cpu_multithreading_loop;
+  // Emit the body of CPU range-fors as a loop over a whole chunk of indices,
+  // called once per chunk instead of once per index. Experimental: the body
+  // reloads its arguments from the RuntimeContext, so the loop is rarely
+  // vectorized.
+  bool cpu_vectorize_range_for{false};
   DataType default_fp;
   DataType default_ip;
   DataType default_up;
   std::string extra_flags;
   int default_cpu_block_dim;
   bool cpu_block_dim_adaptive;
+  // Traverse multi-dimensional ndrange-fors tile by tile on CPU when no tile
+  // sizes are given by ti.loop_config.
+  bool auto_tile_ndrange{false};
   int default_gpu_block_dim;
   int gpu_max_reg;
   int ad_stack_size{0};  // 0 = adaptive
   // The default size when the Taichi compiler is unable to automatically
-  // determine the autodiff stack size.
+  // determine the autodiff stack size. AD-stacks of the LLVM backends grow
+  // beyond it at runtime.
   int default_ad_stack_size{32};
+  // The bytes of AD-stacks a serial loop may use per thread in reverse-mode
+  // autodiff before it is checkpointed and recomputed segment by segment.
+  // 0 = unlimited.
+  int64 ad_stack_memory_budget{0};
 
   int saturating_grid_dim;
   int max_block_dim;
   int cpu_max_num_threads;
+  // Back the host memory chunks of at least |cpu_huge_page_min_size| bytes,
+  // e.g. SNode roots and ndarrays, with huge pages on CPU:
+  // "none"|"transparent"|"explicit_2m"|"explicit_1g".
+  std::string cpu_huge_pages{"none"};
+  int64 cpu_huge_page_min_size{32 << 20};
+  // The bytes of the released ndarray allocations kept by the LLVM backends
+  // for the following allocations of similar sizes. 0 = no caching.
+  int64 device_allocation_cache_size{512 << 20};
   int random_seed;
 
   // LLVM backend options:
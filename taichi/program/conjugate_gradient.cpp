@@ -1,5 +1,11 @@
 #include "conjugate_gradient.h"
 
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "Eigen/Dense"
+
 namespace taichi::lang {
 void CUCG::init_solver() {
 #if defined(TI_WITH_CUDA)
@@ -91,4 +97,536 @@ std::unique_ptr<CUCG> make_cucg_solver(SparseMatrix &A,
                                        bool verbose) {
   return std::make_unique<CUCG>(A, max_iters, tol, verbose);
 }
+
+namespace {
+
+using sparse_kernels::CompressedView;
+using sparse_kernels::parallel_for;
+using sparse_kernels::TaskSplit;
+
+// Number of vector entries handled by each task.
+constexpr int64 kEntriesPerTask = 1 << 14;
+
+template <typename F>
+void for_each_entry(int n, ThreadPool *pool, const F &func) {
+  TaskSplit split(pool, n, kEntriesPerTask);
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    for (int64 i = split.begin(task); i < split.end(task); i++) {
+      func(i);
+    }
+  });
+}
+
+// The partial sums are added in a fixed order so that the result does not
+// depend on the scheduling.
+template <typename T>
+T dot(const T *a, const T *b, int n, ThreadPool *pool) {
+  TaskSplit split(pool, n, kEntriesPerTask);
+  std::vector<T> partial(split.num_tasks());
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    T sum = 0;
+    for (int64 i = split.begin(task); i < split.end(task); i++) {
+      sum += a[i] * b[i];
+    }
+    partial[task] = sum;
+  });
+  return std::accumulate(partial.begin(), partial.end(), T(0));
+}
+
+template <typename T>
+class JacobiPreconditioner : public Preconditioner<T> {
+ public:
+  explicit JacobiPreconditioner(std::vector<T> &&diagonal)
+      : inv_diagonal_(std::move(diagonal)) {
+    for (std::size_t i = 0; i < inv_diagonal_.size(); i++) {
+      TI_ERROR_IF(inv_diagonal_[i] == T(0),
+                  "Jacobi preconditioner: zero diagonal entry at row {}", i);
+      inv_diagonal_[i] = T(1) / inv_diagonal_[i];
+    }
+  }
+
+  void apply(const T *r, T *z, ThreadPool *pool) const override {
+    const T *inv = inv_diagonal_.data();
+    for_each_entry((int)inv_diagonal_.size(), pool,
+                   [&](int64 i) { z[i] = inv[i] * r[i]; });
+  }
+
+ private:
+  std::vector<T> inv_diagonal_;
+};
+
+template <typename T>
+class BlockJacobiPreconditioner : public Preconditioner<T> {
+ public:
+  BlockJacobiPreconditioner(const CompressedView<T, int> &a, int block_size)
+      : n_(a.outer_size), block_size_(block_size) {
+    using DenseMatrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic,
+                                      Eigen::RowMajor>;
+    const int num_blocks = (n_ + block_size_ - 1) / block_size_;
+    inverses_.assign((std::size_t)num_blocks * block_size_ * block_size_, 0);
+    for (int block = 0; block < num_blocks; block++) {
+      const int begin = block * block_size_;
+      const int size = std::min(block_size_, n_ - begin);
+      DenseMatrix dense = DenseMatrix::Zero(size, size);
+      for (int row = begin; row < begin + size; row++) {
+        for (int k = a.outer[row]; k < a.outer[row + 1]; k++) {
+          const int col = a.inner[k];
+          if (col >= begin && col < begin + size) {
+            dense(row - begin, col - begin) = a.values[k];
+          }
+        }
+      }
+      Eigen::FullPivLU<DenseMatrix> lu(dense);
+      TI_ERROR_IF(!lu.isInvertible(),
+                  "Block-Jacobi preconditioner: singular diagonal block at "
+                  "row {}",
+                  begin);
+      Eigen::Map<DenseMatrix>(block_data(block), size, size) = lu.inverse();
+    }
+  }
+
+  void apply(const T *r, T *z, ThreadPool *pool) const override {
+    const int num_blocks = (n_ + block_size_ - 1) / block_size_;
+    TaskSplit split(pool, num_blocks, kEntriesPerTask / block_size_);
+    parallel_for(pool, split.num_tasks(), [&](int, int task) {
+      for (int64 block = split.begin(task); block < split.end(task);
+           block++) {
+        const int begin = block * block_size_;
+        const int size = std::min(block_size_, n_ - begin);
+        const T *inv = block_data(block);
+        for (int i = 0; i < size; i++) {
+          T sum = 0;
+          for (int j = 0; j < size; j++) {
+            sum += inv[i * size + j] * r[begin + j];
+          }
+          z[begin + i] = sum;
+        }
+      }
+    });
+  }
+
+ private:
+  // The inverse of a block of |size| rows is stored densely with a stride of
+  // |size|.
+  T *block_data(int64 block) {
+    return inverses_.data() + block * block_size_ * block_size_;
+  }
+
+  const T *block_data(int64 block) const {
+    return inverses_.data() + block * block_size_ * block_size_;
+  }
+
+  int n_{0};
+  int block_size_{1};
+  std::vector<T> inverses_;
+};
+
+// IC(0): A ~ L L^T where L has the pattern of the lower triangle of A.
+template <typename T>
+class IC0Preconditioner : public Preconditioner<T> {
+ public:
+  explicit IC0Preconditioner(const CompressedView<T, int> &a)
+      : n_(a.outer_size) {
+    outer_.resize(n_ + 1);
+    outer_[0] = 0;
+    for (int row = 0; row < n_; row++) {
+      for (int k = a.outer[row]; k < a.outer[row + 1] && a.inner[k] <= row;
+           k++) {
+        inner_.push_back(a.inner[k]);
+        values_.push_back(a.values[k]);
+      }
+      outer_[row + 1] = (int)inner_.size();
+      TI_ERROR_IF(outer_[row + 1] == outer_[row] || inner_.back() != row,
+                  "IC(0) preconditioner: missing diagonal entry at row {}",
+                  row);
+    }
+    factorize();
+  }
+
+  void apply(const T *r, T *z, ThreadPool *pool) const override {
+    // The triangular solves are sequential.
+    // L y = r
+    for (int row = 0; row < n_; row++) {
+      T sum = r[row];
+      const int diag = outer_[row + 1] - 1;
+      for (int k = outer_[row]; k < diag; k++) {
+        sum -= values_[k] * z[inner_[k]];
+      }
+      z[row] = sum / values_[diag];
+    }
+    // L^T z = y, in place.
+    for (int row = n_ - 1; row >= 0; row--) {
+      const int diag = outer_[row + 1] - 1;
+      const T zi = z[row] / values_[diag];
+      z[row] = zi;
+      for (int k = outer_[row]; k < diag; k++) {
+        z[inner_[k]] -= values_[k] * zi;
+      }
+    }
+  }
+
+ private:
+  void factorize() {
+    int num_breakdowns = 0;
+    for (int row = 0; row < n_; row++) {
+      const int begin = outer_[row];
+      const int diag = outer_[row + 1] - 1;
+      for (int k = begin; k <= diag; k++) {
+        const int col = inner_[k];
+        // Sum of L(row, j) L(col, j) for j < col in both patterns.
+        T sum = 0;
+        int p = begin;
+        int q = outer_[col];
+        const int q_end = outer_[col + 1] - 1;
+        while (p < k && q < q_end) {
+          if (inner_[p] < inner_[q]) {
+            p++;
+          } else if (inner_[p] > inner_[q]) {
+            q++;
+          } else {
+            sum += values_[p++] * values_[q++];
+          }
+        }
+        if (k < diag) {
+          values_[k] = (values_[k] - sum) / values_[q_end];
+        } else {
+          const T pivot = values_[k] - sum;
+          if (pivot > T(0)) {
+            values_[k] = std::sqrt(pivot);
+          } else {
+            // Falls back to the original diagonal entry, which keeps the
+            // factorization going on matrices that are not M-matrices.
+            TI_ERROR_IF(values_[k] <= T(0),
+                        "IC(0) preconditioner: non-positive diagonal entry at "
+                        "row {}",
+                        row);
+            values_[k] = std::sqrt(values_[k]);
+            num_breakdowns++;
+          }
+        }
+      }
+    }
+    if (num_breakdowns > 0) {
+      TI_WARN("IC(0) preconditioner: {} non-positive pivots replaced",
+              num_breakdowns);
+    }
+  }
+
+  int n_{0};
+  std::vector<int> outer_;
+  std::vector<int> inner_;
+  std::vector<T> values_;
+};
+
+template <typename T>
+std::unique_ptr<Preconditioner<T>> make_preconditioner(
+    PreconditionerType type,
+    const CompressedView<T, int> &a,
+    int block_size) {
+  switch (type) {
+    case PreconditionerType::kJacobi: {
+      std::vector<T> diagonal(a.outer_size, 0);
+      for (int row = 0; row < a.outer_size; row++) {
+        for (int k = a.outer[row]; k < a.outer[row + 1]; k++) {
+          if (a.inner[k] == row) {
+            diagonal[row] = a.values[k];
+          }
+        }
+      }
+      return std::make_unique<JacobiPreconditioner<T>>(std::move(diagonal));
+    }
+    case PreconditionerType::kBlockJacobi:
+      return std::make_unique<BlockJacobiPreconditioner<T>>(a, block_size);
+    case PreconditionerType::kIC0:
+      return std::make_unique<IC0Preconditioner<T>>(a);
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+template <typename T>
+KrylovSolver<T>::KrylovSolver(Program *prog,
+                              const std::string &method,
+                              const std::string &preconditioner,
+                              int max_iters,
+                              float tol,
+                              int block_size,
+                              bool verbose)
+    : prog_(prog),
+      pool_(prog->get_thread_pool()),
+      max_iters_(max_iters),
+      tol_(tol),
+      block_size_(block_size),
+      verbose_(verbose) {
+  TI_ERROR_IF(!arch_is_cpu(prog->compile_config().arch),
+              "KrylovSolver only supports the CPU backends");
+  static const std::unordered_map<std::string, KrylovMethod> methods = {
+      {"cg", KrylovMethod::kCG}, {"bicgstab", KrylovMethod::kBiCGSTAB}};
+  static const std::unordered_map<std::string, PreconditionerType>
+      preconditioners = {{"none", PreconditionerType::kNone},
+                         {"jacobi", PreconditionerType::kJacobi},
+                         {"block_jacobi", PreconditionerType::kBlockJacobi},
+                         {"ic0", PreconditionerType::kIC0}};
+  TI_ERROR_IF(methods.count(method) == 0, "Unknown Krylov method: {}",
+              method);
+  TI_ERROR_IF(preconditioners.count(preconditioner) == 0,
+              "Unknown preconditioner: {}", preconditioner);
+  TI_ERROR_IF(block_size < 1, "Invalid block size {}", block_size);
+  method_ = methods.at(method);
+  preconditioner_type_ = preconditioners.at(preconditioner);
+}
+
+template <typename T>
+T *KrylovSolver<T>::get_ndarray_data(const Ndarray &array, int n) const {
+  TI_ERROR_IF(data_type_size(array.get_element_data_type()) != sizeof(T) ||
+                  !is_real(array.get_element_data_type()),
+              "The ndarrays of a solve must share the data type of the solver");
+  TI_ERROR_IF((int)array.get_nelement() != n,
+              "Expected an ndarray of {} elements, got {}", n,
+              array.get_nelement());
+  return (T *)prog_->get_ndarray_data_ptr_as_int(&array);
+}
+
+template <typename T>
+bool KrylovSolver<T>::solve(SparseMatrix &A, const Ndarray &b, Ndarray &x) {
+  using ColMajor = EigenSparseMatrix<Eigen::SparseMatrix<T, Eigen::ColMajor>>;
+  using RowMajor = EigenSparseMatrix<Eigen::SparseMatrix<T, Eigen::RowMajor>>;
+  TI_ERROR_IF(A.num_rows() != A.num_cols(),
+              "KrylovSolver needs a square matrix, got {}x{}", A.num_rows(),
+              A.num_cols());
+  const int n = A.num_rows();
+  const T *b_data = get_ndarray_data(b, n);
+  T *x_data = get_ndarray_data(x, n);
+
+  Operator op;
+  if (auto *row_major = dynamic_cast<RowMajor *>(&A)) {
+    op = [row_major, this](const T *in, T *out) {
+      row_major->multiply_vector(in, out, pool_);
+    };
+    if (preconditioner_type_ != PreconditionerType::kNone) {
+      preconditioner_ = make_preconditioner(
+          preconditioner_type_, row_major->compressed_view(), block_size_);
+    }
+  } else if (auto *col_major = dynamic_cast<ColMajor *>(&A)) {
+    op = [col_major, this](const T *in, T *out) {
+      col_major->multiply_vector(in, out, pool_);
+    };
+    if (preconditioner_type_ != PreconditionerType::kNone) {
+      Eigen::SparseMatrix<T, Eigen::RowMajor> rows =
+          *(const Eigen::SparseMatrix<T> *)col_major->get_matrix();
+      rows.makeCompressed();
+      CompressedView<T, int> view;
+      view.outer_size = rows.outerSize();
+      view.inner_size = rows.innerSize();
+      view.outer = rows.outerIndexPtr();
+      view.inner = rows.innerIndexPtr();
+      view.values = rows.valuePtr();
+      preconditioner_ =
+          make_preconditioner(preconditioner_type_, view, block_size_);
+    }
+  } else {
+    TI_ERROR("KrylovSolver needs a CPU sparse matrix of type {}",
+             data_type_name(get_data_type<T>()));
+  }
+  operator_in_ = operator_out_ = nullptr;
+  return run(op, n, b_data, x_data);
+}
+
+template <typename T>
+bool KrylovSolver<T>::solve_matrix_free(const std::function<void()> &matvec,
+                                        Ndarray &in,
+                                        Ndarray &out,
+                                        const Ndarray *diagonal,
+                                        const Ndarray &b,
+                                        Ndarray &x) {
+  const int n = b.get_nelement();
+  const T *b_data = get_ndarray_data(b, n);
+  T *x_data = get_ndarray_data(x, n);
+  operator_in_ = get_ndarray_data(in, n);
+  operator_out_ = get_ndarray_data(out, n);
+
+  switch (preconditioner_type_) {
+    case PreconditionerType::kNone:
+      preconditioner_.reset();
+      break;
+    case PreconditionerType::kJacobi: {
+      TI_ERROR_IF(diagonal == nullptr,
+                  "The Jacobi preconditioner of a matrix-free solve needs "
+                  "the diagonal of the operator");
+      const T *d = get_ndarray_data(*diagonal, n);
+      preconditioner_ = std::make_unique<JacobiPreconditioner<T>>(
+          std::vector<T>(d, d + n));
+      break;
+    }
+    default:
+      TI_ERROR("Matrix-free solves only support the Jacobi preconditioner");
+  }
+
+  Operator op = [&](const T *src, T *dst) {
+    if (src != operator_in_) {
+      std::memcpy(operator_in_, src, sizeof(T) * n);
+    }
+    matvec();
+    // The kernel may have been deferred by lazy kernel fusion.
+    prog_->synchronize();
+    if (dst != operator_out_) {
+      std::memcpy(dst, operator_out_, sizeof(T) * n);
+    }
+  };
+  const bool success = run(op, n, b_data, x_data);
+  operator_in_ = operator_out_ = nullptr;
+  return success;
+}
+
+template <typename T>
+bool KrylovSolver<T>::run(const Operator &A, int n, const T *b, T *x) {
+  // At most 8 work vectors are used by BiCGSTAB.
+  work_.resize(8);
+  for (auto &v : work_) {
+    v.resize(n);
+  }
+  num_iterations_ = 0;
+  const bool success = method_ == KrylovMethod::kCG ? run_cg(A, n, b, x)
+                                                    : run_bicgstab(A, n, b, x);
+  if (verbose_) {
+    fmt::print("#iterations:     {}\n", num_iterations_);
+    fmt::print("residual norm:   {}\n", residual_norm_);
+  }
+  return success;
+}
+
+template <typename T>
+const T *KrylovSolver<T>::precondition(const T *r, std::vector<T> &z) {
+  if (!preconditioner_) {
+    return r;
+  }
+  preconditioner_->apply(r, z.data(), pool_);
+  return z.data();
+}
+
+template <typename T>
+bool KrylovSolver<T>::run_cg(const Operator &A, int n, const T *b, T *x) {
+  T *r = work_[0].data();
+  T *p = operator_in_ ? operator_in_ : work_[1].data();
+  T *q = operator_out_ ? operator_out_ : work_[2].data();
+
+  // r = b - A x
+  A(x, q);
+  for_each_entry(n, pool_, [&](int64 i) { r[i] = b[i] - q[i]; });
+  residual_norm_ = std::sqrt(dot(r, r, n, pool_));
+  if (residual_norm_ <= tol_) {
+    return true;
+  }
+  const T *z = precondition(r, work_[3]);
+  std::memcpy(p, z, sizeof(T) * n);
+  T rz = dot(r, z, n, pool_);
+
+  while (num_iterations_ < max_iters_) {
+    num_iterations_++;
+    // q = A p
+    A(p, q);
+    const T pq = dot(p, q, n, pool_);
+    if (pq == T(0)) {
+      return false;
+    }
+    const T alpha = rz / pq;
+    for_each_entry(n, pool_, [&](int64 i) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+    });
+    residual_norm_ = std::sqrt(dot(r, r, n, pool_));
+    if (residual_norm_ <= tol_) {
+      return true;
+    }
+    z = precondition(r, work_[3]);
+    const T rz_new = dot(r, z, n, pool_);
+    const T beta = rz_new / rz;
+    rz = rz_new;
+    // p = z + beta p
+    for_each_entry(n, pool_, [&](int64 i) { p[i] = z[i] + beta * p[i]; });
+  }
+  return false;
+}
+
+template <typename T>
+bool KrylovSolver<T>::run_bicgstab(const Operator &A,
+                                   int n,
+                                   const T *b,
+                                   T *x) {
+  // Right-preconditioned BiCGSTAB. A matrix-free operator copies its
+  // operands, as two of them are live at once.
+  T *r = work_[0].data();
+  T *r_hat = work_[1].data();
+  T *p = work_[2].data();
+  T *v = work_[3].data();
+  T *s = work_[4].data();
+  T *t = work_[5].data();
+
+  // r = b - A x
+  A(x, v);
+  for_each_entry(n, pool_, [&](int64 i) {
+    r[i] = b[i] - v[i];
+    r_hat[i] = r[i];
+  });
+  residual_norm_ = std::sqrt(dot(r, r, n, pool_));
+  if (residual_norm_ <= tol_) {
+    return true;
+  }
+
+  T rho = 1, alpha = 1, omega = 1;
+  while (num_iterations_ < max_iters_) {
+    num_iterations_++;
+    const T rho_new = dot(r_hat, r, n, pool_);
+    if (rho_new == T(0)) {
+      return false;
+    }
+    if (num_iterations_ == 1) {
+      std::memcpy(p, r, sizeof(T) * n);
+    } else {
+      const T beta = (rho_new / rho) * (alpha / omega);
+      for_each_entry(n, pool_, [&](int64 i) {
+        p[i] = r[i] + beta * (p[i] - omega * v[i]);
+      });
+    }
+    rho = rho_new;
+    // v = A M^-1 p
+    const T *p_hat = precondition(p, work_[6]);
+    A(p_hat, v);
+    const T r_hat_v = dot(r_hat, v, n, pool_);
+    if (r_hat_v == T(0)) {
+      return false;
+    }
+    alpha = rho / r_hat_v;
+    for_each_entry(n, pool_, [&](int64 i) {
+      x[i] += alpha * p_hat[i];
+      s[i] = r[i] - alpha * v[i];
+    });
+    residual_norm_ = std::sqrt(dot(s, s, n, pool_));
+    if (residual_norm_ <= tol_) {
+      return true;
+    }
+    // t = A M^-1 s
+    const T *s_hat = precondition(s, work_[7]);
+    A(s_hat, t);
+    const T tt = dot(t, t, n, pool_);
+    omega = tt == T(0) ? T(0) : dot(t, s, n, pool_) / tt;
+    for_each_entry(n, pool_, [&](int64 i) {
+      x[i] += omega * s_hat[i];
+      r[i] = s[i] - omega * t[i];
+    });
+    residual_norm_ = std::sqrt(dot(r, r, n, pool_));
+    if (residual_norm_ <= tol_) {
+      return true;
+    }
+    if (omega == T(0)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+template class KrylovSolver<float32>;
+template class KrylovSolver<float64>;
 }  // namespace taichi::lang
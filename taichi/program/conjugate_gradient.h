@@ -1,3 +1,10 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "sparse_matrix.h"
 
 #include "taichi/program/ndarray.h"
@@ -101,4 +108,106 @@ std::unique_ptr<CUCG> make_cucg_solver(SparseMatrix &A,
                                        int max_iters,
                                        float tol,
                                        bool verbose);
+
+enum class KrylovMethod { kCG, kBiCGSTAB };
+
+enum class PreconditionerType { kNone, kJacobi, kBlockJacobi, kIC0 };
+
+// Computes z = M^-1 r for an approximation M of the system matrix.
+template <typename T>
+class Preconditioner {
+ public:
+  virtual ~Preconditioner() = default;
+
+  virtual void apply(const T *r, T *z, ThreadPool *pool) const = 0;
+};
+
+/**
+ * Preconditioned CG and BiCGSTAB on the CPU backends.
+ *
+ * Unlike CG, the solver reads the right-hand side and updates the solution
+ * in the storage of the ndarrays, and multiplies by the matrix with the
+ * multithreaded SpMV of EigenSparseMatrix. The matrix can also be left
+ * unassembled, in which case a Taichi kernel applies the operator.
+ *
+ * Preconditioners:
+ *  - "jacobi" scales by the inverse of the diagonal,
+ *  - "block_jacobi" multiplies by the inverses of the dense diagonal blocks
+ *    of |block_size| rows,
+ *  - "ic0" applies the incomplete Cholesky factorization of the matrix with
+ *    no fill-in. It reads the lower triangle only and needs the matrix to be
+ *    symmetric positive definite.
+ */
+template <typename T>
+class KrylovSolver {
+ public:
+  // y = A x.
+  using Operator = std::function<void(const T *x, T *y)>;
+
+  KrylovSolver(Program *prog,
+               const std::string &method,
+               const std::string &preconditioner,
+               int max_iters,
+               float tol,
+               int block_size,
+               bool verbose);
+
+  // Solves A x = b starting from the current value of |x|. Returns whether
+  // the norm of the residual dropped to |tol|.
+  bool solve(SparseMatrix &A, const Ndarray &b, Ndarray &x);
+
+  /**
+   * Solves A x = b for an operator A applied by |matvec|, which must write A
+   * |in| to |out|. Only the "jacobi" preconditioner is supported, for which
+   * |diagonal| holds the diagonal of A.
+   *
+   * CG keeps its search direction in |in| and A times it in |out|, so that
+   * no vector is copied.
+   */
+  bool solve_matrix_free(const std::function<void()> &matvec,
+                         Ndarray &in,
+                         Ndarray &out,
+                         const Ndarray *diagonal,
+                         const Ndarray &b,
+                         Ndarray &x);
+
+  int num_iterations() const {
+    return num_iterations_;
+  }
+
+  T residual_norm() const {
+    return residual_norm_;
+  }
+
+ private:
+  T *get_ndarray_data(const Ndarray &array, int n) const;
+
+  bool run(const Operator &A, int n, const T *b, T *x);
+
+  bool run_cg(const Operator &A, int n, const T *b, T *x);
+
+  bool run_bicgstab(const Operator &A, int n, const T *b, T *x);
+
+  // Applies the preconditioner to |r|. Returns |r| itself if there is none.
+  const T *precondition(const T *r, std::vector<T> &z);
+
+  Program *prog_{nullptr};
+  ThreadPool *pool_{nullptr};
+  KrylovMethod method_{KrylovMethod::kCG};
+  PreconditionerType preconditioner_type_{PreconditionerType::kNone};
+  int max_iters_{0};
+  T tol_{0};
+  int block_size_{1};
+  bool verbose_{false};
+
+  std::unique_ptr<Preconditioner<T>> preconditioner_;
+  // Storage of the operands and results of the operator, if it has its own.
+  T *operator_in_{nullptr};
+  T *operator_out_{nullptr};
+  // Work vectors, reused across solves.
+  std::vector<std::vector<T>> work_;
+
+  int num_iterations_{0};
+  T residual_norm_{0};
+};
 }  // namespace taichi::lang
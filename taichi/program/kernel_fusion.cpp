@@ -0,0 +1,519 @@
+#include "taichi/program/kernel_fusion.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <unordered_set>
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/type_factory.h"
+#include "taichi/ir/type_utils.h"
+#include "taichi/program/context.h"
+#include "taichi/program/program.h"
+
+namespace taichi::lang {
+
+struct KernelFusionQueue::FusibleKernel {
+  struct ArrayAccess {
+    bool written{false};
+    // True if every access is at the current loop index.
+    bool elementwise{true};
+  };
+
+  // A copy of the kernel's IR after lower_ast. The last statement of the root
+  // block is |loop|, all the statements before it are loop-invariant.
+  std::unique_ptr<IRNode> ir;
+  RangeForStmt *loop{nullptr};
+  // Statements evaluating to the extent of each axis of the index space if
+  // this is an ndarray-for, empty if this is a plain range-for.
+  std::vector<Stmt *> extents;
+  bool has_continue{false};
+  std::unordered_set<SNode *> snode_reads;
+  std::unordered_set<SNode *> snode_writes;
+  // Accessed ndarrays, indexed by (argument id, is_grad).
+  std::map<std::pair<int, bool>, ArrayAccess> arrays;
+};
+
+namespace {
+
+bool is_loop_invariant_stmt(Stmt *stmt) {
+  return stmt->is<ConstStmt>() || stmt->is<ArgLoadStmt>() ||
+         stmt->is<ExternalTensorShapeAlongAxisStmt>() ||
+         stmt->is<UnaryOpStmt>() || stmt->is<BinaryOpStmt>() ||
+         stmt->is<TernaryOpStmt>() || stmt->is<AllocaStmt>() ||
+         stmt->is<LocalLoadStmt>() || stmt->is<LocalStoreStmt>();
+}
+
+bool is_unsupported_stmt(Stmt *stmt) {
+  // Calls may access anything, so we cannot reason about them.
+  return stmt->is<FuncCallStmt>() || stmt->is<ExternalFuncCallStmt>() ||
+         stmt->is<InternalFuncStmt>() || stmt->is<ReturnStmt>() ||
+         stmt->is<TexturePtrStmt>() || stmt->is<TextureOpStmt>();
+}
+
+// Returns the pointer that |ptr| indexes into, if |ptr| is an element of a
+// matrix.
+Stmt *strip_matrix_ptr(Stmt *ptr) {
+  while (auto *matrix_ptr = ptr->cast<MatrixPtrStmt>()) {
+    ptr = matrix_ptr->origin;
+  }
+  return ptr;
+}
+
+std::optional<int64> evaluate(Stmt *stmt, LaunchContextBuilder &ctx) {
+  if (auto *c = stmt->cast<ConstStmt>()) {
+    if (!is_integral(c->ret_type)) {
+      return std::nullopt;
+    }
+    return c->val.val_as_int64();
+  }
+  if (auto *shape = stmt->cast<ExternalTensorShapeAlongAxisStmt>()) {
+    return ctx.get_struct_arg<int32>(
+        {shape->arg_id[0], TypeFactory::SHAPE_POS_IN_NDARRAY, shape->axis});
+  }
+  if (auto *arg = stmt->cast<ArgLoadStmt>()) {
+    if (arg->is_ptr || arg->arg_depth != 0 || arg->arg_id.size() != 1) {
+      return std::nullopt;
+    }
+    auto dt = arg->ret_type.ptr_removed();
+    if (dt->is_primitive(PrimitiveTypeID::i32)) {
+      return ctx.get_struct_arg<int32>(arg->arg_id);
+    } else if (dt->is_primitive(PrimitiveTypeID::i64)) {
+      return ctx.get_struct_arg<int64>(arg->arg_id);
+    } else if (dt->is_primitive(PrimitiveTypeID::u32)) {
+      return ctx.get_struct_arg<uint32>(arg->arg_id);
+    }
+    return std::nullopt;
+  }
+  if (auto *unary = stmt->cast<UnaryOpStmt>()) {
+    if (unary->op_type == UnaryOpType::cast_value &&
+        is_integral(unary->cast_type)) {
+      return evaluate(unary->operand, ctx);
+    }
+    return std::nullopt;
+  }
+  if (auto *binary = stmt->cast<BinaryOpStmt>()) {
+    auto lhs = evaluate(binary->lhs, ctx);
+    auto rhs = evaluate(binary->rhs, ctx);
+    if (!lhs || !rhs) {
+      return std::nullopt;
+    }
+    switch (binary->op_type) {
+      case BinaryOpType::add:
+        return *lhs + *rhs;
+      case BinaryOpType::sub:
+        return *lhs - *rhs;
+      case BinaryOpType::mul:
+        return *lhs * *rhs;
+      case BinaryOpType::max:
+        return std::max(*lhs, *rhs);
+      case BinaryOpType::min:
+        return std::min(*lhs, *rhs);
+      case BinaryOpType::div:
+      case BinaryOpType::floordiv:
+        // Truncation and flooring only agree on non-negative operands.
+        if (*lhs >= 0 && *rhs > 0) {
+          return *lhs / *rhs;
+        }
+        return std::nullopt;
+      default:
+        return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+std::unique_ptr<IRNode> lower_kernel_ir(const Kernel &kernel) {
+  auto ir = irpass::analysis::clone(kernel.ir.get());
+  if (kernel.ir_is_ast()) {
+    irpass::frontend_type_check(ir.get());
+    irpass::lower_ast(ir.get());
+  }
+  return ir;
+}
+
+// Offsets the ids of all the arguments referenced in |root| by |offset|.
+void shift_arg_ids(IRNode *root, int offset) {
+  irpass::analysis::gather_statements(root, [&](Stmt *stmt) {
+    if (auto *arg = stmt->cast<ArgLoadStmt>()) {
+      arg->arg_id[0] += offset;
+    } else if (auto *shape = stmt->cast<ExternalTensorShapeAlongAxisStmt>()) {
+      shape->arg_id[0] += offset;
+    } else if (auto *base = stmt->cast<ExternalTensorBasePtrStmt>()) {
+      base->arg_id[0] += offset;
+    }
+    return false;
+  });
+}
+
+// Appends the loop-invariant statements of |other| to the ones of |root| and
+// the body of its range-for to the body of |loop|.
+void merge_range_for(Block *root, RangeForStmt *loop, Block *other) {
+  auto *other_loop = other->back()->as<RangeForStmt>();
+  while (other->size() > 1) {
+    root->insert(other->extract(0), (int)root->size() - 1);
+  }
+  irpass::analysis::gather_statements(other_loop->body.get(), [&](Stmt *s) {
+    if (auto *index = s->cast<LoopIndexStmt>()) {
+      if (index->loop == other_loop) {
+        index->loop = loop;
+      }
+    } else if (auto *linear_index = s->cast<LoopLinearIndexStmt>()) {
+      if (linear_index->loop == other_loop) {
+        linear_index->loop = loop;
+      }
+    } else if (auto *cont = s->cast<ContinueStmt>()) {
+      if (cont->scope == other_loop) {
+        cont->scope = loop;
+      }
+    }
+    return false;
+  });
+  while (other_loop->body->size() > 0) {
+    loop->body->insert(other_loop->body->extract(0));
+  }
+}
+
+// Copies the arguments of |kernel| in |src| to |dst|, starting at argument
+// |arg_offset|.
+void copy_args(const Kernel &kernel,
+               LaunchContextBuilder &src,
+               int arg_offset,
+               LaunchContextBuilder &dst) {
+  for (int i = 0; i < (int)kernel.parameter_list.size(); i++) {
+    const auto &param = kernel.parameter_list[i];
+    const int j = arg_offset + i;
+    if (param.ptype == ParameterType::kNdarray) {
+      const int ndim = param.total_dim - param.element_shape.size();
+      std::vector<int> shape(ndim);
+      for (int axis = 0; axis < ndim; axis++) {
+        shape[axis] = src.get_struct_arg<int32>(
+            {i, TypeFactory::SHAPE_POS_IN_NDARRAY, axis});
+      }
+      auto *data =
+          src.array_ptrs.at({i, TypeFactory::DATA_PTR_POS_IN_NDARRAY});
+      auto grad =
+          src.array_ptrs.find({i, TypeFactory::GRAD_PTR_POS_IN_NDARRAY});
+      dst.set_arg_ndarray_impl(
+          {j}, (intptr_t)data, shape,
+          grad != src.array_ptrs.end() ? (intptr_t)grad->second : 0);
+    } else {
+      std::memcpy(dst.get_context().arg_buffer +
+                      dst.args_type->get_element_offset({j}),
+                  src.get_context().arg_buffer +
+                      src.args_type->get_element_offset({i}),
+                  data_type_size(param.get_dtype()));
+      dst.set_array_device_allocation_type(
+          {j}, LaunchContextBuilder::DevAllocType::kNone);
+    }
+  }
+}
+
+const DeviceAllocation *get_buffer(const LaunchContextBuilder &ctx,
+                                   const std::pair<int, bool> &array) {
+  auto it = ctx.array_ptrs.find(
+      {array.first, array.second ? TypeFactory::GRAD_PTR_POS_IN_NDARRAY
+                                 : TypeFactory::DATA_PTR_POS_IN_NDARRAY});
+  return it == ctx.array_ptrs.end() ? nullptr
+                                    : (const DeviceAllocation *)it->second;
+}
+
+}  // namespace
+
+KernelFusionQueue::KernelFusionQueue(Program *program, Launcher launcher)
+    : program_(program), launcher_(std::move(launcher)) {
+}
+
+KernelFusionQueue::~KernelFusionQueue() = default;
+
+const KernelFusionQueue::FusibleKernel *KernelFusionQueue::get_fusible_kernel(
+    Kernel &kernel) {
+  if (auto it = fusible_kernels_.find(&kernel); it != fusible_kernels_.end()) {
+    return it->second.get();
+  }
+  auto &result = fusible_kernels_[&kernel];
+  if (kernel.autodiff_mode != AutodiffMode::kNone || !kernel.rets.empty() ||
+      kernel.is_accessor) {
+    return nullptr;
+  }
+  for (const auto &param : kernel.parameter_list) {
+    const bool is_scalar = param.ptype == ParameterType::kScalar &&
+                           !param.is_array && !param.is_argpack &&
+                           (param.get_dtype()->is<PrimitiveType>() ||
+                            param.get_dtype()->is<TensorType>());
+    if (!is_scalar && param.ptype != ParameterType::kNdarray) {
+      return nullptr;
+    }
+  }
+
+  auto info = std::make_unique<FusibleKernel>();
+  info->ir = lower_kernel_ir(kernel);
+  auto *root = info->ir->as<Block>();
+  if (root->size() == 0 || !root->back()->is<RangeForStmt>()) {
+    return nullptr;
+  }
+  for (int i = 0; i + 1 < (int)root->size(); i++) {
+    if (!is_loop_invariant_stmt(root->statements[i].get())) {
+      return nullptr;
+    }
+  }
+  info->loop = root->back()->as<RangeForStmt>();
+
+  // The loop variables of an ndarray-for are decorated with kLoopUnique by
+  // lower_ast, and those of a plain range-for are its loop index.
+  std::vector<Stmt *> loop_vars;
+  for (auto &stmt : info->loop->body->statements) {
+    auto *decoration = stmt->cast<DecorationStmt>();
+    if (!decoration || decoration->decoration.size() < 2 ||
+        decoration->decoration[0] !=
+            uint32_t(DecorationStmt::Decoration::kLoopUnique)) {
+      continue;
+    }
+    const int axis = decoration->decoration[1];
+    if (axis >= (int)loop_vars.size()) {
+      loop_vars.resize(axis + 1, nullptr);
+      info->extents.resize(axis + 1, nullptr);
+    }
+    loop_vars[axis] = decoration->operand;
+    info->extents[axis] = decoration->operand->as<BinaryOpStmt>()->rhs;
+  }
+  if (loop_vars.empty()) {
+    for (auto &stmt : info->loop->body->statements) {
+      auto *index = stmt->cast<LoopIndexStmt>();
+      if (index && index->loop == info->loop && index->index == 0) {
+        loop_vars.push_back(index);
+        break;
+      }
+    }
+  }
+  if (std::find(loop_vars.begin(), loop_vars.end(), nullptr) !=
+      loop_vars.end()) {
+    return nullptr;
+  }
+
+  // Any use of a pointer other than loading from it may write through it.
+  bool supported = true;
+  std::unordered_set<Stmt *> written_ptrs;
+  irpass::analysis::gather_statements(info->loop->body.get(), [&](Stmt *stmt) {
+    if (is_unsupported_stmt(stmt)) {
+      supported = false;
+    } else if (stmt->is<ContinueStmt>()) {
+      info->has_continue = true;
+    }
+    if (stmt->is<GlobalLoadStmt>() || stmt->is<MatrixPtrStmt>()) {
+      return false;
+    }
+    for (auto *operand : stmt->get_operands()) {
+      if (operand) {
+        written_ptrs.insert(strip_matrix_ptr(operand));
+      }
+    }
+    return false;
+  });
+  if (!supported) {
+    return nullptr;
+  }
+
+  std::tie(info->snode_reads, info->snode_writes) =
+      irpass::analysis::gather_snode_read_writes(info->ir.get());
+  irpass::analysis::gather_statements(info->ir.get(), [&](Stmt *stmt) {
+    const bool written = written_ptrs.count(stmt) > 0;
+    if (auto *ptr = stmt->cast<ExternalPtrStmt>()) {
+      auto *base = ptr->base_ptr->cast<ArgLoadStmt>();
+      if (!base || base->arg_depth != 0) {
+        supported = false;
+        return false;
+      }
+      auto &access = info->arrays[{base->arg_id[0], ptr->is_grad}];
+      access.written |= written;
+      access.elementwise &= ptr->indices == loop_vars;
+    } else if (auto *base = stmt->cast<ExternalTensorBasePtrStmt>()) {
+      auto &access = info->arrays[{base->arg_id[0], base->is_grad}];
+      access.written = true;
+      access.elementwise = false;
+    } else if (auto *global_ptr = stmt->cast<GlobalPtrStmt>()) {
+      // Also covers the pointers reached through MatrixPtrStmt.
+      info->snode_reads.insert(global_ptr->snode);
+      if (written) {
+        info->snode_writes.insert(global_ptr->snode);
+      }
+    } else if (auto *matrix_ptr = stmt->cast<MatrixOfGlobalPtrStmt>()) {
+      for (auto *snode : matrix_ptr->snodes) {
+        info->snode_reads.insert(snode);
+        if (written) {
+          info->snode_writes.insert(snode);
+        }
+      }
+    } else if (auto *snode_op = stmt->cast<SNodeOpStmt>()) {
+      info->snode_reads.insert(snode_op->snode);
+      info->snode_writes.insert(snode_op->snode);
+    }
+    return false;
+  });
+  if (!supported) {
+    return nullptr;
+  }
+  result = std::move(info);
+  return result.get();
+}
+
+bool KernelFusionQueue::can_fuse(const PendingLaunch &earlier,
+                                 const PendingLaunch &later) const {
+  const auto *a = earlier.info;
+  const auto *b = later.info;
+  // A continue in |earlier| would skip the body of |later|.
+  if (a->has_continue) {
+    return false;
+  }
+  if (!(earlier.space == later.space) ||
+      a->loop->is_bit_vectorized != b->loop->is_bit_vectorized ||
+      a->loop->num_cpu_threads != b->loop->num_cpu_threads ||
+      a->loop->block_dim != b->loop->block_dim ||
+      a->loop->strictly_serialized != b->loop->strictly_serialized) {
+    return false;
+  }
+  for (auto *snode : b->snode_writes) {
+    if (a->snode_reads.count(snode) || a->snode_writes.count(snode)) {
+      return false;
+    }
+  }
+  for (auto *snode : b->snode_reads) {
+    if (a->snode_writes.count(snode)) {
+      return false;
+    }
+  }
+  for (const auto &[array_b, access_b] : b->arrays) {
+    const auto *buffer_b = get_buffer(later.ctx, array_b);
+    if (!buffer_b) {
+      return false;
+    }
+    for (const auto &[array_a, access_a] : a->arrays) {
+      const auto *buffer_a = get_buffer(earlier.ctx, array_a);
+      if (!buffer_a) {
+        return false;
+      }
+      if (*buffer_a == *buffer_b && (access_a.written || access_b.written) &&
+          !(access_a.elementwise && access_b.elementwise)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void KernelFusionQueue::enqueue(Kernel &kernel, LaunchContextBuilder &&ctx) {
+  const auto *info = get_fusible_kernel(kernel);
+  std::optional<LoopSpace> space;
+  if (info) {
+    // External arrays are copied back right after their launch, so they
+    // cannot be deferred.
+    bool deferrable = true;
+    for (int i = 0; i < (int)kernel.parameter_list.size(); i++) {
+      if (kernel.parameter_list[i].ptype == ParameterType::kNdarray &&
+          ctx.device_allocation_type[{i}] !=
+              LaunchContextBuilder::DevAllocType::kNdarray) {
+        deferrable = false;
+      }
+    }
+    auto begin = evaluate(info->loop->begin, ctx);
+    auto end = evaluate(info->loop->end, ctx);
+    if (deferrable && begin && end) {
+      space = LoopSpace{*begin, *end, {}};
+      if (info->extents.empty()) {
+        space->extents.push_back(*end - *begin);
+      }
+      for (auto *extent : info->extents) {
+        auto value = evaluate(extent, ctx);
+        if (!value) {
+          space.reset();
+          break;
+        }
+        space->extents.push_back(*value);
+      }
+    }
+  }
+  if (!space) {
+    flush();
+    launcher_(kernel, ctx);
+    return;
+  }
+
+  PendingLaunch launch{&kernel, info, std::move(ctx), std::move(*space)};
+  bool fusible = pending_.size() < kMaxFusedLaunches;
+  for (const auto &pending : pending_) {
+    if (!fusible) {
+      break;
+    }
+    fusible = can_fuse(pending, launch);
+  }
+  if (!fusible) {
+    flush();
+  }
+  pending_.push_back(std::move(launch));
+}
+
+void KernelFusionQueue::flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  // |launcher_| may flush this queue again.
+  auto launches = std::move(pending_);
+  pending_.clear();
+  if (launches.size() == 1) {
+    launcher_(*launches[0].kernel, launches[0].ctx);
+    return;
+  }
+  auto &fused_kernel = get_fused_kernel(launches);
+  auto ctx = fused_kernel.make_launch_context();
+  int arg_offset = 0;
+  for (auto &launch : launches) {
+    copy_args(*launch.kernel, launch.ctx, arg_offset, ctx);
+    arg_offset += launch.kernel->parameter_list.size();
+  }
+  launcher_(fused_kernel, ctx);
+}
+
+Kernel &KernelFusionQueue::get_fused_kernel(
+    const std::vector<PendingLaunch> &launches) {
+  std::vector<const Kernel *> key;
+  std::vector<std::string> names;
+  for (const auto &launch : launches) {
+    key.push_back(launch.kernel);
+    names.push_back(launch.kernel->name);
+  }
+  auto &fused_kernel = fused_kernels_[key];
+  if (fused_kernel) {
+    return *fused_kernel;
+  }
+
+  auto ir = irpass::analysis::clone(launches[0].info->ir.get());
+  auto *root = ir->as<Block>();
+  auto *loop = root->back()->as<RangeForStmt>();
+  int arg_offset = launches[0].kernel->parameter_list.size();
+  for (int i = 1; i < (int)launches.size(); i++) {
+    auto other = irpass::analysis::clone(launches[i].info->ir.get());
+    shift_arg_ids(other.get(), arg_offset);
+    merge_range_for(root, loop, other->as<Block>());
+    arg_offset += launches[i].kernel->parameter_list.size();
+  }
+
+  // The name is the key in the in-memory kernel cache of CHI IR kernels.
+  fused_kernel = std::make_unique<Kernel>(
+      *program_, std::move(ir),
+      fmt::format("fused_{}_{}", fmt::join(names, "_"), fused_kernels_.size()));
+  for (const auto &launch : launches) {
+    for (const auto &param : launch.kernel->parameter_list) {
+      fused_kernel->parameter_list.push_back(param);
+      fused_kernel->nested_parameters[{
+          (int)fused_kernel->parameter_list.size() - 1}] = param;
+    }
+  }
+  fused_kernel->finalize_params();
+  fused_kernel->finalize_rets();
+  TI_TRACE("Fused {} kernels into {}", launches.size(), fused_kernel->name);
+  return *fused_kernel;
+}
+
+}  // namespace taichi::lang
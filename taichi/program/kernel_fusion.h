@@ -0,0 +1,114 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/program/kernel.h"
+#include "taichi/program/launch_context_builder.h"
+
+namespace taichi::lang {
+
+class Program;
+class RangeForStmt;
+
+/**
+ * Records consecutive kernel launches and fuses the compatible ones.
+ *
+ * A launch can be deferred if its kernel consists of a single range-for
+ * (optionally preceded by loop-invariant scalar code) and only takes scalars
+ * and Taichi ndarrays. Consecutive deferred launches are merged into one
+ * range-for when
+ *  - they iterate over the same index space with the same loop config,
+ *  - no SNode written by one of them is accessed by another, and
+ *  - every ndarray shared between them that one of them writes is only ever
+ *    accessed at the current loop index, so that iteration |i| of a later
+ *    kernel only depends on iteration |i| of the earlier ones.
+ * The fused kernels are built as CHI IR and cached per kernel sequence.
+ */
+class KernelFusionQueue {
+ public:
+  using Launcher = std::function<void(Kernel &, LaunchContextBuilder &)>;
+
+  // Launches at most this many kernels as one fused kernel.
+  static constexpr int kMaxFusedLaunches = 8;
+
+  /**
+   * @param program The program that owns the fused kernels.
+   * @param launcher Compiles and launches a kernel without flushing this
+   * queue.
+   */
+  KernelFusionQueue(Program *program, Launcher launcher);
+
+  ~KernelFusionQueue();
+
+  /**
+   * Defers the launch of |kernel| with |ctx|, or launches it right away if it
+   * cannot be fused. Pending launches are flushed first if |kernel| cannot be
+   * fused with them.
+   *
+   * Note that |kernel| must outlive this queue, as the fusion analysis is
+   * cached per kernel.
+   */
+  void enqueue(Kernel &kernel, LaunchContextBuilder &&ctx);
+
+  /**
+   * Launches all the pending launches.
+   */
+  void flush();
+
+  bool empty() const {
+    return pending_.empty();
+  }
+
+  std::size_t num_pending_launches() const {
+    return pending_.size();
+  }
+
+  // Number of distinct fused kernels built so far.
+  std::size_t num_fused_kernels() const {
+    return fused_kernels_.size();
+  }
+
+ private:
+  // Fusion-related facts about a kernel, independent of its arguments.
+  struct FusibleKernel;
+
+  // The index space of a range-for, evaluated with the launch arguments.
+  struct LoopSpace {
+    int64 begin{0};
+    int64 end{0};
+    std::vector<int64> extents;
+
+    bool operator==(const LoopSpace &o) const {
+      return begin == o.begin && end == o.end && extents == o.extents;
+    }
+  };
+
+  struct PendingLaunch {
+    Kernel *kernel{nullptr};
+    const FusibleKernel *info{nullptr};
+    LaunchContextBuilder ctx;
+    LoopSpace space;
+  };
+
+  const FusibleKernel *get_fusible_kernel(Kernel &kernel);
+
+  bool can_fuse(const PendingLaunch &earlier,
+                const PendingLaunch &later) const;
+
+  Kernel &get_fused_kernel(const std::vector<PendingLaunch> &launches);
+
+  Program *const program_;
+  Launcher launcher_;
+  std::vector<PendingLaunch> pending_;
+  // nullptr if the kernel cannot be fused.
+  std::unordered_map<const Kernel *, std::unique_ptr<FusibleKernel>>
+      fusible_kernels_;
+  std::map<std::vector<const Kernel *>, std::unique_ptr<Kernel>>
+      fused_kernels_;
+};
+
+}  // namespace taichi::lang
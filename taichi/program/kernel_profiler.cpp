@@ -6,6 +6,7 @@
 #include "taichi/system/timeline.h"
 
 #include "taichi/rhi/amdgpu/amdgpu_profiler.h"
+#include "taichi/rhi/cpu/cpu_profiler.h"
 
 namespace taichi::lang {
 
@@ -67,8 +68,54 @@ double KernelProfilerBase::get_total_time() const {
   return total_time_ms_ / 1000.0;
 }
 
+void KernelProfilerBase::insert_streaming_record(
+    const std::string &kernel_name,
+    double duration_ms) {
+  auto it = std::find_if(
+      streaming_statistics_.begin(), streaming_statistics_.end(),
+      [&](KernelLatencyStatistics &s) { return s.name == kernel_name; });
+  if (it == streaming_statistics_.end()) {
+    streaming_statistics_.emplace_back(kernel_name);
+    it = std::prev(streaming_statistics_.end());
+  }
+  it->insert_record(duration_ms);
+}
+
+void KernelProfilerBase::stream_traced_records(std::size_t begin) {
+  if (!streaming_) {
+    return;
+  }
+  for (std::size_t i = begin; i < traced_records_.size(); i++) {
+    insert_streaming_record(traced_records_[i].name,
+                            traced_records_[i].kernel_elapsed_time_in_ms);
+  }
+  traced_records_.clear();
+}
+
+std::vector<KernelLatencyStatistics>
+KernelProfilerBase::get_streaming_statistics(bool reset) {
+  auto statistics = streaming_statistics_;
+  std::sort(statistics.begin(), statistics.end(),
+            [](const KernelLatencyStatistics &a,
+               const KernelLatencyStatistics &b) { return a.total > b.total; });
+  if (reset) {
+    // Keeps the kernels, which are reported with a zero counter until they
+    // are launched again.
+    for (auto &s : streaming_statistics_) {
+      s.reset();
+    }
+  }
+  return statistics;
+}
+
 void KernelProfilerBase::insert_record(const std::string &kernel_name,
                                        double duration_ms) {
+  if (streaming_) {
+    // Only the last record is kept, for the callers filling in more of its
+    // fields.
+    traced_records_.clear();
+    insert_streaming_record(kernel_name, duration_ms);
+  }
   // Trace record
   KernelProfileTracedRecord record;
   record.name = kernel_name;
@@ -101,6 +148,7 @@ class DefaultProfiler : public KernelProfilerBase {
     total_time_ms_ = 0;
     traced_records_.clear();
     statistical_results_.clear();
+    streaming_statistics_.clear();
   }
 
   void start(const std::string &kernel_name) override {
@@ -110,24 +158,7 @@ class DefaultProfiler : public KernelProfilerBase {
 
   void stop() override {
     auto t = Time::get_time() - start_t_;
-    auto ms = t * 1000.0;
-    // trace record
-    KernelProfileTracedRecord record;
-    record.name = event_name_;
-    record.kernel_elapsed_time_in_ms = ms;
-    traced_records_.push_back(record);
-    // count record
-    auto it =
-        std::find_if(statistical_results_.begin(), statistical_results_.end(),
-                     [&](KernelProfileStatisticalResult &r) {
-                       return r.name == event_name_;
-                     });
-    if (it == statistical_results_.end()) {
-      statistical_results_.emplace_back(event_name_);
-      it = std::prev(statistical_results_.end());
-    }
-    it->insert_record(ms);
-    total_time_ms_ += ms;
+    insert_record(event_name_, t * 1000.0);
   }
 
  private:
@@ -151,6 +182,12 @@ std::unique_ptr<KernelProfilerBase> make_profiler(Arch arch, bool enable) {
     return std::make_unique<KernelProfilerAMDGPU>();
 #else
     TI_NOT_IMPLEMENTED
+#endif
+  } else if (arch_is_cpu(arch)) {
+#if defined(TI_WITH_LLVM)
+    return std::make_unique<KernelProfilerCPU>();
+#else
+    return std::make_unique<DefaultProfiler>();
 #endif
   } else {
     return std::make_unique<DefaultProfiler>();
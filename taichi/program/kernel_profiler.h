@@ -1,5 +1,6 @@
 #pragma once
 
+#include "taichi/program/kernel_statistics.h"
 #include "taichi/rhi/arch.h"
 #include "taichi/util/lang_util.h"
 
@@ -24,6 +25,10 @@ struct KernelProfileTracedRecord {
   float time_since_base{0.0};        // for Timeline
   std::string name;                  // kernel name
   std::vector<float> metric_values;  // user selected metrics
+  // load balance of the CPU thread pool, when recorded
+  float thread_imbalance_ratio{0.0};  // max / mean busy time of the threads
+  float thread_idle_time_in_ms{0.0};  // summed over the threads
+  std::vector<int> tasks_per_thread;
 };
 
 struct KernelProfileStatisticalResult {
@@ -48,6 +53,16 @@ class KernelProfilerBase {
   std::vector<KernelProfileTracedRecord> traced_records_;
   std::vector<KernelProfileStatisticalResult> statistical_results_;
   double total_time_ms_{0};
+  // Only counted in streaming mode, see set_streaming().
+  std::vector<KernelLatencyStatistics> streaming_statistics_;
+  bool streaming_{false};
+
+  void insert_streaming_record(const std::string &kernel_name,
+                               double duration_ms);
+
+  // In streaming mode, counts the kernel times of traced_records_[begin:],
+  // which must be known, and drops the traced records.
+  void stream_traced_records(std::size_t begin);
 
  public:
   // Needed for the CUDA backend since we need to know which task to "stop"
@@ -67,6 +82,11 @@ class KernelProfilerBase {
     return false;
   }
 
+  // Records how busy each thread of the CPU thread pool is in each task.
+  virtual bool set_load_balance_recording(bool enabled) {
+    return false;
+  }
+
   // TODO: remove start and always use start_with_handle
   virtual void start(const std::string &kernel_name){TI_NOT_IMPLEMENTED};
 
@@ -94,6 +114,20 @@ class KernelProfilerBase {
 
   double get_total_time() const;
 
+  // In streaming mode, the kernel times are counted in histograms of bounded
+  // memory instead of being traced, for long-running programs.
+  void set_streaming(bool enabled) {
+    streaming_ = enabled;
+  }
+
+  bool get_streaming() const {
+    return streaming_;
+  }
+
+  // The statistics counted in streaming mode since the last reset, sorted by
+  // total time. Must be called after sync() and update().
+  std::vector<KernelLatencyStatistics> get_streaming_statistics(bool reset);
+
   void insert_record(const std::string &kernel_name, double duration_ms);
 
   virtual std::string get_device_name() {
@@ -0,0 +1,77 @@
+#include "taichi/program/kernel_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "taichi/util/bit.h"
+
+namespace taichi::lang {
+
+int KernelLatencyStatistics::bucket_index(uint64 ns) {
+  ns = std::min(ns, (uint64(1) << kMaxBits) - 1);
+  if (ns < kLinearBuckets) {
+    return (int)ns;
+  }
+  // |ns| is in [2^k, 2^(k + 1)), split into kSubBuckets buckets.
+  const int k = (int)bit::log2int(ns);
+  const int shift = k - kSubBucketBits;
+  return int(kLinearBuckets + (k - kSubBucketBits - 1) * kSubBuckets +
+             (ns >> shift) - kSubBuckets);
+}
+
+double KernelLatencyStatistics::bucket_value(int index) {
+  if (index < (int)kLinearBuckets) {
+    return index;
+  }
+  const int j = index - (int)kLinearBuckets;
+  const int shift = j / (int)kSubBuckets + 1;
+  const uint64 lower = (j % kSubBuckets + kSubBuckets) << shift;
+  return lower + 0.5 * ((uint64(1) << shift) - 1);
+}
+
+void KernelLatencyStatistics::insert_record(double t) {
+  if (counter == 0) {
+    min = t;
+    max = t;
+  }
+  counter++;
+  min = std::min(min, t);
+  max = std::max(max, t);
+  total += t;
+
+  const int index = bucket_index((uint64)std::llround(std::max(t, 0.0) * 1e6));
+  if (index >= (int)counts_.size()) {
+    counts_.resize(index + 1, 0);
+  }
+  counts_[index]++;
+}
+
+double KernelLatencyStatistics::percentile(double q) const {
+  if (counter == 0) {
+    return 0;
+  }
+  const auto rank = std::max<uint64>(
+      1, (uint64)std::ceil(std::clamp(q, 0.0, 1.0) * counter));
+  // The extremes are known exactly.
+  if (rank == 1) {
+    return min;
+  } else if (rank >= (uint64)counter) {
+    return max;
+  }
+  uint64 seen = 0;
+  for (int i = 0; i < (int)counts_.size(); i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::clamp(bucket_value(i) * 1e-6, min, max);
+    }
+  }
+  return max;
+}
+
+void KernelLatencyStatistics::reset() {
+  counter = 0;
+  min = max = total = 0;
+  counts_.clear();
+}
+
+}  // namespace taichi::lang
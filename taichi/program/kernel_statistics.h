@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "taichi/util/lang_util.h"
+
+namespace taichi::lang {
+
+// The times of a kernel in a log-linear histogram as HdrHistogram, whose
+// percentiles are within 1% of the recorded times. The memory is bounded by
+// the longest time recorded, 24 KB for times up to a second.
+class KernelLatencyStatistics {
+ public:
+  explicit KernelLatencyStatistics(const std::string &name) : name(name) {
+  }
+
+  std::string name;
+  int64 counter{0};
+  double min{0};
+  double max{0};
+  double total{0};
+
+  void insert_record(double t);
+
+  // The time below which |q| (in [0, 1]) of the recorded times fall, 0 when
+  // nothing is recorded.
+  double percentile(double q) const;
+
+  void reset();
+
+ private:
+  // 2^7 buckets per power of two, each spanning less than 1% of its times.
+  static constexpr int kSubBucketBits = 7;
+  static constexpr uint64 kSubBuckets = uint64(1) << kSubBucketBits;
+  // The times below are counted exactly, one nanosecond per bucket.
+  static constexpr uint64 kLinearBuckets = 2 * kSubBuckets;
+  // Times are counted in nanoseconds, up to about 13 days.
+  static constexpr int kMaxBits = 50;
+
+  static int bucket_index(uint64 ns);
+  // The middle of the times counted in a bucket, in nanoseconds.
+  static double bucket_value(int index);
+
+  std::vector<uint64> counts_;
+};
+
+}  // namespace taichi::lang
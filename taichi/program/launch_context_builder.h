@@ -97,6 +97,10 @@ class LaunchContextBuilder {
 
   RuntimeContext &get_context();
 
+  const CallableBase *get_kernel() const {
+    return kernel_;
+  }
+
  private:
   TypedConstant fetch_ret_impl(int offset, const Type *dt);
   CallableBase *kernel_;
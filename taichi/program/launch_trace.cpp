@@ -0,0 +1,241 @@
+#include "taichi/program/launch_trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "taichi/codegen/compiled_kernel_data.h"
+#include "taichi/common/serialization.h"
+#include "taichi/program/kernel.h"
+#include "taichi/program/ndarray.h"
+#include "taichi/program/program.h"
+#include "taichi/system/timer.h"
+#ifdef TI_WITH_LLVM
+#include "taichi/codegen/llvm/compiled_kernel_data.h"
+#endif
+
+namespace taichi::lang {
+
+namespace {
+
+std::vector<int> concatenate(const std::vector<int> &arg_id, int pos) {
+  auto result = arg_id;
+  result.push_back(pos);
+  return result;
+}
+
+}  // namespace
+
+LaunchTraceRecorder::LaunchTraceRecorder(Arch arch)
+    : start_time_(Time::get_time()) {
+  trace_.version[0] = TI_VERSION_MAJOR;
+  trace_.version[1] = TI_VERSION_MINOR;
+  trace_.version[2] = TI_VERSION_PATCH;
+  trace_.arch = arch;
+}
+
+void LaunchTraceRecorder::register_kernel(const CompiledKernelData &compiled,
+                                          const Kernel &kernel,
+                                          bool cached_on_disk) {
+  if (!cached_on_disk) {
+    compiled_ids_[&compiled] = -1;
+    return;
+  }
+  const auto &key = kernel.get_cached_kernel_key();
+  auto [iter, inserted] =
+      kernel_ids_.insert({key, (int)trace_.kernels.size()});
+  if (inserted) {
+    trace_.kernels.push_back({key, kernel.get_name()});
+  }
+  compiled_ids_[&compiled] = iter->second;
+}
+
+void LaunchTraceRecorder::record(const CompiledKernelData &compiled,
+                                 LaunchContextBuilder &ctx) {
+  auto iter = compiled_ids_.find(&compiled);
+  if (iter == compiled_ids_.end() || iter->second < 0) {
+    num_skipped_++;
+    return;
+  }
+  LaunchTraceRecord record;
+  record.kernel_id = iter->second;
+  record.time = Time::get_time() - start_time_;
+  for (const auto &[arg_id, param] : ctx.get_kernel()->nested_parameters) {
+    if (param.is_argpack) {
+      num_skipped_++;
+      return;
+    }
+    if (!param.is_array) {
+      continue;
+    }
+    LaunchTraceArray array;
+    array.arg_id = arg_id;
+    array.type = ctx.device_allocation_type[arg_id];
+    if (array.type != LaunchContextBuilder::DevAllocType::kNone &&
+        array.type != LaunchContextBuilder::DevAllocType::kNdarray) {
+      num_skipped_++;
+      return;
+    }
+    array.runtime_size = ctx.array_runtime_sizes[arg_id];
+    array.bytes = array.type == LaunchContextBuilder::DevAllocType::kNdarray
+                      ? array.runtime_size * param.get_element_size()
+                      : array.runtime_size;
+    auto grad_iter = ctx.array_ptrs.find(
+        concatenate(arg_id, TypeFactory::GRAD_PTR_POS_IN_NDARRAY));
+    array.has_grad = param.needs_grad && grad_iter != ctx.array_ptrs.end() &&
+                     grad_iter->second != nullptr;
+    record.arrays.push_back(std::move(array));
+  }
+  std::sort(record.arrays.begin(), record.arrays.end(),
+            [](const LaunchTraceArray &a, const LaunchTraceArray &b) {
+              return a.arg_id < b.arg_id;
+            });
+  const auto *arg_buffer = (const uint8 *)ctx.get_context().arg_buffer;
+  record.arg_buffer.assign(arg_buffer, arg_buffer + ctx.arg_buffer_size);
+  trace_.records.push_back(std::move(record));
+}
+
+void LaunchTraceRecorder::save(const std::string &filename) const {
+  write_to_binary_file(trace_, filename);
+}
+
+LaunchTraceReplayer::LaunchTraceReplayer(Program *prog,
+                                         const std::string &filename)
+    : prog_(prog) {
+  TI_ERROR_IF(!read_from_binary_file(trace_, filename),
+              "Cannot read the launch trace {}", filename);
+  TI_ERROR_IF(trace_.magic != LaunchTrace::kMagic,
+              "{} is not a launch trace", filename);
+  if (trace_.version[0] != TI_VERSION_MAJOR ||
+      trace_.version[1] != TI_VERSION_MINOR ||
+      trace_.version[2] != TI_VERSION_PATCH) {
+    TI_WARN(
+        "The launch trace {} was recorded with Taichi {}.{}.{}, whose offline "
+        "cache is not loaded by this version",
+        filename, trace_.version[0], trace_.version[1], trace_.version[2]);
+  }
+  load_kernels();
+}
+
+LaunchTraceReplayer::~LaunchTraceReplayer() {
+  for (auto &[_, ndarrays] : ndarrays_) {
+    for (auto *ndarray : ndarrays) {
+      prog_->delete_ndarray(ndarray);
+    }
+  }
+}
+
+void LaunchTraceReplayer::load_kernels() {
+  const auto arch = prog_->compile_config().arch;
+  TI_ERROR_IF(trace_.arch != arch,
+              "The launch trace was recorded on arch={}, but the program runs "
+              "on arch={}",
+              arch_name(trace_.arch), arch_name(arch));
+  TI_ERROR_IF(!arch_uses_llvm(arch),
+              "Launch traces are only replayed on the LLVM backends");
+#ifdef TI_WITH_LLVM
+  auto &mgr = prog_->get_program_impl()->get_kernel_compilation_manager();
+  for (const auto &kernel : trace_.kernels) {
+    const auto *compiled = mgr.load_cached_kernel(kernel.key, arch);
+    TI_ERROR_IF(!compiled,
+                "Kernel '{}' (key='{}') is not in the offline cache {}",
+                kernel.name, kernel.key,
+                prog_->compile_config().offline_cache_file_path);
+    const auto &data =
+        dynamic_cast<const LLVM::CompiledKernelData *>(compiled)
+            ->get_internal_data();
+    auto callable = std::make_unique<CallableBase>();
+    for (const auto &[arg_id, param] : data.args) {
+      callable->nested_parameters[arg_id] = param;
+    }
+    callable->rets = data.rets;
+    callable->ret_type = data.ret_type;
+    callable->ret_size = data.ret_size;
+    callable->args_type = data.args_type;
+    callable->args_size = data.args_size;
+    callable->arch = arch;
+    callable->name = kernel.name;
+    kernels_.push_back({compiled, std::move(callable)});
+  }
+#endif
+}
+
+void *LaunchTraceReplayer::get_array_buffer(const LaunchTraceArray &array) {
+  const auto bytes = std::max<std::size_t>(array.bytes, 1);
+  if (array.type == LaunchContextBuilder::DevAllocType::kNdarray) {
+    auto &ndarrays = ndarrays_[bytes];
+    auto &num_used = num_used_ndarrays_[bytes];
+    if (num_used == (int)ndarrays.size()) {
+      // u32 elements, for the fast fill on the LLVM backends.
+      const auto num_elements = (bytes + 3) / 4;
+      TI_ERROR_IF(num_elements > INT_MAX, "Array of {} bytes is too large",
+                  bytes);
+      ndarrays.push_back(prog_->create_ndarray(
+          PrimitiveType::u32, {(int)num_elements}, ExternalArrayLayout::kNull,
+          /*zero_fill=*/true));
+    }
+    return &ndarrays[num_used++]->ndarray_alloc_;
+  }
+  auto &buffers = host_buffers_[bytes];
+  auto &num_used = num_used_host_buffers_[bytes];
+  if (num_used == (int)buffers.size()) {
+    buffers.push_back(std::make_unique<uint8[]>(bytes));
+  }
+  return buffers[num_used++].get();
+}
+
+LaunchContextBuilder LaunchTraceReplayer::make_launch_context(
+    const LaunchTraceRecord &record) {
+  auto &kernel = kernels_[record.kernel_id];
+  LaunchContextBuilder ctx(kernel.callable.get());
+  TI_ASSERT(record.arg_buffer.size() == ctx.arg_buffer_size);
+  std::memcpy(ctx.get_context().arg_buffer, record.arg_buffer.data(),
+              record.arg_buffer.size());
+  num_used_ndarrays_.clear();
+  num_used_host_buffers_.clear();
+  for (const auto &array : record.arrays) {
+    ctx.array_ptrs[concatenate(array.arg_id,
+                               TypeFactory::DATA_PTR_POS_IN_NDARRAY)] =
+        get_array_buffer(array);
+    ctx.array_ptrs[concatenate(array.arg_id,
+                               TypeFactory::GRAD_PTR_POS_IN_NDARRAY)] =
+        array.has_grad ? get_array_buffer(array) : nullptr;
+    ctx.set_array_runtime_size(array.arg_id, array.runtime_size);
+    ctx.set_array_device_allocation_type(array.arg_id, array.type);
+  }
+  return ctx;
+}
+
+LaunchTraceReplayResult LaunchTraceReplayer::replay(int repeats,
+                                                    bool synchronize_each) {
+  std::vector<KernelLatencyStatistics> statistics;
+  for (const auto &kernel : trace_.kernels) {
+    statistics.emplace_back(kernel.name);
+  }
+  LaunchTraceReplayResult result;
+  prog_->synchronize();
+  const auto start_time = Time::get_time();
+  for (int i = 0; i < repeats; i++) {
+    for (const auto &record : trace_.records) {
+      auto ctx = make_launch_context(record);
+      const auto launch_time = Time::get_time();
+      prog_->launch_kernel(*kernels_[record.kernel_id].compiled, ctx);
+      if (synchronize_each) {
+        prog_->synchronize();
+        statistics[record.kernel_id].insert_record(
+            (Time::get_time() - launch_time) * 1e3);
+      }
+      result.num_launches++;
+    }
+  }
+  prog_->synchronize();
+  result.total_time = Time::get_time() - start_time;
+  for (auto &s : statistics) {
+    if (s.counter > 0) {
+      result.kernels.push_back(std::move(s));
+    }
+  }
+  return result;
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/program/callable.h"
+#include "taichi/program/kernel_statistics.h"
+#include "taichi/program/launch_context_builder.h"
+#include "taichi/rhi/arch.h"
+#include "taichi/util/lang_util.h"
+
+namespace taichi::lang {
+
+class CompiledKernelData;
+class Kernel;
+class Ndarray;
+class Program;
+
+struct LaunchTraceKernel {
+  // The offline cache key of the kernel.
+  std::string key;
+  std::string name;
+
+  TI_IO_DEF(key, name);
+};
+
+// An ndarray or external array argument, recreated in its size on replay.
+struct LaunchTraceArray {
+  std::vector<int> arg_id;
+  LaunchContextBuilder::DevAllocType type{
+      LaunchContextBuilder::DevAllocType::kNone};
+  // Elements for ndarrays, bytes for external arrays.
+  uint64 runtime_size{0};
+  std::size_t bytes{0};
+  bool has_grad{false};
+
+  TI_IO_DEF(arg_id, type, runtime_size, bytes, has_grad);
+};
+
+struct LaunchTraceRecord {
+  int kernel_id{0};
+  // Seconds since the start of the recording.
+  float64 time{0};
+  // The scalars and the shapes of the arrays, as laid out in the arguments.
+  std::vector<uint8> arg_buffer;
+  std::vector<LaunchTraceArray> arrays;
+
+  TI_IO_DEF(kernel_id, time, arg_buffer, arrays);
+};
+
+// The kernel launches of a program, replayed from the offline cache by
+// LaunchTraceReplayer to benchmark them without the Python frontend.
+struct LaunchTrace {
+  static constexpr char kMagic[] = "ti.launch_trace";
+
+  std::string magic{kMagic};
+  std::uint16_t version[3]{};
+  Arch arch{Arch::x64};
+  std::vector<LaunchTraceKernel> kernels;
+  std::vector<LaunchTraceRecord> records;
+
+  TI_IO_DEF(magic, version, arch, kernels, records);
+};
+
+// Records the launches of the kernels from the offline cache. The kernels of
+// SNode accessors, fused kernels and launches with argpacks are skipped.
+class LaunchTraceRecorder {
+ public:
+  explicit LaunchTraceRecorder(Arch arch);
+
+  // Called for each kernel compiled or loaded while recording, which the
+  // following launches of its CompiledKernelData refer to.
+  void register_kernel(const CompiledKernelData &compiled,
+                       const Kernel &kernel,
+                       bool cached_on_disk);
+
+  // Must be called before the launch, which patches the arguments.
+  void record(const CompiledKernelData &compiled, LaunchContextBuilder &ctx);
+
+  void save(const std::string &filename) const;
+
+  const LaunchTrace &get_trace() const {
+    return trace_;
+  }
+
+  int get_num_skipped() const {
+    return num_skipped_;
+  }
+
+ private:
+  LaunchTrace trace_;
+  float64 start_time_{0};
+  std::unordered_map<std::string, int> kernel_ids_;
+  // -1 for the kernels that are not replayable.
+  std::unordered_map<const CompiledKernelData *, int> compiled_ids_;
+  int num_skipped_{0};
+};
+
+struct LaunchTraceReplayResult {
+  int num_launches{0};
+  // The wall time of the replay, synchronization included.
+  float64 total_time{0};
+  // The time of each kernel, in ms, only when synchronizing each launch.
+  std::vector<KernelLatencyStatistics> kernels;
+};
+
+// Replays a LaunchTrace with kernels loaded from the offline cache by their
+// keys, so the program needs the offline cache path of the recording. The
+// arrays are replaced with zero-filled buffers of the same sizes and the
+// SNode trees are not recreated, so only the kernels over ndarrays and
+// scalars replay faithfully. LLVM backends only.
+class LaunchTraceReplayer {
+ public:
+  LaunchTraceReplayer(Program *prog, const std::string &filename);
+  ~LaunchTraceReplayer();
+
+  // Launches the recorded sequence |repeats| times. When |synchronize_each|,
+  // each launch is timed up to its completion; otherwise the launches are
+  // issued back to back and only the total time is measured.
+  LaunchTraceReplayResult replay(int repeats, bool synchronize_each);
+
+  const LaunchTrace &get_trace() const {
+    return trace_;
+  }
+
+ private:
+  struct ReplayKernel {
+    const CompiledKernelData *compiled{nullptr};
+    // The arguments of the kernel, as a Kernel would describe them.
+    std::unique_ptr<CallableBase> callable;
+  };
+
+  void load_kernels();
+  void *get_array_buffer(const LaunchTraceArray &array);
+  LaunchContextBuilder make_launch_context(const LaunchTraceRecord &record);
+
+  Program *prog_{nullptr};
+  LaunchTrace trace_;
+  std::vector<ReplayKernel> kernels_;
+  // Buffers reused across the launches, by size.
+  std::unordered_map<std::size_t, std::vector<Ndarray *>> ndarrays_;
+  std::unordered_map<std::size_t, std::vector<std::unique_ptr<uint8[]>>>
+      host_buffers_;
+  std::unordered_map<std::size_t, int> num_used_ndarrays_;
+  std::unordered_map<std::size_t, int> num_used_host_buffers_;
+};
+
+}  // namespace taichi::lang
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "taichi/rhi/common/caching_device_allocator.h"
+#include "taichi/rhi/common/host_memory_pool.h"
+#include "taichi/util/lang_util.h"
+
+namespace taichi::lang {
+
+// A ListManager of the LLVM runtime, which grows by chunks.
+struct ListMemoryUsage {
+  int64 num_elements{0};
+  int64 num_chunks{0};
+  int64 elements_per_chunk{0};
+  int64 element_size{0};
+
+  std::size_t reserved_bytes() const {
+    return std::size_t(num_chunks * elements_per_chunk * element_size);
+  }
+};
+
+// The dynamically allocated memory of a sparse SNode on the LLVM backends.
+struct SNodeMemoryUsage {
+  int snode_id{0};
+  std::string name;
+  // The active elements, listed before the struct-fors over the SNode.
+  ListMemoryUsage element_list;
+  // The NodeManager allocating the cells, absent for dense SNodes.
+  bool has_node_allocator{false};
+  ListMemoryUsage data_list;
+  ListMemoryUsage free_list;
+  ListMemoryUsage recycled_list;
+  // The cells of the free list handed out since the last garbage collection.
+  int64 free_list_used{0};
+
+  // The cells neither free nor waiting for the garbage collection.
+  int64 num_live_cells() const {
+    const int64 num_unused_free = std::max<int64>(
+        free_list.num_elements - free_list_used, 0);
+    return data_list.num_elements - num_unused_free -
+           recycled_list.num_elements;
+  }
+
+  std::size_t reserved_bytes() const {
+    return element_list.reserved_bytes() + data_list.reserved_bytes() +
+           free_list.reserved_bytes() + recycled_list.reserved_bytes();
+  }
+
+  std::size_t used_bytes() const {
+    return std::size_t(num_live_cells() * data_list.element_size);
+  }
+};
+
+struct NdarrayMemoryUsage {
+  std::vector<int> shape;
+  std::string dtype;
+  std::size_t bytes{0};
+};
+
+// A snapshot of the memory used by a program, see Program::query_memory_usage.
+// The fields a backend cannot report are left zero or empty.
+struct MemoryUsage {
+  // The kernel launched before a sampled snapshot.
+  std::string label;
+  float64 time{0};
+  std::vector<SNodeMemoryUsage> snodes;
+  // The root buffers of the SNode trees.
+  std::size_t snode_tree_bytes{0};
+  std::vector<NdarrayMemoryUsage> ndarrays;
+  int num_argpacks{0};
+  std::size_t argpack_bytes{0};
+  // The memory preallocated for the runtime on CUDA and AMDGPU, from which
+  // the SNodes and the runtime objects are allocated.
+  std::size_t runtime_memory_reserved{0};
+  std::size_t runtime_memory_used{0};
+  // All the dynamic allocations of the runtime, without alignment padding.
+  std::size_t total_requested_memory{0};
+  HostMemoryPool::Stats host_memory_pool;
+  // The memory of the deleted ndarrays kept by the device for reuse.
+  CachingDeviceAllocator::Stats device_allocation_cache;
+};
+
+}  // namespace taichi::lang
@@ -117,6 +117,16 @@ Ndarray::Ndarray(DeviceAllocation &devalloc,
   TI_ASSERT(type->is<PrimitiveType>());
 }
 
+Ndarray::Ndarray(Program *prog,
+                 DeviceAllocation &devalloc,
+                 const DataType type,
+                 const std::vector<int> &shape,
+                 ExternalArrayLayout layout,
+                 const DebugInfo &dbg_info)
+    : Ndarray(devalloc, type, shape, layout, dbg_info) {
+  prog_ = prog;
+}
+
 Ndarray::~Ndarray() {
   if (prog_) {
     // prog_->flush();
@@ -155,7 +165,7 @@ std::size_t Ndarray::get_nelement() const {
 }
 
 TypedConstant Ndarray::read(const std::vector<int> &I) const {
-  prog_->synchronize();
+  prog_->synchronize_allocation(ndarray_alloc_, /*host_write=*/false);
   size_t index = flatten_index(total_shape_, I);
   size_t size = data_type_size(get_element_data_type());
   taichi::lang::Device::AllocParams alloc_params;
@@ -166,9 +176,9 @@ TypedConstant Ndarray::read(const std::vector<int> &I) const {
   auto [staging_buf_, res] =
       this->ndarray_alloc_.device->allocate_memory_unique(alloc_params);
   TI_ASSERT(res == RhiResult::success);
-  staging_buf_->device->memcpy_internal(
-      staging_buf_->get_ptr(),
-      this->ndarray_alloc_.get_ptr(/*offset=*/index * size), size);
+  prog_->copy_for_host(staging_buf_->get_ptr(),
+                       this->ndarray_alloc_.get_ptr(/*offset=*/index * size),
+                       size);
 
   char *device_arr_ptr{nullptr};
   TI_ASSERT(staging_buf_->device->map(
@@ -186,11 +196,14 @@ TypedConstant Ndarray::read(const std::vector<int> &I) const {
 }
 
 void Ndarray::write(const std::vector<int> &I, TypedConstant val) const {
+  TI_ERROR_IF(read_only, "Cannot write to a read-only memory-mapped ndarray");
   if (get_element_data_type()->is_primitive(PrimitiveTypeID::f16)) {
     uint16_t float16 = fp16_ieee_from_fp32_value(val.val_f32);
     std::memcpy(&val.value_bits, &float16, 4);
   }
 
+  // The pending launches writing the ndarray must not overwrite this write
+  prog_->synchronize_allocation(ndarray_alloc_, /*host_write=*/true);
   size_t index = flatten_index(total_shape_, I);
   size_t size_ = data_type_size(get_element_data_type());
   taichi::lang::Device::AllocParams alloc_params;
@@ -210,11 +223,8 @@ void Ndarray::write(const std::vector<int> &I, TypedConstant val) const {
   std::memcpy(device_arr_ptr, &val.value_bits, size_);
 
   staging_buf_->device->unmap(*staging_buf_);
-  staging_buf_->device->memcpy_internal(
-      this->ndarray_alloc_.get_ptr(index * size_), staging_buf_->get_ptr(),
-      size_);
-
-  prog_->synchronize();
+  prog_->copy_for_host(this->ndarray_alloc_.get_ptr(index * size_),
+                       staging_buf_->get_ptr(), size_);
 }
 
 int64 Ndarray::read_int(const std::vector<int> &i) {
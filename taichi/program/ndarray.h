@@ -36,6 +36,16 @@ class TI_DLL_EXPORT Ndarray {
                    ExternalArrayLayout layout = ExternalArrayLayout::kNull,
                    const DebugInfo &dbg_info = DebugInfo());
 
+  /* Constructs a Ndarray managed by Program on an existing DeviceAllocation,
+   * e.g. a memory-mapped file. Program deallocates it with the Ndarray.
+   */
+  explicit Ndarray(Program *prog,
+                   DeviceAllocation &devalloc,
+                   const DataType type,
+                   const std::vector<int> &shape,
+                   ExternalArrayLayout layout = ExternalArrayLayout::kNull,
+                   const DebugInfo &dbg_info = DebugInfo());
+
   /* Constructs a Ndarray from an existing DeviceAllocation.
    * This is an overloaded constructor for constructing Ndarray with TensorType
    * elements "type" is expected to be PrimitiveType
@@ -55,6 +65,9 @@ class TI_DLL_EXPORT Ndarray {
   std::vector<int> shape;
   ExternalArrayLayout layout{ExternalArrayLayout::kNull};
   DebugInfo dbg_info;
+  // Set on the ndarrays mapped from a file in read-only mode, which the host
+  // must not write. Kernel writes stay private to the process.
+  bool read_only{false};
 
   std::vector<int> get_element_shape() const;
   DataType get_element_data_type() const;
@@ -146,6 +146,12 @@ Program::Program(Arch desired_arch) : snode_rw_accessors_bank_(this) {
   result_buffer = nullptr;
   finalized_ = false;
 
+  kernel_fusion_queue_ = std::make_unique<KernelFusionQueue>(
+      this, [this](Kernel &kernel, LaunchContextBuilder &ctx) {
+        launch_kernel(
+            compile_kernel(compile_config(), get_device_caps(), kernel), ctx);
+      });
+
   if (!is_extension_supported(config.arch, Extension::assertion)) {
     if (config.check_out_of_bound) {
       TI_WARN("Out-of-bound access checking is not supported on arch={}",
@@ -184,15 +190,45 @@ const CompiledKernelData &Program::compile_kernel(
   auto &mgr = program_impl_->get_kernel_compilation_manager();
   const auto &ckd = mgr.load_or_compile(compile_config, caps, kernel_def);
   total_compilation_time_ += Time::get_time() - start_t;
+  if (launch_trace_recorder_) {
+    launch_trace_recorder_->register_kernel(
+        ckd, kernel_def,
+        /*cached_on_disk=*/compile_config.offline_cache &&
+            kernel_def.ir_is_ast());
+  }
   return ckd;
 }
 
 void Program::launch_kernel(const CompiledKernelData &compiled_kernel_data,
                             LaunchContextBuilder &ctx) {
+  flush_lazy_launches();
+  if (launch_trace_recorder_) {
+    launch_trace_recorder_->record(compiled_kernel_data, ctx);
+  }
   program_impl_->get_kernel_launcher().launch_kernel(compiled_kernel_data, ctx);
   if (compile_config().debug && arch_uses_llvm(compiled_kernel_data.arch())) {
     program_impl_->check_runtime_error(result_buffer);
   }
+  if (memory_sampling_) {
+    synchronize();
+    memory_samples_.push_back(query_memory_usage());
+    memory_samples_.back().label = ctx.get_kernel()->name;
+  }
+}
+
+void Program::launch_kernel_lazily(Kernel &kernel, LaunchContextBuilder &ctx) {
+  if (!compile_config().lazy_kernel_fusion) {
+    launch_kernel(compile_kernel(compile_config(), get_device_caps(), kernel),
+                  ctx);
+    return;
+  }
+  kernel_fusion_queue_->enqueue(kernel, std::move(ctx));
+}
+
+void Program::flush_lazy_launches() {
+  if (kernel_fusion_queue_) {
+    kernel_fusion_queue_->flush();
+  }
 }
 
 void Program::materialize_runtime() {
@@ -212,6 +248,7 @@ static void remove_rw_accessor_cache(
 }
 
 void Program::destroy_snode_tree(SNodeTree *snode_tree) {
+  flush_lazy_launches();
   TI_ASSERT(arch_uses_llvm(compile_config().arch) ||
             compile_config().arch == Arch::vulkan ||
             compile_config().arch == Arch::dx11 ||
@@ -259,10 +296,22 @@ SNode *Program::get_snode_root(int tree_id) {
 }
 
 void Program::synchronize() {
+  flush_lazy_launches();
   program_impl_->synchronize();
 }
 
+void Program::synchronize_allocation(const DeviceAllocation &alloc,
+                                     bool host_write) {
+  flush_lazy_launches();
+  program_impl_->synchronize_allocation(alloc, host_write);
+}
+
+void Program::copy_for_host(DevicePtr dst, DevicePtr src, size_t size) {
+  program_impl_->copy_for_host(dst, src, size);
+}
+
 StreamSemaphore Program::flush() {
+  flush_lazy_launches();
   return program_impl_->flush();
 }
 
@@ -367,6 +416,47 @@ void Program::print_memory_profiler_info() {
   program_impl_->print_memory_profiler_info(snode_trees_, result_buffer);
 }
 
+MemoryUsage Program::query_memory_usage() {
+  MemoryUsage usage;
+  usage.time = Time::get_time();
+  program_impl_->query_memory_usage(snode_trees_, result_buffer, usage);
+  for (auto &[ptr, ndarray] : ndarrays_) {
+    usage.ndarrays.push_back({ndarray->shape, ndarray->dtype->to_string(),
+                              ndarray->get_nelement() *
+                                  ndarray->get_element_size()});
+  }
+  usage.num_argpacks = (int)argpacks_.size();
+  for (auto &[ptr, argpack] : argpacks_) {
+    usage.argpack_bytes += argpack->get_nbytes();
+  }
+  usage.host_memory_pool = HostMemoryPool::get_instance().get_stats();
+  return usage;
+}
+
+void Program::start_launch_trace() {
+  if (!compile_config().offline_cache) {
+    TI_WARN(
+        "The offline cache is off, so the launch trace cannot be replayed");
+  }
+  flush_lazy_launches();
+  launch_trace_recorder_ =
+      std::make_unique<LaunchTraceRecorder>(compile_config().arch);
+}
+
+int Program::stop_launch_trace(const std::string &filename) {
+  TI_ERROR_IF(!launch_trace_recorder_, "The launch trace is not started");
+  flush_lazy_launches();
+  auto recorder = std::move(launch_trace_recorder_);
+  if (recorder->get_num_skipped() > 0) {
+    TI_WARN(
+        "{} launches of kernels outside the offline cache, or with argpacks "
+        "or textures, are not in the launch trace",
+        recorder->get_num_skipped());
+  }
+  recorder->save(filename);
+  return (int)recorder->get_trace().records.size();
+}
+
 std::size_t Program::get_snode_num_dynamically_allocated(SNode *snode) {
   return program_impl_->get_snode_num_dynamically_allocated(snode,
                                                             result_buffer);
@@ -380,7 +470,9 @@ Ndarray *Program::create_ndarray(const DataType type,
   auto arr = std::make_unique<Ndarray>(this, type, shape, layout, dbg_info);
   if (zero_fill) {
     Arch arch = compile_config().arch;
-    if (arch_is_cpu(arch) || arch == Arch::cuda || arch == Arch::amdgpu) {
+    if (arch_is_cpu(arch)) {
+      // Already zeroed by CpuDevice, see CpuDevice::set_thread_pool()
+    } else if (arch == Arch::cuda || arch == Arch::amdgpu) {
       fill_ndarray_fast_u32(arr.get(), /*data=*/0);
     } else if (arch != Arch::dx12) {
       // Device api support for dx12 backend are not complete yet
@@ -399,6 +491,28 @@ Ndarray *Program::create_ndarray(const DataType type,
   return arr_ptr;
 }
 
+Ndarray *Program::map_ndarray_file(const DataType type,
+                                   const std::vector<int> &shape,
+                                   ExternalArrayLayout layout,
+                                   const std::string &path,
+                                   std::size_t offset,
+                                   bool read_only,
+                                   const std::string &access_hint,
+                                   const DebugInfo &dbg_info) {
+  std::size_t size = data_type_size(type);
+  for (int n : shape) {
+    size *= n;
+  }
+  auto alloc =
+      program_impl_->map_file_on_device(path, offset, size, access_hint);
+  auto arr =
+      std::make_unique<Ndarray>(this, alloc, type, shape, layout, dbg_info);
+  arr->read_only = read_only;
+  auto arr_ptr = arr.get();
+  ndarrays_.insert({arr_ptr, std::move(arr)});
+  return arr_ptr;
+}
+
 ArgPack *Program::create_argpack(const DataType dt) {
   auto pack = std::make_unique<ArgPack>(this, dt);
   auto pack_ptr = pack.get();
@@ -418,6 +532,7 @@ void Program::delete_ndarray(Ndarray *ndarray) {
   // runtime instead of this giant program and it should be freed when:
   // - Python GC signals taichi that it's no longer useful
   // - All kernels using it are executed.
+  flush_lazy_launches();
   if (ndarrays_.count(ndarray) &&
       !program_impl_->used_in_kernel(ndarray->ndarray_alloc_.alloc_id)) {
     ndarrays_.erase(ndarray);
@@ -460,6 +575,7 @@ Texture *Program::create_texture(BufferFormat buffer_format,
 }
 
 intptr_t Program::get_ndarray_data_ptr_as_int(const Ndarray *ndarray) {
+  flush_lazy_launches();
   uint64_t *data_ptr{nullptr};
   if (arch_is_cpu(compile_config().arch) ||
       compile_config().arch == Arch::cuda ||
@@ -473,6 +589,9 @@ intptr_t Program::get_ndarray_data_ptr_as_int(const Ndarray *ndarray) {
 }
 
 void Program::fill_ndarray_fast_u32(Ndarray *ndarray, uint32_t val) {
+  TI_ERROR_IF(ndarray->read_only,
+              "Cannot fill a read-only memory-mapped ndarray");
+  flush_lazy_launches();
   // This is a temporary solution to bypass device api.
   // Should be moved to CommandList once available in CUDA.
   program_impl_->fill_ndarray(
@@ -568,6 +687,7 @@ int Program::allocate_snode_tree_id() {
 void Program::enqueue_compute_op_lambda(
     std::function<void(Device *device, CommandList *cmdlist)> op,
     const std::vector<ComputeOpImageRef> &image_refs) {
+  flush_lazy_launches();
   program_impl_->enqueue_compute_op_lambda(op, image_refs);
 }
 
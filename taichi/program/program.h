@@ -20,7 +20,9 @@
 #include "taichi/program/callable.h"
 #include "taichi/program/function.h"
 #include "taichi/program/kernel.h"
+#include "taichi/program/kernel_fusion.h"
 #include "taichi/program/kernel_profiler.h"
+#include "taichi/program/launch_trace.h"
 #include "taichi/program/snode_expr_utils.h"
 #include "taichi/program/snode_rw_accessors_bank.h"
 #include "taichi/program/context.h"
@@ -105,6 +107,12 @@ class TI_DLL_EXPORT Program {
 
   void synchronize();
 
+  void synchronize_allocation(const DeviceAllocation &alloc, bool host_write);
+
+  // Copies between an ndarray and a staging buffer, see
+  // ProgramImpl::copy_for_host().
+  void copy_for_host(DevicePtr dst, DevicePtr src, size_t size);
+
   StreamSemaphore flush();
 
   /**
@@ -133,6 +141,23 @@ class TI_DLL_EXPORT Program {
   void launch_kernel(const CompiledKernelData &compiled_kernel_data,
                      LaunchContextBuilder &ctx);
 
+  /**
+   * Launches |kernel| with |ctx| lazily if
+   * `CompileConfig::lazy_kernel_fusion` is on, so that it can be fused with
+   * the consecutive launches (see KernelFusionQueue). Otherwise launches it
+   * right away.
+   *
+   * Deferred launches are flushed by any eager launch, synchronization or
+   * host access to an ndarray, and by `flush_lazy_launches()`.
+   */
+  void launch_kernel_lazily(Kernel &kernel, LaunchContextBuilder &ctx);
+
+  void flush_lazy_launches();
+
+  KernelFusionQueue &get_kernel_fusion_queue() {
+    return *kernel_fusion_queue_;
+  }
+
   DeviceCapabilityConfig get_device_caps() {
     return program_impl_->get_device_caps();
   }
@@ -170,6 +195,28 @@ class TI_DLL_EXPORT Program {
   // it's exposed to python.
   void print_memory_profiler_info();
 
+  // Reports the memory reserved and used by the SNodes, the ndarrays, the
+  // argpacks and the memory pools.
+  MemoryUsage query_memory_usage();
+
+  // When enabled, the memory usage is queried after each kernel launch, which
+  // synchronizes the device.
+  void set_memory_sampling(bool enabled) {
+    memory_sampling_ = enabled;
+  }
+
+  std::vector<MemoryUsage> take_memory_samples() {
+    return std::move(memory_samples_);
+  }
+
+  // Records the kernel launches until stop_launch_trace(), for
+  // LaunchTraceReplayer. The kernels are replayed from the offline cache,
+  // which is written when the program is finalized.
+  void start_launch_trace();
+
+  // Saves the recorded launches to |filename|, returns their number.
+  int stop_launch_trace(const std::string &filename);
+
   // Returns zero if the SNode is statically allocated
   std::size_t get_snode_num_dynamically_allocated(SNode *snode);
 
@@ -241,6 +288,10 @@ class TI_DLL_EXPORT Program {
     return program_impl_->get_graphics_device();
   }
 
+  ThreadPool *get_thread_pool() {
+    return program_impl_->get_thread_pool();
+  }
+
   // TODO: do we still need result_buffer?
   DeviceAllocation allocate_memory_on_device(std::size_t alloc_size,
                                              uint64 *result_buffer) {
@@ -257,6 +308,19 @@ class TI_DLL_EXPORT Program {
       bool zero_fill = false,
       const DebugInfo &dbg_info = DebugInfo());
 
+  // Creates an Ndarray on a memory-mapped file, starting at byte |offset|.
+  // The mapping is copy-on-write, the file is never written. The host may not
+  // write the ndarray if |read_only|. CPU only.
+  Ndarray *map_ndarray_file(
+      const DataType type,
+      const std::vector<int> &shape,
+      ExternalArrayLayout layout,
+      const std::string &path,
+      std::size_t offset,
+      bool read_only,
+      const std::string &access_hint,
+      const DebugInfo &dbg_info = DebugInfo());
+
   ArgPack *create_argpack(const DataType dt);
 
   std::string get_kernel_return_data_layout() {
@@ -339,6 +403,7 @@ class TI_DLL_EXPORT Program {
   std::unordered_map<FunctionKey, Function *> function_map_;
 
   std::unique_ptr<ProgramImpl> program_impl_;
+  std::unique_ptr<KernelFusionQueue> kernel_fusion_queue_;
   float64 total_compilation_time_{0.0};
   static std::atomic<int> num_instances_;
   bool finalized_{false};
@@ -347,6 +412,11 @@ class TI_DLL_EXPORT Program {
   std::unordered_map<void *, std::unique_ptr<Ndarray>> ndarrays_;
   std::unordered_map<void *, std::unique_ptr<ArgPack>> argpacks_;
   std::vector<std::unique_ptr<Texture>> textures_;
+
+  bool memory_sampling_{false};
+  std::vector<MemoryUsage> memory_samples_;
+
+  std::unique_ptr<LaunchTraceRecorder> launch_trace_recorder_;
 };
 
 }  // namespace taichi::lang
@@ -7,10 +7,12 @@
 #include "taichi/program/snode_expr_utils.h"
 #include "taichi/program/kernel_profiler.h"
 #include "taichi/program/kernel_launcher.h"
+#include "taichi/program/memory_usage.h"
 #include "taichi/rhi/device.h"
 #include "taichi/aot/graph_data.h"
 #include "taichi/codegen/kernel_compiler.h"
 #include "taichi/compilation_manager/kernel_compilation_manager.h"
+#include "taichi/system/threading.h"
 
 namespace taichi::lang {
 
@@ -63,11 +65,30 @@ class ProgramImpl {
    */
   virtual void synchronize() = 0;
 
+  /**
+   * Wait until the pending device work accessing |alloc| has completed, so
+   * that the host can read it (or overwrite it if |host_write| is set).
+   * Backends without per-allocation tracking fall back to synchronize().
+   */
+  virtual void synchronize_allocation(const DeviceAllocation &alloc,
+                                      bool host_write) {
+    synchronize();
+  }
+
   virtual StreamSemaphore flush() {
     synchronize();
     return nullptr;
   }
 
+  /**
+   * Copies |size| bytes between an allocation and a staging buffer for a
+   * host access. Backends that track submissions only wait for the copy.
+   */
+  virtual void copy_for_host(DevicePtr dst, DevicePtr src, size_t size) {
+    dst.device->memcpy_internal(dst, src, size);
+    synchronize();
+  }
+
   /**
    * Make a AotModulerBuilder.
    */
@@ -104,6 +125,22 @@ class ProgramImpl {
     return false;
   }
 
+  // Maps |size| bytes of a file from |offset| on as a device allocation, see
+  // CpuDevice::map_file().
+  virtual DeviceAllocation map_file_on_device(const std::string &path,
+                                              std::size_t offset,
+                                              std::size_t size,
+                                              const std::string &access_hint) {
+    TI_ERROR("Memory-mapped ndarrays are not supported on the current backend");
+    return kDeviceNullAllocation;
+  }
+
+  // The pool running the CPU kernels, which host-side work can borrow while
+  // no kernel is running. nullptr if the backend has none.
+  virtual ThreadPool *get_thread_pool() {
+    return nullptr;
+  }
+
   virtual DeviceAllocation allocate_texture(const ImageParams &params) {
     return kDeviceNullAllocation;
   }
@@ -138,6 +175,14 @@ class ProgramImpl {
         "print_memory_profiler_info() not implemented on the current backend");
   }
 
+  // Fills the SNode and runtime fields of |usage|. Backends without dynamic
+  // SNode allocation leave them empty.
+  virtual void query_memory_usage(
+      std::vector<std::unique_ptr<SNodeTree>> &snode_trees,
+      uint64 *result_buffer,
+      MemoryUsage &usage) {
+  }
+
   virtual void check_runtime_error(uint64 *result_buffer) {
     TI_ERROR("check_runtime_error() not implemented on the current backend");
   }
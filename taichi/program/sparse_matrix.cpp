@@ -1,11 +1,16 @@
 #include "taichi/program/sparse_matrix.h"
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 
+#include "taichi/util/hash.h"
+
 #include "Eigen/Dense"
 #include "Eigen/SparseLU"
 
@@ -25,10 +30,24 @@
         }                                                                      \
   }
 
-#define INSTANTIATE_SPMV(type, storage)                               \
-  template void                                                       \
-  EigenSparseMatrix<Eigen::SparseMatrix<type, Eigen::storage>>::spmv( \
-      Program *prog, const Ndarray &x, const Ndarray &y);
+#define INSTANTIATE_SPMV(type, storage)                                       \
+  template void                                                               \
+  EigenSparseMatrix<Eigen::SparseMatrix<type, Eigen::storage>>::spmv(         \
+      Program *prog, const Ndarray &x, const Ndarray &y);                     \
+  template void EigenSparseMatrix<                                            \
+      Eigen::SparseMatrix<type, Eigen::storage>>::multiply_vector(            \
+      const type *x, type *y, ThreadPool *pool);                              \
+  template void EigenSparseMatrix<                                            \
+      Eigen::SparseMatrix<type, Eigen::storage>>::use_sell_c_sigma(int, int); \
+  template sparse_kernels::CompressedView<type, int> EigenSparseMatrix<       \
+      Eigen::SparseMatrix<type, Eigen::storage>>::compressed_view();          \
+  template EigenSparseMatrix<Eigen::SparseMatrix<type, Eigen::storage>>       \
+  EigenSparseMatrix<Eigen::SparseMatrix<type, Eigen::storage>>::matmul(       \
+      const EigenSparseMatrix &, Program *);                                  \
+  template Eigen::Matrix<type, Eigen::Dynamic, 1>                             \
+  EigenSparseMatrix<Eigen::SparseMatrix<type, Eigen::storage>>::mat_vec_mul(  \
+      const Eigen::Ref<const Eigen::Matrix<type, Eigen::Dynamic, 1>> &,       \
+      Program *);
 
 namespace {
 using Pair = std::pair<std::string, std::string>;
@@ -98,6 +117,7 @@ SparseMatrixBuilder::SparseMatrixBuilder(int rows,
 SparseMatrixBuilder::~SparseMatrixBuilder() = default;
 
 void SparseMatrixBuilder::create_ndarray(Program *prog) {
+  prog_ = prog;
   ndarray_data_base_ptr_ = prog->create_ndarray(
       dtype_, std::vector<int>{3 * (int)max_num_triplets_ + 1});
   ndarray_data_ptr_ = prog->get_ndarray_data_ptr_as_int(ndarray_data_base_ptr_);
@@ -160,19 +180,16 @@ intptr_t SparseMatrixBuilder::get_ndarray_data_ptr() const {
   return ndarray_data_ptr_;
 }
 
-template <typename T, typename G>
-void SparseMatrixBuilder::build_template(std::unique_ptr<SparseMatrix> &m) {
-  using V = Eigen::Triplet<T>;
-  std::vector<V> triplets;
+template <typename G>
+void SparseMatrixBuilder::build_template(SparseMatrix &m, bool reuse_pattern) {
   auto ptr = get_ndarray_data_ptr();
   G *data = reinterpret_cast<G *>(ptr);
   num_triplets_ = data[0];
   data += 1;
-  for (int i = 0; i < num_triplets_; i++) {
-    triplets.push_back(
-        V(data[i * 3], data[i * 3 + 1], taichi_union_cast<T>(data[i * 3 + 2])));
+  ThreadPool *pool = prog_ ? prog_->get_thread_pool() : nullptr;
+  if (!reuse_pattern || !m.reassemble_triplets(data, num_triplets_, pool)) {
+    m.assemble_triplets(data, num_triplets_, pool);
   }
-  m->build_triplets(static_cast<void *>(&triplets));
   clear();
 }
 
@@ -183,10 +200,10 @@ std::unique_ptr<SparseMatrix> SparseMatrixBuilder::build() {
   auto element_size = data_type_size(dtype_);
   switch (element_size) {
     case 4:
-      build_template<float32, int32>(sm);
+      build_template<int32>(*sm, /*reuse_pattern=*/false);
       break;
     case 8:
-      build_template<float64, int64>(sm);
+      build_template<int64>(*sm, /*reuse_pattern=*/false);
       break;
     default:
       TI_ERROR("Unsupported sparse matrix data type!");
@@ -195,6 +212,28 @@ std::unique_ptr<SparseMatrix> SparseMatrixBuilder::build() {
   return sm;
 }
 
+void SparseMatrixBuilder::build_into(SparseMatrix &sm) {
+  TI_ASSERT(built_ == false);
+  TI_ERROR_IF(sm.num_rows() != rows_ || sm.num_cols() != cols_ ||
+                  sm.get_data_type() != dtype_,
+              "Cannot build a {}x{} {} sparse matrix into a {}x{} {} one",
+              rows_, cols_, data_type_name(dtype_), sm.num_rows(),
+              sm.num_cols(), data_type_name(sm.get_data_type()));
+  built_ = true;
+  auto element_size = data_type_size(dtype_);
+  switch (element_size) {
+    case 4:
+      build_template<int32>(sm, /*reuse_pattern=*/true);
+      break;
+    case 8:
+      build_template<int64>(sm, /*reuse_pattern=*/true);
+      break;
+    default:
+      TI_ERROR("Unsupported sparse matrix data type!");
+      break;
+  }
+}
+
 std::unique_ptr<SparseMatrix> SparseMatrixBuilder::build_cuda() {
   TI_ASSERT(built_ == false);
   built_ = true;
@@ -258,6 +297,237 @@ void SparseMatrixBuilder::clear() {
   num_triplets_ = 0;
 }
 
+namespace {
+
+using sparse_kernels::parallel_for;
+using sparse_kernels::TaskSplit;
+
+template <typename Matrix>
+sparse_kernels::CompressedView<typename Matrix::Scalar,
+                               typename Matrix::StorageIndex>
+compressed_view_of(const Matrix &m) {
+  TI_ASSERT(m.isCompressed());
+  sparse_kernels::CompressedView<typename Matrix::Scalar,
+                                 typename Matrix::StorageIndex>
+      view;
+  view.outer_size = m.outerSize();
+  view.inner_size = m.innerSize();
+  view.outer = m.outerIndexPtr();
+  view.inner = m.innerIndexPtr();
+  view.values = m.valuePtr();
+  return view;
+}
+
+// Number of triplets and of outer indices handled by each assembly task.
+constexpr int64 kTripletsPerTask = 1 << 14;
+constexpr int64 kOuterIndicesPerTask = 1 << 10;
+
+// The triplets filled by a SparseMatrixBuilder, with the values bit-cast to
+// integers of the same width.
+template <typename T, bool kRowMajor>
+struct BuilderTriplets {
+  using G = std::conditional_t<sizeof(T) == 4, int32, int64>;
+
+  const G *data{nullptr};
+  int64 size{0};
+
+  int64 row(int64 i) const {
+    return data[i * 3];
+  }
+
+  int64 col(int64 i) const {
+    return data[i * 3 + 1];
+  }
+
+  int64 outer(int64 i) const {
+    return kRowMajor ? row(i) : col(i);
+  }
+
+  int64 inner(int64 i) const {
+    return kRowMajor ? col(i) : row(i);
+  }
+
+  T value(int64 i) const {
+    return taichi_union_cast<T>(data[i * 3 + 2]);
+  }
+};
+
+// Triplet indices grouped by outer index with a counting sort, and sorted by
+// inner index within each group. Duplicated entries stay in their original
+// order, so that they are always summed up in the same order.
+struct SortedTriplets {
+  std::vector<int64> outer_offsets;
+  std::vector<int64> order;
+};
+
+template <typename Triplets>
+SortedTriplets sort_triplets(const Triplets &triplets,
+                             int rows,
+                             int cols,
+                             int outer_size,
+                             ThreadPool *pool) {
+  const int64 n = triplets.size;
+  SortedTriplets sorted;
+  sorted.outer_offsets.resize(outer_size + 1);
+  sorted.order.resize(n);
+
+  std::unique_ptr<std::atomic<int64>[]> counts(
+      new std::atomic<int64>[outer_size]());
+  std::atomic<bool> out_of_range{false};
+  TaskSplit split(pool, n, kTripletsPerTask);
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    for (int64 i = split.begin(task); i < split.end(task); i++) {
+      if (triplets.row(i) < 0 || triplets.row(i) >= rows ||
+          triplets.col(i) < 0 || triplets.col(i) >= cols) {
+        out_of_range.store(true, std::memory_order_relaxed);
+        return;
+      }
+      counts[triplets.outer(i)].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  TI_ERROR_IF(out_of_range.load(),
+              "Sparse matrix triplet out of the bounds of the {}x{} matrix",
+              rows, cols);
+
+  int64 offset = 0;
+  for (int o = 0; o < outer_size; o++) {
+    sorted.outer_offsets[o] = offset;
+    offset += counts[o].load(std::memory_order_relaxed);
+  }
+  sorted.outer_offsets[outer_size] = offset;
+
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    for (int64 i = split.begin(task); i < split.end(task); i++) {
+      auto o = triplets.outer(i);
+      auto slot = counts[o].fetch_sub(1, std::memory_order_relaxed) - 1;
+      sorted.order[sorted.outer_offsets[o] + slot] = i;
+    }
+  });
+
+  TaskSplit outer_split(pool, outer_size, kOuterIndicesPerTask);
+  parallel_for(pool, outer_split.num_tasks(), [&](int, int task) {
+    for (int64 o = outer_split.begin(task); o < outer_split.end(task); o++) {
+      std::sort(sorted.order.begin() + sorted.outer_offsets[o],
+                sorted.order.begin() + sorted.outer_offsets[o + 1],
+                [&](int64 a, int64 b) {
+                  auto inner_a = triplets.inner(a);
+                  auto inner_b = triplets.inner(b);
+                  return inner_a != inner_b ? inner_a < inner_b : a < b;
+                });
+    }
+  });
+  return sorted;
+}
+
+}  // namespace
+
+template <class EigenMatrix>
+void EigenSparseMatrix<EigenMatrix>::assemble_triplets(const void *triplets,
+                                                       int64 num_triplets,
+                                                       ThreadPool *pool) {
+  using Scalar = typename EigenMatrix::Scalar;
+  using StorageIndex = typename EigenMatrix::StorageIndex;
+  using Triplets = BuilderTriplets<Scalar, EigenMatrix::IsRowMajor>;
+  Triplets trips{static_cast<const typename Triplets::G *>(triplets),
+                 num_triplets};
+  sell_.reset();
+
+  // Keeps the capacity of the current storage.
+  matrix_.resize(rows_, cols_);
+  const int outer_size = matrix_.outerSize();
+  auto sorted = sort_triplets(trips, rows_, cols_, outer_size, pool);
+
+  // Count the distinct entries of each outer index...
+  std::vector<int64> nnz_offsets(outer_size + 1, 0);
+  TaskSplit outer_split(pool, outer_size, kOuterIndicesPerTask);
+  parallel_for(pool, outer_split.num_tasks(), [&](int, int task) {
+    for (int64 o = outer_split.begin(task); o < outer_split.end(task); o++) {
+      int64 nnz = 0;
+      for (auto k = sorted.outer_offsets[o]; k < sorted.outer_offsets[o + 1];
+           k++) {
+        if (k == sorted.outer_offsets[o] ||
+            trips.inner(sorted.order[k]) != trips.inner(sorted.order[k - 1])) {
+          nnz++;
+        }
+      }
+      nnz_offsets[o + 1] = nnz;
+    }
+  });
+  for (int o = 0; o < outer_size; o++) {
+    nnz_offsets[o + 1] += nnz_offsets[o];
+  }
+
+  // ...then write them straight into the compressed storage.
+  matrix_.resizeNonZeros(nnz_offsets[outer_size]);
+  StorageIndex *outer_index = matrix_.outerIndexPtr();
+  StorageIndex *inner_index = matrix_.innerIndexPtr();
+  Scalar *values = matrix_.valuePtr();
+  for (int o = 0; o <= outer_size; o++) {
+    outer_index[o] = static_cast<StorageIndex>(nnz_offsets[o]);
+  }
+  parallel_for(pool, outer_split.num_tasks(), [&](int, int task) {
+    for (int64 o = outer_split.begin(task); o < outer_split.end(task); o++) {
+      auto pos = nnz_offsets[o] - 1;
+      for (auto k = sorted.outer_offsets[o]; k < sorted.outer_offsets[o + 1];
+           k++) {
+        auto i = sorted.order[k];
+        if (k == sorted.outer_offsets[o] ||
+            trips.inner(i) != trips.inner(sorted.order[k - 1])) {
+          pos++;
+          inner_index[pos] = static_cast<StorageIndex>(trips.inner(i));
+          values[pos] = 0;
+        }
+        values[pos] += trips.value(i);
+      }
+    }
+  });
+}
+
+template <class EigenMatrix>
+bool EigenSparseMatrix<EigenMatrix>::reassemble_triplets(const void *triplets,
+                                                         int64 num_triplets,
+                                                         ThreadPool *pool) {
+  using Scalar = typename EigenMatrix::Scalar;
+  using Triplets = BuilderTriplets<Scalar, EigenMatrix::IsRowMajor>;
+  Triplets trips{static_cast<const typename Triplets::G *>(triplets),
+                 num_triplets};
+  if (!matrix_.isCompressed() || matrix_.rows() != rows_ ||
+      matrix_.cols() != cols_) {
+    return false;
+  }
+  // The pattern stays the same, but the values of the copy are stale.
+  sell_.reset();
+
+  const int outer_size = matrix_.outerSize();
+  auto sorted = sort_triplets(trips, rows_, cols_, outer_size, pool);
+  const auto *outer_index = matrix_.outerIndexPtr();
+  const auto *inner_index = matrix_.innerIndexPtr();
+  Scalar *values = matrix_.valuePtr();
+  std::atomic<bool> fits{true};
+  TaskSplit outer_split(pool, outer_size, kOuterIndicesPerTask);
+  parallel_for(pool, outer_split.num_tasks(), [&](int, int task) {
+    for (int64 o = outer_split.begin(task); o < outer_split.end(task); o++) {
+      auto pos = outer_index[o];
+      auto end = outer_index[o + 1];
+      std::fill(values + pos, values + end, Scalar(0));
+      // Both the triplets and the pattern are sorted by inner index.
+      for (auto k = sorted.outer_offsets[o]; k < sorted.outer_offsets[o + 1];
+           k++) {
+        auto i = sorted.order[k];
+        while (pos < end && inner_index[pos] < trips.inner(i)) {
+          pos++;
+        }
+        if (pos == end || inner_index[pos] != trips.inner(i)) {
+          fits.store(false, std::memory_order_relaxed);
+          return;
+        }
+        values[pos] += trips.value(i);
+      }
+    }
+  });
+  return fits.load();
+}
+
 template <class EigenMatrix>
 const std::string EigenSparseMatrix<EigenMatrix>::to_string() const {
   Eigen::IOFormat clean_fmt(4, 0, ", ", "\n", "[", "]");
@@ -283,8 +553,27 @@ void EigenSparseMatrix<EigenMatrix>::mmwrite(const std::string &filename) {
   file.close();
 }
 
+template <class EigenMatrix>
+uint64 EigenSparseMatrix<EigenMatrix>::pattern_fingerprint() const {
+  // The matrix may be uncompressed, so the non-zeros are iterated over
+  // instead of hashing the index arrays.
+  size_t hash = 0;
+  hashing::hash_combine(hash, matrix_.rows());
+  hashing::hash_combine(hash, matrix_.cols());
+  for (int outer = 0; outer < matrix_.outerSize(); outer++) {
+    int64 count = 0;
+    for (typename EigenMatrix::InnerIterator it(matrix_, outer); it; ++it) {
+      hashing::hash_combine(hash, it.index());
+      count++;
+    }
+    hashing::hash_combine(hash, count);
+  }
+  return hash;
+}
+
 template <class EigenMatrix>
 void EigenSparseMatrix<EigenMatrix>::build_triplets(void *triplets_adr) {
+  sell_.reset();
   std::string sdtype = taichi::lang::data_type_name(dtype_);
   if (sdtype == "f32") {
     BUILD(32)
@@ -299,20 +588,95 @@ template <class EigenMatrix>
 void EigenSparseMatrix<EigenMatrix>::spmv(Program *prog,
                                           const Ndarray &x,
                                           const Ndarray &y) {
+  TI_ERROR_IF(x.get_element_data_type() != y.get_element_data_type() ||
+                  data_type_size(x.get_element_data_type()) != sizeof(Scalar),
+              "Sparse matrix and vectors of spmv must share the data type");
   size_t dX = prog->get_ndarray_data_ptr_as_int(&x);
   size_t dY = prog->get_ndarray_data_ptr_as_int(&y);
-  std::string sdtype = taichi::lang::data_type_name(dtype_);
-  if (sdtype == "f32") {
-    Eigen::Map<Eigen::VectorXf>((float *)dY, cols_) =
-        matrix_.template cast<float>() *
-        Eigen::Map<Eigen::VectorXf>((float *)dX, cols_);
-  } else if (sdtype == "f64") {
-    Eigen::Map<Eigen::VectorXd>((double *)dY, cols_) =
-        matrix_.template cast<double>() *
-        Eigen::Map<Eigen::VectorXd>((double *)dX, cols_);
+  multiply_vector((const Scalar *)dX, (Scalar *)dY, prog->get_thread_pool());
+}
+
+template <class EigenMatrix>
+template <class VT>
+VT EigenSparseMatrix<EigenMatrix>::mat_vec_mul(const Eigen::Ref<const VT> &b,
+                                               Program *prog) {
+  VT result(rows_);
+  multiply_vector(b.data(), result.data(), prog->get_thread_pool());
+  return result;
+}
+
+template <class EigenMatrix>
+void EigenSparseMatrix<EigenMatrix>::multiply_vector(const Scalar *x,
+                                                     Scalar *y,
+                                                     ThreadPool *pool) {
+  if (sell_chunk_size_ > 0) {
+    if (!sell_ && EigenMatrix::IsRowMajor) {
+      sell_ = std::make_unique<SellMatrix>(compressed_view(), sell_chunk_size_,
+                                           sell_sigma_);
+    } else if (!sell_) {
+      Eigen::SparseMatrix<Scalar, Eigen::RowMajor, StorageIndex> row_major =
+          matrix_;
+      sell_ = std::make_unique<SellMatrix>(compressed_view_of(row_major),
+                                           sell_chunk_size_, sell_sigma_);
+    }
+    sell_->spmv(x, y, pool);
+  } else if (EigenMatrix::IsRowMajor) {
+    sparse_kernels::csr_spmv(compressed_view(), x, y, pool);
   } else {
-    TI_ERROR("Unsupported sparse matrix data type {}!", sdtype);
+    sparse_kernels::csc_spmv(compressed_view(), x, y, pool);
+  }
+}
+
+template <class EigenMatrix>
+void EigenSparseMatrix<EigenMatrix>::use_sell_c_sigma(int chunk_size,
+                                                      int sigma) {
+  TI_ERROR_IF(chunk_size < 0 || sigma < 1,
+              "Invalid SELL-C-sigma parameters C={}, sigma={}", chunk_size,
+              sigma);
+  sell_chunk_size_ = chunk_size;
+  sell_sigma_ = sigma;
+  sell_.reset();
+}
+
+template <class EigenMatrix>
+sparse_kernels::CompressedView<typename EigenMatrix::Scalar,
+                               typename EigenMatrix::StorageIndex>
+EigenSparseMatrix<EigenMatrix>::compressed_view() {
+  matrix_.makeCompressed();
+  return compressed_view_of(matrix_);
+}
+
+template <class EigenMatrix>
+EigenSparseMatrix<EigenMatrix> EigenSparseMatrix<EigenMatrix>::matmul(
+    const EigenSparseMatrix &sm,
+    Program *prog) {
+  TI_ASSERT(cols_ == sm.rows_);
+  auto *pool = prog->get_thread_pool();
+  EigenMatrix compressed_rhs;
+  const EigenMatrix *rhs = &sm.matrix_;
+  if (!rhs->isCompressed()) {
+    compressed_rhs = sm.matrix_;
+    compressed_rhs.makeCompressed();
+    rhs = &compressed_rhs;
+  }
+  // The compressed arrays of a col-major matrix are those of its row-major
+  // transpose, and (AB)^T = B^T A^T.
+  auto a = EigenMatrix::IsRowMajor ? compressed_view()
+                                   : compressed_view_of(*rhs);
+  auto b = EigenMatrix::IsRowMajor ? compressed_view_of(*rhs)
+                                   : compressed_view();
+  auto c_outer = sparse_kernels::csr_spgemm_symbolic(a, b, pool);
+
+  EigenMatrix result(rows_, sm.cols_);
+  result.resizeNonZeros(c_outer.back());
+  for (std::size_t i = 0; i < c_outer.size(); i++) {
+    result.outerIndexPtr()[i] = static_cast<StorageIndex>(c_outer[i]);
   }
+  sparse_kernels::csr_spgemm_numeric(a, b, c_outer, result.innerIndexPtr(),
+                                     result.valuePtr(), pool);
+  EigenSparseMatrix product(result);
+  product.dtype_ = dtype_;
+  return product;
 }
 
 INSTANTIATE_SPMV(float32, ColMajor)
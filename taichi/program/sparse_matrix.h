@@ -5,6 +5,7 @@
 #include "taichi/ir/type_utils.h"
 #include "taichi/program/ndarray.h"
 #include "taichi/program/program.h"
+#include "taichi/program/sparse_matrix_kernels.h"
 #include "taichi/rhi/cuda/cuda_driver.h"
 
 #include "Eigen/Sparse"
@@ -33,19 +34,24 @@ class SparseMatrixBuilder {
 
   std::unique_ptr<SparseMatrix> build();
 
+  // Rebuilds |sm| from the triplets, reusing its storage if the triplets fit
+  // in its current sparsity pattern.
+  void build_into(SparseMatrix &sm);
+
   std::unique_ptr<SparseMatrix> build_cuda();
 
   void clear();
 
  private:
-  template <typename T, typename G>
-  void build_template(std::unique_ptr<SparseMatrix> &);
+  template <typename G>
+  void build_template(SparseMatrix &m, bool reuse_pattern);
 
   template <typename T, typename G>
   void print_triplets_template();
 
  private:
   uint64 num_triplets_{0};
+  Program *prog_{nullptr};
   Ndarray *ndarray_data_base_ptr_{nullptr};
   intptr_t ndarray_data_ptr_{0};
   int rows_{0};
@@ -73,6 +79,24 @@ class SparseMatrix {
     TI_NOT_IMPLEMENTED;
   };
 
+  // Builds the matrix from |num_triplets| (row, col, value) triplets laid out
+  // as in SparseMatrixBuilder, summing up duplicated entries. The work is
+  // spread over |pool| unless it is nullptr.
+  virtual void assemble_triplets(const void *triplets,
+                                 int64 num_triplets,
+                                 ThreadPool *pool) {
+    TI_NOT_IMPLEMENTED;
+  }
+
+  // Same as assemble_triplets(), but keeps the current sparsity pattern and
+  // storage. Returns false if some triplet is outside of the pattern, in which
+  // case the values are left unspecified.
+  virtual bool reassemble_triplets(const void *triplets,
+                                   int64 num_triplets,
+                                   ThreadPool *pool) {
+    return false;
+  }
+
   virtual void build_csr_from_coo(void *coo_row_ptr,
                                   void *coo_col_ptr,
                                   void *coo_values_ptr,
@@ -113,6 +137,12 @@ class SparseMatrix {
     TI_NOT_IMPLEMENTED;
   }
 
+  // A hash of the shape and of the positions of the non-zeros, to tell
+  // matrices with different patterns apart cheaply.
+  virtual uint64 pattern_fingerprint() const {
+    TI_NOT_IMPLEMENTED;
+  }
+
  protected:
   int rows_{0};
   int cols_{0};
@@ -121,6 +151,10 @@ class SparseMatrix {
 
 template <class EigenMatrix>
 class EigenSparseMatrix : public SparseMatrix {
+  using Scalar = typename EigenMatrix::Scalar;
+  using StorageIndex = typename EigenMatrix::StorageIndex;
+  using SellMatrix = sparse_kernels::SellCSigmaMatrix<Scalar, StorageIndex>;
+
  public:
   explicit EigenSparseMatrix(int rows, int cols, DataType dt)
       : SparseMatrix(rows, cols, dt), matrix_(rows, cols) {
@@ -140,21 +174,31 @@ class EigenSparseMatrix : public SparseMatrix {
   ~EigenSparseMatrix() override = default;
 
   void build_triplets(void *triplets_adr) override;
+  void assemble_triplets(const void *triplets,
+                         int64 num_triplets,
+                         ThreadPool *pool) override;
+  bool reassemble_triplets(const void *triplets,
+                           int64 num_triplets,
+                           ThreadPool *pool) override;
   const std::string to_string() const override;
 
   // Write the sparse matrix to a Matrix Market file
   void mmwrite(const std::string &filename) override;
 
+  uint64 pattern_fingerprint() const override;
+
   const void *get_matrix() const override {
     return &matrix_;
   };
 
   void *get_matrix() {
+    sell_.reset();
     return &matrix_;
   };
 
   virtual EigenSparseMatrix &operator+=(const EigenSparseMatrix &other) {
     this->matrix_ += other.matrix_;
+    sell_.reset();
     return *this;
   };
 
@@ -165,6 +209,7 @@ class EigenSparseMatrix : public SparseMatrix {
 
   virtual EigenSparseMatrix &operator-=(const EigenSparseMatrix &other) {
     this->matrix_ -= other.matrix_;
+    sell_.reset();
     return *this;
   }
 
@@ -175,6 +220,7 @@ class EigenSparseMatrix : public SparseMatrix {
 
   virtual EigenSparseMatrix &operator*=(float scale) {
     this->matrix_ *= scale;
+    sell_.reset();
     return *this;
   }
 
@@ -195,9 +241,8 @@ class EigenSparseMatrix : public SparseMatrix {
     return EigenSparseMatrix(matrix_.transpose());
   }
 
-  EigenSparseMatrix matmul(const EigenSparseMatrix &sm) {
-    return EigenSparseMatrix(matrix_ * sm.matrix_);
-  }
+  // Sparse matrix product, run on the CPU thread pool of |prog|.
+  EigenSparseMatrix matmul(const EigenSparseMatrix &sm, Program *prog);
 
   template <typename T>
   T get_element(int row, int col) {
@@ -207,17 +252,31 @@ class EigenSparseMatrix : public SparseMatrix {
   template <typename T>
   void set_element(int row, int col, T value) {
     matrix_.coeffRef(row, col) = value;
+    sell_.reset();
   }
 
   template <class VT>
-  VT mat_vec_mul(const Eigen::Ref<const VT> &b) {
-    return matrix_ * b;
-  }
+  VT mat_vec_mul(const Eigen::Ref<const VT> &b, Program *prog);
 
   void spmv(Program *prog, const Ndarray &x, const Ndarray &y);
 
+  // Runs SpMV on a copy of the matrix in the SELL-C-σ format with chunks of
+  // |chunk_size| rows sorted within windows of |sigma| rows. The copy is
+  // rebuilt after the matrix changes. A |chunk_size| of 0 goes back to the
+  // compressed format.
+  void use_sell_c_sigma(int chunk_size, int sigma);
+
+  // The compressed storage of the matrix, which is compressed first if needed.
+  sparse_kernels::CompressedView<Scalar, StorageIndex> compressed_view();
+
+  // y = A x on |pool|, for |x| and |y| in host memory.
+  void multiply_vector(const Scalar *x, Scalar *y, ThreadPool *pool);
+
  private:
   EigenMatrix matrix_;
+  int sell_chunk_size_{0};
+  int sell_sigma_{1};
+  std::unique_ptr<SellMatrix> sell_;
 };
 
 class CuSparseMatrix : public SparseMatrix {
@@ -0,0 +1,357 @@
+#include "taichi/program/sparse_matrix_kernels.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace taichi::lang {
+namespace sparse_kernels {
+
+namespace {
+
+// Number of non-zeros and of rows handled by each task.
+constexpr int64 kNonZerosPerTask = 1 << 14;
+constexpr int64 kRowsPerTask = 1 << 10;
+
+// Splits the outer vectors of |a| into |num_tasks| ranges with about the same
+// number of non-zeros. Returns the |num_tasks + 1| boundaries.
+template <typename T, typename I>
+std::vector<int> split_by_nonzeros(const CompressedView<T, I> &a,
+                                   int num_tasks) {
+  std::vector<int> bounds(num_tasks + 1);
+  const int64 nnz = a.outer[a.outer_size];
+  bounds[0] = 0;
+  for (int t = 1; t < num_tasks; t++) {
+    const int64 target = nnz * t / num_tasks;
+    bounds[t] = std::lower_bound(a.outer, a.outer + a.outer_size, target) -
+                a.outer;
+  }
+  bounds[num_tasks] = a.outer_size;
+  return bounds;
+}
+
+template <typename T, typename I>
+T sparse_dot(const CompressedView<T, I> &a, int row, const T *x) {
+  // Independent partial sums let the compiler vectorize the row and hide the
+  // latency of the gathers from |x|.
+  T sum[4] = {0, 0, 0, 0};
+  I k = a.outer[row];
+  const I end = a.outer[row + 1];
+  for (; k + 4 <= end; k += 4) {
+    for (int l = 0; l < 4; l++) {
+      sum[l] += a.values[k + l] * x[a.inner[k + l]];
+    }
+  }
+  for (; k < end; k++) {
+    sum[0] += a.values[k] * x[a.inner[k]];
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+// Per-thread buffers that are allocated on first use.
+template <typename V>
+class PerThread {
+ public:
+  PerThread(ThreadPool *pool, std::size_t size, V init)
+      : buffers_(max_num_threads(pool)), size_(size), init_(init) {
+  }
+
+  std::vector<V> &get(int thread_id) {
+    auto &buffer = buffers_[thread_id];
+    if (buffer.size() != size_) {
+      buffer.assign(size_, init_);
+    }
+    return buffer;
+  }
+
+  std::vector<std::vector<V>> &all() {
+    return buffers_;
+  }
+
+ private:
+  std::vector<std::vector<V>> buffers_;
+  std::size_t size_{0};
+  V init_;
+};
+
+}  // namespace
+
+void parallel_for(ThreadPool *pool,
+                  int num_tasks,
+                  const std::function<void(int, int)> &func) {
+  if (pool == nullptr || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; i++) {
+      func(/*thread_id=*/0, i);
+    }
+    return;
+  }
+  pool->run(num_tasks, pool->max_num_threads,
+            const_cast<std::function<void(int, int)> *>(&func),
+            [](void *ctx, int thread_id, int i) {
+              (*static_cast<std::function<void(int, int)> *>(ctx))(thread_id,
+                                                                   i);
+            });
+}
+
+int max_num_threads(ThreadPool *pool) {
+  return pool ? pool->max_num_threads : 1;
+}
+
+TaskSplit::TaskSplit(ThreadPool *pool, int64 n, int64 grain) : n_(n) {
+  num_tasks_ = pool ? (int)std::clamp<int64>(n / std::max<int64>(grain, 1), 1,
+                                             4 * pool->max_num_threads)
+                    : 1;
+}
+
+template <typename T, typename I>
+void csr_spmv(const CompressedView<T, I> &a,
+              const T *x,
+              T *y,
+              ThreadPool *pool) {
+  TaskSplit split(pool, a.outer[a.outer_size] + a.outer_size,
+                  kNonZerosPerTask);
+  auto bounds = split_by_nonzeros(a, split.num_tasks());
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    for (int row = bounds[task]; row < bounds[task + 1]; row++) {
+      y[row] = sparse_dot(a, row, x);
+    }
+  });
+}
+
+template <typename T, typename I>
+void csc_spmv(const CompressedView<T, I> &a,
+              const T *x,
+              T *y,
+              ThreadPool *pool) {
+  const int rows = a.inner_size;
+  TaskSplit split(pool, a.outer[a.outer_size] + a.outer_size,
+                  kNonZerosPerTask);
+  if (split.num_tasks() == 1) {
+    std::fill(y, y + rows, T(0));
+    for (int col = 0; col < a.outer_size; col++) {
+      for (I k = a.outer[col]; k < a.outer[col + 1]; k++) {
+        y[a.inner[k]] += a.values[k] * x[col];
+      }
+    }
+    return;
+  }
+
+  auto bounds = split_by_nonzeros(a, split.num_tasks());
+  PerThread<T> partial_y(pool, rows, T(0));
+  parallel_for(pool, split.num_tasks(), [&](int thread_id, int task) {
+    auto &local_y = partial_y.get(thread_id);
+    for (int col = bounds[task]; col < bounds[task + 1]; col++) {
+      for (I k = a.outer[col]; k < a.outer[col + 1]; k++) {
+        local_y[a.inner[k]] += a.values[k] * x[col];
+      }
+    }
+  });
+
+  // Reduce the per-thread copies of y.
+  TaskSplit row_split(pool, rows, kRowsPerTask);
+  parallel_for(pool, row_split.num_tasks(), [&](int, int task) {
+    for (int64 row = row_split.begin(task); row < row_split.end(task); row++) {
+      T sum = 0;
+      for (auto &local_y : partial_y.all()) {
+        if (!local_y.empty()) {
+          sum += local_y[row];
+        }
+      }
+      y[row] = sum;
+    }
+  });
+}
+
+template <typename T, typename I>
+std::vector<int64> csr_spgemm_symbolic(const CompressedView<T, I> &a,
+                                       const CompressedView<T, I> &b,
+                                       ThreadPool *pool) {
+  std::vector<int64> c_outer(a.outer_size + 1, 0);
+  TaskSplit split(pool, a.outer[a.outer_size] + a.outer_size,
+                  kNonZerosPerTask);
+  auto bounds = split_by_nonzeros(a, split.num_tasks());
+  // The last row of C that has visited each column.
+  PerThread<int> markers(pool, b.inner_size, -1);
+  parallel_for(pool, split.num_tasks(), [&](int thread_id, int task) {
+    auto &marker = markers.get(thread_id);
+    for (int row = bounds[task]; row < bounds[task + 1]; row++) {
+      int64 nnz = 0;
+      for (I k = a.outer[row]; k < a.outer[row + 1]; k++) {
+        const I mid = a.inner[k];
+        for (I l = b.outer[mid]; l < b.outer[mid + 1]; l++) {
+          if (marker[b.inner[l]] != row) {
+            marker[b.inner[l]] = row;
+            nnz++;
+          }
+        }
+      }
+      c_outer[row + 1] = nnz;
+    }
+  });
+  std::partial_sum(c_outer.begin(), c_outer.end(), c_outer.begin());
+  return c_outer;
+}
+
+template <typename T, typename I>
+void csr_spgemm_numeric(const CompressedView<T, I> &a,
+                        const CompressedView<T, I> &b,
+                        const std::vector<int64> &c_outer,
+                        I *c_inner,
+                        T *c_values,
+                        ThreadPool *pool) {
+  TaskSplit split(pool, a.outer[a.outer_size] + a.outer_size,
+                  kNonZerosPerTask);
+  auto bounds = split_by_nonzeros(a, split.num_tasks());
+  PerThread<int> markers(pool, b.inner_size, -1);
+  PerThread<T> accumulators(pool, b.inner_size, T(0));
+  parallel_for(pool, split.num_tasks(), [&](int thread_id, int task) {
+    auto &marker = markers.get(thread_id);
+    auto &acc = accumulators.get(thread_id);
+    for (int row = bounds[task]; row < bounds[task + 1]; row++) {
+      // Gustavson's algorithm: scatter the row into a dense accumulator...
+      I *cols = c_inner + c_outer[row];
+      int64 nnz = 0;
+      for (I k = a.outer[row]; k < a.outer[row + 1]; k++) {
+        const I mid = a.inner[k];
+        const T scale = a.values[k];
+        for (I l = b.outer[mid]; l < b.outer[mid + 1]; l++) {
+          const I col = b.inner[l];
+          if (marker[col] != row) {
+            marker[col] = row;
+            acc[col] = 0;
+            cols[nnz++] = col;
+          }
+          acc[col] += scale * b.values[l];
+        }
+      }
+      TI_ASSERT(c_outer[row] + nnz == c_outer[row + 1]);
+      // ...and gather it back in column order.
+      std::sort(cols, cols + nnz);
+      for (int64 j = 0; j < nnz; j++) {
+        c_values[c_outer[row] + j] = acc[cols[j]];
+      }
+    }
+  });
+}
+
+template <typename T, typename I>
+SellCSigmaMatrix<T, I>::SellCSigmaMatrix(const CompressedView<T, I> &a,
+                                         int chunk_size,
+                                         int sigma)
+    : rows_(a.outer_size), chunk_size_(chunk_size), sigma_(sigma) {
+  TI_ERROR_IF(chunk_size != 4 && chunk_size != 8 && chunk_size != 16 &&
+                  chunk_size != 32,
+              "SELL-C-sigma chunk size must be 4, 8, 16 or 32, got {}",
+              chunk_size);
+  TI_ERROR_IF(sigma < 1, "SELL-C-sigma sorting window must be positive");
+  const int num_chunks = (rows_ + chunk_size - 1) / chunk_size;
+  auto row_length = [&](I row) { return a.outer[row + 1] - a.outer[row]; };
+
+  // Sort the rows by decreasing length within each window of sigma rows, so
+  // that rows of similar lengths share chunks.
+  slot_rows_.assign((int64)num_chunks * chunk_size, -1);
+  std::iota(slot_rows_.begin(), slot_rows_.begin() + rows_, 0);
+  for (int begin = 0; begin < rows_; begin += sigma) {
+    int end = std::min(rows_, begin + sigma);
+    std::stable_sort(
+        slot_rows_.begin() + begin, slot_rows_.begin() + end,
+        [&](I lhs, I rhs) { return row_length(lhs) > row_length(rhs); });
+  }
+
+  chunk_offsets_.resize(num_chunks + 1);
+  chunk_offsets_[0] = 0;
+  for (int c = 0; c < num_chunks; c++) {
+    I width = 0;
+    for (int lane = 0; lane < chunk_size; lane++) {
+      I row = slot_rows_[(int64)c * chunk_size + lane];
+      if (row >= 0) {
+        width = std::max(width, row_length(row));
+      }
+    }
+    chunk_offsets_[c + 1] = chunk_offsets_[c] + (int64)width * chunk_size;
+  }
+
+  // Padding multiplies zeros with x[0], which keeps the inner loop free of
+  // branches.
+  columns_.assign(chunk_offsets_[num_chunks], 0);
+  values_.assign(chunk_offsets_[num_chunks], T(0));
+  for (int c = 0; c < num_chunks; c++) {
+    for (int lane = 0; lane < chunk_size; lane++) {
+      I row = slot_rows_[(int64)c * chunk_size + lane];
+      if (row < 0) {
+        continue;
+      }
+      for (I j = 0; j < row_length(row); j++) {
+        int64 slot = chunk_offsets_[c] + (int64)j * chunk_size + lane;
+        columns_[slot] = a.inner[a.outer[row] + j];
+        values_[slot] = a.values[a.outer[row] + j];
+      }
+    }
+  }
+}
+
+template <typename T, typename I>
+template <int kChunkSize>
+void SellCSigmaMatrix<T, I>::spmv_chunks(const T *x,
+                                         T *y,
+                                         ThreadPool *pool) const {
+  const int num_chunks = (int)chunk_offsets_.size() - 1;
+  TaskSplit split(pool, chunk_offsets_[num_chunks] + rows_, kNonZerosPerTask);
+  parallel_for(pool, split.num_tasks(), [&](int, int task) {
+    const int begin = num_chunks * (int64)task / split.num_tasks();
+    const int end = num_chunks * (int64)(task + 1) / split.num_tasks();
+    for (int c = begin; c < end; c++) {
+      T sum[kChunkSize] = {};
+      for (int64 k = chunk_offsets_[c]; k < chunk_offsets_[c + 1];
+           k += kChunkSize) {
+        for (int lane = 0; lane < kChunkSize; lane++) {
+          sum[lane] += values_[k + lane] * x[columns_[k + lane]];
+        }
+      }
+      for (int lane = 0; lane < kChunkSize; lane++) {
+        I row = slot_rows_[(int64)c * kChunkSize + lane];
+        if (row >= 0) {
+          y[row] = sum[lane];
+        }
+      }
+    }
+  });
+}
+
+template <typename T, typename I>
+void SellCSigmaMatrix<T, I>::spmv(const T *x, T *y, ThreadPool *pool) const {
+  switch (chunk_size_) {
+    case 4:
+      spmv_chunks<4>(x, y, pool);
+      break;
+    case 8:
+      spmv_chunks<8>(x, y, pool);
+      break;
+    case 16:
+      spmv_chunks<16>(x, y, pool);
+      break;
+    case 32:
+      spmv_chunks<32>(x, y, pool);
+      break;
+    default:
+      TI_NOT_IMPLEMENTED;
+  }
+}
+
+#define INSTANTIATE_SPARSE_KERNELS(T, I)                                      \
+  template void csr_spmv(const CompressedView<T, I> &, const T *, T *,        \
+                         ThreadPool *);                                       \
+  template void csc_spmv(const CompressedView<T, I> &, const T *, T *,        \
+                         ThreadPool *);                                       \
+  template std::vector<int64> csr_spgemm_symbolic(                            \
+      const CompressedView<T, I> &, const CompressedView<T, I> &,             \
+      ThreadPool *);                                                          \
+  template void csr_spgemm_numeric(                                           \
+      const CompressedView<T, I> &, const CompressedView<T, I> &,             \
+      const std::vector<int64> &, I *, T *, ThreadPool *);                    \
+  template class SellCSigmaMatrix<T, I>;
+
+INSTANTIATE_SPARSE_KERNELS(float32, int)
+INSTANTIATE_SPARSE_KERNELS(float64, int)
+
+}  // namespace sparse_kernels
+}  // namespace taichi::lang
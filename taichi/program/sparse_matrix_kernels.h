@@ -0,0 +1,126 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/system/threading.h"
+
+namespace taichi::lang {
+namespace sparse_kernels {
+
+// Runs |func(thread_id, task)| for every task in [0, num_tasks) on |pool|, or
+// on the calling thread with thread_id 0 if |pool| is nullptr. Thread ids are
+// in [0, max_num_threads(pool)).
+void parallel_for(ThreadPool *pool,
+                  int num_tasks,
+                  const std::function<void(int, int)> &func);
+
+int max_num_threads(ThreadPool *pool);
+
+// Splits [0, n) into tasks of at least |grain| elements each.
+class TaskSplit {
+ public:
+  TaskSplit(ThreadPool *pool, int64 n, int64 grain);
+
+  int num_tasks() const {
+    return num_tasks_;
+  }
+
+  int64 begin(int task) const {
+    return n_ * task / num_tasks_;
+  }
+
+  int64 end(int task) const {
+    return n_ * (task + 1) / num_tasks_;
+  }
+
+ private:
+  int64 n_{0};
+  int num_tasks_{1};
+};
+
+// A compressed sparse matrix in Eigen's layout: outer vector |i| (a row of a
+// row-major matrix, a column of a col-major one) spans [outer[i], outer[i+1])
+// of |inner| and |values|, with its inner indices sorted.
+template <typename T, typename I>
+struct CompressedView {
+  int outer_size{0};
+  int inner_size{0};
+  const I *outer{nullptr};
+  const I *inner{nullptr};
+  const T *values{nullptr};
+};
+
+// y = A x for a row-major A. Rows are split into tasks with about the same
+// number of non-zeros.
+template <typename T, typename I>
+void csr_spmv(const CompressedView<T, I> &a,
+              const T *x,
+              T *y,
+              ThreadPool *pool);
+
+// y = A x for a col-major A. Each thread accumulates into its own copy of y.
+template <typename T, typename I>
+void csc_spmv(const CompressedView<T, I> &a,
+              const T *x,
+              T *y,
+              ThreadPool *pool);
+
+// Symbolic phase of C = A B for row-major A and B. Returns the offsets of the
+// rows of C, which stay valid as long as the patterns of A and B do.
+template <typename T, typename I>
+std::vector<int64> csr_spgemm_symbolic(const CompressedView<T, I> &a,
+                                       const CompressedView<T, I> &b,
+                                       ThreadPool *pool);
+
+// Numeric phase of C = A B: fills the sorted column indices and the values of
+// the rows of C given their offsets |c_outer|.
+template <typename T, typename I>
+void csr_spgemm_numeric(const CompressedView<T, I> &a,
+                        const CompressedView<T, I> &b,
+                        const std::vector<int64> &c_outer,
+                        I *c_inner,
+                        T *c_values,
+                        ThreadPool *pool);
+
+/**
+ * A copy of a row-major matrix in the SELL-C-σ format, for SpMV with wide
+ * SIMD units.
+ *
+ * Rows are sorted by length within windows of σ rows and packed into chunks
+ * of C rows. Each chunk is padded to its longest row and stored column by
+ * column, so that the C rows of a chunk are processed in lockstep.
+ */
+template <typename T, typename I>
+class SellCSigmaMatrix {
+ public:
+  SellCSigmaMatrix(const CompressedView<T, I> &a, int chunk_size, int sigma);
+
+  void spmv(const T *x, T *y, ThreadPool *pool) const;
+
+  int chunk_size() const {
+    return chunk_size_;
+  }
+
+  int sigma() const {
+    return sigma_;
+  }
+
+ private:
+  template <int kChunkSize>
+  void spmv_chunks(const T *x, T *y, ThreadPool *pool) const;
+
+  int rows_{0};
+  int chunk_size_{0};
+  int sigma_{0};
+  // The row held by each slot of each chunk; -1 for padding.
+  std::vector<I> slot_rows_;
+  // Where the entries of each chunk start in |columns_| and |values_|.
+  std::vector<int64> chunk_offsets_;
+  std::vector<I> columns_;
+  std::vector<T> values_;
+};
+
+}  // namespace sparse_kernels
+}  // namespace taichi::lang
@@ -15,6 +15,10 @@ namespace taichi::lang {
       Eigen::Sparse##type<Eigen::SparseMatrix<dt>,      \
                           Eigen::order##Ordering<int>>, \
       Eigen::SparseMatrix<dt>>;
+#define EIGEN_SUPERNODAL_SOLVER_INSTANTIATION(dt, order)               \
+  template class EigenSparseSolver<                                    \
+      SupernodalCholesky<dt, Eigen::order##Ordering<int>>,             \
+      Eigen::SparseMatrix<dt>>;
 // Explicit instantiation of EigenSparseSolver
 EIGEN_LLT_SOLVER_INSTANTIATION(float32, LLT, AMD);
 EIGEN_LLT_SOLVER_INSTANTIATION(float32, LLT, COLAMD);
@@ -28,6 +32,10 @@ EIGEN_LLT_SOLVER_INSTANTIATION(float64, LDLT, AMD);
 EIGEN_LLT_SOLVER_INSTANTIATION(float64, LDLT, COLAMD);
 EIGEN_LU_SOLVER_INSTANTIATION(float64, LU, AMD);
 EIGEN_LU_SOLVER_INSTANTIATION(float64, LU, COLAMD);
+EIGEN_SUPERNODAL_SOLVER_INSTANTIATION(float32, AMD);
+EIGEN_SUPERNODAL_SOLVER_INSTANTIATION(float32, COLAMD);
+EIGEN_SUPERNODAL_SOLVER_INSTANTIATION(float64, AMD);
+EIGEN_SUPERNODAL_SOLVER_INSTANTIATION(float64, COLAMD);
 }  // namespace taichi::lang
 
 // Explicit instantiation of the template class EigenSparseSolver::solve
@@ -96,14 +104,40 @@ namespace taichi::lang {
 #define GET_EM(sm) \
   const EigenMatrix *mat = (const EigenMatrix *)(sm.get_matrix());
 
+namespace {
+template <class EigenSolver>
+void set_solver_thread_pool(EigenSolver &solver, ThreadPool *pool) {
+}
+
+template <typename T, typename Ordering>
+void set_solver_thread_pool(SupernodalCholesky<T, Ordering> &solver,
+                            ThreadPool *pool) {
+  solver.set_thread_pool(pool);
+}
+
+// The matrix may be uncompressed, so the non-zeros are iterated over instead
+// of copying the index arrays.
+template <class EigenMatrix, class Pattern>
+void get_sparsity_pattern(const EigenMatrix &mat, Pattern &pattern) {
+  pattern.rows = mat.rows();
+  pattern.cols = mat.cols();
+  pattern.outer_offsets.assign(1, 0);
+  pattern.inner_indices.clear();
+  pattern.inner_indices.reserve(mat.nonZeros());
+  for (int outer = 0; outer < mat.outerSize(); outer++) {
+    for (typename EigenMatrix::InnerIterator it(mat, outer); it; ++it) {
+      pattern.inner_indices.push_back(it.index());
+    }
+    pattern.outer_offsets.push_back(pattern.inner_indices.size());
+  }
+}
+}  // namespace
+
 template <class EigenSolver, class EigenMatrix>
 bool EigenSparseSolver<EigenSolver, EigenMatrix>::compute(
     const SparseMatrix &sm) {
-  if (!is_initialized_) {
-    SparseSolver::init_solver(sm.num_rows(), sm.num_cols(), sm.get_data_type());
-  }
-  GET_EM(sm);
-  solver_.compute(*mat);
+  analyze_pattern(sm);
+  factorize(sm);
   if (solver_.info() != Eigen::Success) {
     return false;
   } else
@@ -116,13 +150,25 @@ void EigenSparseSolver<EigenSolver, EigenMatrix>::analyze_pattern(
     SparseSolver::init_solver(sm.num_rows(), sm.num_cols(), sm.get_data_type());
   }
   GET_EM(sm);
+  SparsityPattern pattern;
+  get_sparsity_pattern(*mat, pattern);
+  if (analyzed_pattern_ && analyzed_pattern_->rows == pattern.rows &&
+      analyzed_pattern_->cols == pattern.cols &&
+      analyzed_pattern_->outer_offsets == pattern.outer_offsets &&
+      analyzed_pattern_->inner_indices == pattern.inner_indices) {
+    return;
+  }
   solver_.analyzePattern(*mat);
+  analyzed_pattern_ = std::move(pattern);
 }
 
 template <class EigenSolver, class EigenMatrix>
 void EigenSparseSolver<EigenSolver, EigenMatrix>::factorize(
     const SparseMatrix &sm) {
+  // Analyzes the pattern first unless it is the one analyzed last.
+  analyze_pattern(sm);
   GET_EM(sm);
+  set_solver_thread_pool(solver_, pool_);
   solver_.factorize(*mat);
 }
 
@@ -175,6 +221,18 @@ INSTANTIATE_LLT_SOLVE_RF(float64, LDLT, AMD, Eigen::VectorXd)
 INSTANTIATE_LU_SOLVE_RF(float64, LU, AMD, Eigen::VectorXd)
 INSTANTIATE_LU_SOLVE_RF(float64, LU, COLAMD, Eigen::VectorXd)
 
+#define INSTANTIATE_SUPERNODAL_SOLVE(dt, order, vt)                          \
+  template vt EigenSparseSolver##dt##SupernodalLLT##order::solve(const vt &); \
+  template void EigenSparseSolver##dt##SupernodalLLT##order::solve_rf<vt,    \
+                                                                      dt>(   \
+      Program * prog, const SparseMatrix &sm, const Ndarray &b,              \
+      const Ndarray &x);
+
+INSTANTIATE_SUPERNODAL_SOLVE(float32, AMD, Eigen::VectorXf)
+INSTANTIATE_SUPERNODAL_SOLVE(float32, COLAMD, Eigen::VectorXf)
+INSTANTIATE_SUPERNODAL_SOLVE(float64, AMD, Eigen::VectorXd)
+INSTANTIATE_SUPERNODAL_SOLVE(float64, COLAMD, Eigen::VectorXd)
+
 CuSparseSolver::CuSparseSolver() {
   init_solver();
 }
@@ -539,17 +597,26 @@ void CuSparseSolver::solve_lu(Program *prog,
 #endif
 }
 
-std::unique_ptr<SparseSolver> make_sparse_solver(DataType dt,
-                                                 const std::string &solver_type,
-                                                 const std::string &ordering) {
+namespace {
+std::unique_ptr<SparseSolver> make_eigen_sparse_solver(
+    DataType dt,
+    const std::string &solver_type,
+    const std::string &ordering) {
   using key_type = Triplets;
   using func_type = std::unique_ptr<SparseSolver> (*)();
   static const std::unordered_map<key_type, func_type, key_hash>
-      solver_factory = {
-          MAKE_SOLVER(float32, LLT, AMD),  MAKE_SOLVER(float32, LLT, COLAMD),
-          MAKE_SOLVER(float32, LDLT, AMD), MAKE_SOLVER(float32, LDLT, COLAMD),
-          MAKE_SOLVER(float64, LLT, AMD),  MAKE_SOLVER(float64, LLT, COLAMD),
-          MAKE_SOLVER(float64, LDLT, AMD), MAKE_SOLVER(float64, LDLT, COLAMD)};
+      solver_factory = {MAKE_SOLVER(float32, LLT, AMD),
+                        MAKE_SOLVER(float32, LLT, COLAMD),
+                        MAKE_SOLVER(float32, LDLT, AMD),
+                        MAKE_SOLVER(float32, LDLT, COLAMD),
+                        MAKE_SOLVER(float32, SupernodalLLT, AMD),
+                        MAKE_SOLVER(float32, SupernodalLLT, COLAMD),
+                        MAKE_SOLVER(float64, LLT, AMD),
+                        MAKE_SOLVER(float64, LLT, COLAMD),
+                        MAKE_SOLVER(float64, LDLT, AMD),
+                        MAKE_SOLVER(float64, LDLT, COLAMD),
+                        MAKE_SOLVER(float64, SupernodalLLT, AMD),
+                        MAKE_SOLVER(float64, SupernodalLLT, COLAMD)};
   static const std::unordered_map<std::string, std::string> dt_map = {
       {"f32", "float32"}, {"f64", "float64"}};
   auto it = dt_map.find(taichi::lang::data_type_name(dt));
@@ -576,6 +643,16 @@ std::unique_ptr<SparseSolver> make_sparse_solver(DataType dt,
   } else
     TI_ERROR("Not supported sparse solver type: {}", solver_type);
 }
+}  // namespace
+
+std::unique_ptr<SparseSolver> make_sparse_solver(DataType dt,
+                                                 const std::string &solver_type,
+                                                 const std::string &ordering,
+                                                 Program *prog) {
+  auto solver = make_eigen_sparse_solver(dt, solver_type, ordering);
+  solver->set_thread_pool(prog->get_thread_pool());
+  return solver;
+}
 
 CuSparseSolver::~CuSparseSolver() {
 #if defined(TI_WITH_CUDA)
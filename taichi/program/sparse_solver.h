@@ -1,10 +1,13 @@
 #pragma once
 
+#include <optional>
+
 #include "sparse_matrix.h"
 
 #include "taichi/ir/type.h"
 #include "taichi/rhi/cuda/cuda_driver.h"
 #include "taichi/program/program.h"
+#include "taichi/program/supernodal_cholesky.h"
 
 #define DECLARE_EIGEN_LLT_SOLVER(dt, type, order)                    \
   typedef EigenSparseSolver<                                         \
@@ -19,6 +22,12 @@
                             Eigen::SparseMatrix<dt>>                          \
       EigenSparseSolver##dt##type##order;
 
+#define DECLARE_EIGEN_SUPERNODAL_SOLVER(dt, order)                     \
+  typedef EigenSparseSolver<                                           \
+      SupernodalCholesky<dt, Eigen::order##Ordering<int>>,             \
+      Eigen::SparseMatrix<dt>>                                         \
+      EigenSparseSolver##dt##SupernodalLLT##order;
+
 namespace taichi::lang {
 
 class SparseSolver {
@@ -27,6 +36,7 @@ class SparseSolver {
   int cols_{0};
   DataType dtype_{PrimitiveType::f32};
   bool is_initialized_{false};
+  ThreadPool *pool_{nullptr};
 
  public:
   virtual ~SparseSolver() = default;
@@ -35,6 +45,10 @@ class SparseSolver {
     cols_ = cols;
     dtype_ = dtype;
   }
+  // The thread pool of the CPU solvers that run in parallel.
+  void set_thread_pool(ThreadPool *pool) {
+    pool_ = pool;
+  }
   virtual bool compute(const SparseMatrix &sm) = 0;
   virtual void analyze_pattern(const SparseMatrix &sm) = 0;
   virtual void factorize(const SparseMatrix &sm) = 0;
@@ -45,6 +59,16 @@ template <class EigenSolver, class EigenMatrix>
 class EigenSparseSolver : public SparseSolver {
  private:
   EigenSolver solver_;
+  // The shape and the positions of the non-zeros of the matrix last analyzed.
+  // The ordering and the symbolic factorization are reused for matrices with
+  // exactly this pattern.
+  struct SparsityPattern {
+    int64 rows{0};
+    int64 cols{0};
+    std::vector<int64> outer_offsets;
+    std::vector<int> inner_indices;
+  };
+  std::optional<SparsityPattern> analyzed_pattern_;
 
  public:
   ~EigenSparseSolver() override = default;
@@ -74,6 +98,10 @@ DECLARE_EIGEN_LLT_SOLVER(float64, LDLT, AMD);
 DECLARE_EIGEN_LLT_SOLVER(float64, LDLT, COLAMD);
 DECLARE_EIGEN_LU_SOLVER(float64, LU, AMD);
 DECLARE_EIGEN_LU_SOLVER(float64, LU, COLAMD);
+DECLARE_EIGEN_SUPERNODAL_SOLVER(float32, AMD);
+DECLARE_EIGEN_SUPERNODAL_SOLVER(float32, COLAMD);
+DECLARE_EIGEN_SUPERNODAL_SOLVER(float64, AMD);
+DECLARE_EIGEN_SUPERNODAL_SOLVER(float64, COLAMD);
 
 class CuSparseSolver : public SparseSolver {
  public:
@@ -141,7 +169,8 @@ class CuSparseSolver : public SparseSolver {
 
 std::unique_ptr<SparseSolver> make_sparse_solver(DataType dt,
                                                  const std::string &solver_type,
-                                                 const std::string &ordering);
+                                                 const std::string &ordering,
+                                                 Program *prog);
 
 std::unique_ptr<SparseSolver> make_cusparse_solver(
     DataType dt,
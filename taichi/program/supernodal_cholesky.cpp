@@ -0,0 +1,317 @@
+#include "taichi/program/supernodal_cholesky.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "taichi/program/sparse_matrix_kernels.h"
+
+namespace taichi::lang {
+
+template <typename T, typename Ordering>
+void SupernodalCholesky<T, Ordering>::analyzePattern(const Matrix &a) {
+  TI_ERROR_IF(a.rows() != a.cols(),
+              "Cholesky factorization needs a square matrix, got {}x{}",
+              a.rows(), a.cols());
+  n_ = a.rows();
+
+  // Same ordering as the Eigen simplicial solvers.
+  {
+    Matrix symmetric;
+    symmetric = a.template selfadjointView<Eigen::Lower>();
+    Ordering ordering;
+    ordering(symmetric, perm_inv_);
+    perm_ = perm_inv_.inverse();
+  }
+  Matrix upper(n_, n_);
+  upper.template selfadjointView<Eigen::Upper>() =
+      a.template selfadjointView<Eigen::Lower>().twistedBy(perm_);
+  const Matrix lower = upper.transpose();
+
+  // Elimination tree, see Davis, Direct Methods for Sparse Linear Systems.
+  std::vector<int> parent(n_, -1);
+  {
+    std::vector<int> ancestor(n_, -1);
+    for (int k = 0; k < n_; k++) {
+      for (typename Matrix::InnerIterator it(upper, k); it; ++it) {
+        int i = it.index();
+        while (i != -1 && i < k) {
+          const int next = ancestor[i];
+          ancestor[i] = k;
+          if (next == -1) {
+            parent[i] = k;
+          }
+          i = next;
+        }
+      }
+    }
+  }
+  std::vector<std::vector<int>> children(n_);
+  for (int j = 0; j < n_; j++) {
+    if (parent[j] != -1) {
+      children[parent[j]].push_back(j);
+    }
+  }
+
+  // The pattern of column j of L is the pattern of column j of C below the
+  // diagonal merged with the patterns of its children in the elimination
+  // tree. A child is always the last column of its supernode at that point.
+  supernode_begin_.assign(1, 0);
+  supernode_of_column_.assign(n_, -1);
+  row_offsets_.assign(1, 0);
+  rows_.clear();
+  std::vector<int> marker(n_, -1);
+  std::vector<int> pattern;
+  for (int j = 0; j < n_; j++) {
+    pattern.clear();
+    marker[j] = j;
+    for (typename Matrix::InnerIterator it(lower, j); it; ++it) {
+      const int i = it.index();
+      if (i > j && marker[i] != j) {
+        marker[i] = j;
+        pattern.push_back(i);
+      }
+    }
+    for (int child : children[j]) {
+      const int s = supernode_of_column_[child];
+      const int64 below = row_offsets_[s] + (child - supernode_begin_[s]) + 1;
+      for (int64 k = below; k < row_offsets_[s + 1]; k++) {
+        const int i = rows_[k];
+        if (marker[i] != j) {
+          marker[i] = j;
+          pattern.push_back(i);
+        }
+      }
+    }
+    std::sort(pattern.begin(), pattern.end());
+
+    const int last = (int)supernode_begin_.size() - 2;
+    if (j > 0 && parent[j - 1] == j && num_cols(last) < kMaxSupernodeWidth &&
+        (int64)pattern.size() == num_rows(last) - num_cols(last) - 1) {
+      // Column j continues the supernode of column j - 1, whose rows already
+      // include the pattern of column j.
+      supernode_begin_.back() = j + 1;
+      supernode_of_column_[j] = last;
+    } else {
+      supernode_of_column_[j] = last + 1;
+      rows_.push_back(j);
+      rows_.insert(rows_.end(), pattern.begin(), pattern.end());
+      row_offsets_.push_back((int64)rows_.size());
+      supernode_begin_.push_back(j + 1);
+    }
+  }
+  const int num_sn = num_supernodes();
+
+  // Descendants updating each supernode.
+  updater_offsets_.assign(num_sn + 1, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    std::vector<int64> fill(updater_offsets_.begin(), updater_offsets_.end());
+    for (int d = 0; d < num_sn; d++) {
+      int previous = -1;
+      for (int64 k = row_offsets_[d] + num_cols(d); k < row_offsets_[d + 1];
+           k++) {
+        const int s = supernode_of_column_[rows_[k]];
+        if (s == previous) {
+          continue;
+        }
+        previous = s;
+        if (pass == 0) {
+          updater_offsets_[s + 1]++;
+        } else {
+          updaters_[fill[s]++] = d;
+        }
+      }
+    }
+    if (pass == 0) {
+      for (int s = 0; s < num_sn; s++) {
+        updater_offsets_[s + 1] += updater_offsets_[s];
+      }
+      updaters_.resize(updater_offsets_[num_sn]);
+    }
+  }
+
+  // A supernode is one level above its highest child, so that the
+  // supernodes of a level are independent.
+  std::vector<int> level(num_sn, 0);
+  int num_levels = num_sn > 0 ? 1 : 0;
+  for (int s = 0; s < num_sn; s++) {
+    if (num_rows(s) > num_cols(s)) {
+      const int p = supernode_of_column_[rows_[row_offsets_[s] + num_cols(s)]];
+      level[p] = std::max(level[p], level[s] + 1);
+      num_levels = std::max(num_levels, level[p] + 1);
+    }
+  }
+  level_offsets_.assign(num_levels + 1, 0);
+  for (int s = 0; s < num_sn; s++) {
+    level_offsets_[level[s] + 1]++;
+  }
+  for (int l = 0; l < num_levels; l++) {
+    level_offsets_[l + 1] += level_offsets_[l];
+  }
+  supernodes_by_level_.resize(num_sn);
+  {
+    std::vector<int> fill(level_offsets_.begin(), level_offsets_.end() - 1);
+    for (int s = 0; s < num_sn; s++) {
+      supernodes_by_level_[fill[level[s]]++] = s;
+    }
+  }
+
+  value_offsets_.assign(num_sn + 1, 0);
+  for (int s = 0; s < num_sn; s++) {
+    value_offsets_[s + 1] =
+        value_offsets_[s] + (int64)num_rows(s) * num_cols(s);
+  }
+  values_.assign(value_offsets_[num_sn], T(0));
+  info_ = Eigen::Success;
+}
+
+template <typename T, typename Ordering>
+void SupernodalCholesky<T, Ordering>::factorize(const Matrix &a) {
+  TI_ERROR_IF(a.rows() != n_ || a.cols() != n_,
+              "The matrix to factorize does not match the analyzed pattern");
+  Matrix c(n_, n_);
+  c.template selfadjointView<Eigen::Lower>() =
+      a.template selfadjointView<Eigen::Lower>().twistedBy(perm_);
+
+  const int num_threads = sparse_kernels::max_num_threads(pool_);
+  std::vector<std::vector<int>> relative(num_threads);
+  std::vector<DenseMatrix> update(num_threads);
+  std::atomic<bool> success{true};
+  for (int l = 0; l + 1 < (int)level_offsets_.size(); l++) {
+    const int begin = level_offsets_[l];
+    sparse_kernels::parallel_for(
+        pool_, level_offsets_[l + 1] - begin, [&](int thread_id, int task) {
+          if (!success.load(std::memory_order_relaxed)) {
+            return;
+          }
+          auto &rel = relative[thread_id];
+          if ((int)rel.size() != n_) {
+            rel.assign(n_, -1);
+          }
+          if (!factorize_supernode(supernodes_by_level_[begin + task], c, rel,
+                                   update[thread_id])) {
+            success = false;
+          }
+        });
+    if (!success) {
+      break;
+    }
+  }
+  info_ = success ? Eigen::Success : Eigen::NumericalIssue;
+}
+
+template <typename T, typename Ordering>
+bool SupernodalCholesky<T, Ordering>::factorize_supernode(
+    int s,
+    const Matrix &c,
+    std::vector<int> &relative,
+    DenseMatrix &update) {
+  using Block = Eigen::Map<DenseMatrix>;
+  const int first = supernode_begin_[s];
+  const int width = num_cols(s);
+  const int height = num_rows(s);
+  const int *rows = rows_.data() + row_offsets_[s];
+  Block ls(values_.data() + value_offsets_[s], height, width);
+  for (int k = 0; k < height; k++) {
+    relative[rows[k]] = k;
+  }
+
+  // L_s = C(rows, columns)
+  ls.setZero();
+  for (int j = 0; j < width; j++) {
+    for (typename Matrix::InnerIterator it(c, first + j); it; ++it) {
+      ls(relative[it.index()], j) = it.value();
+    }
+  }
+
+  // L_s -= L_d L_d(columns, :)^T for each descendant d.
+  for (int64 u = updater_offsets_[s]; u < updater_offsets_[s + 1]; u++) {
+    const int d = updaters_[u];
+    const int *d_rows = rows_.data() + row_offsets_[d];
+    const int d_height = num_rows(d);
+    const int d_width = num_cols(d);
+    const int p1 = std::lower_bound(d_rows + d_width, d_rows + d_height,
+                                    first) -
+                   d_rows;
+    const int p2 = std::lower_bound(d_rows + p1, d_rows + d_height,
+                                    first + width) -
+                   d_rows;
+    Eigen::Map<const DenseMatrix> ld(values_.data() + value_offsets_[d],
+                                     d_height, d_width);
+    update.noalias() = ld.middleRows(p1, d_height - p1) *
+                       ld.middleRows(p1, p2 - p1).transpose();
+    for (int j = 0; j < p2 - p1; j++) {
+      const int col = d_rows[p1 + j] - first;
+      for (int i = j; i < d_height - p1; i++) {
+        ls(relative[d_rows[p1 + i]], col) -= update(i, j);
+      }
+    }
+  }
+
+  // L_s(columns, :) = chol(L_s(columns, :)), L_s(below, :) /= L_s^T.
+  Eigen::Ref<DenseMatrix> diagonal = ls.topRows(width);
+  Eigen::LLT<Eigen::Ref<DenseMatrix>> llt(diagonal);
+  if (llt.info() != Eigen::Success) {
+    return false;
+  }
+  if (height > width) {
+    ls.topRows(width)
+        .transpose()
+        .template triangularView<Eigen::Upper>()
+        .template solveInPlace<Eigen::OnTheRight>(
+            ls.bottomRows(height - width));
+  }
+  return true;
+}
+
+template <typename T, typename Ordering>
+typename SupernodalCholesky<T, Ordering>::Vector
+SupernodalCholesky<T, Ordering>::solve(
+    const Eigen::Ref<const Vector> &b) const {
+  TI_ERROR_IF(info_ != Eigen::Success,
+              "The matrix was not factorized successfully");
+  TI_ERROR_IF(b.size() != n_, "Expected a right-hand side of size {}, got {}",
+              n_, b.size());
+  Vector y = perm_ * b;
+  Vector below;
+  const int num_sn = num_supernodes();
+  // L y' = y
+  for (int s = 0; s < num_sn; s++) {
+    const int first = supernode_begin_[s];
+    const int width = num_cols(s);
+    const int height = num_rows(s);
+    const int *rows = rows_.data() + row_offsets_[s];
+    Eigen::Map<const DenseMatrix> ls(values_.data() + value_offsets_[s], height,
+                                     width);
+    ls.topRows(width).template triangularView<Eigen::Lower>().solveInPlace(
+        y.segment(first, width));
+    below.noalias() = ls.bottomRows(height - width) * y.segment(first, width);
+    for (int k = width; k < height; k++) {
+      y[rows[k]] -= below[k - width];
+    }
+  }
+  // L^T y'' = y'
+  for (int s = num_sn - 1; s >= 0; s--) {
+    const int first = supernode_begin_[s];
+    const int width = num_cols(s);
+    const int height = num_rows(s);
+    const int *rows = rows_.data() + row_offsets_[s];
+    Eigen::Map<const DenseMatrix> ls(values_.data() + value_offsets_[s], height,
+                                     width);
+    below.resize(height - width);
+    for (int k = width; k < height; k++) {
+      below[k - width] = y[rows[k]];
+    }
+    y.segment(first, width).noalias() -=
+        ls.bottomRows(height - width).transpose() * below;
+    ls.topRows(width).transpose().template triangularView<Eigen::Upper>()
+        .solveInPlace(y.segment(first, width));
+  }
+  return perm_inv_ * y;
+}
+
+template class SupernodalCholesky<float32, Eigen::AMDOrdering<int>>;
+template class SupernodalCholesky<float32, Eigen::COLAMDOrdering<int>>;
+template class SupernodalCholesky<float64, Eigen::AMDOrdering<int>>;
+template class SupernodalCholesky<float64, Eigen::COLAMDOrdering<int>>;
+
+}  // namespace taichi::lang
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/system/threading.h"
+
+#include "Eigen/Dense"
+#include "Eigen/Sparse"
+
+namespace taichi::lang {
+
+/**
+ * A supernodal sparse Cholesky factorization A = P^T L L^T P, with the same
+ * interface as the Eigen sparse solvers.
+ *
+ * Columns of L that share their sparsity pattern below the diagonal are
+ * grouped into supernodes, which are stored and factorized as dense blocks.
+ * Supernodes in disjoint subtrees of the elimination tree are factorized in
+ * parallel, one level of the tree after another, on the thread pool set by
+ * set_thread_pool(). Only the lower triangle of A is read.
+ */
+template <typename T, typename Ordering>
+class SupernodalCholesky {
+ public:
+  using Matrix = Eigen::SparseMatrix<T>;
+  using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+  // Supernodes are split to keep their dense blocks at most this wide.
+  static constexpr int kMaxSupernodeWidth = 128;
+
+  void set_thread_pool(ThreadPool *pool) {
+    pool_ = pool;
+  }
+
+  // Computes the ordering and the structure of L.
+  void analyzePattern(const Matrix &a);
+
+  // Computes the values of L. |a| must have the pattern last analyzed.
+  void factorize(const Matrix &a);
+
+  void compute(const Matrix &a) {
+    analyzePattern(a);
+    factorize(a);
+  }
+
+  Vector solve(const Eigen::Ref<const Vector> &b) const;
+
+  Eigen::ComputationInfo info() const {
+    return info_;
+  }
+
+  int num_supernodes() const {
+    return (int)supernode_begin_.size() - 1;
+  }
+
+ private:
+  using DenseMatrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  int num_rows(int s) const {
+    return int(row_offsets_[s + 1] - row_offsets_[s]);
+  }
+
+  int num_cols(int s) const {
+    return supernode_begin_[s + 1] - supernode_begin_[s];
+  }
+
+  // Factorizes supernode |s|, whose descendants are done.
+  bool factorize_supernode(int s,
+                           const Matrix &c,
+                           std::vector<int> &relative,
+                           DenseMatrix &update);
+
+  ThreadPool *pool_{nullptr};
+  Eigen::ComputationInfo info_{Eigen::InvalidInput};
+  int n_{0};
+
+  // C = P A P^T.
+  Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> perm_;
+  Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> perm_inv_;
+
+  // Supernode |s| spans columns [supernode_begin_[s], supernode_begin_[s+1])
+  // of L.
+  std::vector<int> supernode_begin_;
+  std::vector<int> supernode_of_column_;
+  // The sorted rows of supernode |s|, starting with its own columns.
+  std::vector<int64> row_offsets_;
+  std::vector<int> rows_;
+  // The supernodes whose rows intersect the columns of supernode |s|.
+  std::vector<int64> updater_offsets_;
+  std::vector<int> updaters_;
+  // Supernodes grouped by their height in the elimination tree.
+  std::vector<int> level_offsets_;
+  std::vector<int> supernodes_by_level_;
+
+  // The dense column-major block of supernode |s| starts at
+  // values_[value_offsets_[s]].
+  std::vector<int64> value_offsets_;
+  std::vector<T> values_;
+};
+
+}  // namespace taichi::lang
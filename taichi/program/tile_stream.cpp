@@ -0,0 +1,174 @@
+#include "taichi/program/tile_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace taichi::lang {
+
+TileStreamMode tile_stream_mode_from_string(const std::string &mode) {
+  if (mode == "r") {
+    return TileStreamMode::read;
+  } else if (mode == "r+") {
+    return TileStreamMode::read_write;
+  } else if (mode == "w+") {
+    return TileStreamMode::write;
+  }
+  TI_ERROR("Unknown tile stream mode \"{}\", expected \"r\", \"r+\" or \"w+\"",
+           mode);
+}
+
+TileStream::TileStream(const std::string &path,
+                       std::size_t offset,
+                       std::size_t row_bytes,
+                       int64 num_rows,
+                       int64 tile_rows,
+                       int64 halo,
+                       TileStreamMode mode)
+    : path_(path),
+      offset_(offset),
+      row_bytes_(row_bytes),
+      num_rows_(num_rows),
+      tile_rows_(tile_rows),
+      halo_(halo),
+      mode_(mode),
+      io_thread_("tile_stream", 1) {
+  TI_ERROR_IF(row_bytes == 0 || num_rows < 0, "Invalid array to stream");
+  TI_ERROR_IF(tile_rows <= 0, "Tiles need at least one row, got {}",
+              tile_rows);
+  TI_ERROR_IF(halo < 0, "Invalid halo size {}", halo);
+  TI_ERROR_IF(halo > 0 && mode != TileStreamMode::read,
+              "Only read-only arrays can be streamed with a halo");
+  num_tiles_ = (num_rows + tile_rows - 1) / tile_rows;
+
+  auto flags = std::ios::in | std::ios::binary;
+  if (mode == TileStreamMode::read_write) {
+    flags |= std::ios::out;
+  } else if (mode == TileStreamMode::write) {
+    flags |= std::ios::out | std::ios::trunc;
+  }
+  file_.open(path, flags);
+  TI_ERROR_IF(!file_.is_open(), "Cannot open \"{}\"", path);
+  if (mode != TileStreamMode::write) {
+    file_.seekg(0, std::ios::end);
+    const std::size_t file_size = (std::size_t)file_.tellg();
+    TI_ERROR_IF(file_size < offset + num_rows * row_bytes,
+                "\"{}\" has {} bytes, too few for {} rows of {} bytes at "
+                "offset {}",
+                path, file_size, num_rows, row_bytes, offset);
+  }
+
+  for (auto &buf : buffers_) {
+    buf.resize((std::min(tile_rows, num_rows) + 2 * halo) * row_bytes);
+  }
+  if (mode != TileStreamMode::write && num_tiles_ > 0) {
+    enqueue(0, [this]() { return read_tile(0); });
+  }
+}
+
+TileStream::~TileStream() {
+  io_thread_.flush();
+  if (!error_.empty()) {
+    TI_WARN("Streaming \"{}\" failed: {}", path_, error_);
+  }
+}
+
+TileStream::Tile TileStream::acquire(int64 index) {
+  TI_ERROR_IF(acquired_ || index != next_tile_,
+              "Tile {} is acquired out of order, expected tile {}", index,
+              next_tile_);
+  TI_ERROR_IF(index >= num_tiles_, "Tile {} is out of range [0, {})", index,
+              num_tiles_);
+  auto &ready = buffer_ready_[index % 2];
+  if (ready.valid()) {
+    ready.wait();
+  }
+  check_error();
+  if (mode_ == TileStreamMode::write) {
+    // Do not write back whatever the kernel leaves of two tiles ago.
+    std::memset(buffer(index), 0, buffers_[index % 2].size());
+  } else if (index + 1 < num_tiles_) {
+    enqueue(index + 1, [this, index]() { return read_tile(index + 1); });
+  }
+  acquired_ = true;
+  Tile tile;
+  tile.begin = tile_begin(index);
+  tile.rows = tile_size(index);
+  tile.data = buffer(index);
+  return tile;
+}
+
+void TileStream::release(int64 index) {
+  TI_ERROR_IF(!acquired_ || index != next_tile_,
+              "Tile {} is released without being acquired", index);
+  if (mode_ != TileStreamMode::read) {
+    enqueue(index, [this, index]() { return write_tile(index); });
+  }
+  acquired_ = false;
+  next_tile_++;
+}
+
+void TileStream::flush() {
+  io_thread_.flush();
+  check_error();
+}
+
+void TileStream::enqueue(int64 index, std::function<std::string()> job) {
+  // The I/O thread runs the jobs in order, so a read into a buffer always
+  // follows the write back of its previous tile.
+  auto done = std::make_shared<std::promise<void>>();
+  buffer_ready_[index % 2] = done->get_future().share();
+  io_thread_.enqueue([this, done, job = std::move(job)]() {
+    auto error = job();
+    if (!error.empty()) {
+      std::lock_guard<std::mutex> _(error_mut_);
+      if (error_.empty()) {
+        error_ = std::move(error);
+      }
+    }
+    done->set_value();
+  });
+}
+
+std::string TileStream::read_tile(int64 index) {
+  const int64 first = tile_begin(index) - halo_;
+  const int64 last = tile_begin(index) + tile_size(index) + halo_;
+  const int64 begin = std::max(first, int64(0));
+  const int64 end = std::min(last, num_rows_);
+  uint8 *data = buffer(index);
+  std::memset(data, 0, (begin - first) * row_bytes_);
+  std::memset(data + (end - first) * row_bytes_, 0,
+              (last - end) * row_bytes_);
+  file_.seekg(offset_ + begin * row_bytes_);
+  file_.read((char *)data + (begin - first) * row_bytes_,
+             (end - begin) * row_bytes_);
+  if (!file_) {
+    file_.clear();
+    return fmt::format("cannot read rows [{}, {})", begin, end);
+  }
+  return "";
+}
+
+std::string TileStream::write_tile(int64 index) {
+  const int64 begin = tile_begin(index);
+  file_.seekp(offset_ + begin * row_bytes_);
+  file_.write((const char *)buffer(index) + halo_ * row_bytes_,
+              tile_size(index) * row_bytes_);
+  file_.flush();
+  if (!file_) {
+    file_.clear();
+    return fmt::format("cannot write rows [{}, {})", begin,
+                       begin + tile_size(index));
+  }
+  return "";
+}
+
+void TileStream::check_error() {
+  std::string error;
+  {
+    std::lock_guard<std::mutex> _(error_mut_);
+    std::swap(error, error_);
+  }
+  TI_ERROR_IF(!error.empty(), "Streaming \"{}\" failed: {}", path_, error);
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/program/parallel_executor.h"
+
+namespace taichi::lang {
+
+enum class TileStreamMode {
+  read,        // "r", the file is only read
+  read_write,  // "r+", tiles are read and written back
+  write,       // "w+", the file is created or truncated and only written
+};
+
+TileStreamMode tile_stream_mode_from_string(const std::string &mode);
+
+/**
+ * Streams a row-major array stored in a binary file through two host buffers,
+ * one tile of rows at a time, so that arrays larger than the memory can be
+ * processed by kernels.
+ *
+ * While the caller works on a tile, a background thread writes back the
+ * previous tile and reads the next one into the other buffer. A tile of an
+ * array opened for reading also holds |halo| rows on each side of its own
+ * rows; the halo rows outside of the array are zero.
+ */
+class TileStream {
+ public:
+  struct Tile {
+    // The first row of the tile in the array.
+    int64 begin{0};
+    // The number of rows of the tile, not counting the halo.
+    int64 rows{0};
+    // Row |begin - halo| of the array, followed by |rows + 2 * halo| rows.
+    void *data{nullptr};
+  };
+
+  TileStream(const std::string &path,
+             std::size_t offset,
+             std::size_t row_bytes,
+             int64 num_rows,
+             int64 tile_rows,
+             int64 halo,
+             TileStreamMode mode);
+
+  ~TileStream();
+
+  int64 num_tiles() const {
+    return num_tiles_;
+  }
+
+  int64 halo() const {
+    return halo_;
+  }
+
+  // Waits until tile |index| is loaded and starts loading tile |index + 1|.
+  // Tiles are acquired in order, each one after the previous one is released.
+  Tile acquire(int64 index);
+
+  // Hands tile |index| back, writing its rows to the file in the background
+  // unless the array is read-only.
+  void release(int64 index);
+
+  // Waits for the pending reads and writes.
+  void flush();
+
+ private:
+  int64 tile_begin(int64 index) const {
+    return index * tile_rows_;
+  }
+
+  int64 tile_size(int64 index) const {
+    return std::min(tile_rows_, num_rows_ - tile_begin(index));
+  }
+
+  uint8 *buffer(int64 index) {
+    return buffers_[index % 2].data();
+  }
+
+  // Queues |job| on the I/O thread as the last use of the buffer of tile
+  // |index|.
+  void enqueue(int64 index, std::function<std::string()> job);
+
+  std::string read_tile(int64 index);
+  std::string write_tile(int64 index);
+
+  void check_error();
+
+  std::string path_;
+  std::size_t offset_;
+  std::size_t row_bytes_;
+  int64 num_rows_;
+  int64 tile_rows_;
+  int64 halo_;
+  int64 num_tiles_;
+  TileStreamMode mode_;
+  // Only used by the I/O thread once the stream is constructed.
+  std::fstream file_;
+  std::vector<uint8> buffers_[2];
+  std::shared_future<void> buffer_ready_[2];
+  int64 next_tile_{0};
+  bool acquired_{false};
+
+  std::mutex error_mut_;
+  std::string error_;
+
+  // Destroyed first, after finishing the queued I/O.
+  ParallelExecutor io_thread_;
+};
+
+}  // namespace taichi::lang
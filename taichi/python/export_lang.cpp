@@ -20,6 +20,7 @@
 #include "taichi/program/graph_builder.h"
 #include "taichi/program/extension.h"
 #include "taichi/program/ndarray.h"
+#include "taichi/program/tile_stream.h"
 #include "taichi/program/matrix.h"
 #include "taichi/python/export.h"
 #include "taichi/math/svd.h"
@@ -30,6 +31,7 @@
 #include "taichi/program/conjugate_gradient.h"
 #include "taichi/aot/graph_data.h"
 #include "taichi/ir/mesh.h"
+#include "taichi/ir/mesh_reorder.h"
 
 #include "taichi/program/kernel_profiler.h"
 
@@ -188,12 +190,20 @@ void export_lang(py::module &m) {
                      &CompileConfig::default_cpu_block_dim)
       .def_readwrite("cpu_block_dim_adaptive",
                      &CompileConfig::cpu_block_dim_adaptive)
+      .def_readwrite("auto_tile_ndrange", &CompileConfig::auto_tile_ndrange)
+      .def_readwrite("cpu_vectorize_range_for",
+                     &CompileConfig::cpu_vectorize_range_for)
       .def_readwrite("default_gpu_block_dim",
                      &CompileConfig::default_gpu_block_dim)
       .def_readwrite("gpu_max_reg", &CompileConfig::gpu_max_reg)
       .def_readwrite("saturating_grid_dim", &CompileConfig::saturating_grid_dim)
       .def_readwrite("max_block_dim", &CompileConfig::max_block_dim)
       .def_readwrite("cpu_max_num_threads", &CompileConfig::cpu_max_num_threads)
+      .def_readwrite("cpu_huge_pages", &CompileConfig::cpu_huge_pages)
+      .def_readwrite("cpu_huge_page_min_size",
+                     &CompileConfig::cpu_huge_page_min_size)
+      .def_readwrite("device_allocation_cache_size",
+                     &CompileConfig::device_allocation_cache_size)
       .def_readwrite("random_seed", &CompileConfig::random_seed)
       .def_readwrite("verbose_kernel_launches",
                      &CompileConfig::verbose_kernel_launches)
@@ -212,6 +222,8 @@ void export_lang(py::module &m) {
       .def_readwrite("advanced_optimization",
                      &CompileConfig::advanced_optimization)
       .def_readwrite("ad_stack_size", &CompileConfig::ad_stack_size)
+      .def_readwrite("ad_stack_memory_budget",
+                     &CompileConfig::ad_stack_memory_budget)
       .def_readwrite("flatten_if", &CompileConfig::flatten_if)
       .def_readwrite("make_thread_local", &CompileConfig::make_thread_local)
       .def_readwrite("make_block_local", &CompileConfig::make_block_local)
@@ -223,6 +235,7 @@ void export_lang(py::module &m) {
       .def_readwrite("half2_vectorization", &CompileConfig::half2_vectorization)
       .def_readwrite("make_cpu_multithreading_loop",
                      &CompileConfig::make_cpu_multithreading_loop)
+      .def_readwrite("lazy_kernel_fusion", &CompileConfig::lazy_kernel_fusion)
       .def_readwrite("quant_opt_store_fusion",
                      &CompileConfig::quant_opt_store_fusion)
       .def_readwrite("quant_opt_atomic_demotion",
@@ -287,7 +300,98 @@ void export_lang(py::module &m) {
       .def_readwrite("base_time", &KernelProfileTracedRecord::time_since_base)
       .def_readwrite("name", &KernelProfileTracedRecord::name)
       .def_readwrite("metric_values",
-                     &KernelProfileTracedRecord::metric_values);
+                     &KernelProfileTracedRecord::metric_values)
+      .def_readwrite("thread_imbalance_ratio",
+                     &KernelProfileTracedRecord::thread_imbalance_ratio)
+      .def_readwrite("thread_idle_time",
+                     &KernelProfileTracedRecord::thread_idle_time_in_ms)
+      .def_readwrite("tasks_per_thread",
+                     &KernelProfileTracedRecord::tasks_per_thread);
+
+  py::class_<KernelLatencyStatistics>(m, "KernelLatencyStatistics")
+      .def_readonly("name", &KernelLatencyStatistics::name)
+      .def_readonly("counter", &KernelLatencyStatistics::counter)
+      .def_readonly("min", &KernelLatencyStatistics::min)
+      .def_readonly("max", &KernelLatencyStatistics::max)
+      .def_readonly("total", &KernelLatencyStatistics::total)
+      .def("percentile", &KernelLatencyStatistics::percentile);
+
+  py::class_<LaunchTraceReplayResult>(m, "LaunchTraceReplayResult")
+      .def_readonly("num_launches", &LaunchTraceReplayResult::num_launches)
+      .def_readonly("total_time", &LaunchTraceReplayResult::total_time)
+      .def_readonly("kernels", &LaunchTraceReplayResult::kernels);
+
+  py::class_<ListMemoryUsage>(m, "ListMemoryUsage")
+      .def_readonly("num_elements", &ListMemoryUsage::num_elements)
+      .def_readonly("num_chunks", &ListMemoryUsage::num_chunks)
+      .def_readonly("elements_per_chunk", &ListMemoryUsage::elements_per_chunk)
+      .def_readonly("element_size", &ListMemoryUsage::element_size)
+      .def_property_readonly("reserved_bytes",
+                             &ListMemoryUsage::reserved_bytes);
+
+  py::class_<SNodeMemoryUsage>(m, "SNodeMemoryUsage")
+      .def_readonly("snode_id", &SNodeMemoryUsage::snode_id)
+      .def_readonly("name", &SNodeMemoryUsage::name)
+      .def_readonly("element_list", &SNodeMemoryUsage::element_list)
+      .def_readonly("has_node_allocator",
+                    &SNodeMemoryUsage::has_node_allocator)
+      .def_readonly("data_list", &SNodeMemoryUsage::data_list)
+      .def_readonly("free_list", &SNodeMemoryUsage::free_list)
+      .def_readonly("recycled_list", &SNodeMemoryUsage::recycled_list)
+      .def_readonly("free_list_used", &SNodeMemoryUsage::free_list_used)
+      .def_property_readonly("num_live_cells",
+                             &SNodeMemoryUsage::num_live_cells)
+      .def_property_readonly("reserved_bytes",
+                             &SNodeMemoryUsage::reserved_bytes)
+      .def_property_readonly("used_bytes", &SNodeMemoryUsage::used_bytes);
+
+  py::class_<NdarrayMemoryUsage>(m, "NdarrayMemoryUsage")
+      .def_readonly("shape", &NdarrayMemoryUsage::shape)
+      .def_readonly("dtype", &NdarrayMemoryUsage::dtype)
+      .def_readonly("bytes", &NdarrayMemoryUsage::bytes);
+
+  py::class_<HostMemoryPool::Stats>(m, "HostMemoryPoolStats")
+      .def_readonly("reserved_bytes", &HostMemoryPool::Stats::reserved_bytes)
+      .def_readonly("used_bytes", &HostMemoryPool::Stats::used_bytes)
+      .def_readonly("num_chunks", &HostMemoryPool::Stats::num_chunks)
+      .def_readonly("num_exclusive_chunks",
+                    &HostMemoryPool::Stats::num_exclusive_chunks)
+      .def_readonly("free_bytes", &HostMemoryPool::Stats::free_bytes)
+      .def_readonly("largest_free_bytes",
+                    &HostMemoryPool::Stats::largest_free_bytes)
+      .def_readonly("binned_bytes", &HostMemoryPool::Stats::binned_bytes)
+      .def_readonly("num_binned_blocks",
+                    &HostMemoryPool::Stats::num_binned_blocks)
+      .def_readonly("thread_cached_bytes",
+                    &HostMemoryPool::Stats::thread_cached_bytes)
+      .def_readonly("huge_page_bytes", &HostMemoryPool::Stats::huge_page_bytes)
+      .def_readonly("huge_page_backed_bytes",
+                    &HostMemoryPool::Stats::huge_page_backed_bytes);
+
+  py::class_<CachingDeviceAllocator::Stats>(m, "DeviceAllocationCacheStats")
+      .def_readonly("cached_bytes",
+                    &CachingDeviceAllocator::Stats::cached_bytes)
+      .def_readonly("num_cached_blocks",
+                    &CachingDeviceAllocator::Stats::num_cached_blocks)
+      .def_readonly("num_hits", &CachingDeviceAllocator::Stats::num_hits)
+      .def_readonly("num_misses", &CachingDeviceAllocator::Stats::num_misses);
+
+  py::class_<MemoryUsage>(m, "MemoryUsage")
+      .def_readonly("label", &MemoryUsage::label)
+      .def_readonly("time", &MemoryUsage::time)
+      .def_readonly("snodes", &MemoryUsage::snodes)
+      .def_readonly("snode_tree_bytes", &MemoryUsage::snode_tree_bytes)
+      .def_readonly("ndarrays", &MemoryUsage::ndarrays)
+      .def_readonly("num_argpacks", &MemoryUsage::num_argpacks)
+      .def_readonly("argpack_bytes", &MemoryUsage::argpack_bytes)
+      .def_readonly("runtime_memory_reserved",
+                    &MemoryUsage::runtime_memory_reserved)
+      .def_readonly("runtime_memory_used", &MemoryUsage::runtime_memory_used)
+      .def_readonly("total_requested_memory",
+                    &MemoryUsage::total_requested_memory)
+      .def_readonly("host_memory_pool", &MemoryUsage::host_memory_pool)
+      .def_readonly("device_allocation_cache",
+                    &MemoryUsage::device_allocation_cache);
 
   py::enum_<SNodeAccessFlag>(m, "SNodeAccessFlag", py::arithmetic())
       .value("block_local", SNodeAccessFlag::block_local)
@@ -347,6 +451,8 @@ void export_lang(py::module &m) {
       .def("parallelize", &ASTBuilder::parallelize)
       .def("strictly_serialize", &ASTBuilder::strictly_serialize)
       .def("block_dim", &ASTBuilder::block_dim)
+      .def("tile", &ASTBuilder::tile)
+      .def("get_loop_tile_sizes", &ASTBuilder::get_loop_tile_sizes)
       .def("insert_snode_access_flag", &ASTBuilder::insert_snode_access_flag)
       .def("reset_snode_access_flag", &ASTBuilder::reset_snode_access_flag);
 
@@ -387,6 +493,18 @@ void export_lang(py::module &m) {
            [](Program *program, const std::string toolkit_name) {
              return program->profiler->set_profiler_toolkit(toolkit_name);
            })
+      .def("set_kernel_profiler_load_balance",
+           [](Program *program, bool enabled) {
+             return program->profiler->set_load_balance_recording(enabled);
+           })
+      .def("set_kernel_profiler_streaming",
+           [](Program *program, bool enabled) {
+             program->profiler->set_streaming(enabled);
+           })
+      .def("get_kernel_profiler_streaming_statistics",
+           [](Program *program, bool reset) {
+             return program->profiler->get_streaming_statistics(reset);
+           })
       .def("timeline_clear",
            [](Program *) { Timelines::get_instance().clear(); })
       .def("timeline_save",
@@ -394,6 +512,17 @@ void export_lang(py::module &m) {
              Timelines::get_instance().save(fn);
            })
       .def("print_memory_profiler_info", &Program::print_memory_profiler_info)
+      .def("query_memory_usage", &Program::query_memory_usage)
+      .def("set_memory_sampling", &Program::set_memory_sampling)
+      .def("take_memory_samples", &Program::take_memory_samples)
+      .def("start_launch_trace", &Program::start_launch_trace)
+      .def("stop_launch_trace", &Program::stop_launch_trace)
+      .def("replay_launch_trace",
+           [](Program *program, const std::string &filename, int repeats,
+              bool synchronize_each) {
+             LaunchTraceReplayer replayer(program, filename);
+             return replayer.replay(repeats, synchronize_each);
+           })
       .def("finalize", &Program::finalize)
       .def("get_total_compilation_time", &Program::get_total_compilation_time)
       .def("get_snode_num_dynamically_allocated",
@@ -448,6 +577,19 @@ void export_lang(py::module &m) {
           py::arg("layout") = ExternalArrayLayout::kNull,
           py::arg("zero_fill") = false, py::arg("dbg_info") = DebugInfo(),
           py::return_value_policy::reference)
+      .def(
+          "map_ndarray_file",
+          [&](Program *program, const DataType &dt,
+              const std::vector<int> &shape, ExternalArrayLayout layout,
+              const std::string &path, std::size_t offset, bool read_only,
+              const std::string &access_hint, DebugInfo dbg_info) -> Ndarray * {
+            return program->map_ndarray_file(dt, shape, layout, path, offset,
+                                             read_only, access_hint, dbg_info);
+          },
+          py::arg("dt"), py::arg("shape"), py::arg("layout"), py::arg("path"),
+          py::arg("offset"), py::arg("read_only"), py::arg("access_hint"),
+          py::arg("dbg_info") = DebugInfo(),
+          py::return_value_policy::reference)
       .def("delete_ndarray", &Program::delete_ndarray)
       .def(
           "create_argpack",
@@ -485,6 +627,8 @@ void export_lang(py::module &m) {
       .def("compile_kernel", &Program::compile_kernel,
            py::return_value_policy::reference)
       .def("launch_kernel", &Program::launch_kernel)
+      .def("launch_kernel_lazily", &Program::launch_kernel_lazily)
+      .def("flush_lazy_launches", &Program::flush_lazy_launches)
       .def("get_device_caps", &Program::get_device_caps);
 
   py::class_<AotModuleBuilder>(m, "AotModuleBuilder")
@@ -590,6 +734,7 @@ void export_lang(py::module &m) {
       .def("read_float", &Ndarray::read_float)
       .def("write_int", &Ndarray::write_int)
       .def("write_float", &Ndarray::write_float)
+      .def_readonly("read_only", &Ndarray::read_only)
       .def("total_shape", &Ndarray::total_shape)
       .def("element_shape", &Ndarray::get_element_shape)
       .def("element_data_type", &Ndarray::get_element_data_type)
@@ -618,6 +763,37 @@ void export_lang(py::module &m) {
       .def("from_ndarray", &Texture::from_ndarray)
       .def("from_snode", &Texture::from_snode);
 
+  py::class_<TileStream::Tile>(m, "StreamTile")
+      .def_readonly("begin", &TileStream::Tile::begin)
+      .def_readonly("rows", &TileStream::Tile::rows)
+      .def_property_readonly("data", [](const TileStream::Tile &tile) {
+        return (uint64)tile.data;
+      });
+
+  py::class_<TileStream>(m, "TileStream")
+      .def(py::init([](const std::string &path, std::size_t offset,
+                       std::size_t row_bytes, int64 num_rows, int64 tile_rows,
+                       int64 halo, const std::string &mode) {
+             return std::make_unique<TileStream>(
+                 path, offset, row_bytes, num_rows, tile_rows, halo,
+                 tile_stream_mode_from_string(mode));
+           }),
+           py::arg("path"), py::arg("offset"), py::arg("row_bytes"),
+           py::arg("num_rows"), py::arg("tile_rows"), py::arg("halo"),
+           py::arg("mode"))
+      .def("num_tiles", &TileStream::num_tiles)
+      .def("halo", &TileStream::halo)
+      .def("acquire",
+           [](TileStream *stream, int64 index) {
+             py::gil_scoped_release release;
+             return stream->acquire(index);
+           })
+      .def("release", &TileStream::release)
+      .def("flush", [](TileStream *stream) {
+        py::gil_scoped_release release;
+        stream->flush();
+      });
+
   py::enum_<aot::ArgKind>(m, "ArgKind")
       .value("SCALAR", aot::ArgKind::kScalar)
       .value("NDARRAY", aot::ArgKind::kNdarray)
@@ -1339,6 +1515,7 @@ void export_lang(py::module &m) {
            })
       .def("get_ndarray_data_ptr", &SparseMatrixBuilder::get_ndarray_data_ptr)
       .def("build", &SparseMatrixBuilder::build)
+      .def("build_into", &SparseMatrixBuilder::build_into)
       .def("build_cuda", &SparseMatrixBuilder::build_cuda)
       .def("get_addr", [](SparseMatrixBuilder *mat) { return uint64(mat); });
 
@@ -1353,7 +1530,8 @@ void export_lang(py::module &m) {
       .def("mmwrite", &SparseMatrix::mmwrite)
       .def("num_rows", &SparseMatrix::num_rows)
       .def("num_cols", &SparseMatrix::num_cols)
-      .def("get_data_type", &SparseMatrix::get_data_type);
+      .def("get_data_type", &SparseMatrix::get_data_type)
+      .def("pattern_fingerprint", &SparseMatrix::pattern_fingerprint);
 
 #define MAKE_SPARSE_MATRIX(TYPE, STORAGE, VTYPE)                             \
   using STORAGE##TYPE##EigenMatrix =                                         \
@@ -1373,6 +1551,8 @@ void export_lang(py::module &m) {
       .def(py::self *py::self)                                               \
       .def("matmul", &EigenSparseMatrix<STORAGE##TYPE##EigenMatrix>::matmul) \
       .def("spmv", &EigenSparseMatrix<STORAGE##TYPE##EigenMatrix>::spmv)     \
+      .def("use_sell_c_sigma",                                               \
+           &EigenSparseMatrix<STORAGE##TYPE##EigenMatrix>::use_sell_c_sigma) \
       .def("transpose",                                                      \
            &EigenSparseMatrix<STORAGE##TYPE##EigenMatrix>::transpose)        \
       .def("get_element",                                                    \
@@ -1435,6 +1615,10 @@ void export_lang(py::module &m) {
   REGISTER_EIGEN_SOLVER(float64, LDLT, COLAMD, d)
   REGISTER_EIGEN_SOLVER(float64, LU, AMD, d)
   REGISTER_EIGEN_SOLVER(float64, LU, COLAMD, d)
+  REGISTER_EIGEN_SOLVER(float32, SupernodalLLT, AMD, f)
+  REGISTER_EIGEN_SOLVER(float32, SupernodalLLT, COLAMD, f)
+  REGISTER_EIGEN_SOLVER(float64, SupernodalLLT, AMD, d)
+  REGISTER_EIGEN_SOLVER(float64, SupernodalLLT, COLAMD, d)
 
   py::class_<CuSparseSolver, SparseSolver>(m, "CuSparseSolver")
       .def("compute", &CuSparseSolver::compute)
@@ -1477,6 +1661,22 @@ void export_lang(py::module &m) {
   py::class_<CUCG>(m, "CUCG").def("solve", &CUCG::solve);
   m.def("make_cucg_solver", make_cucg_solver);
 
+  // Preconditioned Krylov solvers
+#define EXPORT_KRYLOV_SOLVER(T, name)                                  \
+  py::class_<KrylovSolver<T>>(m, name)                                 \
+      .def(py::init<Program *, const std::string &,                    \
+                    const std::string &, int, float, int, bool>())     \
+      .def("solve", &KrylovSolver<T>::solve)                           \
+      .def("solve_matrix_free", &KrylovSolver<T>::solve_matrix_free,   \
+           py::arg("matvec"), py::arg("in_"), py::arg("out"),          \
+           py::arg("diagonal").none(true), py::arg("b"), py::arg("x")) \
+      .def("num_iterations", &KrylovSolver<T>::num_iterations)         \
+      .def("residual_norm", &KrylovSolver<T>::residual_norm);
+
+  EXPORT_KRYLOV_SOLVER(float32, "KrylovSolverf");
+  EXPORT_KRYLOV_SOLVER(float64, "KrylovSolverd");
+#undef EXPORT_KRYLOV_SOLVER
+
   // Mesh Class
   // Mesh related.
   py::enum_<mesh::MeshTopology>(m, "MeshTopology", py::arithmetic())
@@ -1585,6 +1785,55 @@ void export_lang(py::module &m) {
               type, mesh::MeshLocalRelation(value, patch_offset, offset)));
         });
 
+  m.def(
+      "build_mesh_patches",
+      [](mesh::MeshTopology topology,
+         py::array_t<int, py::array::c_style | py::array::forcecast> cells,
+         py::array_t<float64, py::array::c_style | py::array::forcecast>
+             positions,
+         const std::string &reorder, int max_cells_per_patch,
+         const std::vector<mesh::MeshRelationType> &relations) {
+        auto data = mesh::build_mesh_patches(
+            topology,
+            std::vector<int>(cells.data(), cells.data() + cells.size()),
+            std::vector<float64>(positions.data(),
+                                 positions.data() + positions.size()),
+            reorder, max_cells_per_patch, relations);
+        auto to_array = [](const std::vector<uint32> &v) {
+          return py::array_t<uint32>(v.size(), v.data());
+        };
+        py::list elements;
+        for (const auto &element : data.elements) {
+          py::dict e;
+          e["order"] = element.order;
+          e["num"] = element.num;
+          e["max_num_per_patch"] = element.max_num_per_patch;
+          e["owned_offsets"] = to_array(element.owned_offsets);
+          e["total_offsets"] = to_array(element.total_offsets);
+          e["l2g_mapping"] = to_array(element.l2g_mapping);
+          e["l2r_mapping"] = to_array(element.l2r_mapping);
+          e["g2r_mapping"] = to_array(element.g2r_mapping);
+          elements.append(e);
+        }
+        py::list rels;
+        for (const auto &relation : data.relations) {
+          py::dict r;
+          r["from_order"] = relation.from_order;
+          r["to_order"] = relation.to_order;
+          r["value"] = to_array(relation.value);
+          if (relation.from_order <= relation.to_order) {
+            r["offset"] = to_array(relation.offset);
+            r["patch_offset"] = to_array(relation.patch_offset);
+          }
+          rels.append(r);
+        }
+        py::dict result;
+        result["num_patches"] = data.num_patches;
+        result["elements"] = elements;
+        result["relations"] = rels;
+        return result;
+      });
+
   m.def("wait_for_debugger", []() {
 #ifdef WIN32
     while (!::IsDebuggerPresent())
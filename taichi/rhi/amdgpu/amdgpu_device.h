@@ -63,6 +63,8 @@ class AmdgpuDevice : public LlvmDevice {
     bool is_imported{false};
     bool use_preallocated{true};
     bool use_cached{false};
+    // Whether |ptr| is recycled by the |allocation_cache_| once released.
+    bool use_allocation_cache{false};
     void *mapped{nullptr};
   };
 
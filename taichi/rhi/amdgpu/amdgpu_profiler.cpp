@@ -105,6 +105,7 @@ void KernelProfilerAMDGPU::update() {
   event_toolkit_->update_timeline(traced_records_);
   statistics_on_traced_records();
   event_toolkit_->clear();
+  stream_traced_records(records_size_after_sync_);
   records_size_after_sync_ = traced_records_.size();
 }
 
@@ -114,6 +115,7 @@ void KernelProfilerAMDGPU::clear() {
   records_size_after_sync_ = 0;
   traced_records_.clear();
   statistical_results_.clear();
+  streaming_statistics_.clear();
 }
 
 #else
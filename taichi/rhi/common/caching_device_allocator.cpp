@@ -0,0 +1,113 @@
+#include "taichi/rhi/common/caching_device_allocator.h"
+
+#include <algorithm>
+
+#include "taichi/math/arithmetic.h"
+
+namespace taichi::lang {
+
+CachingDeviceAllocator::CachingDeviceAllocator(AllocateFn allocate_fn,
+                                               DeallocateFn deallocate_fn,
+                                               std::size_t granularity,
+                                               std::size_t max_cached_bytes)
+    : allocate_fn_(std::move(allocate_fn)),
+      deallocate_fn_(std::move(deallocate_fn)),
+      granularity_(granularity),
+      max_cached_bytes_(max_cached_bytes) {
+  TI_ASSERT(granularity_ > 0 && (granularity_ & (granularity_ - 1)) == 0);
+}
+
+CachingDeviceAllocator::~CachingDeviceAllocator() {
+  trim();
+}
+
+std::size_t CachingDeviceAllocator::round_size(std::size_t size) const {
+  size = iroundup(std::max<std::size_t>(size, 1), granularity_);
+  std::size_t power = 1;
+  while (power <= size / 2) {
+    power <<= 1;
+  }
+  // |size| is in [power, 2 * power), split into four classes.
+  return iroundup(size, std::max(granularity_, power / 4));
+}
+
+void *CachingDeviceAllocator::allocate(std::size_t size, bool *recycled) {
+  const std::size_t block_size = round_size(size);
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    auto it = free_blocks_.find(block_size);
+    if (it != free_blocks_.end()) {
+      void *ptr = it->second.back();
+      it->second.pop_back();
+      if (it->second.empty()) {
+        free_blocks_.erase(it);
+      }
+      stats_.cached_bytes -= block_size;
+      stats_.num_cached_blocks--;
+      stats_.num_hits++;
+      if (recycled) {
+        *recycled = true;
+      }
+      return ptr;
+    }
+    stats_.num_misses++;
+  }
+  if (recycled) {
+    *recycled = false;
+  }
+  void *ptr = allocate_fn_(block_size);
+  if (ptr == nullptr) {
+    // The cached blocks of other sizes may be what the backend is missing
+    trim();
+    ptr = allocate_fn_(block_size);
+  }
+  return ptr;
+}
+
+void CachingDeviceAllocator::release(std::size_t size, void *ptr) {
+  const std::size_t block_size = round_size(size);
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    if (block_size <= max_cached_bytes_) {
+      free_blocks_[block_size].push_back(ptr);
+      stats_.cached_bytes += block_size;
+      stats_.num_cached_blocks++;
+      trim_locked(max_cached_bytes_);
+      return;
+    }
+  }
+  deallocate_fn_(ptr, block_size);
+}
+
+void CachingDeviceAllocator::trim(std::size_t max_bytes) {
+  std::lock_guard<std::mutex> _(mut_);
+  trim_locked(max_bytes);
+}
+
+void CachingDeviceAllocator::trim_locked(std::size_t max_bytes) {
+  while (stats_.cached_bytes > max_bytes) {
+    auto it = std::prev(free_blocks_.end());
+    const std::size_t block_size = it->first;
+    deallocate_fn_(it->second.back(), block_size);
+    it->second.pop_back();
+    if (it->second.empty()) {
+      free_blocks_.erase(it);
+    }
+    stats_.cached_bytes -= block_size;
+    stats_.num_cached_blocks--;
+  }
+}
+
+void CachingDeviceAllocator::set_max_cached_bytes(
+    std::size_t max_cached_bytes) {
+  std::lock_guard<std::mutex> _(mut_);
+  max_cached_bytes_ = max_cached_bytes;
+  trim_locked(max_cached_bytes_);
+}
+
+CachingDeviceAllocator::Stats CachingDeviceAllocator::get_stats() {
+  std::lock_guard<std::mutex> _(mut_);
+  return stats_;
+}
+
+}  // namespace taichi::lang
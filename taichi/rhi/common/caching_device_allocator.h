@@ -0,0 +1,70 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "taichi/common/core.h"
+
+namespace taichi::lang {
+
+// Keeps the released allocations of a device, and hands them out again to
+// the following allocations of the same size class instead of going through
+// the backend. Sizes are rounded up to four classes per power of two, as the
+// second level of a TLSF allocator, which wastes at most a quarter of a
+// block.
+class TI_DLL_EXPORT CachingDeviceAllocator {
+ public:
+  // Returns a block of |size| bytes from the backend, or nullptr.
+  using AllocateFn = std::function<void *(std::size_t size)>;
+  using DeallocateFn = std::function<void(void *ptr, std::size_t size)>;
+
+  static constexpr std::size_t kDefaultMaxCachedBytes = 512 << 20;
+
+  struct Stats {
+    // The released blocks kept for reuse.
+    std::size_t cached_bytes{0};
+    std::size_t num_cached_blocks{0};
+    // The allocations served from the cache, and by the backend.
+    std::size_t num_hits{0};
+    std::size_t num_misses{0};
+  };
+
+  // Blocks are multiples of |granularity|. At most |max_cached_bytes| are
+  // kept, the largest blocks are returned to the backend first.
+  CachingDeviceAllocator(AllocateFn allocate_fn,
+                         DeallocateFn deallocate_fn,
+                         std::size_t granularity,
+                         std::size_t max_cached_bytes);
+  ~CachingDeviceAllocator();
+
+  // The size of the blocks serving the allocations of |size| bytes.
+  std::size_t round_size(std::size_t size) const;
+
+  // Returns a block of round_size(size) bytes, or nullptr if the backend is
+  // out of memory even after trimming the cache. The content of a recycled
+  // block is left as it was released.
+  void *allocate(std::size_t size, bool *recycled = nullptr);
+  // |size| is the size passed to allocate().
+  void release(std::size_t size, void *ptr);
+  // Returns the cached blocks to the backend until at most |max_bytes| are
+  // left.
+  void trim(std::size_t max_bytes = 0);
+  void set_max_cached_bytes(std::size_t max_cached_bytes);
+  Stats get_stats();
+
+ private:
+  void trim_locked(std::size_t max_bytes);
+
+  AllocateFn allocate_fn_;
+  DeallocateFn deallocate_fn_;
+  std::size_t granularity_;
+  std::size_t max_cached_bytes_;
+
+  // The released blocks by size, the most recently released last.
+  std::map<std::size_t, std::vector<void *>> free_blocks_;
+  Stats stats_;
+  std::mutex mut_;
+};
+
+}  // namespace taichi::lang
@@ -1,5 +1,8 @@
 #include "taichi/rhi/common/host_memory_pool.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <memory>
 
 #if defined(TI_PLATFORM_UNIX)
@@ -10,8 +13,26 @@
 
 namespace taichi::lang {
 
+struct HostMemoryPool::ThreadCache {
+  // Size classes up to 32 KB, with up to 16 allocations each.
+  static constexpr std::size_t kMaxSize = 32 << 10;
+  static constexpr std::size_t kMaxBlocks = 16;
+
+  HostMemoryPool *pool{nullptr};
+  std::atomic<uint64> generation{0};
+  std::vector<std::vector<void *>> blocks;
+  // Written by the owner thread only, read by get_stats().
+  std::atomic<std::size_t> bytes{0};
+
+  ~ThreadCache() {
+    if (pool) {
+      pool->retire_thread_cache(*this);
+    }
+  }
+};
+
 HostMemoryPool::HostMemoryPool() {
-  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator());
+  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator(this));
 
   TI_TRACE("Memory pool created. Default buffer size per allocator = {} MB",
            UnifiedAllocator::default_allocator_size / 1024 / 1024);
@@ -20,6 +41,20 @@ HostMemoryPool::HostMemoryPool() {
 void *HostMemoryPool::allocate(std::size_t size,
                                std::size_t alignment,
                                bool exclusive) {
+  if (use_thread_caches_ && !exclusive && size <= ThreadCache::kMaxSize) {
+    auto &cache = get_thread_cache();
+    const int c = UnifiedAllocator::size_class(size);
+    auto &blocks = cache.blocks[c];
+    if (!blocks.empty() && (std::size_t)blocks.back() % alignment == 0) {
+      void *ret = blocks.back();
+      blocks.pop_back();
+      cache.bytes.store(cache.bytes.load(std::memory_order_relaxed) -
+                            UnifiedAllocator::class_size(c),
+                        std::memory_order_relaxed);
+      return ret;
+    }
+  }
+
   std::lock_guard<std::mutex> _(mut_allocation_);
 
   if (!allocator_) {
@@ -29,7 +64,20 @@ void *HostMemoryPool::allocate(std::size_t size,
   return ret;
 }
 
-void HostMemoryPool::release(std::size_t size, void *ptr) {
+void HostMemoryPool::release(std::size_t size, void *ptr, bool exclusive) {
+  if (use_thread_caches_ && !exclusive && size <= ThreadCache::kMaxSize) {
+    auto &cache = get_thread_cache();
+    const int c = UnifiedAllocator::size_class(size);
+    auto &blocks = cache.blocks[c];
+    if (blocks.size() < ThreadCache::kMaxBlocks) {
+      blocks.push_back(ptr);
+      cache.bytes.store(cache.bytes.load(std::memory_order_relaxed) +
+                            UnifiedAllocator::class_size(c),
+                        std::memory_order_relaxed);
+      return;
+    }
+  }
+
   std::lock_guard<std::mutex> _(mut_allocation_);
 
   if (!allocator_) {
@@ -37,10 +85,82 @@ void HostMemoryPool::release(std::size_t size, void *ptr) {
   }
 
   if (allocator_->release(size, ptr)) {
-    if (dynamic_cast<UnifiedAllocator *>(allocator_.get())) {
-      deallocate_raw_memory(ptr);  // release raw memory as well
+    deallocate_raw_memory(ptr);  // release raw memory as well
+  }
+}
+
+HostMemoryPool::ThreadCache &HostMemoryPool::get_thread_cache() {
+  thread_local ThreadCache cache;
+  const auto generation = generation_.load(std::memory_order_acquire);
+  if (cache.generation.load(std::memory_order_relaxed) != generation) {
+    if (!cache.pool) {
+      std::lock_guard<std::mutex> _(mut_allocation_);
+      cache.pool = this;
+      thread_caches_.push_back(&cache);
     }
+    // The cached memory was freed by reset()
+    cache.blocks.clear();
+    cache.blocks.resize(
+        UnifiedAllocator::size_class(ThreadCache::kMaxSize) + 1);
+    cache.bytes.store(0, std::memory_order_relaxed);
+    cache.generation.store(generation, std::memory_order_relaxed);
   }
+  return cache;
+}
+
+void HostMemoryPool::retire_thread_cache(ThreadCache &cache) {
+  std::lock_guard<std::mutex> _(mut_allocation_);
+  thread_caches_.erase(
+      std::find(thread_caches_.begin(), thread_caches_.end(), &cache));
+  if (!allocator_ || cache.generation.load() != generation_.load()) {
+    return;
+  }
+  for (int c = 0; c < (int)cache.blocks.size(); c++) {
+    for (void *ptr : cache.blocks[c]) {
+      allocator_->release(UnifiedAllocator::class_size(c), ptr);
+    }
+  }
+}
+
+HostMemoryPool::Stats HostMemoryPool::get_stats() {
+  std::lock_guard<std::mutex> _(mut_allocation_);
+  Stats stats;
+  for (auto &[ptr, size] : raw_memory_chunks_) {
+    stats.reserved_bytes += size;
+  }
+  if (!allocator_) {
+    return stats;
+  }
+  for (auto &[ptr, size] : allocator_->exclusive_chunks_) {
+    stats.num_chunks++;
+    stats.num_exclusive_chunks++;
+    stats.used_bytes += size;
+  }
+  for (auto &chunk : allocator_->chunks_) {
+    const auto data = (std::size_t)chunk.data;
+    const auto head = (std::size_t)chunk.head;
+    const auto tail = (std::size_t)chunk.tail;
+    stats.num_chunks++;
+    stats.used_bytes += head - data;
+    stats.free_bytes += tail - head;
+    stats.largest_free_bytes = std::max(stats.largest_free_bytes, tail - head);
+  }
+  stats.binned_bytes = allocator_->binned_bytes_;
+  stats.num_binned_blocks = allocator_->num_binned_blocks_;
+  const auto generation = generation_.load();
+  for (auto *cache : thread_caches_) {
+    if (cache->generation.load() == generation) {
+      stats.thread_cached_bytes += cache->bytes.load();
+    }
+  }
+  stats.used_bytes -= stats.binned_bytes + stats.thread_cached_bytes;
+  for (auto &[ptr, size] : huge_page_chunks_) {
+    stats.huge_page_bytes += size;
+  }
+  if (!huge_page_chunks_.empty()) {
+    stats.huge_page_backed_bytes = query_huge_page_backed_bytes();
+  }
+  return stats;
 }
 
 void *HostMemoryPool::allocate_raw_memory(std::size_t size) {
@@ -55,23 +175,32 @@ void *HostMemoryPool::allocate_raw_memory(std::size_t size) {
   */
 
   void *ptr = nullptr;
+  if (huge_pages_ != HugePages::kNone && size >= huge_page_min_size_) {
+    ptr = allocate_huge_pages(size);
+    if (ptr) {
+      huge_page_chunks_[ptr] = size;
+    }
+  }
+  if (!ptr) {
 #if defined(TI_PLATFORM_UNIX)
-  ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
-             -1, 0);
-  TI_ERROR_IF(ptr == MAP_FAILED, "Virtual memory allocation ({} B) failed.",
-              size);
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    TI_ERROR_IF(ptr == MAP_FAILED, "Virtual memory allocation ({} B) failed.",
+                size);
 #else
-  MEMORYSTATUSEX stat;
-  stat.dwLength = sizeof(stat);
-  GlobalMemoryStatusEx(&stat);
-  if (stat.ullAvailVirtual < size) {
-    TI_P(stat.ullAvailVirtual);
-    TI_P(size);
-    TI_ERROR("Insufficient virtual memory space");
-  }
-  ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-  TI_ERROR_IF(ptr == nullptr, "Virtual memory allocation ({} B) failed.", size);
+    MEMORYSTATUSEX stat;
+    stat.dwLength = sizeof(stat);
+    GlobalMemoryStatusEx(&stat);
+    if (stat.ullAvailVirtual < size) {
+      TI_P(stat.ullAvailVirtual);
+      TI_P(size);
+      TI_ERROR("Insufficient virtual memory space");
+    }
+    ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    TI_ERROR_IF(ptr == nullptr, "Virtual memory allocation ({} B) failed.",
+                size);
 #endif
+  }
   TI_ERROR_IF(((uint64_t)ptr) % page_size != 0,
               "Allocated address ({:}) is not aligned by page size {}", ptr,
               page_size);
@@ -109,11 +238,163 @@ void HostMemoryPool::deallocate_raw_memory(void *ptr) {
     TI_ERROR("Failed to free virtual memory ({} B)", size);
 
   raw_memory_chunks_.erase(ptr);
+  huge_page_chunks_.erase(ptr);
+}
+
+HostMemoryPool::HugePages HostMemoryPool::huge_pages_from_name(
+    const std::string &name) {
+  if (name == "none") {
+    return HugePages::kNone;
+  } else if (name == "transparent") {
+    return HugePages::kTransparent;
+  } else if (name == "explicit_2m") {
+    return HugePages::kExplicit2M;
+  } else if (name == "explicit_1g") {
+    return HugePages::kExplicit1G;
+  }
+  TI_ERROR(
+      "Unknown huge pages '{}', expected 'none', 'transparent', 'explicit_2m' "
+      "or 'explicit_1g'",
+      name);
+}
+
+void HostMemoryPool::set_huge_pages(HugePages huge_pages,
+                                    std::size_t min_size) {
+  std::lock_guard<std::mutex> _(mut_allocation_);
+  huge_pages_ = huge_pages;
+  huge_page_min_size_ = min_size;
+}
+
+void *HostMemoryPool::allocate_huge_pages(std::size_t &size) {
+  // Be aware that this method is not protected by the mutex, as
+  // allocate_raw_memory().
+  auto warn_once = [this](const std::string &msg) {
+    if (!huge_page_warned_) {
+      TI_WARN("{}", msg);
+      huge_page_warned_ = true;
+    }
+  };
+  auto round_up = [](std::size_t size, std::size_t page) {
+    return (size + page - 1) / page * page;
+  };
+
+  if (huge_pages_ == HugePages::kExplicit2M ||
+      huge_pages_ == HugePages::kExplicit1G) {
+    const bool is_1g = huge_pages_ == HugePages::kExplicit1G;
+    const std::size_t huge_page_size = is_1g ? (1 << 30) : (2 << 20);
+    const std::size_t huge_size = round_up(size, huge_page_size);
+#if defined(__linux__) && defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    const int page_flag = (is_1g ? 30 : 21) << MAP_HUGE_SHIFT;
+    void *ptr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag,
+                     -1, 0);
+    if (ptr != MAP_FAILED) {
+      size = huge_size;
+      return ptr;
+    }
+    warn_once(fmt::format(
+        "Failed to map {} B of explicit huge pages, falling back to "
+        "transparent huge pages. Reserve them in "
+        "/sys/kernel/mm/hugepages/hugepages-{}kB/nr_hugepages",
+        huge_size, huge_page_size / 1024));
+#elif defined(TI_PLATFORM_WINDOWS)
+    const std::size_t large_page_size = GetLargePageMinimum();
+    if (large_page_size != 0) {
+      const std::size_t large_size = round_up(size, large_page_size);
+      void *ptr =
+          VirtualAlloc(nullptr, large_size,
+                       MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                       PAGE_READWRITE);
+      if (ptr != nullptr) {
+        size = large_size;
+        return ptr;
+      }
+    }
+    warn_once(
+        "Failed to allocate large pages, which need the privilege to lock "
+        "pages in memory");
+    return nullptr;
+#endif
+  }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  // Align the chunk to the huge pages, which the kernel only uses for the
+  // aligned 2 MB ranges of a mapping.
+  const std::size_t alignment = 2 << 20;
+  const std::size_t aligned_size = round_up(size, page_size);
+  auto *ptr = (char *)mmap(nullptr, aligned_size + alignment,
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1, 0);
+  if (ptr == (char *)MAP_FAILED) {
+    return nullptr;
+  }
+  auto *begin = (char *)round_up((std::size_t)ptr, alignment);
+  auto *end = begin + aligned_size;
+  if (begin != ptr) {
+    munmap(ptr, begin - ptr);
+  }
+  if (end != ptr + aligned_size + alignment) {
+    munmap(end, ptr + aligned_size + alignment - end);
+  }
+  if (madvise(begin, aligned_size, MADV_HUGEPAGE) != 0) {
+    warn_once(
+        "Transparent huge pages are not available, see "
+        "/sys/kernel/mm/transparent_hugepage/enabled");
+  }
+  size = aligned_size;
+  return begin;
+#else
+  warn_once("Huge pages are not supported on this platform");
+  return nullptr;
+#endif
+}
+
+std::size_t HostMemoryPool::query_huge_page_backed_bytes() const {
+  std::size_t backed = 0;
+#if defined(__linux__)
+  // The mappings of the process and their huge pages, in kB.
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  std::size_t overlap = 0;
+  while (std::getline(smaps, line)) {
+    std::size_t begin = 0, end = 0;
+    if (std::sscanf(line.c_str(), "%zx-%zx ", &begin, &end) == 2) {
+      // A mapping may span several chunks, or more than the chunks.
+      overlap = 0;
+      for (auto &[ptr, size] : huge_page_chunks_) {
+        const auto chunk_begin = (std::size_t)ptr;
+        const auto chunk_end = chunk_begin + size;
+        if (chunk_begin < end && begin < chunk_end) {
+          overlap += std::min(end, chunk_end) - std::max(begin, chunk_begin);
+        }
+      }
+      continue;
+    }
+    if (overlap == 0) {
+      continue;
+    }
+    std::size_t kb = 0;
+    if (std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1 ||
+        std::sscanf(line.c_str(), "Private_Hugetlb: %zu kB", &kb) == 1 ||
+        std::sscanf(line.c_str(), "Shared_Hugetlb: %zu kB", &kb) == 1) {
+      const auto bytes = std::min(kb * 1024, overlap);
+      backed += bytes;
+      overlap -= bytes;
+    }
+  }
+#elif defined(TI_PLATFORM_WINDOWS)
+  // Large pages are always backed
+  for (auto &[ptr, size] : huge_page_chunks_) {
+    backed += size;
+  }
+#endif
+  return backed;
 }
 
 void HostMemoryPool::reset() {
   std::lock_guard<std::mutex> _(mut_allocation_);
-  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator());
+  generation_++;
+  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator(this));
 
   const auto ptr_map_copied = raw_memory_chunks_;
   for (auto &ptr : ptr_map_copied) {
@@ -128,7 +409,11 @@ HostMemoryPool::~HostMemoryPool() {
 const size_t HostMemoryPool::page_size{1 << 12};  // 4 KB page size by default
 
 HostMemoryPool &HostMemoryPool::get_instance() {
-  static HostMemoryPool *memory_pool = new HostMemoryPool();
+  static HostMemoryPool *memory_pool = [] {
+    auto *pool = new HostMemoryPool();
+    pool->use_thread_caches_ = true;
+    return pool;
+  }();
   return *memory_pool;
 }
 
@@ -2,7 +2,9 @@
 #include "taichi/common/core.h"
 #include "taichi/rhi/common/unified_allocator.h"
 #include "taichi/rhi/device.h"
+#include <atomic>
 #include <mutex>
+#include <string>
 #include <vector>
 #include <memory>
 #include <thread>
@@ -15,27 +17,88 @@ class TI_DLL_EXPORT HostMemoryPool {
  public:
   static const size_t page_size;
 
+  // How the large chunks are backed by huge pages, see set_huge_pages().
+  enum class HugePages { kNone, kTransparent, kExplicit2M, kExplicit1G };
+
+  // "none", "transparent", "explicit_2m" or "explicit_1g".
+  static HugePages huge_pages_from_name(const std::string &name);
+
+  struct Stats {
+    // The memory mapped from the OS.
+    std::size_t reserved_bytes{0};
+    // The memory handed out and not released yet.
+    std::size_t used_bytes{0};
+    std::size_t num_chunks{0};
+    std::size_t num_exclusive_chunks{0};
+    // The remaining space of the shared chunks and the largest of them. The
+    // pool is fragmented when a request larger than |largest_free_bytes| but
+    // smaller than |free_bytes| has to map a new chunk.
+    std::size_t free_bytes{0};
+    std::size_t largest_free_bytes{0};
+    // The released shared allocations kept for reuse by the pool, and by the
+    // thread caches. They only grow the pool when the following requests are
+    // of other sizes.
+    std::size_t binned_bytes{0};
+    std::size_t num_binned_blocks{0};
+    std::size_t thread_cached_bytes{0};
+    // The chunks mapped with huge pages or advised to use them, and how much
+    // of them the OS reports backed by huge pages. Transparent huge pages are
+    // only backed once touched, if available.
+    std::size_t huge_page_bytes{0};
+    std::size_t huge_page_backed_bytes{0};
+  };
+
   static HostMemoryPool &get_instance();
 
   void *allocate(std::size_t size,
                  std::size_t alignment,
                  bool exclusive = false);
-  void release(std::size_t size, void *ptr);
+  // |exclusive| must match the allocation. A shared allocation is reused by
+  // the following allocations of its size, from the same thread first.
+  void release(std::size_t size, void *ptr, bool exclusive = true);
   void reset();
+  Stats get_stats();
+
+  // Backs the chunks of at least |min_size| bytes mapped from now on with
+  // huge pages. Explicit huge pages must be reserved by the OS, otherwise
+  // transparent huge pages are used instead. Linux only, except explicit huge
+  // pages on Windows, which need the privilege to lock pages in memory.
+  void set_huge_pages(HugePages huge_pages, std::size_t min_size);
   HostMemoryPool();
   ~HostMemoryPool();
 
  protected:
+  // The small shared allocations released by a thread, which its next
+  // allocations reuse without locking. Only for the global pool.
+  struct ThreadCache;
+
   void *allocate_raw_memory(std::size_t size);
   void deallocate_raw_memory(void *ptr);
+  // Maps |size| bytes with huge pages, rounding |size| up to the mapped size.
+  // Returns nullptr if the OS can't.
+  void *allocate_huge_pages(std::size_t &size);
+  std::size_t query_huge_page_backed_bytes() const;
+
+  ThreadCache &get_thread_cache();
+  void retire_thread_cache(ThreadCache &cache);
 
   // All the raw memory allocated from OS/Driver
   // We need to keep track of them to guarantee that they are freed
   std::map<void *, std::size_t> raw_memory_chunks_;
+  // The raw memory chunks backed by huge pages.
+  std::map<void *, std::size_t> huge_page_chunks_;
+  HugePages huge_pages_{HugePages::kNone};
+  std::size_t huge_page_min_size_{0};
+  bool huge_page_warned_{false};
 
   std::unique_ptr<UnifiedAllocator> allocator_;
   std::mutex mut_allocation_;
 
+  bool use_thread_caches_{false};
+  // Bumped by reset(), which drops the thread caches.
+  std::atomic<uint64> generation_{1};
+  std::vector<ThreadCache *> thread_caches_;
+
   friend class UnifiedAllocator;
 };
 
@@ -2,6 +2,7 @@
 
 #include "taichi/rhi/common/unified_allocator.h"
 #include "taichi/rhi/common/host_memory_pool.h"
+#include <algorithm>
 #include <string>
 
 namespace taichi::lang {
@@ -20,63 +21,114 @@ static void swap_erase_vector(std::vector<T> &vec, size_t idx) {
 
   vec.pop_back();
 
-  // There's no need to swap back since we'll iterate the memory chunks to
-  // search for reusable memory
+  // There's no need to swap back since the order of the released memory
+  // doesn't matter
 }
 
-UnifiedAllocator::UnifiedAllocator() {
+int UnifiedAllocator::size_class(std::size_t size) {
+  if (size <= 128) {
+    return (int)((std::max<std::size_t>(size, 1) + 15) / 16) - 1;
+  }
+  // |size| is in (2^k, 2^(k + 1)], split into four classes.
+  int k = 7;
+  while ((std::size_t(2) << k) < size) {
+    k++;
+  }
+  const std::size_t step = std::size_t(1) << (k - 2);
+  return 8 + (k - 7) * 4 +
+         (int)((size - (std::size_t(1) << k) + step - 1) / step) - 1;
+}
+
+std::size_t UnifiedAllocator::class_size(int size_class) {
+  if (size_class < 8) {
+    return std::size_t(size_class + 1) * 16;
+  }
+  const int j = size_class - 8;
+  const int k = 7 + j / 4;
+  const std::size_t step = std::size_t(1) << (k - 2);
+  return (std::size_t(1) << k) + std::size_t(j % 4 + 1) * step;
+}
+
+UnifiedAllocator::UnifiedAllocator(HostMemoryPool *pool)
+    : pool_(pool), bins_(size_class(kMaxBinnedSize) + 1) {
 }
 
 void *UnifiedAllocator::allocate(std::size_t size,
                                  std::size_t alignment,
                                  bool exclusive) {
-  // UnifiedAllocator never reuses the previously allocated memory
-  // just move the head forward util depleting all the free memory
-
   // Note: put mutex on MemoryPool instead of Allocator, since Allocators are
   // transparent to user code
-  std::size_t allocation_size = size;
-  if (!chunks_.empty() && !exclusive) {
-    // Search for a non-exclusive chunk that has enough space
-    for (size_t chunk_id = 0; chunk_id < chunks_.size(); chunk_id++) {
-      auto &chunk = chunks_[chunk_id];
-      if (chunk.is_exclusive) {
-        continue;
+  if (exclusive) {
+    // Do not allocate large memory chunks for "exclusive" allocation
+    // to increate memory & performance efficiency
+    void *ptr = pool_->allocate_raw_memory(size);
+    TI_ASSERT(uint64(ptr) % HostMemoryPool::page_size == 0);
+    exclusive_chunks_[ptr] = size;
+    return ptr;
+  }
+
+  // Reuse a released allocation of the same size class
+  if (size <= kMaxBinnedSize) {
+    const int c = size_class(size);
+    size = class_size(c);
+    auto &bin = bins_[c];
+    // The most recently released allocations are the likeliest to be cached
+    for (int i = (int)bin.size() - 1; i >= 0 && i >= (int)bin.size() - 8;
+         i--) {
+      void *ptr = bin[i];
+      if ((std::size_t)ptr % alignment == 0) {
+        swap_erase_vector<void *>(bin, i);
+        binned_bytes_ -= size;
+        num_binned_blocks_--;
+        return ptr;
       }
-      auto head = (std::size_t)chunk.head;
-      auto tail = (std::size_t)chunk.tail;
-      auto data = (std::size_t)chunk.data;
-      auto ret = head + alignment - 1 - (head + alignment - 1) % alignment;
-      TI_TRACE("UM [data={}] allocate() request={} remain={}", (intptr_t)data,
-               size, (tail - head));
-      head = ret + allocation_size;
-      if (head <= tail) {
-        // success
-        TI_ASSERT(ret % alignment == 0);
-        chunk.head = (void *)head;
-        return (void *)ret;
+    }
+  } else {
+    auto [begin, end] = large_free_blocks_.equal_range(size);
+    for (auto iter = begin; iter != end; ++iter) {
+      void *ptr = iter->second;
+      if ((std::size_t)ptr % alignment == 0) {
+        large_free_blocks_.erase(iter);
+        binned_bytes_ -= size;
+        num_binned_blocks_--;
+        return ptr;
       }
     }
   }
+  return allocate_from_chunks(size, alignment);
+}
+
+void *UnifiedAllocator::allocate_from_chunks(std::size_t size,
+                                             std::size_t alignment) {
+  // Search for a shared chunk that has enough space
+  for (auto &chunk : chunks_) {
+    auto head = (std::size_t)chunk.head;
+    auto tail = (std::size_t)chunk.tail;
+    auto data = (std::size_t)chunk.data;
+    auto ret = head + alignment - 1 - (head + alignment - 1) % alignment;
+    TI_TRACE("UM [data={}] allocate() request={} remain={}", (intptr_t)data,
+             size, (tail - head));
+    head = ret + size;
+    if (head <= tail) {
+      // success
+      TI_ASSERT(ret % alignment == 0);
+      chunk.head = (void *)head;
+      return (void *)ret;
+    }
+  }
 
   // Allocate a new chunk
   MemoryChunk chunk;
-
-  if (!exclusive) {
-    // Do not allocate large memory chunks for "exclusive" allocation
-    // to increate memory & performance efficiency
-    allocation_size = std::max(allocation_size, default_allocator_size);
-  }
+  std::size_t allocation_size = std::max(size, default_allocator_size);
 
   TI_TRACE("Allocating virtual address space of size {} MB",
            allocation_size / 1024 / 1024);
 
-  void *ptr =
-      HostMemoryPool::get_instance().allocate_raw_memory(allocation_size);
+  void *ptr = pool_->allocate_raw_memory(allocation_size);
   chunk.data = ptr;
-  chunk.head = chunk.data;
-  chunk.tail = (void *)((std::size_t)chunk.head + allocation_size);
-  chunk.is_exclusive = exclusive;
+  chunk.head = (void *)((std::size_t)chunk.data + size);
+  chunk.tail = (void *)((std::size_t)chunk.data + allocation_size);
+  chunk.is_exclusive = false;
 
   TI_ASSERT(chunk.data != nullptr);
   TI_ASSERT(uint64(chunk.data) % HostMemoryPool::page_size == 0);
@@ -86,25 +138,32 @@ void *UnifiedAllocator::allocate(std::size_t size,
 }
 
 bool UnifiedAllocator::release(size_t sz, void *ptr) {
-  // UnifiedAllocator is special in that it never reuses the previously
-  // allocated memory We have to release the entire memory chunk to avoid memory
-  // leak
-  int remove_idx = -1;
-  for (size_t chunk_idx = 0; chunk_idx < chunks_.size(); chunk_idx++) {
-    auto &chunk = chunks_[chunk_idx];
-
-    if (chunk.data == ptr) {
-      TI_ASSERT(chunk.is_exclusive);
-      remove_idx = chunk_idx;
-    }
-  }
-
-  if (remove_idx != -1) {
-    swap_erase_vector<MemoryChunk>(chunks_, remove_idx);
+  // An exclusive chunk is released as a whole
+  auto iter = exclusive_chunks_.find(ptr);
+  if (iter != exclusive_chunks_.end()) {
+    exclusive_chunks_.erase(iter);
     // MemoryPool is responsible for releasing the raw memory
     return true;
   }
 
+  // A shared allocation is kept for the next allocations of its size
+  bool found = false;
+  for (auto &chunk : chunks_) {
+    if (chunk.data <= ptr && ptr < chunk.head) {
+      found = true;
+      break;
+    }
+  }
+  TI_ERROR_IF(!found, "Memory address ({:}) is not allocated", ptr);
+  if (sz <= kMaxBinnedSize) {
+    const int c = size_class(sz);
+    bins_[c].push_back(ptr);
+    binned_bytes_ += class_size(c);
+  } else {
+    large_free_blocks_.insert({sz, ptr});
+    binned_bytes_ += sz;
+  }
+  num_binned_blocks_++;
   return false;
 }
 
@@ -3,6 +3,7 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
 
 #include "taichi/rhi/arch.h"
 #include "taichi/rhi/device.h"
@@ -24,15 +25,38 @@ class UnifiedAllocator {
  private:
   static const std::size_t default_allocator_size;
 
-  UnifiedAllocator();
+  // Shared allocations up to this size are rounded up to a size class, and
+  // reused from the bin of their class once released.
+  static constexpr std::size_t kMaxBinnedSize = 1 << 20;
+
+  // Size classes are multiples of 16 bytes up to 128 bytes, then four per
+  // power of two, which wastes at most a quarter of an allocation.
+  static int size_class(std::size_t size);
+  static std::size_t class_size(int size_class);
+
+  explicit UnifiedAllocator(HostMemoryPool *pool);
 
   void *allocate(std::size_t size,
                  std::size_t alignment,
                  bool exclusive = false);
 
+  // Returns true if |ptr| is an exclusive chunk, whose raw memory is to be
+  // released by the pool. Shared allocations are kept for reuse.
   bool release(size_t sz, void *ptr);
 
+  void *allocate_from_chunks(std::size_t size, std::size_t alignment);
+
+  HostMemoryPool *pool_;
+  // The shared chunks, from which the non-exclusive allocations are carved.
   std::vector<MemoryChunk> chunks_;
+  std::unordered_map<void *, std::size_t> exclusive_chunks_;
+
+  // The released shared allocations, by size class.
+  std::vector<std::vector<void *>> bins_;
+  // The released shared allocations above kMaxBinnedSize, by exact size.
+  std::multimap<std::size_t, void *> large_free_blocks_;
+  std::size_t binned_bytes_{0};
+  std::size_t num_binned_blocks_{0};
 
   friend class HostMemoryPool;
 };
@@ -1,9 +1,22 @@
 #include "taichi/rhi/cpu/cpu_device.h"
+
+#include <algorithm>
+#include <cstring>
+
 #include "taichi/rhi/impl_support.h"
 #include "taichi/rhi/common/host_memory_pool.h"
 
 #include "taichi/jit/jit_module.h"
 
+#if defined(TI_PLATFORM_UNIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include "taichi/platform/windows/windows.h"
+#endif
+
 namespace taichi::lang {
 
 namespace cpu {
@@ -14,6 +27,16 @@ CpuDevice::AllocInfo CpuDevice::get_alloc_info(const DeviceAllocation handle) {
 }
 
 CpuDevice::CpuDevice() {
+  allocation_cache_ = std::make_unique<CachingDeviceAllocator>(
+      [](std::size_t size) {
+        return HostMemoryPool::get_instance().allocate(
+            size, HostMemoryPool::page_size, true /*exclusive*/);
+      },
+      [](void *ptr, std::size_t size) {
+        HostMemoryPool::get_instance().release(size, ptr, true /*exclusive*/);
+      },
+      HostMemoryPool::page_size,
+      CachingDeviceAllocator::kDefaultMaxCachedBytes);
 }
 
 RhiResult CpuDevice::allocate_memory(const AllocParams &params,
@@ -24,13 +47,26 @@ RhiResult CpuDevice::allocate_memory(const AllocParams &params,
 
   if (info.size == 0) {
     info.ptr = nullptr;
-  } else {
+  } else if (info.size <= kMaxSharedAllocationSize) {
+    info.exclusive = false;
     info.ptr = HostMemoryPool::get_instance().allocate(
-        params.size, HostMemoryPool::page_size, true /*exclusive*/);
-
+        params.size, kSharedAllocationAlignment);
+    if (info.ptr == nullptr) {
+      return RhiResult::out_of_memory;
+    }
+    // Zeroed as the freshly mapped memory, since it may be reused
+    std::memset(info.ptr, 0, info.size);
+  } else {
+    bool recycled = false;
+    info.ptr = allocation_cache_->allocate(params.size, &recycled);
     if (info.ptr == nullptr) {
       return RhiResult::out_of_memory;
     }
+    info.use_allocation_cache = true;
+    if (recycled) {
+      // Zeroed as the freshly mapped memory
+      zero_fill(info.ptr, info.size);
+    }
   }
   *out_devalloc = DeviceAllocation{};
   out_devalloc->alloc_id = allocations_.size();
@@ -41,6 +77,27 @@ RhiResult CpuDevice::allocate_memory(const AllocParams &params,
   return RhiResult::success;
 }
 
+void CpuDevice::zero_fill(void *ptr, size_t size) {
+  if (thread_pool_ == nullptr || size < kMinParallelZeroFillSize) {
+    std::memset(ptr, 0, size);
+    return;
+  }
+  struct ZeroFillContext {
+    char *ptr;
+    size_t size;
+  } context{static_cast<char *>(ptr), size};
+  const int num_blocks =
+      (int)((size + kZeroFillBlockSize - 1) / kZeroFillBlockSize);
+  thread_pool_->run(num_blocks, thread_pool_->max_num_threads, &context,
+                    [](void *context, int thread_id, int i) {
+                      auto *ctx = static_cast<ZeroFillContext *>(context);
+                      const size_t begin = i * kZeroFillBlockSize;
+                      std::memset(ctx->ptr + begin, 0,
+                                  std::min(kZeroFillBlockSize,
+                                           ctx->size - begin));
+                    });
+}
+
 DeviceAllocation CpuDevice::allocate_memory_runtime(
     const LlvmRuntimeAllocParams &params) {
   DeviceAllocation alloc;
@@ -67,8 +124,21 @@ void CpuDevice::dealloc_memory(DeviceAllocation handle) {
   if (info.ptr == nullptr) {
     TI_ERROR("the DeviceAllocation is already deallocated");
   }
-  if (!info.use_cached) {
-    HostMemoryPool::get_instance().release(info.size, info.ptr);
+  if (info.mapped_base) {
+#if defined(TI_PLATFORM_UNIX)
+    munmap(info.mapped_base, info.mapped_size);
+#else
+    UnmapViewOfFile(info.mapped_base);
+#endif
+    info.mapped_base = nullptr;
+    info.ptr = nullptr;
+  } else if (!info.use_cached) {
+    if (info.use_allocation_cache) {
+      allocation_cache_->release(info.size, info.ptr);
+    } else {
+      HostMemoryPool::get_instance().release(info.size, info.ptr,
+                                             info.exclusive);
+    }
     info.ptr = nullptr;
   }
 }
@@ -160,5 +230,86 @@ DeviceAllocation CpuDevice::import_memory(void *ptr, size_t size) {
   return alloc;
 }
 
+DeviceAllocation CpuDevice::map_file(const std::string &path,
+                                     size_t offset,
+                                     size_t size,
+                                     MemoryAccessHint hint) {
+  TI_ERROR_IF(size == 0, "Cannot map an empty range of \"{}\"", path);
+  AllocInfo info;
+  info.size = size;
+#if defined(TI_PLATFORM_UNIX)
+  const size_t granularity = sysconf(_SC_PAGESIZE);
+  const size_t aligned_offset = offset / granularity * granularity;
+  info.mapped_size = size + (offset - aligned_offset);
+
+  int fd = open(path.c_str(), O_RDONLY);
+  TI_ERROR_IF(fd < 0, "Failed to open \"{}\" for mapping", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < offset + size) {
+    close(fd);
+    TI_ERROR("\"{}\" is shorter than the {} B to map at offset {}", path,
+             size, offset);
+  }
+  void *base = mmap(nullptr, info.mapped_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, fd, aligned_offset);
+  // The mapping keeps the file referenced.
+  close(fd);
+  TI_ERROR_IF(base == MAP_FAILED, "Failed to map \"{}\" ({} B)", path,
+              info.mapped_size);
+
+  int advice = MADV_NORMAL;
+  if (hint == MemoryAccessHint::sequential) {
+    advice = MADV_SEQUENTIAL;
+  } else if (hint == MemoryAccessHint::random) {
+    advice = MADV_RANDOM;
+  } else if (hint == MemoryAccessHint::will_need) {
+    advice = MADV_WILLNEED;
+  }
+  if (madvise(base, info.mapped_size, advice) != 0) {
+    TI_WARN("madvise() failed on the mapping of \"{}\"", path);
+  }
+#else
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  const size_t granularity = system_info.dwAllocationGranularity;
+  const size_t aligned_offset = offset / granularity * granularity;
+  info.mapped_size = size + (offset - aligned_offset);
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  TI_ERROR_IF(file == INVALID_HANDLE_VALUE, "Failed to open \"{}\" for mapping",
+              path);
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      (size_t)file_size.QuadPart < offset + size) {
+    CloseHandle(file);
+    TI_ERROR("\"{}\" is shorter than the {} B to map at offset {}", path,
+             size, offset);
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file);
+  TI_ERROR_IF(mapping == nullptr, "Failed to map \"{}\"", path);
+  void *base = MapViewOfFile(
+      mapping, FILE_MAP_COPY, DWORD(uint64_t(aligned_offset) >> 32),
+      DWORD(aligned_offset & 0xffffffffu), info.mapped_size);
+  // The view keeps the mapping referenced.
+  CloseHandle(mapping);
+  TI_ERROR_IF(base == nullptr, "Failed to map \"{}\" ({} B)", path,
+              info.mapped_size);
+  // Paging hints are not forwarded on Windows.
+  (void)hint;
+#endif
+  info.mapped_base = base;
+  info.ptr = (uint8_t *)base + (offset - aligned_offset);
+
+  DeviceAllocation alloc;
+  alloc.alloc_id = allocations_.size();
+  alloc.device = this;
+  allocations_.push_back(info);
+  return alloc;
+}
+
 }  // namespace cpu
 }  // namespace taichi::lang
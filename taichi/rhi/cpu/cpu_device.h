@@ -1,11 +1,13 @@
 #pragma once
 
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "taichi/common/core.h"
 #include "taichi/rhi/llvm/llvm_device.h"
+#include "taichi/system/threading.h"
 
 namespace taichi::lang {
 namespace cpu {
@@ -58,19 +60,48 @@ class CpuStream : public Stream {
   void command_sync() override{TI_NOT_IMPLEMENTED};
 };
 
+// How a memory-mapped file is going to be accessed, forwarded to the OS as
+// a paging hint.
+enum class MemoryAccessHint { normal, sequential, random, will_need };
+
 class CpuDevice : public LlvmDevice {
  public:
   struct AllocInfo {
     void *ptr{nullptr};
     size_t size{0};
     bool use_cached{false};
+    // Whether |ptr| was mapped for this allocation alone, see
+    // kMaxSharedAllocationSize.
+    bool exclusive{true};
+    // Whether |ptr| is recycled by the |allocation_cache_| once released.
+    bool use_allocation_cache{false};
+    // The page-aligned view of a memory-mapped file containing |ptr|.
+    void *mapped_base{nullptr};
+    size_t mapped_size{0};
   };
 
+  // Allocations up to this size are carved from the shared chunks of the
+  // HostMemoryPool and reused once released, so that temporary ndarrays don't
+  // map and unmap memory each time.
+  static constexpr size_t kMaxSharedAllocationSize = 1 << 20;
+  static constexpr size_t kSharedAllocationAlignment = 64;
+
+  // Recycled allocations of at least this size are zeroed by the thread pool,
+  // a block of kZeroFillBlockSize bytes per task.
+  static constexpr size_t kMinParallelZeroFillSize = 8 << 20;
+  static constexpr size_t kZeroFillBlockSize = 1 << 20;
+
   AllocInfo get_alloc_info(const DeviceAllocation handle);
 
   CpuDevice();
   ~CpuDevice() override{};
 
+  // Allocations are zeroed, as the memory freshly mapped from the OS. The
+  // large recycled ones are zeroed with the threads of |thread_pool|.
+  void set_thread_pool(ThreadPool *thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   RhiResult allocate_memory(const AllocParams &params,
                             DeviceAllocation *out_devalloc) override;
   DeviceAllocation allocate_memory_runtime(
@@ -109,6 +140,14 @@ class CpuDevice : public LlvmDevice {
 
   DeviceAllocation import_memory(void *ptr, size_t size) override;
 
+  // Maps |size| bytes of the file at |path|, starting at byte |offset|. The
+  // mapping is copy-on-write: writes are private to the process and never
+  // reach the file. dealloc_memory() unmaps it.
+  DeviceAllocation map_file(const std::string &path,
+                            size_t offset,
+                            size_t size,
+                            MemoryAccessHint hint);
+
   void memcpy_internal(DevicePtr dst, DevicePtr src, uint64_t size) override;
 
   Stream *get_compute_stream() override{TI_NOT_IMPLEMENTED};
@@ -116,7 +155,10 @@ class CpuDevice : public LlvmDevice {
   void wait_idle() override{TI_NOT_IMPLEMENTED};
 
  private:
+  void zero_fill(void *ptr, size_t size);
+
   std::vector<AllocInfo> allocations_;
+  ThreadPool *thread_pool_{nullptr};
 
   void validate_device_alloc(const DeviceAllocation alloc) {
     if (allocations_.size() <= alloc.alloc_id) {
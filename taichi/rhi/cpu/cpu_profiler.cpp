@@ -0,0 +1,321 @@
+#include "taichi/rhi/cpu/cpu_profiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include "taichi/system/timer.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace taichi::lang {
+
+KernelProfilerCPU::KernelProfilerCPU()
+    : metric_list_(PerfEventToolkit::supported_metrics()) {
+}
+
+KernelProfilerCPU::~KernelProfilerCPU() = default;
+
+bool KernelProfilerCPU::set_profiler_toolkit(std::string toolkit_name) {
+  if (toolkit_name == "default") {
+    perf_toolkit_.reset();
+    return true;
+  } else if (toolkit_name == "perf") {
+    if (perf_toolkit_) {
+      return true;
+    }
+    perf_toolkit_ = make_perf_toolkit(metric_list_);
+    return perf_toolkit_ != nullptr;
+  }
+  return false;
+}
+
+bool KernelProfilerCPU::set_load_balance_recording(bool enabled) {
+  if (!thread_pool_) {
+    return false;
+  }
+  thread_pool_->record_load_balance = enabled;
+  return true;
+}
+
+bool KernelProfilerCPU::reinit_with_metrics(
+    const std::vector<std::string> metrics) {
+  if (!perf_toolkit_) {
+    return false;
+  }
+  auto toolkit = make_perf_toolkit(metrics);
+  if (!toolkit) {
+    return false;
+  }
+  perf_toolkit_ = std::move(toolkit);
+  metric_list_ = metrics;
+  return true;
+}
+
+std::unique_ptr<PerfEventToolkit> KernelProfilerCPU::make_perf_toolkit(
+    const std::vector<std::string> &metrics) {
+  std::vector<int> worker_tids;
+  if (thread_pool_) {
+    worker_tids = thread_pool_->get_worker_os_thread_ids();
+  }
+  auto toolkit = std::make_unique<PerfEventToolkit>();
+  if (!toolkit->init(metrics, worker_tids)) {
+    return nullptr;
+  }
+  return toolkit;
+}
+
+void KernelProfilerCPU::clear() {
+  total_time_ms_ = 0;
+  traced_records_.clear();
+  statistical_results_.clear();
+  streaming_statistics_.clear();
+}
+
+void KernelProfilerCPU::start(const std::string &kernel_name) {
+  if (perf_toolkit_) {
+    perf_toolkit_->begin();
+  }
+  if (thread_pool_ && thread_pool_->record_load_balance) {
+    thread_pool_->take_load_balance();
+    thread_pool_->timeline_label = kernel_name;
+  }
+  event_name_ = kernel_name;
+  start_t_ = Time::get_time();
+}
+
+void KernelProfilerCPU::stop() {
+  auto ms = (Time::get_time() - start_t_) * 1000.0;
+  if (perf_toolkit_) {
+    perf_toolkit_->end(metric_values_);
+  }
+  insert_record(event_name_, ms);
+  auto &record = traced_records_.back();
+  if (perf_toolkit_) {
+    record.metric_values = metric_values_;
+  }
+  if (thread_pool_ && thread_pool_->record_load_balance) {
+    // Serial tasks do not use the thread pool and leave the fields empty.
+    auto load = thread_pool_->take_load_balance();
+    const int num_threads = (int)load.busy_time.size();
+    float64 max_busy = 0, total_busy = 0;
+    for (auto busy : load.busy_time) {
+      max_busy = std::max(max_busy, busy);
+      total_busy += busy;
+    }
+    if (total_busy > 0) {
+      record.thread_imbalance_ratio =
+          float(max_busy / (total_busy / num_threads));
+    }
+    record.thread_idle_time_in_ms =
+        float((load.wall_time * num_threads - total_busy) * 1000.0);
+    record.tasks_per_thread = std::move(load.num_tasks);
+  }
+}
+
+#if defined(__linux__)
+namespace {
+
+struct PerfEventMetric {
+  const char *name;
+  int type;
+  uint64 config;
+};
+
+const std::vector<PerfEventMetric> &perf_event_metrics() {
+  static const std::vector<PerfEventMetric> metrics = {
+      {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      // The generic cache miss event counts the last level cache misses.
+      {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  };
+  return metrics;
+}
+
+int open_counter(int type, uint64 config, int tid) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Count in user space only, which perf_event_paranoid <= 2 allows.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, tid, /*cpu=*/-1,
+                      /*group_fd=*/-1, /*flags=*/0);
+}
+
+// Reads the value, the time enabled and the time running of a counter.
+bool read_counter(int fd, uint64 *values) {
+  return read(fd, values, 3 * sizeof(uint64)) == 3 * sizeof(uint64);
+}
+
+}  // namespace
+#endif
+
+const std::vector<std::string> &PerfEventToolkit::supported_metrics() {
+  static const std::vector<std::string> metrics = {
+      "cycles", "instructions", "llc_misses", "branch_misses"};
+  return metrics;
+}
+
+#if defined(__linux__)
+
+bool PerfEventToolkit::init(const std::vector<std::string> &metrics,
+                            const std::vector<int> &worker_tids) {
+  for (auto &name : metrics) {
+    auto &known = perf_event_metrics();
+    auto it = std::find_if(
+        known.begin(), known.end(),
+        [&](const PerfEventMetric &metric) { return name == metric.name; });
+    if (it == known.end()) {
+      TI_WARN("Unknown perf metric \"{}\", expected one of {}", name,
+              fmt::join(supported_metrics(), ", "));
+      return false;
+    }
+    event_types_.push_back(it->type);
+    event_configs_.push_back(it->config);
+  }
+
+  const int self = (int)syscall(SYS_gettid);
+  bool any_available = false;
+  int error = 0;
+  for (int m = 0; m < (int)metrics.size(); m++) {
+    int fd = open_counter(event_types_[m], event_configs_[m], self);
+    available_.push_back(fd >= 0);
+    if (fd >= 0) {
+      close(fd);
+      any_available = true;
+    } else {
+      error = errno;
+      TI_TRACE("perf metric \"{}\" is unavailable: {}", metrics[m],
+               std::strerror(error));
+    }
+  }
+  if (!any_available) {
+    TI_WARN("Hardware performance counters are unavailable: {}{}",
+            std::strerror(error),
+            error == EACCES || error == EPERM
+                ? ". /proc/sys/kernel/perf_event_paranoid must be at most 2."
+                : "");
+    return false;
+  }
+  // Serial tasks run on the calling thread, parallel ones on the workers.
+  std::vector<int> tids = {self};
+  for (int tid : worker_tids) {
+    if (tid > 0 && tid != self) {
+      tids.push_back(tid);
+    }
+  }
+  for (int tid : tids) {
+    ThreadCounters counters;
+    if (open_thread(tid, counters)) {
+      threads_.push_back(std::move(counters));
+    } else {
+      close_thread(counters);
+    }
+  }
+  return true;
+}
+
+PerfEventToolkit::~PerfEventToolkit() {
+  for (auto &thread : threads_) {
+    close_thread(thread);
+  }
+}
+
+bool PerfEventToolkit::open_thread(int tid, ThreadCounters &counters) {
+  counters.tid = tid;
+  counters.fds.assign(available_.size(), -1);
+  counters.begin_values.assign(3 * available_.size(), 0);
+  bool opened = false;
+  for (int m = 0; m < (int)available_.size(); m++) {
+    if (available_[m]) {
+      counters.fds[m] = open_counter(event_types_[m], event_configs_[m], tid);
+      opened = opened || counters.fds[m] >= 0;
+    }
+  }
+  return opened;
+}
+
+void PerfEventToolkit::close_thread(ThreadCounters &counters) {
+  for (int fd : counters.fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  counters.fds.clear();
+}
+
+void PerfEventToolkit::begin() {
+  for (auto &thread : threads_) {
+    for (int m = 0; m < (int)thread.fds.size(); m++) {
+      uint64 *values = &thread.begin_values[3 * m];
+      if (thread.fds[m] >= 0 && !read_counter(thread.fds[m], values)) {
+        std::fill(values, values + 3, 0);
+      }
+    }
+  }
+}
+
+void PerfEventToolkit::end(std::vector<float> &values) {
+  values.assign(available_.size(), 0.0f);
+  for (int m = 0; m < (int)available_.size(); m++) {
+    if (!available_[m]) {
+      values[m] = std::nanf("");
+    }
+  }
+  for (auto &thread : threads_) {
+    for (int m = 0; m < (int)thread.fds.size(); m++) {
+      uint64 now[3];
+      if (thread.fds[m] < 0 || !read_counter(thread.fds[m], now)) {
+        continue;
+      }
+      const uint64 *then = &thread.begin_values[3 * m];
+      double count = double(now[0] - then[0]);
+      const uint64 enabled = now[1] - then[1];
+      const uint64 running = now[2] - then[2];
+      if (running > 0 && running < enabled) {
+        count *= double(enabled) / double(running);
+      }
+      values[m] += (float)count;
+    }
+  }
+}
+
+#else
+
+bool PerfEventToolkit::init(const std::vector<std::string> &metrics,
+                            const std::vector<int> &worker_tids) {
+  TI_WARN("Hardware performance counters are only available on Linux");
+  return false;
+}
+
+PerfEventToolkit::~PerfEventToolkit() {
+}
+
+bool PerfEventToolkit::open_thread(int tid, ThreadCounters &counters) {
+  return false;
+}
+
+void PerfEventToolkit::close_thread(ThreadCounters &counters) {
+}
+
+void PerfEventToolkit::begin() {
+}
+
+void PerfEventToolkit::end(std::vector<float> &values) {
+  values.clear();
+}
+
+#endif
+
+}  // namespace taichi::lang
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "taichi/program/kernel_profiler.h"
+#include "taichi/system/threading.h"
+
+#include <string>
+#include <vector>
+
+namespace taichi::lang {
+
+class PerfEventToolkit;
+
+// A CPU kernel profiler. Offloaded tasks are timed with Time::get_time(), and
+// with the "perf" toolkit their hardware events are counted as metrics.
+class KernelProfilerCPU : public KernelProfilerBase {
+ public:
+  KernelProfilerCPU();
+  ~KernelProfilerCPU() override;
+
+  bool reinit_with_metrics(const std::vector<std::string> metrics) override;
+  bool set_profiler_toolkit(std::string toolkit_name) override;
+  bool set_load_balance_recording(bool enabled) override;
+
+  // The pool running the offloaded tasks, whose load balance can be recorded.
+  void set_thread_pool(ThreadPool *thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
+  void sync() override {
+  }
+  void update() override {
+  }
+  void clear() override;
+
+  void start(const std::string &kernel_name) override;
+  void stop() override;
+
+ private:
+  std::unique_ptr<PerfEventToolkit> make_perf_toolkit(
+      const std::vector<std::string> &metrics);
+
+  // Only set when the "perf" toolkit is in use.
+  std::unique_ptr<PerfEventToolkit> perf_toolkit_{nullptr};
+  ThreadPool *thread_pool_{nullptr};
+  std::vector<std::string> metric_list_;
+  std::vector<float> metric_values_;
+  double start_t_{0};
+  std::string event_name_;
+};
+
+// Counts hardware events with perf_event_open(2) on Linux, summed over the
+// thread launching the kernels and the workers of the thread pool.
+//
+// The counters are opened once by init() and keep running; begin() and end()
+// read them and end() returns the differences. Counters multiplexed by the
+// kernel are scaled by the fraction of time they ran.
+class PerfEventToolkit {
+ public:
+  // "cycles", "instructions", "llc_misses" and "branch_misses".
+  static const std::vector<std::string> &supported_metrics();
+
+  // Counts |metrics| on the calling thread and on |worker_tids|. Returns
+  // false when none of |metrics| can be counted, e.g. when
+  // perf_event_paranoid forbids it or in a VM without a virtual PMU. The
+  // metrics that cannot be counted alone are reported as NaN.
+  bool init(const std::vector<std::string> &metrics,
+            const std::vector<int> &worker_tids);
+
+  void begin();
+  void end(std::vector<float> &values);
+
+  ~PerfEventToolkit();
+
+ private:
+  struct ThreadCounters {
+    int tid{0};
+    // One file descriptor per metric, -1 for those that cannot be counted.
+    std::vector<int> fds;
+    // Value, time enabled and time running of each counter at begin().
+    std::vector<uint64> begin_values;
+  };
+
+  bool open_thread(int tid, ThreadCounters &counters);
+  void close_thread(ThreadCounters &counters);
+
+  std::vector<int> event_types_;
+  std::vector<uint64> event_configs_;
+  std::vector<bool> available_;
+  std::vector<ThreadCounters> threads_;
+};
+
+}  // namespace taichi::lang
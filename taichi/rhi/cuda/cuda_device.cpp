@@ -10,6 +10,18 @@ namespace cuda {
 CudaDevice::CudaDevice() {
   // Initialize the device memory pool
   DeviceMemoryPool::get_instance(true /*merge_upon_release*/);
+
+  allocation_cache_ = std::make_unique<CachingDeviceAllocator>(
+      [](std::size_t size) {
+        return DeviceMemoryPool::get_instance().allocate(
+            size, DeviceMemoryPool::page_size);
+      },
+      [](void *ptr, std::size_t size) {
+        DeviceMemoryPool::get_instance().release(size, ptr,
+                                                 true /*release_raw*/);
+      },
+      DeviceMemoryPool::page_size,
+      CachingDeviceAllocator::kDefaultMaxCachedBytes);
 }
 
 CudaDevice::AllocInfo CudaDevice::get_alloc_info(
@@ -24,14 +36,18 @@ RhiResult CudaDevice::allocate_memory(const AllocParams &params,
 
   auto &mem_pool = DeviceMemoryPool::get_instance();
 
+  // Managed memory is not recycled, since it is rarely temporary
   bool managed = params.host_read || params.host_write;
   void *ptr =
-      mem_pool.allocate(params.size, DeviceMemoryPool::page_size, managed);
+      managed
+          ? mem_pool.allocate(params.size, DeviceMemoryPool::page_size, managed)
+          : allocation_cache_->allocate(params.size);
   if (ptr == nullptr) {
     return RhiResult::out_of_memory;
   }
 
   info.ptr = ptr;
+  info.use_allocation_cache = !managed;
   info.size = params.size;
   info.is_imported = false;
   info.use_cached = false;
@@ -104,7 +120,9 @@ void CudaDevice::dealloc_memory(DeviceAllocation handle) {
     TI_ERROR("the DeviceAllocation is already deallocated");
   }
   TI_ASSERT(!info.is_imported);
-  if (info.use_memory_pool) {
+  if (info.use_allocation_cache) {
+    allocation_cache_->release(info.size, info.ptr);
+  } else if (info.use_memory_pool) {
     CUDADriver::get_instance().mem_free_async(info.ptr, nullptr);
   } else if (info.use_cached) {
     DeviceMemoryPool::get_instance().release(info.size, (uint64_t *)info.ptr,
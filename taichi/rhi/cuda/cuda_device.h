@@ -77,6 +77,8 @@ class CudaDevice : public LlvmDevice {
      * */
     bool use_preallocated{true};
     bool use_cached{false};
+    // Whether |ptr| is recycled by the |allocation_cache_| once released.
+    bool use_allocation_cache{false};
     bool use_memory_pool{false};
     void *mapped{nullptr};
   };
@@ -181,6 +181,7 @@ void KernelProfilerCUDA::update() {
     this->reinit_with_metrics(metric_list_);
   }
 
+  stream_traced_records(records_size_after_sync_);
   records_size_after_sync_ = traced_records_.size();
 }
 
@@ -191,6 +192,7 @@ void KernelProfilerCUDA::clear() {
   records_size_after_sync_ = 0;
   traced_records_.clear();
   statistical_results_.clear();
+  streaming_statistics_.clear();
 }
 
 // must be called immediately after KernelProfilerCUDA::trace()
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory>
+
 #include "taichi/rhi/device.h"
+#include "taichi/rhi/common/caching_device_allocator.h"
 
 namespace taichi::lang {
 
@@ -52,6 +55,32 @@ class LlvmDevice : public Device {
       const LlvmRuntimeAllocParams &params) {
     TI_NOT_IMPLEMENTED;
   }
+
+  // The released allocations kept by the device for reuse, see
+  // |allocation_cache_|.
+  CachingDeviceAllocator::Stats get_allocation_cache_stats() {
+    return allocation_cache_ ? allocation_cache_->get_stats()
+                             : CachingDeviceAllocator::Stats{};
+  }
+
+  void set_allocation_cache_size(std::size_t max_bytes) {
+    if (allocation_cache_) {
+      allocation_cache_->set_max_cached_bytes(max_bytes);
+    }
+  }
+
+  // Returns the cached allocations to the memory pool, before it is reset.
+  void trim_allocation_cache() {
+    if (allocation_cache_) {
+      allocation_cache_->trim();
+    }
+  }
+
+ protected:
+  // Recycles the memory of the released ndarrays, so that temporary ndarrays
+  // don't go through the memory pool each time. Absent on the devices which
+  // don't allocate from a pool.
+  std::unique_ptr<CachingDeviceAllocator> allocation_cache_;
 };
 
 }  // namespace taichi::lang
@@ -594,6 +594,15 @@ class RHI_DLL_EXPORT Stream {
       const std::vector<StreamSemaphore> &wait_semaphores = {}) = 0;
 
   virtual void command_sync() = 0;
+
+  /**
+   * Blocks the host until the submissions that signal `semaphores` complete.
+   * Backends without per-submission tracking wait for the entire stream.
+   * @params[in] semaphores The semaphores returned by previous submissions.
+   */
+  virtual void wait_semaphores(const std::vector<StreamSemaphore> &semaphores) {
+    command_sync();
+  }
 };
 
 class RHI_DLL_EXPORT PipelineCache {
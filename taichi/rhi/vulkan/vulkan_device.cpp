@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -2030,7 +2031,7 @@ StreamSemaphore VulkanStream::submit(
   auto fence = vkapi::create_fence(buffer->device, 0);
 
   // Resource tracking, check previously submitted commands
-  submitted_cmdbuffers_.push_back(TrackedCmdbuf{fence, buffer});
+  submitted_cmdbuffers_.push_back(TrackedCmdbuf{fence, buffer, semaphore});
 
   BAIL_ON_VK_BAD_RESULT_NO_RETURN(
       vkQueueSubmit(queue_, /*submitCount=*/1, &submit_info,
@@ -2056,6 +2057,36 @@ void VulkanStream::command_sync() {
   submitted_cmdbuffers_.clear();
 }
 
+void VulkanStream::wait_semaphores(
+    const std::vector<StreamSemaphore> &semaphores) {
+  std::vector<VkFence> fences;
+  for (const StreamSemaphore &sema_ : semaphores) {
+    auto sema = std::static_pointer_cast<VulkanStreamSemaphoreObject>(sema_);
+    for (const TrackedCmdbuf &tracked : submitted_cmdbuffers_) {
+      if (tracked.signal_sema == sema->vkapi_ref) {
+        fences.push_back(tracked.fence->fence);
+      }
+    }
+  }
+
+  if (!fences.empty()) {
+    BAIL_ON_VK_BAD_RESULT_NO_RETURN(
+        vkWaitForFences(device_.vk_device(), fences.size(), fences.data(),
+                        /*waitAll=*/VK_TRUE, /*timeout=*/UINT64_MAX),
+        "Vulkan device might be lost (vkWaitForFences failed)");
+  }
+
+  // Release the command buffers whose execution has completed.
+  submitted_cmdbuffers_.erase(
+      std::remove_if(submitted_cmdbuffers_.begin(), submitted_cmdbuffers_.end(),
+                     [&](const TrackedCmdbuf &tracked) {
+                       return vkGetFenceStatus(device_.vk_device(),
+                                               tracked.fence->fence) ==
+                              VK_SUCCESS;
+                     }),
+      submitted_cmdbuffers_.end());
+}
+
 std::unique_ptr<Pipeline> VulkanDevice::create_raster_pipeline(
     const std::vector<PipelineSourceDesc> &src,
     const RasterParams &raster_params,
@@ -546,11 +546,13 @@ class VulkanStream : public Stream {
       const std::vector<StreamSemaphore> &wait_semaphores = {}) override;
 
   void command_sync() override;
+  void wait_semaphores(const std::vector<StreamSemaphore> &semaphores) override;
 
  private:
   struct TrackedCmdbuf {
     vkapi::IVkFence fence;
     vkapi::IVkCommandBuffer buf;
+    vkapi::IVkSemaphore signal_sema;
   };
 
   VulkanDevice &device_;
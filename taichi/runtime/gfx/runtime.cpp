@@ -161,9 +161,8 @@ class HostDeviceContextBlitter {
         StreamSemaphore command_complete_sema =
             device_->get_compute_stream()->submit(cmdlist);
 
-        device_->wait_idle();
-
-        // In this case `readback_data` syncs
+        // `readback_data` waits for `command_complete_sema` and syncs, so
+        // there's no need to idle the whole device here.
         TI_ASSERT(device_->readback_data(
                       readback_dev_ptrs.data(), readback_host_ptrs.data(),
                       readback_sizes.data(), int(readback_sizes.size()),
@@ -444,6 +443,19 @@ void GfxRuntime::launch_kernel(KernelHandle handle,
               LaunchContextBuilder::DevAllocType::kNdarray) {
             any_arrays[indices] = devalloc;
             ndarrays_in_use_.insert(devalloc.alloc_id);
+            auto arr_access =
+                ti_kernel->ti_kernel_attribs().ctx_attribs.arr_access;
+            auto access_it =
+                std::find_if(arr_access.begin(), arr_access.end(),
+                             [indices](const auto &pair) -> bool {
+                               return pair.first == indices;
+                             });
+            // Conservatively treat arrays without access info as written.
+            bool is_written =
+                access_it == arr_access.end() ||
+                (uint32_t(access_it->second) &
+                 uint32_t(irpass::ExternalPtrAccess::WRITE));
+            submission_tracker_.record_access(devalloc.alloc_id, is_written);
           } else if (host_ctx.device_allocation_type[indices] ==
                      LaunchContextBuilder::DevAllocType::kTexture) {
             textures[indices] = devalloc;
@@ -487,6 +499,7 @@ void GfxRuntime::launch_kernel(KernelHandle handle,
       const ArgPack *argpack = host_ctx.argpack_ptrs[indices];
       DeviceAllocation devalloc = argpack->get_device_allocation();
       argpacks_in_use_.insert(devalloc.alloc_id);
+      submission_tracker_.record_access(devalloc.alloc_id, /*write=*/false);
       argpacks[indices] = argpack;
     }
 
@@ -587,6 +600,8 @@ void GfxRuntime::launch_kernel(KernelHandle handle,
                                     ext_array_size)) {
       current_cmdlist_ = nullptr;
       ctx_buffers_.clear();
+      // The command list has been waited for by the blitter.
+      submission_tracker_.on_complete();
     }
   }
 
@@ -598,6 +613,8 @@ void GfxRuntime::buffer_copy(DevicePtr dst, DevicePtr src, size_t size) {
   current_cmdlist_->buffer_barrier(src);
   current_cmdlist_->buffer_copy(dst, src, size);
   current_cmdlist_->buffer_barrier(dst);
+  submission_tracker_.record_access(src.alloc_id, /*write=*/false);
+  submission_tracker_.record_access(dst.alloc_id, /*write=*/true);
 }
 
 void GfxRuntime::copy_image(DeviceAllocation dst,
@@ -647,15 +664,38 @@ void GfxRuntime::synchronize() {
   }
   ctx_buffers_.clear();
   ndarrays_in_use_.clear();
+  submission_tracker_.retire_all();
   fflush(stdout);
 }
 
+void GfxRuntime::synchronize_allocations(
+    const std::vector<DeviceAllocationId> &ids,
+    bool host_write) {
+  // Submit the pending command list first if it touches any of |ids|.
+  for (auto id : ids) {
+    if (submission_tracker_.has_pending_access(id,
+                                               /*write_only=*/!host_write)) {
+      flush();
+      break;
+    }
+  }
+  if (!submission_tracker_.wait_for(device_->get_compute_stream(), ids,
+                                    host_write)) {
+    synchronize();
+  }
+}
+
+void GfxRuntime::copy_for_host(DevicePtr dst, DevicePtr src, size_t size) {
+  copy_and_wait(device_->get_compute_stream(), dst, src, size);
+}
+
 StreamSemaphore GfxRuntime::flush() {
   StreamSemaphore sema;
   if (current_cmdlist_) {
     sema = device_->get_compute_stream()->submit(current_cmdlist_.get());
     current_cmdlist_ = nullptr;
     ctx_buffers_.clear();
+    submission_tracker_.on_submit(sema);
   } else {
     auto [cmdlist, res] =
         device_->get_compute_stream()->new_command_list_unique();
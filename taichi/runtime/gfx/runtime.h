@@ -12,6 +12,7 @@
 #include "taichi/program/snode_expr_utils.h"
 #include "taichi/program/program_impl.h"
 #include "taichi/program/kernel_launcher.h"
+#include "taichi/runtime/gfx/submission_tracker.h"
 
 namespace taichi::lang {
 namespace gfx {
@@ -110,6 +111,16 @@ class TI_DLL_EXPORT GfxRuntime {
 
   void synchronize();
 
+  // Waits only for the submitted work that accesses |ids|, so that the host
+  // can read them (or overwrite them if |host_write| is set). Falls back to
+  // synchronize() on backends that can't track submissions.
+  void synchronize_allocations(const std::vector<DeviceAllocationId> &ids,
+                               bool host_write);
+
+  // Copies between an allocation and a staging buffer for a host access,
+  // waiting only for the copy itself.
+  void copy_for_host(DevicePtr dst, DevicePtr src, size_t size);
+
   StreamSemaphore flush();
 
   Device *get_ti_device() const;
@@ -170,6 +181,9 @@ class TI_DLL_EXPORT GfxRuntime {
   // ndarray whenever it's safe to do so.
   std::unordered_set<DeviceAllocationId> ndarrays_in_use_;
   std::unordered_set<DeviceAllocationId> argpacks_in_use_;
+  // Tracks which submission last accessed each ndarray / argpack, so that host
+  // readbacks don't have to idle the whole device.
+  SubmissionTracker submission_tracker_;
 };
 
 GfxRuntime::RegisterParams run_codegen(
@@ -0,0 +1,122 @@
+#include "taichi/runtime/gfx/submission_tracker.h"
+
+#include <algorithm>
+
+namespace taichi::lang {
+namespace gfx {
+
+void SubmissionTracker::record_access(DeviceAllocationId id, bool write) {
+  if (write) {
+    pending_writes_.insert(id);
+  } else {
+    pending_reads_.insert(id);
+  }
+}
+
+bool SubmissionTracker::has_pending_access(DeviceAllocationId id,
+                                           bool write_only) const {
+  if (pending_writes_.count(id)) {
+    return true;
+  }
+  return !write_only && pending_reads_.count(id);
+}
+
+void SubmissionTracker::on_submit(const StreamSemaphore &sema) {
+  if (!sema) {
+    // The backend does not hand out semaphores; nothing can be tracked and
+    // callers will fall back to a device-wide sync.
+    if (!pending_reads_.empty() || !pending_writes_.empty()) {
+      has_untracked_submissions_ = true;
+    }
+    on_complete();
+    return;
+  }
+  for (auto id : pending_writes_) {
+    // A newer write supersedes both the previous write and all the reads
+    // before it, since work on the same stream is ordered by the memory
+    // barrier recorded after every dispatch.
+    last_write_[id] = sema;
+    last_read_.erase(id);
+  }
+  for (auto id : pending_reads_) {
+    if (pending_writes_.count(id)) {
+      continue;
+    }
+    // Likewise, waiting for the newest read covers the older ones.
+    last_read_[id] = sema;
+  }
+  on_complete();
+}
+
+void SubmissionTracker::on_complete() {
+  pending_reads_.clear();
+  pending_writes_.clear();
+}
+
+std::vector<StreamSemaphore> SubmissionTracker::get_dependencies(
+    const std::vector<DeviceAllocationId> &ids,
+    bool host_write) const {
+  std::vector<StreamSemaphore> deps;
+  auto add_dep = [&deps](const StreamSemaphore &sema) {
+    if (std::find(deps.begin(), deps.end(), sema) == deps.end()) {
+      deps.push_back(sema);
+    }
+  };
+  for (auto id : ids) {
+    if (auto it = last_write_.find(id); it != last_write_.end()) {
+      add_dep(it->second);
+    }
+    if (!host_write) {
+      continue;
+    }
+    if (auto it = last_read_.find(id); it != last_read_.end()) {
+      add_dep(it->second);
+    }
+  }
+  return deps;
+}
+
+void SubmissionTracker::retire(const std::vector<DeviceAllocationId> &ids,
+                               bool host_write) {
+  for (auto id : ids) {
+    last_write_.erase(id);
+    if (host_write) {
+      last_read_.erase(id);
+    }
+  }
+}
+
+bool SubmissionTracker::wait_for(Stream *stream,
+                                 const std::vector<DeviceAllocationId> &ids,
+                                 bool host_write) {
+  if (requires_full_sync()) {
+    return false;
+  }
+  auto deps = get_dependencies(ids, host_write);
+  if (!deps.empty()) {
+    stream->wait_semaphores(deps);
+  }
+  retire(ids, host_write);
+  return true;
+}
+
+void copy_and_wait(Stream *stream, DevicePtr dst, DevicePtr src, size_t size) {
+  auto [cmdlist, res] = stream->new_command_list_unique();
+  TI_ASSERT(res == RhiResult::success);
+  cmdlist->buffer_copy(dst, src, size);
+  auto sema = stream->submit(cmdlist.get());
+  if (sema) {
+    stream->wait_semaphores({sema});
+  } else {
+    stream->command_sync();
+  }
+}
+
+void SubmissionTracker::retire_all() {
+  last_write_.clear();
+  last_read_.clear();
+  has_untracked_submissions_ = false;
+}
+
+}  // namespace gfx
+}  // namespace taichi::lang
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "taichi/rhi/device.h"
+
+namespace taichi::lang {
+namespace gfx {
+
+/**
+ * @brief Tracks which submissions last accessed each device allocation.
+ *
+ * Accesses are first recorded against the command list being built. When
+ * that command list is submitted, they are bound to the semaphore returned by
+ * the submission. A host readback of an allocation then only has to wait for
+ * the submissions that wrote it, and a host write only for the submissions
+ * that accessed it, instead of idling the whole device.
+ *
+ * All tracked submissions go to the same stream, whose submissions complete
+ * in order, so only the last reader and the last writer of each allocation
+ * are kept.
+ */
+class SubmissionTracker {
+ public:
+  /**
+   * Records that the pending (not yet submitted) command list reads and/or
+   * writes |id|.
+   */
+  void record_access(DeviceAllocationId id, bool write);
+
+  /**
+   * Returns true if the pending command list accesses |id| (writes only if
+   * |write_only| is set), i.e. the command list must be submitted before the
+   * host can observe a consistent state of |id|.
+   */
+  bool has_pending_access(DeviceAllocationId id, bool write_only) const;
+
+  /**
+   * Binds all accesses recorded since the last submission to |sema|. A null
+   * |sema| means the backend cannot track submissions, see
+   * `requires_full_sync()`.
+   */
+  void on_submit(const StreamSemaphore &sema);
+
+  /**
+   * Drops the accesses recorded since the last submission, for a command list
+   * the host has already waited for.
+   */
+  void on_complete();
+
+  /**
+   * Returns true if some submission could not be tracked, in which case the
+   * host must fall back to a device-wide sync.
+   */
+  bool requires_full_sync() const {
+    return has_untracked_submissions_;
+  }
+
+  /**
+   * Returns the semaphores the host has to wait for before accessing |ids|.
+   * A host read depends on the last writer; a host write additionally depends
+   * on the last reader since the last write.
+   */
+  std::vector<StreamSemaphore> get_dependencies(
+      const std::vector<DeviceAllocationId> &ids,
+      bool host_write) const;
+
+  /**
+   * Forgets the dependencies returned by `get_dependencies(ids, host_write)`
+   * once the host has waited for them.
+   */
+  void retire(const std::vector<DeviceAllocationId> &ids, bool host_write);
+
+  /**
+   * Blocks until the host can access |ids|, by waiting on |stream| for their
+   * dependencies, and retires them. Returns false without waiting if a
+   * device-wide sync is required instead.
+   */
+  bool wait_for(Stream *stream,
+                const std::vector<DeviceAllocationId> &ids,
+                bool host_write);
+
+  /**
+   * Forgets about all tracked submissions. Must only be called once the
+   * device is idle.
+   */
+  void retire_all();
+
+  std::size_t num_tracked_allocations() const {
+    return last_write_.size() + last_read_.size();
+  }
+
+ private:
+  std::unordered_set<DeviceAllocationId> pending_reads_;
+  std::unordered_set<DeviceAllocationId> pending_writes_;
+  std::unordered_map<DeviceAllocationId, StreamSemaphore> last_write_;
+  std::unordered_map<DeviceAllocationId, StreamSemaphore> last_read_;
+  bool has_untracked_submissions_{false};
+};
+
+/**
+ * Copies |size| bytes from |src| to |dst| in a submission of its own on
+ * |stream|, and blocks until that submission completes without waiting for
+ * the other submissions in flight.
+ */
+void copy_and_wait(Stream *stream, DevicePtr dst, DevicePtr src, size_t size);
+
+}  // namespace gfx
+}  // namespace taichi::lang
@@ -3,6 +3,7 @@
 #include "taichi/rhi/common/host_memory_pool.h"
 #include "taichi/runtime/llvm/llvm_offline_cache.h"
 #include "taichi/rhi/cpu/cpu_device.h"
+#include "taichi/rhi/cpu/cpu_profiler.h"
 #include "taichi/rhi/cuda/cuda_device.h"
 #include "taichi/platform/cuda/detect_cuda.h"
 #include "taichi/rhi/cuda/cuda_driver.h"
@@ -79,13 +80,23 @@ LlvmRuntimeExecutor::LlvmRuntimeExecutor(CompileConfig &config,
 
   snode_tree_buffer_manager_ = std::make_unique<SNodeTreeBufferManager>(this);
   thread_pool_ = std::make_unique<ThreadPool>(config.cpu_max_num_threads);
+  if (auto cpu_profiler = dynamic_cast<KernelProfilerCPU *>(profiler_)) {
+    cpu_profiler->set_thread_pool(thread_pool_.get());
+  }
 
   llvm_runtime_ = nullptr;
 
+  HostMemoryPool::get_instance().set_huge_pages(
+      arch_is_cpu(config.arch)
+          ? HostMemoryPool::huge_pages_from_name(config.cpu_huge_pages)
+          : HostMemoryPool::HugePages::kNone,
+      config.cpu_huge_page_min_size);
+
   if (arch_is_cpu(config.arch)) {
     config.max_block_dim = 1024;
-    device_ = std::make_shared<cpu::CpuDevice>();
-
+    auto cpu_device = std::make_shared<cpu::CpuDevice>();
+    cpu_device->set_thread_pool(thread_pool_.get());
+    device_ = std::move(cpu_device);
   }
 #if defined(TI_WITH_CUDA)
   else if (config.arch == Arch::cuda) {
@@ -166,6 +177,8 @@ LlvmRuntimeExecutor::LlvmRuntimeExecutor(CompileConfig &config,
   else {
     TI_NOT_IMPLEMENTED
   }
+  llvm_device()->set_allocation_cache_size(
+      std::max<int64>(config.device_allocation_cache_size, 0));
   llvm_context_ = std::make_unique<TaichiLLVMContext>(
       config_, arch_is_cpu(config.arch) ? host_arch() : config.arch);
   jit_session_ = JITSession::create(llvm_context_.get(), config, config.arch);
@@ -383,6 +396,79 @@ void LlvmRuntimeExecutor::print_memory_profiler_info(
       total_requested_memory);
 }
 
+ListMemoryUsage LlvmRuntimeExecutor::query_list_memory_usage(
+    void *list_manager,
+    uint64 *result_buffer) {
+  ListMemoryUsage usage;
+  usage.num_elements = runtime_query<int32>("ListManager_get_num_elements",
+                                            result_buffer, list_manager);
+  usage.num_chunks = runtime_query<int32>("ListManager_get_num_active_chunks",
+                                          result_buffer, list_manager);
+  usage.elements_per_chunk =
+      runtime_query<int32>("ListManager_get_max_num_elements_per_chunk",
+                           result_buffer, list_manager);
+  usage.element_size = runtime_query<int32>("ListManager_get_element_size",
+                                            result_buffer, list_manager);
+  return usage;
+}
+
+void LlvmRuntimeExecutor::query_memory_usage(
+    std::vector<std::unique_ptr<SNodeTree>> &snode_trees,
+    uint64 *result_buffer,
+    MemoryUsage &usage) {
+  TI_ASSERT(arch_uses_llvm(config_.arch));
+
+  std::function<void(SNode *)> visit = [&](SNode *snode) {
+    auto element_list =
+        runtime_query<void *>("LLVMRuntime_get_element_lists", result_buffer,
+                              llvm_runtime_, snode->id);
+    if (snode->type != SNodeType::place && element_list) {
+      SNodeMemoryUsage snode_usage;
+      snode_usage.snode_id = snode->id;
+      snode_usage.name = snode->get_node_type_name_hinted();
+      snode_usage.element_list =
+          query_list_memory_usage(element_list, result_buffer);
+      auto node_allocator =
+          runtime_query<void *>("LLVMRuntime_get_node_allocators",
+                                result_buffer, llvm_runtime_, snode->id);
+      if (node_allocator) {
+        snode_usage.has_node_allocator = true;
+        for (auto [list, key] : {
+                 std::make_pair(&snode_usage.data_list, "data_list"),
+                 std::make_pair(&snode_usage.free_list, "free_list"),
+                 std::make_pair(&snode_usage.recycled_list, "recycled_list"),
+             }) {
+          auto list_manager =
+              runtime_query<void *>(std::string("NodeManager_get_") + key,
+                                    result_buffer, node_allocator);
+          *list = query_list_memory_usage(list_manager, result_buffer);
+        }
+        snode_usage.free_list_used = runtime_query<int32>(
+            "NodeManager_get_free_list_used", result_buffer, node_allocator);
+      }
+      usage.snodes.push_back(std::move(snode_usage));
+    }
+    for (const auto &ch : snode->ch) {
+      visit(ch.get());
+    }
+  };
+
+  for (auto &tree : snode_trees) {
+    visit(tree->root());
+    usage.snode_tree_bytes +=
+        runtime_query<std::size_t>("LLVMRuntime_get_root_mem_sizes",
+                                   result_buffer, llvm_runtime_, tree->id());
+  }
+
+  usage.runtime_memory_reserved = runtime_query<std::size_t>(
+      "LLVMRuntime_get_runtime_memory_reserved", result_buffer);
+  usage.runtime_memory_used = runtime_query<std::size_t>(
+      "LLVMRuntime_get_runtime_memory_used", result_buffer);
+  usage.total_requested_memory = runtime_query<std::size_t>(
+      "LLVMRuntime_get_total_requested_memory", result_buffer, llvm_runtime_);
+  usage.device_allocation_cache = llvm_device()->get_allocation_cache_stats();
+}
+
 DevicePtr LlvmRuntimeExecutor::get_snode_tree_device_ptr(int tree_id) {
   DeviceAllocation tree_alloc = snode_tree_allocs_[tree_id];
   return tree_alloc.get_ptr();
@@ -497,6 +583,32 @@ void LlvmRuntimeExecutor::deallocate_memory_on_device(DeviceAllocation handle) {
   allocated_runtime_memory_allocs_.erase(handle.alloc_id);
 }
 
+DeviceAllocation LlvmRuntimeExecutor::map_file_on_device(
+    const std::string &path,
+    std::size_t offset,
+    std::size_t size,
+    const std::string &access_hint) {
+  TI_ERROR_IF(!arch_is_cpu(config_.arch),
+              "Memory-mapped ndarrays are only supported on the CPU backends");
+  cpu::MemoryAccessHint hint;
+  if (access_hint == "normal") {
+    hint = cpu::MemoryAccessHint::normal;
+  } else if (access_hint == "sequential") {
+    hint = cpu::MemoryAccessHint::sequential;
+  } else if (access_hint == "random") {
+    hint = cpu::MemoryAccessHint::random;
+  } else if (access_hint == "willneed") {
+    hint = cpu::MemoryAccessHint::will_need;
+  } else {
+    TI_ERROR(
+        "Unknown access hint '{}', expected one of normal, sequential, random "
+        "and willneed",
+        access_hint);
+  }
+  return llvm_device()->as<cpu::CpuDevice>()->map_file(path, offset, size,
+                                                        hint);
+}
+
 void LlvmRuntimeExecutor::fill_ndarray(const DeviceAllocation &alloc,
                                        std::size_t size,
                                        uint32_t data) {
@@ -548,6 +660,7 @@ uint64_t *LlvmRuntimeExecutor::get_device_alloc_info_ptr(
 
 void LlvmRuntimeExecutor::finalize() {
   profiler_ = nullptr;
+  llvm_device()->trim_allocation_cache();
   if (config_.arch == Arch::cuda || config_.arch == Arch::amdgpu) {
     preallocated_runtime_objects_allocs_.reset();
     preallocated_runtime_memory_allocs_.reset();
@@ -11,6 +11,7 @@
 #include "taichi/runtime/llvm/llvm_context.h"
 #include "taichi/struct/snode_tree.h"
 #include "taichi/program/compile_config.h"
+#include "taichi/program/memory_usage.h"
 
 #include "taichi/system/threading.h"
 
@@ -53,6 +54,12 @@ class LlvmRuntimeExecutor {
 
   void deallocate_memory_on_device(DeviceAllocation handle);
 
+  // Memory-mapped Ndarray, CPU only
+  DeviceAllocation map_file_on_device(const std::string &path,
+                                      std::size_t offset,
+                                      std::size_t size,
+                                      const std::string &access_hint);
+
   void check_runtime_error(uint64 *result_buffer);
 
   uint64_t *get_device_alloc_info_ptr(const DeviceAllocation &alloc);
@@ -73,6 +80,10 @@ class LlvmRuntimeExecutor {
 
   LlvmDevice *llvm_device();
 
+  ThreadPool *get_thread_pool() {
+    return thread_pool_.get();
+  }
+
   void synchronize();
 
   bool use_device_memory_pool() {
@@ -108,9 +119,14 @@ class LlvmRuntimeExecutor {
   /* ---- Runtime Helpers ---- */
   /* ------------------------- */
   void print_list_manager_info(void *list_manager, uint64 *result_buffer);
+  ListMemoryUsage query_list_memory_usage(void *list_manager,
+                                          uint64 *result_buffer);
   void print_memory_profiler_info(
       std::vector<std::unique_ptr<SNodeTree>> &snode_trees_,
       uint64 *result_buffer);
+  void query_memory_usage(std::vector<std::unique_ptr<SNodeTree>> &snode_trees,
+                          uint64 *result_buffer,
+                          MemoryUsage &usage);
 
   template <typename T, typename... Args>
   T runtime_query(const std::string &key,
@@ -54,11 +54,24 @@ i32 test_internal_func_args(RuntimeContext *context,
 }
 
 i32 test_stack(RuntimeContext *context) {
-  auto stack = new u8[132];
-  stack_push(stack, 16, 4);
-  stack_push(stack, 16, 4);
-  stack_push(stack, 16, 4);
-  stack_push(stack, 16, 4);
+  auto runtime = context->runtime;
+  auto stack = new u8[sizeof(AdStackHeader) + 16 * 2 * 4];
+  for (int round = 0; round < 2; round++) {
+    stack_init(stack);
+    // Grows through several segments, reused from the cache in round 1.
+    for (int i = 0; i < 200; i++) {
+      stack_push(context, stack, 16, 4);
+      *(i32 *)stack_top_primal(stack, 4) = i;
+      *(i32 *)stack_top_adjoint(stack, 4) = -i;
+    }
+    for (int i = 199; i >= 0; i--) {
+      TI_TEST_CHECK(*(i32 *)stack_top_primal(stack, 4) == i, runtime);
+      TI_TEST_CHECK(*(i32 *)stack_top_adjoint(stack, 4) == -i, runtime);
+      stack_pop(context, stack);
+    }
+    TI_TEST_CHECK(((AdStackHeader *)stack)->segment == nullptr, runtime);
+  }
+  delete[] stack;
   return 0;
 }
 
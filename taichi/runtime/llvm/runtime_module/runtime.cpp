@@ -41,6 +41,11 @@ using host_vsnprintf_type = int (*)(char *,
                                     std::va_list);
 using host_allocator_type = void *(*)(void *, std::size_t, std::size_t);
 using RangeForTaskFunc = void(RuntimeContext *, const char *tls, int i);
+// Runs the iterations [begin, end) of a range-for.
+using RangeForBlockTaskFunc = void(RuntimeContext *,
+                                   const char *tls,
+                                   int begin,
+                                   int end);
 using MeshForTaskFunc = void(RuntimeContext *, const char *tls, uint32_t i);
 using parallel_for_type = void (*)(void *thread_pool,
                                    int splits,
@@ -532,6 +537,7 @@ void initialize_rand_state(RandState *state, u32 i) {
 }
 
 struct NodeManager;
+struct AdStackSegment;
 
 struct PreallocatedMemoryChunk {
   Ptr preallocated_head = nullptr;
@@ -559,6 +565,8 @@ struct LLVMRuntime {
   Ptr ambient_elements[taichi_max_num_snodes];
   Ptr temporaries;
   RandState *rand_states;
+  // The AD-stack segments released by each thread, see stack_push.
+  AdStackSegment **ad_stack_segment_caches;
 
   // Cross backend (CPU, CUDA, AMDGPU) runtime memory allocation
   Ptr allocate_aligned(PreallocatedMemoryChunk &memory_chunk,
@@ -736,8 +744,21 @@ void runtime_ListManager_get_num_active_chunks(LLVMRuntime *runtime,
                       list_manager->get_num_active_chunks());
 }
 
+void runtime_LLVMRuntime_get_runtime_memory_reserved(LLVMRuntime *runtime) {
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      runtime->runtime_memory_chunk.preallocated_size);
+}
+
+void runtime_LLVMRuntime_get_runtime_memory_used(LLVMRuntime *runtime) {
+  auto &chunk = runtime->runtime_memory_chunk;
+  runtime->set_result(taichi_result_buffer_runtime_query_id,
+                      chunk.preallocated_size - (std::size_t)(
+                          chunk.preallocated_tail - chunk.preallocated_head));
+}
+
 RUNTIME_STRUCT_FIELD_ARRAY(LLVMRuntime, node_allocators);
 RUNTIME_STRUCT_FIELD_ARRAY(LLVMRuntime, element_lists);
+RUNTIME_STRUCT_FIELD_ARRAY(LLVMRuntime, root_mem_sizes);
 RUNTIME_STRUCT_FIELD(LLVMRuntime, total_requested_memory);
 
 RUNTIME_STRUCT_FIELD(NodeManager, free_list);
@@ -891,6 +912,8 @@ void runtime_get_memory_requirements(Ptr result_buffer,
       taichi::iroundup(i64(taichi_global_tmp_buffer_size), taichi_page_size);
   size += taichi::iroundup(i64(sizeof(RandState)) * num_rand_states,
                            taichi_page_size);
+  size += taichi::iroundup(i64(sizeof(Ptr)) * num_rand_states,
+                           taichi_page_size);
 
   reinterpret_cast<i64 *>(result_buffer)[0] = size;
 }
@@ -947,6 +970,11 @@ void runtime_initialize(
   runtime->rand_states = (RandState *)runtime->allocate_aligned(
       runtime->runtime_objects_chunk,
       sizeof(RandState) * runtime->num_rand_states, taichi_page_size);
+  runtime->ad_stack_segment_caches =
+      (AdStackSegment **)runtime->allocate_aligned(
+          runtime->runtime_objects_chunk,
+          sizeof(AdStackSegment *) * runtime->num_rand_states,
+          taichi_page_size);
 }
 
 void runtime_initialize_memory(LLVMRuntime *runtime,
@@ -960,16 +988,19 @@ void runtime_initialize_memory(LLVMRuntime *runtime,
   }
 }
 
+// The per-thread states are initialized along with the random states.
 void runtime_initialize_rand_states_cuda(LLVMRuntime *runtime,
                                          int starting_rand_state) {
   int i = block_dim() * block_idx() + thread_idx();
   initialize_rand_state(&runtime->rand_states[i], starting_rand_state + i);
+  runtime->ad_stack_segment_caches[i] = nullptr;
 }
 
 void runtime_initialize_rand_states_serial(LLVMRuntime *runtime,
                                            int starting_rand_state) {
   for (int i = 0; i < runtime->num_rand_states; i++) {
     initialize_rand_state(&runtime->rand_states[i], starting_rand_state + i);
+    runtime->ad_stack_segment_caches[i] = nullptr;
   }
 }
 
@@ -1462,6 +1493,7 @@ struct range_task_helper_context {
   RuntimeContext *context;
   range_for_xlogue prologue{nullptr};
   RangeForTaskFunc *body{nullptr};
+  RangeForBlockTaskFunc *block_body{nullptr};
   range_for_xlogue epilogue{nullptr};
   std::size_t tls_size{1};
   int begin;
@@ -1481,7 +1513,11 @@ void cpu_parallel_range_for_task(void *range_context,
 
   RuntimeContext this_thread_context = *ctx.context;
   this_thread_context.cpu_thread_id = thread_id;
-  if (ctx.step == 1) {
+  if (ctx.block_body) {
+    int block_start = ctx.begin + task_id * ctx.block_size;
+    int block_end = std::min(block_start + ctx.block_size, ctx.end);
+    ctx.block_body(&this_thread_context, tls_ptr, block_start, block_end);
+  } else if (ctx.step == 1) {
     int block_start = ctx.begin + task_id * ctx.block_size;
     int block_end = std::min(block_start + ctx.block_size, ctx.end);
     for (int i = block_start; i < block_end; i++) {
@@ -1528,6 +1564,31 @@ void cpu_parallel_range_for(RuntimeContext *context,
                         &ctx, cpu_parallel_range_for_task);
 }
 
+void cpu_parallel_range_for_blocked(RuntimeContext *context,
+                                    int num_threads,
+                                    int begin,
+                                    int end,
+                                    int block_dim,
+                                    range_for_xlogue prologue,
+                                    RangeForBlockTaskFunc *block_body,
+                                    range_for_xlogue epilogue,
+                                    std::size_t tls_size) {
+  range_task_helper_context ctx;
+  ctx.context = context;
+  ctx.prologue = prologue;
+  ctx.tls_size = tls_size;
+  ctx.block_body = block_body;
+  ctx.epilogue = epilogue;
+  ctx.begin = begin;
+  ctx.end = end;
+  ctx.step = 1;
+  ctx.block_size = block_dim;
+  auto runtime = context->runtime;
+  runtime->parallel_for(runtime->thread_pool,
+                        (end - begin + block_dim - 1) / block_dim, num_threads,
+                        &ctx, cpu_parallel_range_for_task);
+}
+
 void gpu_parallel_range_for(RuntimeContext *context,
                             int begin,
                             int end,
@@ -1863,9 +1924,36 @@ void taichi_printf(LLVMRuntime *runtime, const char *format, Args &&...args) {
 
 extern "C" {  // local stack operations
 
+// An AD-stack holds its first |max_num_elements| entries inline after its
+// header. When it grows beyond them, it chains segments allocated from the
+// runtime memory, each holding at least as many entries as all the entries
+// before it. Segments released by popping are cached per thread and reused by
+// the next stack that grows on that thread, so steady-state growth does not
+// allocate.
+struct AdStackSegment {
+  AdStackSegment *prev;
+  // The next segment in the cache of the thread, when released.
+  AdStackSegment *next_free;
+  // The index of the first entry of the segment.
+  u64 base;
+  // The size of the entries following this header.
+  u64 size_in_bytes;
+};
+
+struct AdStackHeader {
+  u64 n;
+  // The segment of the top entry, or nullptr if it is inline.
+  AdStackSegment *segment;
+};
+
 Ptr stack_top_primal(Ptr stack, std::size_t element_size) {
-  auto n = *(u64 *)stack;
-  return stack + sizeof(u64) + (n - 1) * 2 * element_size;
+  auto header = (AdStackHeader *)stack;
+  auto segment = header->segment;
+  if (segment) {
+    return (Ptr)(segment + 1) +
+           (header->n - 1 - segment->base) * 2 * element_size;
+  }
+  return stack + sizeof(AdStackHeader) + (header->n - 1) * 2 * element_size;
 }
 
 Ptr stack_top_adjoint(Ptr stack, std::size_t element_size) {
@@ -1873,19 +1961,60 @@ Ptr stack_top_adjoint(Ptr stack, std::size_t element_size) {
 }
 
 void stack_init(Ptr stack) {
-  *(u64 *)stack = 0;
+  auto header = (AdStackHeader *)stack;
+  header->n = 0;
+  header->segment = nullptr;
 }
 
-void stack_pop(Ptr stack) {
-  auto &n = *(u64 *)stack;
-  n--;
+AdStackSegment *stack_acquire_segment(RuntimeContext *context,
+                                      u64 base,
+                                      u64 size_in_bytes) {
+  auto runtime = context->runtime;
+  auto &cache = runtime->ad_stack_segment_caches[linear_thread_idx(context)];
+  for (auto free = &cache; *free; free = &(*free)->next_free) {
+    if ((*free)->size_in_bytes >= size_in_bytes) {
+      auto segment = *free;
+      *free = segment->next_free;
+      segment->base = base;
+      return segment;
+    }
+  }
+  auto segment = (AdStackSegment *)runtime->allocate_aligned(
+      runtime->runtime_memory_chunk, sizeof(AdStackSegment) + size_in_bytes,
+      sizeof(AdStackSegment), true /*request*/);
+  segment->base = base;
+  segment->size_in_bytes = size_in_bytes;
+  return segment;
+}
+
+void stack_pop(RuntimeContext *context, Ptr stack) {
+  auto header = (AdStackHeader *)stack;
+  auto n = --header->n;
+  auto segment = header->segment;
+  if (segment && n <= segment->base) {
+    header->segment = segment->prev;
+    auto &cache =
+        context->runtime->ad_stack_segment_caches[linear_thread_idx(context)];
+    segment->next_free = cache;
+    cache = segment;
+  }
 }
 
-void stack_push(Ptr stack, size_t max_num_elements, std::size_t element_size) {
-  u64 &n = *(u64 *)stack;
-  n += 1;
-  // TODO: assert n <= max_elements
-  std::memset(stack_top_primal(stack, element_size), 0, element_size * 2);
+void stack_push(RuntimeContext *context,
+                Ptr stack,
+                size_t max_num_elements,
+                std::size_t element_size) {
+  auto header = (AdStackHeader *)stack;
+  auto n = header->n++;
+  auto segment = header->segment;
+  const u64 entry_size = 2 * element_size;
+  if (segment ? (n - segment->base + 1) * entry_size > segment->size_in_bytes
+              : n >= max_num_elements) {
+    header->segment =
+        stack_acquire_segment(context, n, max_u64(n, 8) * entry_size);
+    header->segment->prev = segment;
+  }
+  std::memset(stack_top_primal(stack, element_size), 0, entry_size);
 }
 
 #include "internal_functions.h"
@@ -27,6 +27,17 @@ class GfxProgramImpl : public ProgramImpl {
     }
   }
 
+  void synchronize_allocation(const DeviceAllocation &alloc,
+                              bool host_write) override {
+    if (runtime_) {
+      runtime_->synchronize_allocations({alloc.alloc_id}, host_write);
+    }
+  }
+
+  void copy_for_host(DevicePtr dst, DevicePtr src, size_t size) override {
+    runtime_->copy_for_host(dst, src, size);
+  }
+
   void finalize() override;
 
   StreamSemaphore flush() override {
@@ -126,6 +126,13 @@ class LlvmProgramImpl : public ProgramImpl {
     return runtime_exec_->allocate_memory_on_device(alloc_size, result_buffer);
   }
 
+  DeviceAllocation map_file_on_device(const std::string &path,
+                                      std::size_t offset,
+                                      std::size_t size,
+                                      const std::string &access_hint) override {
+    return runtime_exec_->map_file_on_device(path, offset, size, access_hint);
+  }
+
   Device *get_compute_device() override {
     return runtime_exec_->get_compute_device();
   }
@@ -162,6 +169,12 @@ class LlvmProgramImpl : public ProgramImpl {
     runtime_exec_->print_memory_profiler_info(snode_trees_, result_buffer);
   }
 
+  void query_memory_usage(std::vector<std::unique_ptr<SNodeTree>> &snode_trees,
+                          uint64 *result_buffer,
+                          MemoryUsage &usage) override {
+    runtime_exec_->query_memory_usage(snode_trees, result_buffer, usage);
+  }
+
   TaichiLLVMContext *get_llvm_context() {
     return runtime_exec_->get_llvm_context();
   }
@@ -214,6 +227,10 @@ class LlvmProgramImpl : public ProgramImpl {
     return runtime_exec_.get();
   }
 
+  ThreadPool *get_thread_pool() override {
+    return runtime_exec_->get_thread_pool();
+  }
+
   std::string get_kernel_return_data_layout() override {
     return get_llvm_context()->get_data_layout_string();
   };
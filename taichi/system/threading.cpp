@@ -5,13 +5,32 @@
 
 #include "taichi/system/threading.h"
 
+#include "taichi/system/timeline.h"
+
 #include <algorithm>
 #include <condition_variable>
 #include <thread>
 #include <vector>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace taichi {
 
+namespace {
+
+int get_os_thread_id() {
+#if defined(__linux__)
+  return (int)syscall(SYS_gettid);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace
+
 bool test_threading() {
   auto tp = ThreadPool(20);
   for (int j = 0; j < 100; j++) {
@@ -35,16 +54,22 @@ ThreadPool::ThreadPool(int max_num_threads) : max_num_threads(max_num_threads) {
   task_head = 0;
   task_tail = 0;
   thread_counter = 0;
+  busy_time_.resize(max_num_threads, 0);
+  num_tasks_.resize(max_num_threads, 0);
+  worker_os_thread_ids_.resize(max_num_threads, 0);
   threads.resize((std::size_t)max_num_threads);
   for (int i = 0; i < max_num_threads; i++) {
     threads[i] = std::thread([this] { this->target(); });
   }
+  std::unique_lock<std::mutex> lock(mutex);
+  master_cv.wait(lock, [&] { return thread_counter == max_num_threads; });
 }
 
 void ThreadPool::run(int splits,
                      int desired_num_threads,
                      void *range_for_task_context,
                      RangeForTaskFunc *func) {
+  const float64 start_time = record_load_balance ? Time::get_time() : 0;
   {
     std::lock_guard _(mutex);
     this->range_for_task_context = range_for_task_context;
@@ -67,6 +92,25 @@ void ThreadPool::run(int splits,
     master_cv.wait(lock, [this] { return started && running_threads == 0; });
   }
   TI_ASSERT(task_head >= task_tail);
+  if (record_load_balance) {
+    recorded_wall_time_ += Time::get_time() - start_time;
+    num_recorded_threads_ =
+        std::max(num_recorded_threads_, this->desired_num_threads);
+  }
+}
+
+ThreadPool::LoadBalance ThreadPool::take_load_balance() {
+  LoadBalance result;
+  result.wall_time = recorded_wall_time_;
+  result.busy_time.assign(busy_time_.begin(),
+                          busy_time_.begin() + num_recorded_threads_);
+  result.num_tasks.assign(num_tasks_.begin(),
+                          num_tasks_.begin() + num_recorded_threads_);
+  std::fill(busy_time_.begin(), busy_time_.end(), 0);
+  std::fill(num_tasks_.begin(), num_tasks_.end(), 0);
+  num_recorded_threads_ = 0;
+  recorded_wall_time_ = 0;
+  return result;
 }
 
 void ThreadPool::target() {
@@ -75,7 +119,12 @@ void ThreadPool::target() {
   {
     std::lock_guard<std::mutex> lock(mutex);
     thread_id = thread_counter++;
+    worker_os_thread_ids_[thread_id] = get_os_thread_id();
   }
+  master_cv.notify_one();
+  // Only named once it records load balance, to leave the Timeline alone
+  // otherwise.
+  bool timeline_named = false;
   while (true) {
     {
       std::unique_lock<std::mutex> lock(mutex);
@@ -100,6 +149,8 @@ void ThreadPool::target() {
       }
     }
 
+    const bool record = record_load_balance;
+    float64 first_start = -1, last_end = 0;
     while (true) {
       // For a single parallel task
       int task_id;
@@ -109,7 +160,29 @@ void ThreadPool::target() {
           break;
       }
 
-      func(this->range_for_task_context, thread_id, task_id);
+      if (record) {
+        const float64 start = Time::get_time();
+        func(this->range_for_task_context, thread_id, task_id);
+        last_end = Time::get_time();
+        busy_time_[thread_id] += last_end - start;
+        num_tasks_[thread_id]++;
+        if (first_start < 0) {
+          first_start = start;
+        }
+      } else {
+        func(this->range_for_task_context, thread_id, task_id);
+      }
+    }
+    if (first_start >= 0) {
+      auto &timeline = Timeline::get_this_thread_instance();
+      if (!timeline_named) {
+        timeline.set_name(fmt::format("cpu_worker_{:02d}", thread_id));
+        timeline_named = true;
+      }
+      timeline.insert_event(
+          {timeline_label, true, first_start, timeline.get_name()});
+      timeline.insert_event(
+          {timeline_label, false, last_end, timeline.get_name()});
     }
 
     bool all_finished = false;
@@ -19,6 +19,16 @@ using ParallelFor = void(int n, int num_threads, void *, RangeForTaskFunc func);
 
 class ThreadPool {
  public:
+  // How busy the workers were during the runs since the last call of
+  // take_load_balance(), indexed by thread id.
+  struct LoadBalance {
+    // Total time spent in run(), in seconds.
+    float64 wall_time{0};
+    // Time each worker spent in the tasks, in seconds.
+    std::vector<float64> busy_time;
+    std::vector<int> num_tasks;
+  };
+
   std::vector<std::thread> threads;
   std::condition_variable slave_cv;
   std::condition_variable master_cv;
@@ -38,6 +48,12 @@ class ThreadPool {
                                  // LLVM runtime, which is different from
                                  // taichi::lang::Context.
   int thread_counter;
+  // Opt-in: time the tasks of each worker, and add the busy span of each
+  // worker in each run to its Timeline under |timeline_label|. The Timeline
+  // of a worker is named cpu_worker_NN when it first records. Only changed
+  // between runs.
+  bool record_load_balance{false};
+  std::string timeline_label{"parallel_for"};
 
   explicit ThreadPool(int max_num_threads);
 
@@ -56,7 +72,26 @@ class ThreadPool {
 
   void target();
 
+  LoadBalance take_load_balance();
+
+  // The OS thread ids of the workers (Linux only, 0 elsewhere).
+  const std::vector<int> &get_worker_os_thread_ids() const {
+    return worker_os_thread_ids_;
+  }
+
   ~ThreadPool();
+
+ private:
+  // Filled by the workers before the constructor returns.
+  std::vector<int> worker_os_thread_ids_;
+  // Each worker only writes its own slots, which are read by the master
+  // after run() returns.
+  std::vector<float64> busy_time_;
+  std::vector<int> num_tasks_;
+  // The largest number of workers of a run since the last
+  // take_load_balance().
+  int num_recorded_threads_{0};
+  float64 recorded_wall_time_{0};
 };
 
 }  // namespace taichi
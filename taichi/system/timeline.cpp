@@ -1,7 +1,31 @@
 #include "taichi/system/timeline.h"
 
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
 namespace taichi {
 
+namespace {
+
+// Reads the time stamp counter where available, which is cheaper than
+// Time::get_time(). The ticks are converted to seconds when fetched.
+inline uint64 read_ticks() {
+#if defined(_M_X64) || defined(__x86_64__)
+  return __rdtsc();
+#else
+  return (uint64)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+}  // namespace
+
 std::string TimelineEvent::to_json() {
   std::string json{"{"};
   json += fmt::format("\"cat\":\"taichi\",");
@@ -30,30 +54,92 @@ Timeline::~Timeline() {
 
 void Timeline::clear() {
   std::lock_guard<std::mutex> _(mut_);
-  events_.clear();
+  std::vector<Record> records;
+  drain(records);
+  overflow_.clear();
 }
+
 void Timeline::insert_event(const TimelineEvent &e) {
   if (!Timelines::get_instance().get_enabled())
     return;
-  std::lock_guard<std::mutex> _(mut_);
-  events_.push_back(e);
+  auto &timelines = Timelines::get_instance();
+  Record record{0, timelines.intern(e.name),
+                e.tid.empty() ? kOwnTid : timelines.intern(e.tid), e.begin,
+                true};
+  static_assert(sizeof(record.stamp) == sizeof(e.time));
+  std::memcpy(&record.stamp, &e.time, sizeof(e.time));
+  push(record);
+}
+
+void Timeline::insert_event(uint32 name_id, bool begin) {
+  if (!Timelines::get_instance().get_enabled())
+    return;
+  push({read_ticks(), name_id, kOwnTid, begin, false});
+}
+
+void Timeline::push(const Record &record) {
+  const uint64 head = head_.load(std::memory_order_relaxed);
+  if (!ring_) {
+    ring_ = std::make_unique<Record[]>(kRingSize);
+  }
+  if (head - tail_.load(std::memory_order_acquire) == kRingSize) {
+    // The ring is full until the next fetch, so spill it.
+    std::lock_guard<std::mutex> _(mut_);
+    drain(overflow_);
+  }
+  ring_[head % kRingSize] = record;
+  head_.store(head + 1, std::memory_order_release);
+}
+
+void Timeline::drain(std::vector<Record> &records) {
+  const uint64 head = head_.load(std::memory_order_acquire);
+  const uint64 tail = tail_.load(std::memory_order_relaxed);
+  for (uint64 i = tail; i < head; i++) {
+    records.push_back(ring_[i % kRingSize]);
+  }
+  tail_.store(head, std::memory_order_release);
 }
 
 std::vector<TimelineEvent> Timeline::fetch_events() {
-  std::lock_guard<std::mutex> _(mut_);
+  std::vector<Record> records;
+  std::string tid;
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    std::swap(records, overflow_);
+    drain(records);
+    tid = tid_;
+  }
+  auto &timelines = Timelines::get_instance();
+  const float64 ticks_per_second =
+      records.empty() ? 0 : timelines.ticks_per_second();
   std::vector<TimelineEvent> fetched;
-  std::swap(fetched, events_);
+  fetched.reserve(records.size());
+  for (auto &record : records) {
+    float64 time;
+    if (record.in_seconds) {
+      std::memcpy(&time, &record.stamp, sizeof(time));
+    } else {
+      time = timelines.ticks_to_seconds(record.stamp, ticks_per_second);
+    }
+    fetched.push_back({timelines.get_interned_name(record.name_id),
+                       bool(record.begin), time,
+                       record.tid_id == kOwnTid
+                           ? tid
+                           : timelines.get_interned_name(record.tid_id)});
+  }
   return fetched;
 }
 
-Timeline::Guard::Guard(const std::string &name) : name_(name) {
-  auto &timeline = Timeline::get_this_thread_instance();
-  timeline.insert_event({name, true, Time::get_time(), timeline.tid_});
+Timeline::Guard::Guard(const std::string &name)
+    : Guard(Timelines::get_instance().intern(name)) {
+}
+
+Timeline::Guard::Guard(uint32 name_id) : name_id_(name_id) {
+  Timeline::get_this_thread_instance().insert_event(name_id_, true);
 }
 
 Timeline::Guard::~Guard() {
-  auto &timeline = Timeline::get_this_thread_instance();
-  timeline.insert_event({name_, false, Time::get_time(), timeline.tid_});
+  Timeline::get_this_thread_instance().insert_event(name_id_, false);
 }
 
 void Timelines::insert_events(const std::vector<TimelineEvent> &events) {
@@ -66,6 +152,10 @@ void Timelines::insert_events_without_locking(
   events_.insert(events_.end(), events.begin(), events.end());
 }
 
+Timelines::Timelines()
+    : anchor_time_(Time::get_time()), anchor_ticks_(read_ticks()) {
+}
+
 Timelines &taichi::Timelines::get_instance() {
   static auto instance = new Timelines();
   return *instance;
@@ -114,12 +204,45 @@ void Timelines::remove_timeline(Timeline *timeline) {
   trash(std::remove(timelines_.begin(), timelines_.end(), timeline));
 }
 
-bool Timelines::get_enabled() {
-  return enabled_;
+void Timelines::set_enabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
 }
 
-void Timelines::set_enabled(bool enabled) {
-  enabled_ = enabled;
+uint32 Timelines::intern(const std::string &name) {
+  std::lock_guard<std::mutex> _(names_mut_);
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end()) {
+    return it->second;
+  }
+  const auto name_id = (uint32)names_.size();
+  names_.push_back(name);
+  name_ids_.emplace(name, name_id);
+  return name_id;
+}
+
+std::string Timelines::get_interned_name(uint32 name_id) {
+  std::lock_guard<std::mutex> _(names_mut_);
+  TI_ASSERT(name_id < names_.size());
+  return names_[name_id];
+}
+
+float64 Timelines::ticks_per_second() {
+  // The tick rate is measured since the timelines were created, which takes
+  // long enough to be accurate except right after the start.
+  constexpr float64 kMinCalibrationTime = 0.05;
+  const float64 elapsed = Time::get_time() - anchor_time_;
+  if (elapsed < kMinCalibrationTime) {
+    std::this_thread::sleep_for(
+        std::chrono::duration<float64>(kMinCalibrationTime - elapsed));
+  }
+  const uint64 now_ticks = read_ticks();
+  const float64 now = Time::get_time();
+  return float64(now_ticks - anchor_ticks_) / (now - anchor_time_);
+}
+
+float64 Timelines::ticks_to_seconds(uint64 ticks, float64 ticks_per_second) {
+  return anchor_time_ +
+         float64(int64(ticks - anchor_ticks_)) / ticks_per_second;
 }
 
 }  // namespace taichi
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "taichi/common/core.h"
 #include "taichi/system/timer.h"
@@ -17,6 +21,11 @@ struct TimelineEvent {
   std::string to_json();
 };
 
+// The events of a thread. The thread records its events without locking into
+// a ring buffer of fixed-size records, whose names are interned and whose
+// timestamps are CPU ticks, and the records are turned into TimelineEvents
+// when they are fetched. Interning a name takes a lock, which only
+// TI_AUTO_TIMELINE and the interned overloads avoid on every event.
 class Timeline {
  public:
   Timeline();
@@ -26,33 +35,74 @@ class Timeline {
   static Timeline &get_this_thread_instance();
 
   void set_name(const std::string &tid) {
+    std::lock_guard<std::mutex> _(mut_);
     tid_ = tid;
   }
 
   std::string get_name() {
+    std::lock_guard<std::mutex> _(mut_);
     return tid_;
   }
 
   void clear();
 
+  // Records an event whose time is already known, in seconds. The event keeps
+  // its tid, e.g. the lane of the GPU events, unless it is empty.
   void insert_event(const TimelineEvent &e);
 
+  // Records an event of an interned name at the current time. Must be called
+  // by the thread owning this timeline.
+  void insert_event(uint32 name_id, bool begin);
+
   std::vector<TimelineEvent> fetch_events();
 
   class Guard {
    public:
+    // Interns |name| on each call, which takes a lock.
     explicit Guard(const std::string &name);
 
+    // Skips interning the name, see TI_AUTO_TIMELINE.
+    explicit Guard(uint32 name_id);
+
     ~Guard();
 
    private:
-    std::string name_;
+    uint32 name_id_;
   };
 
  private:
+  struct Record {
+    // CPU ticks, or the bits of the time in seconds if |in_seconds|.
+    uint64 stamp;
+    uint32 name_id;
+    // The interned tid of the event, or kOwnTid for the name of the timeline.
+    uint32 tid_id;
+    uint8 begin;
+    uint8 in_seconds;
+  };
+
+  static constexpr uint32 kOwnTid = ~uint32(0);
+
+  static constexpr uint64 kRingSize = 4096;
+
+  void push(const Record &record);
+
+  // Moves the records out of the ring. Must be called with |mut_| held, which
+  // makes the caller the only consumer of the ring.
+  void drain(std::vector<Record> &records);
+
   std::string tid_;
+  // Guards |tid_|, |overflow_| and the consumer side of the ring.
   std::mutex mut_;
-  std::vector<TimelineEvent> events_;
+  // Allocated on the first event, so that threads never recording events do
+  // not pay for it.
+  std::unique_ptr<Record[]> ring_;
+  // Only written by the owning thread.
+  std::atomic<uint64> head_{0};
+  // Only written with |mut_| held.
+  std::atomic<uint64> tail_{0};
+  // The records drained from the ring when it was full.
+  std::vector<Record> overflow_;
 };
 
 // A timeline system for multi-threaded applications
@@ -72,20 +122,49 @@ class Timelines {
 
   void save(const std::string &filename);
 
-  bool get_enabled();
+  bool get_enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
 
   void set_enabled(bool enabled);
 
+  // Returns the id of |name| for Timeline::insert_event and Timeline::Guard.
+  uint32 intern(const std::string &name);
+
+  std::string get_interned_name(uint32 name_id);
+
+  // Measures the rate of the ticks timestamping the events, which are
+  // converted to seconds as Time::get_time() by ticks_to_seconds().
+  float64 ticks_per_second();
+
+  float64 ticks_to_seconds(uint64 ticks, float64 ticks_per_second);
+
  private:
+  Timelines();
+
   std::mutex mut_;
   std::vector<TimelineEvent> events_;
   std::vector<Timeline *> timelines_;
-  bool enabled_{false};
+  std::atomic<bool> enabled_{false};
+
+  std::mutex names_mut_;
+  std::unordered_map<std::string, uint32> name_ids_;
+  std::deque<std::string> names_;
+
+  // The clocks when the timelines were created, to convert ticks to seconds.
+  float64 anchor_time_;
+  uint64 anchor_ticks_;
 };
 
+// Interns |name| on each call, see Timeline::Guard.
 #define TI_TIMELINE(name) \
   taichi::Timeline::Guard _timeline_guard_##__LINE__(name);
 
-#define TI_AUTO_TIMELINE TI_TIMELINE(__FUNCTION__)
+// Interns the function name once, so that the guard costs two ring buffer
+// writes.
+#define TI_AUTO_TIMELINE                                      \
+  static const taichi::uint32 _timeline_name_id_ =            \
+      taichi::Timelines::get_instance().intern(__FUNCTION__); \
+  taichi::Timeline::Guard _timeline_guard_(_timeline_name_id_);
 
 }  // namespace taichi
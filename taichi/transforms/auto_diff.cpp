@@ -7,6 +7,9 @@
 
 #include <typeinfo>
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace taichi::lang {
 
@@ -700,14 +703,20 @@ class ReplaceLocalVarWithStacks : public BasicStmtVisitor {
  public:
   using BasicStmtVisitor::visit;
   int ad_stack_size;
+  // Allocas that need AD-stacks regardless of AdStackAllocaJudger.
+  std::unordered_set<Stmt *> forced_allocas;
   DelayedIRModifier delayed_modifier_;
 
-  explicit ReplaceLocalVarWithStacks(int ad_stack_size)
-      : ad_stack_size(ad_stack_size) {
+  explicit ReplaceLocalVarWithStacks(
+      int ad_stack_size,
+      std::unordered_set<Stmt *> forced_allocas = {})
+      : ad_stack_size(ad_stack_size),
+        forced_allocas(std::move(forced_allocas)) {
   }
 
   void visit(AllocaStmt *alloc) override {
-    bool is_stack_needed = AdStackAllocaJudger::run(alloc);
+    bool is_stack_needed = forced_allocas.count(alloc) > 0 ||
+                           AdStackAllocaJudger::run(alloc);
     if (is_stack_needed) {
       auto dtype = alloc->ret_type.ptr_removed();
       auto stack_alloca = Stmt::make<AdStackAllocaStmt>(dtype, ad_stack_size);
@@ -948,6 +957,336 @@ class ReverseOuterLoops : public BasicStmtVisitor {
   }
 };
 
+// A serial loop of an IB whose AD-stacks would hold too many iterations,
+// recorded one segment of |interval| iterations at a time (two-level
+// checkpointing):
+//
+// [Forward]                           [Backward]
+// for c in range(num_segments):       for c in reversed(range(num_segments)):
+//   checkpoint the live-in state        restore the state from checkpoint c
+//   for i in segment c:                 for i in segment c:
+//     body, without AD-stacks             body, recorded on AD-stacks
+//                                       for i in reversed(segment c):
+//                                         adjoint of body
+//
+// The AD-stacks then hold one segment, plus one checkpoint per segment, at
+// the cost of running the loop body twice.
+struct SerialLoopCheckpoint {
+  // The original loop, recorded segment by segment in the backward pass.
+  std::unique_ptr<Stmt> loop;
+  int64 begin{0};
+  int64 end{0};
+  int64 interval{0};
+  int64 num_segments{0};
+  // The AD-stacks pushed in the loop body.
+  std::vector<AdStackAllocaStmt *> stacks;
+  // The checkpoints of the AD-stacks that may be read in an iteration before
+  // being pushed.
+  std::unordered_map<AdStackAllocaStmt *, AdStackAllocaStmt *> checkpoints;
+};
+
+// Inserts the range [begin, end) of the |segment|-th segment of |checkpoint|
+// at the end of |block|.
+static std::pair<Stmt *, Stmt *> insert_segment_range(
+    Block *block,
+    Stmt *segment,
+    const SerialLoopCheckpoint &checkpoint) {
+  auto constant = [&](int64 value) {
+    return block->insert(
+        Stmt::make<ConstStmt>(TypedConstant((int32)value)));
+  };
+  auto interval = constant(checkpoint.interval);
+  auto offset = block->insert(
+      Stmt::make<BinaryOpStmt>(BinaryOpType::mul, segment, interval));
+  auto begin = block->insert(Stmt::make<BinaryOpStmt>(
+      BinaryOpType::add, constant(checkpoint.begin), offset));
+  auto end = block->insert(
+      Stmt::make<BinaryOpStmt>(BinaryOpType::add, begin, interval));
+  end = block->insert(Stmt::make<BinaryOpStmt>(BinaryOpType::min, end,
+                                               constant(checkpoint.end)));
+  return {begin, end};
+}
+
+// Checkpoints the long serial loops directly inside an IB, so that their
+// AD-stacks fit in |ad_stack_memory_budget| bytes. A loop is checkpointed
+// only if it has a constant trip count and running its body twice has no
+// side effects.
+class CheckpointSerialLoops {
+ public:
+  CheckpointSerialLoops(Block *ib, const CompileConfig &config)
+      : ib_(ib),
+        budget_(config.ad_stack_memory_budget),
+        default_ad_stack_size_(config.default_ad_stack_size) {
+  }
+
+  // Selects the loops to checkpoint, before the local variables are replaced
+  // with AD-stacks. Returns the allocas stored in these loops: all of them
+  // need AD-stacks so that the loops can be restored from checkpoints.
+  std::unordered_set<Stmt *> select_loops() {
+    std::unordered_set<Stmt *> allocas;
+    if (budget_ <= 0) {
+      return allocas;
+    }
+    for (auto &stmt : ib_->statements) {
+      auto loop = stmt->cast<RangeForStmt>();
+      if (!loop || loop->reversed || !loop->begin->is<ConstStmt>() ||
+          !loop->end->is<ConstStmt>()) {
+        continue;
+      }
+      const int64 n = trip_count(loop);
+      if (n < 2 || !is_replayable(loop->body.get())) {
+        continue;
+      }
+      std::unordered_set<Stmt *> stored;
+      int64 recorded_bytes = 0;
+      bool scalar = true;
+      for (auto s : irpass::analysis::gather_statements(
+               loop->body.get(),
+               [](Stmt *s) { return s->is<LocalStoreStmt>(); })) {
+        auto dest = s->as<LocalStoreStmt>()->dest;
+        auto dtype = dest->ret_type.ptr_removed();
+        if (!dest->is<AllocaStmt>() || dtype->is<TensorType>()) {
+          scalar = false;
+          break;
+        }
+        stored.insert(dest);
+        if (AdStackAllocaJudger::run(dest->as<AllocaStmt>())) {
+          recorded_bytes += 2 * data_type_size(dtype);
+        }
+      }
+      if (!scalar || n * recorded_bytes <= budget_) {
+        continue;
+      }
+      loops_.push_back(loop);
+      allocas.insert(stored.begin(), stored.end());
+    }
+    return allocas;
+  }
+
+  // Replaces the forward pass of the selected loops, after the local
+  // variables are replaced with AD-stacks.
+  void run() {
+    for (auto loop : loops_) {
+      checkpoint(loop);
+    }
+  }
+
+  // The checkpoint whose forward pass is |stmt|, if any.
+  SerialLoopCheckpoint *find(Stmt *stmt) {
+    auto it = checkpoints_.find(stmt);
+    return it == checkpoints_.end() ? nullptr : &it->second;
+  }
+
+  // Whether |stmt| only copies the state of a checkpointed loop in the
+  // forward pass, and has no adjoint.
+  bool is_forward_only(Stmt *stmt) const {
+    return forward_only_.count(stmt) > 0;
+  }
+
+ private:
+  static int64 trip_count(RangeForStmt *loop) {
+    return loop->end->as<ConstStmt>()->val.val_int() -
+           loop->begin->as<ConstStmt>()->val.val_int();
+  }
+
+  static bool is_replayable(Block *body) {
+    return irpass::analysis::gather_statements(body, [](Stmt *s) {
+             return s->is<RangeForStmt>() || s->is<StructForStmt>() ||
+                    s->is<WhileStmt>() || s->is<GlobalStoreStmt>() ||
+                    s->is<AtomicOpStmt>() || s->is<RandStmt>() ||
+                    s->is<PrintStmt>() || s->is<AssertStmt>() ||
+                    s->is<ExternalFuncCallStmt>();
+           }).empty();
+  }
+
+  // Whether |stack| may be read in an iteration of |body| before it is
+  // pushed.
+  static bool is_live_in(Block *body, AdStackAllocaStmt *stack) {
+    for (auto &stmt : body->statements) {
+      auto push = stmt->cast<AdStackPushStmt>();
+      if (push && push->stack == stack) {
+        return false;
+      }
+      if (!irpass::analysis::gather_statements(stmt.get(), [&](Stmt *s) {
+             return s->has_operand(stack);
+           }).empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Picks the longest segments whose AD-stacks fit in the budget.
+  int64 choose_interval(int64 n,
+                        int64 recorded_bytes,
+                        int64 checkpoint_bytes) const {
+    auto memory = [&](int64 interval) {
+      return (n + interval - 1) / interval * checkpoint_bytes +
+             interval * recorded_bytes;
+    };
+    // The memory is the lowest around sqrt(n * checkpoint / recorded).
+    int64 best = std::clamp<int64>(
+        (int64)std::sqrt((double)n * checkpoint_bytes / recorded_bytes), 1, n);
+    if (best < n && memory(best + 1) < memory(best)) {
+      best++;
+    }
+    if (memory(best) > budget_) {
+      TI_WARN(
+          "The AD-stacks of a loop of {} iterations need {} bytes even with "
+          "checkpointing, exceeding ad_stack_memory_budget ({} bytes).",
+          n, memory(best), budget_);
+      return best;
+    }
+    int64 lo = best, hi = n;
+    while (lo < hi) {
+      const int64 mid = (lo + hi + 1) / 2;
+      if (memory(mid) <= budget_) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    return lo;
+  }
+
+  void checkpoint(RangeForStmt *loop) {
+    SerialLoopCheckpoint checkpoint;
+    checkpoint.begin = loop->begin->as<ConstStmt>()->val.val_int();
+    checkpoint.end = loop->end->as<ConstStmt>()->val.val_int();
+    const int64 n = checkpoint.end - checkpoint.begin;
+
+    std::unordered_map<AdStackAllocaStmt *, int64> num_pushes;
+    for (auto s : irpass::analysis::gather_statements(
+             loop->body.get(),
+             [](Stmt *s) { return s->is<AdStackPushStmt>(); })) {
+      auto stack = s->as<AdStackPushStmt>()->stack->as<AdStackAllocaStmt>();
+      if (num_pushes[stack]++ == 0) {
+        checkpoint.stacks.push_back(stack);
+      }
+    }
+    int64 recorded_bytes = 0;
+    int64 checkpoint_bytes = 0;
+    std::vector<AdStackAllocaStmt *> live_in;
+    for (auto stack : checkpoint.stacks) {
+      recorded_bytes += num_pushes[stack] * stack->entry_size_in_bytes();
+      if (is_live_in(loop->body.get(), stack)) {
+        live_in.push_back(stack);
+        checkpoint_bytes += stack->entry_size_in_bytes();
+      }
+    }
+    if (recorded_bytes == 0) {
+      return;
+    }
+    checkpoint.interval = choose_interval(n, recorded_bytes, checkpoint_bytes);
+    if (checkpoint.interval >= n) {
+      return;
+    }
+    checkpoint.num_segments =
+        (n + checkpoint.interval - 1) / checkpoint.interval;
+
+    // The AD-stacks hold one recorded segment on top of the entries pushed
+    // outside the loop, the state before the segment and the state after
+    // the loop.
+    for (auto stack : checkpoint.stacks) {
+      int64 size = 2 + checkpoint.interval * num_pushes[stack];
+      for (auto s : irpass::analysis::gather_statements(ib_, [&](Stmt *s) {
+             auto push = s->cast<AdStackPushStmt>();
+             return push && push->stack == stack;
+           })) {
+        if (!inside_loop(s, loop)) {
+          size += inside_loop(s, nullptr) ? default_ad_stack_size_ : 1;
+        }
+      }
+      stack->max_size = std::max<std::size_t>(stack->max_size, size);
+    }
+    for (auto stack : live_in) {
+      checkpoint.checkpoints[stack] =
+          ib_->insert(Stmt::make<AdStackAllocaStmt>(stack->dt,
+                                                    checkpoint.num_segments),
+                      0)
+              ->as<AdStackAllocaStmt>();
+    }
+
+    // The loop state is kept in local variables during the forward pass.
+    auto forward = [&](std::unique_ptr<Stmt> &&stmt) {
+      auto ptr = loop->insert_before_me(std::move(stmt));
+      forward_only_.insert(ptr);
+      return ptr;
+    };
+    std::unordered_map<Stmt *, Stmt *> states;
+    for (auto stack : checkpoint.stacks) {
+      auto state = forward(Stmt::make<AllocaStmt>(stack->ret_type));
+      auto top = forward(Stmt::make<AdStackLoadTopStmt>(stack));
+      top->ret_type = stack->ret_type;
+      forward(Stmt::make<LocalStoreStmt>(state, top));
+      states[stack] = state;
+    }
+    auto zero = forward(Stmt::make<ConstStmt>(TypedConstant(0)));
+    auto num_segments = forward(Stmt::make<ConstStmt>(
+        TypedConstant((int32)checkpoint.num_segments)));
+    auto segments = loop->insert_before_me(Stmt::make<RangeForStmt>(
+        zero, num_segments, std::make_unique<Block>(), loop->is_bit_vectorized,
+        loop->num_cpu_threads, loop->block_dim, loop->strictly_serialized));
+    auto body = segments->as<RangeForStmt>()->body.get();
+    auto segment = body->insert(Stmt::make<LoopIndexStmt>(segments, 0));
+    for (auto stack : live_in) {
+      auto state = body->insert(Stmt::make<LocalLoadStmt>(states[stack]));
+      state->ret_type = stack->ret_type;
+      body->insert(
+          Stmt::make<AdStackPushStmt>(checkpoint.checkpoints[stack], state));
+    }
+    auto [begin, end] = insert_segment_range(body, segment, checkpoint);
+    auto replay =
+        body->insert(irpass::analysis::clone(loop))->as<RangeForStmt>();
+    replay->begin = begin;
+    replay->end = end;
+    for (auto s : irpass::analysis::gather_statements(
+             replay->body.get(), [](Stmt *s) {
+               return s->is<AdStackPushStmt>() || s->is<AdStackLoadTopStmt>();
+             })) {
+      if (auto push = s->cast<AdStackPushStmt>()) {
+        push->replace_with(
+            Stmt::make<LocalStoreStmt>(states[push->stack], push->v));
+      } else if (auto top = s->as<AdStackLoadTopStmt>();
+                 states.count(top->stack)) {
+        // Stacks that are only read in the loop keep their top.
+        TI_ASSERT(!top->return_ptr);
+        auto load = Stmt::make<LocalLoadStmt>(states[top->stack]);
+        load->ret_type = top->ret_type;
+        top->replace_with(std::move(load));
+      }
+    }
+    for (auto stack : checkpoint.stacks) {
+      auto state = forward(Stmt::make<LocalLoadStmt>(states[stack]));
+      state->ret_type = stack->ret_type;
+      forward(Stmt::make<AdStackPushStmt>(stack, state));
+    }
+
+    checkpoint.loop = ib_->extract(loop);
+    checkpoints_[segments] = std::move(checkpoint);
+  }
+
+  // Whether |stmt| is inside |loop|, or inside any loop of the IB if |loop|
+  // is nullptr.
+  bool inside_loop(Stmt *stmt, Stmt *loop) const {
+    for (auto block = stmt->parent; block != ib_;
+         block = block->parent_block()) {
+      auto parent = block->parent_stmt();
+      if (parent == loop || (!loop && parent->is<RangeForStmt>())) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Block *ib_;
+  int64 budget_;
+  int default_ad_stack_size_;
+  std::vector<RangeForStmt *> loops_;
+  std::unordered_map<Stmt *, SerialLoopCheckpoint> checkpoints_;
+  std::unordered_set<Stmt *> forward_only_;
+};
+
 // Base class for both reverse (make adjoint) and forward (make dual) mode
 class ADTransform : public IRVisitor {
  protected:
@@ -1172,14 +1511,17 @@ class MakeAdjoint : public ADTransform {
   Block *forward_backup;
   std::map<Stmt *, Stmt *> adjoint_stmt;
 
+  CheckpointSerialLoops *checkpoints{nullptr};
+
   explicit MakeAdjoint(Block *block) {
     current_block = nullptr;
     alloca_block = block;
     forward_backup = block;
   }
 
-  static void run(Block *block) {
+  static void run(Block *block, CheckpointSerialLoops *checkpoints = nullptr) {
     auto p = MakeAdjoint(block);
+    p.checkpoints = checkpoints;
     block->accept(&p);
   }
 
@@ -1193,6 +1535,9 @@ class MakeAdjoint : public ADTransform {
     }
     std::reverse(statements.begin(), statements.end());  // reverse-mode AD...
     for (auto stmt : statements) {
+      if (checkpoints && checkpoints->is_forward_only(stmt)) {
+        continue;
+      }
       current_block = block;
       stmt->accept(this);
     }
@@ -1443,7 +1788,93 @@ class MakeAdjoint : public ADTransform {
     insert_grad_stmt(std::move(new_if));
   }
 
+  // Pops |stack| and accumulates the adjoint of the popped entry to the new
+  // top entry.
+  void pop_to_adjoint_below(AdStackAllocaStmt *stack) {
+    if (!is_real(stack->ret_type.get_element_type())) {
+      insert<AdStackPopStmt>(stack);
+      return;
+    }
+    auto adjoint = insert<AdStackLoadTopAdjStmt>(stack);
+    insert<AdStackPopStmt>(stack);
+    insert<AdStackAccAdjointStmt>(stack, adjoint);
+  }
+
+  // The backward pass of a loop checkpointed by CheckpointSerialLoops. At the
+  // beginning of each segment, the top entry of each AD-stack of the loop
+  // holds the state after the segment, with its adjoint.
+  void reverse_checkpointed_loop(SerialLoopCheckpoint &checkpoint) {
+    auto outer_block = current_block;
+    auto loop = checkpoint.loop->as<RangeForStmt>();
+    auto zero = insert<ConstStmt>(TypedConstant(0));
+    auto num_segments =
+        insert<ConstStmt>(TypedConstant((int32)checkpoint.num_segments));
+    auto segments = insert_grad_stmt(Stmt::make<RangeForStmt>(
+        zero, num_segments, std::make_unique<Block>(), loop->is_bit_vectorized,
+        loop->num_cpu_threads, loop->block_dim, loop->strictly_serialized));
+    segments->as<RangeForStmt>()->reversed = true;
+    current_block = segments->as<RangeForStmt>()->body.get();
+    auto segment = insert<LoopIndexStmt>(segments, 0);
+
+    // Take the adjoints of the state after the segment, and push the state
+    // before the segment.
+    std::vector<Stmt *> adjoints;
+    for (auto stack : checkpoint.stacks) {
+      Stmt *adjoint = nullptr;
+      if (is_real(stack->ret_type.get_element_type())) {
+        adjoint = insert<AdStackLoadTopAdjStmt>(stack);
+        insert<AdStackAccAdjointStmt>(stack, negate(adjoint));
+      }
+      adjoints.push_back(adjoint);
+      Stmt *state = nullptr;
+      if (auto it = checkpoint.checkpoints.find(stack);
+          it != checkpoint.checkpoints.end()) {
+        state = insert<AdStackLoadTopStmt>(it->second);
+        insert<AdStackPopStmt>(it->second);
+      } else {
+        // Overwritten before being read, any value does.
+        state = insert<AdStackLoadTopStmt>(stack);
+      }
+      state->ret_type = stack->ret_type;
+      insert<AdStackPushStmt>(stack, state);
+    }
+
+    // Record the segment, hand it the adjoints of the state after it, and
+    // run its adjoint.
+    auto [begin, end] =
+        insert_segment_range(current_block, segment, checkpoint);
+    loop->begin = begin;
+    loop->end = end;
+    auto recorded = insert_grad_stmt(std::move(checkpoint.loop));
+    for (int i = 0; i < (int)checkpoint.stacks.size(); i++) {
+      if (adjoints[i]) {
+        insert<AdStackAccAdjointStmt>(checkpoint.stacks[i], adjoints[i]);
+      }
+    }
+    auto segment_block = current_block;
+    recorded->accept(this);
+    current_block = segment_block;
+
+    // The adjoints of the state before the segment are those of the state
+    // after the previous segment.
+    for (auto stack : checkpoint.stacks) {
+      pop_to_adjoint_below(stack);
+    }
+
+    // The state after the loop was copied from the state before it.
+    current_block = outer_block;
+    for (auto stack : checkpoint.stacks) {
+      pop_to_adjoint_below(stack);
+    }
+  }
+
   void visit(RangeForStmt *for_stmt) override {
+    if (checkpoints) {
+      if (auto checkpoint = checkpoints->find(for_stmt)) {
+        reverse_checkpointed_loop(*checkpoint);
+        return;
+      }
+    }
     auto new_for = for_stmt->clone();
     auto new_for_ptr = new_for->as<RangeForStmt>();
     new_for_ptr->reversed = !new_for_ptr->reversed;
@@ -2402,11 +2833,14 @@ void auto_diff(IRNode *root,
 
       for (auto ib : IB) {
         PromoteSSA2LocalVar::run(ib);
-        ReplaceLocalVarWithStacks replace(config.ad_stack_size);
+        CheckpointSerialLoops checkpoints(ib, config);
+        ReplaceLocalVarWithStacks replace(config.ad_stack_size,
+                                          checkpoints.select_loops());
         ib->accept(&replace);
+        checkpoints.run();
         type_check(root, config);
 
-        MakeAdjoint::run(ib);
+        MakeAdjoint::run(ib, &checkpoints);
         type_check(root, config);
         BackupSSA::run(ib);
         irpass::analysis::verify(root);
@@ -7,6 +7,7 @@
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/visitors.h"
 #include "taichi/ir/analysis.h"
+#include "taichi/ir/ir_builder.h"
 
 namespace taichi::lang {
 
@@ -145,6 +146,18 @@ class BitLoopVectorize : public IRVisitor {
     if (stmt->snode->type != SNodeType::quant_array) {
       return;
     }
+    auto qat = stmt->snode->dt->as<QuantArrayType>();
+    if (stmt->is_bit_vectorized && qat->get_element_num_bits() > 1) {
+      auto element_type = qat->get_element_type();
+      TI_ERROR_IF(!element_type->is<QuantIntType>() &&
+                      !element_type->is<QuantFixedType>(),
+                  "Bit-vectorized loops over quant arrays of multi-bit "
+                  "elements only support quant int and quant fixed elements, "
+                  "not {}",
+                  element_type->to_string());
+      vectorize_lanes(stmt);
+      return;
+    }
     bool old_is_bit_vectorized = is_bit_vectorized;
     is_bit_vectorized = stmt->is_bit_vectorized;
     in_struct_for_loop = true;
@@ -273,6 +286,234 @@ class BitLoopVectorize : public IRVisitor {
   }
 
  private:
+  // A bit-vectorized loop over a quant array of multi-bit elements runs once
+  // per physical word. We load the word once, run the original body for each
+  // of its elements (lanes) in an inner loop of constant trip count that
+  // decodes and encodes the elements with shifts and masks on a local copy,
+  // and store the word back once. LLVM unrolls and vectorizes the lane loop,
+  // instead of emitting a load and an atomic read-modify-write per element.
+  //
+  // for i, j in x:             for i, j' in x (one iteration per word):
+  //   y[i, j] = x[i, j] + 1      w = x.word[i, j']
+  //                              for l in range(n):
+  //                                j = j' + l
+  //                                y[i, j] = decode(w, l) + 1
+  //                              x.word[i, j'] = w
+  void vectorize_lanes(StructForStmt *stmt) {
+    auto snode = stmt->snode;
+    auto qat = snode->dt->as<QuantArrayType>();
+    const int num_lanes = qat->get_num_elements();
+    const int element_bits = qat->get_element_num_bits();
+    const int physical_bits = data_type_bits(snode->physical_type);
+
+    int axis = -1;
+    for (int i = 0; i < taichi_max_num_indices; i++) {
+      if (snode->extractors[i].active) {
+        TI_ERROR_IF(axis != -1,
+                    "A bit-vectorized struct-for over a quant array of "
+                    "multi-bit elements needs the quant array to split a "
+                    "single axis");
+        axis = i;
+      }
+    }
+    TI_ASSERT(axis != -1);
+
+    // Only x[i, j] with the loop indices themselves can be decoded from the
+    // word loaded by the iteration.
+    auto accesses = irpass::analysis::gather_statements(
+        stmt->body.get(), [&](Stmt *s) {
+          auto ptr = s->cast<GlobalPtrStmt>();
+          return ptr && ptr->snode->parent == snode;
+        });
+    std::unordered_set<Stmt *> element_ptrs(accesses.begin(), accesses.end());
+    for (auto s : accesses) {
+      auto ptr = s->as<GlobalPtrStmt>();
+      for (int u = 0; u < (int)ptr->indices.size(); u++) {
+        const int offset =
+            u < (int)stmt->index_offsets.size() ? stmt->index_offsets[u] : 0;
+        auto diff = irpass::analysis::value_diff_loop_index(
+            ptr->indices[u], stmt, snode->physical_index_position[u]);
+        TI_ERROR_IF(!diff.linear_related() || !diff.certain() ||
+                        diff.low != offset,
+                    "A bit-vectorized struct-for can only access the quant "
+                    "array it loops over at the loop indices{}",
+                    ptr->get_tb());
+      }
+    }
+    auto element_uses = irpass::analysis::gather_statements(
+        stmt->body.get(), [&](Stmt *s) {
+          for (auto op : s->get_operands()) {
+            if (element_ptrs.count(op)) {
+              return true;
+            }
+          }
+          return false;
+        });
+    bool has_stores = false;
+    for (auto s : element_uses) {
+      if (s->is<GlobalStoreStmt>() || s->is<AtomicOpStmt>()) {
+        has_stores = true;
+      } else if (!s->is<GlobalLoadStmt>()) {
+        TI_ERROR(
+            "A bit-vectorized struct-for can only load, store or atomically "
+            "update the elements of the quant array it loops over{}",
+            s->get_tb());
+      }
+    }
+    auto old_indices = irpass::analysis::gather_statements(
+        stmt->body.get(), [&](Stmt *s) {
+          auto index = s->cast<LoopIndexStmt>();
+          return index && index->loop == stmt && index->index == axis;
+        });
+    std::unordered_set<Stmt *> lane_axis_indices(old_indices.begin(),
+                                                 old_indices.end());
+
+    DataType physical_type(snode->physical_type);
+    DataType word_type =
+        physical_bits <= 32 ? PrimitiveType::u32 : PrimitiveType::u64;
+    const uint64 mask = element_bits >= 64
+                            ? ~uint64(0)
+                            : (uint64(1) << element_bits) - 1;
+
+    auto body = std::move(stmt->body->statements);
+    stmt->body->statements.clear();
+    IRBuilder builder;
+    builder.set_insertion_point({stmt->body.get(), 0});
+
+    // The word of the elements of this iteration, whose first element is at
+    // the loop index.
+    std::vector<Stmt *> word_indices;
+    Stmt *first_element = nullptr;
+    for (int u = 0; u < snode->num_active_indices; u++) {
+      const int index = snode->physical_index_position[u];
+      Stmt *loop_index = builder.get_loop_index(stmt, index);
+      if (index == axis) {
+        first_element = loop_index;
+      }
+      if (u < (int)stmt->index_offsets.size() && stmt->index_offsets[u] != 0) {
+        loop_index = builder.create_add(
+            loop_index, builder.get_int32(stmt->index_offsets[u]));
+      }
+      word_indices.push_back(loop_index);
+    }
+    auto word_ptr = builder.create_global_ptr(snode->ch[0].get(), word_indices);
+    word_ptr->activate = false;
+    word_ptr->is_bit_vectorized = true;
+    word_ptr->ret_type = DataType(
+        TypeFactory::get_instance().get_pointer_type(snode->physical_type));
+    auto word = builder.create_local_var(word_type);
+    builder.create_local_store(
+        word, builder.create_cast(builder.create_global_load(word_ptr),
+                                  word_type));
+
+    auto lanes = builder.create_range_for(builder.get_int32(0),
+                                          builder.get_int32(num_lanes),
+                                          /*is_bit_vectorized=*/false,
+                                          /*num_cpu_threads=*/1,
+                                          /*block_dim=*/1,
+                                          /*strictly_serialized=*/false);
+    Stmt *shift = nullptr;
+    Stmt *element_index = nullptr;
+    {
+      auto _ = builder.get_loop_guard(lanes);
+      auto lane = builder.get_loop_index(lanes, 0);
+      element_index = builder.create_add(first_element, lane);
+      shift = builder.create_mul(builder.create_cast(lane, word_type),
+                                 builder.get_constant(word_type, element_bits));
+    }
+    if (has_stores) {
+      builder.set_insertion_point_to_after(lanes);
+      builder.create_global_store(
+          word_ptr,
+          builder.create_cast(builder.create_local_load(word), physical_type));
+    }
+    for (auto &s : body) {
+      lanes->body->insert(std::move(s));
+    }
+    irpass::replace_statements(
+        lanes->body.get(),
+        [&](Stmt *s) { return lane_axis_indices.count(s) > 0; },
+        [&](Stmt *) { return element_index; });
+
+    auto element_type = qat->get_element_type();
+    auto decode = [&]() -> Stmt * {
+      Stmt *digits = builder.create_and(
+          builder.create_shr(builder.create_local_load(word), shift),
+          builder.get_constant(word_type, mask));
+      auto qit = element_type->cast<QuantIntType>();
+      auto qfxt = element_type->cast<QuantFixedType>();
+      if (qfxt) {
+        qit = qfxt->get_digits_type()->as<QuantIntType>();
+      }
+      if (qit->get_is_signed()) {
+        // Sign-extend the digits: (d ^ s) - s, with s the sign bit.
+        auto sign = builder.get_constant(word_type,
+                                         uint64(1) << (element_bits - 1));
+        digits = builder.create_sub(builder.create_xor(digits, sign), sign);
+      }
+      digits = builder.create_cast(digits, qit->get_compute_type());
+      if (!qfxt) {
+        return digits;
+      }
+      DataType compute_type = qfxt->get_compute_type();
+      return builder.create_mul(
+          builder.create_cast(digits, compute_type),
+          builder.get_constant(compute_type, qfxt->get_scale()));
+    };
+    auto encode = [&](Stmt *value) {
+      Stmt *digits = nullptr;
+      if (auto qfxt = element_type->cast<QuantFixedType>()) {
+        DataType compute_type = qfxt->get_compute_type();
+        auto scaled = builder.create_mul(
+            builder.create_cast(value, compute_type),
+            builder.get_constant(compute_type, 1.0 / qfxt->get_scale()));
+        // Round half away from zero, as the scalar stores do.
+        auto half = builder.create_select(
+            builder.create_cmp_lt(scaled,
+                                  builder.get_constant(compute_type, 0.0)),
+            builder.get_constant(compute_type, -0.5),
+            builder.get_constant(compute_type, 0.5));
+        digits = builder.create_cast(
+            builder.create_add(scaled, half),
+            qfxt->get_digits_type()->get_compute_type());
+      } else {
+        digits = builder.create_cast(value, element_type->get_compute_type());
+      }
+      auto element_mask = builder.get_constant(word_type, mask);
+      digits = builder.create_and(builder.create_cast(digits, word_type),
+                                  element_mask);
+      auto others = builder.create_and(
+          builder.create_local_load(word),
+          builder.create_not(builder.create_shl(element_mask, shift)));
+      builder.create_local_store(
+          word, builder.create_or(others, builder.create_shl(digits, shift)));
+    };
+
+    for (auto s : element_uses) {
+      builder.set_insertion_point_to_before(s);
+      if (auto load = s->cast<GlobalLoadStmt>()) {
+        load->replace_usages_with(decode());
+      } else if (auto store = s->cast<GlobalStoreStmt>()) {
+        encode(store->val);
+      } else {
+        auto atomic = s->as<AtomicOpStmt>();
+        auto old_value = decode();
+        auto operand =
+            builder.create_cast(atomic->val, element_type->get_compute_type());
+        auto new_value = builder.insert(Stmt::make_typed<BinaryOpStmt>(
+            atomic_to_binary_op_type(atomic->op_type), old_value, operand));
+        encode(new_value);
+        atomic->replace_usages_with(old_value);
+      }
+      s->parent->erase(s);
+    }
+    // Quant arrays live in dense nodes, so the element pointers left without
+    // uses can be removed.
+    for (auto s : accesses) {
+      s->as<GlobalPtrStmt>()->activate = false;
+    }
+  }
+
   void transform_atomic_add(const std::vector<Stmt *> &buffer_vec,
                             AtomicOpStmt *stmt,
                             DataType &dt) {
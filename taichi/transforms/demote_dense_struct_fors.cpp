@@ -111,9 +111,18 @@ void convert_to_range_for(OffloadedStmt *offloaded) {
   offloaded->task_type = TaskType::range_for;
 }
 
+// Bit-vectorized loops over quant arrays of multi-bit elements run their body
+// once per word (see bit_loop_vectorize), a range-for would run it once per
+// element.
+bool iterates_over_words(OffloadedStmt *stmt) {
+  return stmt->is_bit_vectorized &&
+         stmt->snode->type == SNodeType::quant_array &&
+         stmt->snode->dt->as<QuantArrayType>()->get_element_num_bits() > 1;
+}
+
 void maybe_convert(OffloadedStmt *stmt) {
   if ((stmt->task_type == TaskType::struct_for) &&
-      stmt->snode->is_path_all_dense) {
+      stmt->snode->is_path_all_dense && !iterates_over_words(stmt)) {
     convert_to_range_for(stmt);
   }
 }
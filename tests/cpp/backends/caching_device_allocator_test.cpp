@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <map>
+
+#include "taichi/rhi/common/caching_device_allocator.h"
+
+namespace taichi::lang {
+
+namespace {
+
+// Counts the blocks taken from and returned to the backend.
+struct FakeBackend {
+  std::map<void *, std::size_t> live;
+  int num_allocations{0};
+
+  CachingDeviceAllocator make_allocator(std::size_t max_cached_bytes) {
+    return CachingDeviceAllocator(
+        [this](std::size_t size) {
+          void *ptr = std::malloc(size);
+          live[ptr] = size;
+          num_allocations++;
+          return ptr;
+        },
+        [this](void *ptr, std::size_t size) {
+          EXPECT_EQ(live.at(ptr), size);
+          live.erase(ptr);
+          std::free(ptr);
+        },
+        /*granularity=*/4096, max_cached_bytes);
+  }
+};
+
+}  // namespace
+
+TEST(CachingDeviceAllocator, RoundSize) {
+  FakeBackend backend;
+  auto allocator = backend.make_allocator(1 << 30);
+  EXPECT_EQ(allocator.round_size(1), 4096);
+  EXPECT_EQ(allocator.round_size(4096), 4096);
+  EXPECT_EQ(allocator.round_size(4097), 8192);
+  EXPECT_EQ(allocator.round_size(20000), 20480);
+  EXPECT_EQ(allocator.round_size(1 << 20), 1 << 20);
+  EXPECT_EQ(allocator.round_size((1 << 20) + 1), 5 << 18);
+  EXPECT_EQ(allocator.round_size((7 << 18) + 1), 2 << 20);
+}
+
+TEST(CachingDeviceAllocator, RecycleSameSizeClass) {
+  FakeBackend backend;
+  {
+    auto allocator = backend.make_allocator(1 << 30);
+    bool recycled = true;
+    void *a = allocator.allocate(3 << 20, &recycled);
+    EXPECT_FALSE(recycled);
+    allocator.release(3 << 20, a);
+    EXPECT_EQ(allocator.get_stats().cached_bytes, 3 << 20);
+
+    // Another size class goes to the backend.
+    void *b = allocator.allocate(5 << 20);
+    EXPECT_NE(a, b);
+    // The same size class reuses the block, without the backend.
+    EXPECT_EQ(allocator.allocate((3 << 20) - 100, &recycled), a);
+    EXPECT_TRUE(recycled);
+    EXPECT_EQ(backend.num_allocations, 2);
+
+    auto stats = allocator.get_stats();
+    EXPECT_EQ(stats.num_hits, 1);
+    EXPECT_EQ(stats.num_misses, 2);
+    EXPECT_EQ(stats.num_cached_blocks, 0);
+    allocator.release(5 << 20, b);
+    allocator.release(3 << 20, a);
+    EXPECT_EQ(backend.live.size(), 2);
+  }
+  // The cached blocks are returned once the allocator is gone.
+  EXPECT_TRUE(backend.live.empty());
+}
+
+TEST(CachingDeviceAllocator, TrimLargestBlocksFirst) {
+  FakeBackend backend;
+  auto allocator = backend.make_allocator(8 << 20);
+  void *small = allocator.allocate(1 << 20);
+  void *large = allocator.allocate(6 << 20);
+  void *huge = allocator.allocate(16 << 20);
+  allocator.release(1 << 20, small);
+  allocator.release(6 << 20, large);
+  // Above the limit, returned immediately.
+  allocator.release(16 << 20, huge);
+  EXPECT_EQ(backend.live.size(), 2);
+  EXPECT_EQ(allocator.get_stats().cached_bytes, 7 << 20);
+
+  void *other = allocator.allocate(2 << 20);
+  allocator.release(2 << 20, other);
+  EXPECT_EQ(backend.live.count(large), 0);
+  EXPECT_EQ(allocator.get_stats().cached_bytes, 3 << 20);
+
+  allocator.set_max_cached_bytes(0);
+  EXPECT_TRUE(backend.live.empty());
+  EXPECT_EQ(allocator.get_stats().num_cached_blocks, 0);
+}
+
+}  // namespace taichi::lang
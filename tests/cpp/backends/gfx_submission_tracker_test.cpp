@@ -0,0 +1,275 @@
+#include "gtest/gtest.h"
+
+#if defined(TI_WITH_OPENGL) || defined(TI_WITH_VULKAN)
+#include "taichi/runtime/gfx/submission_tracker.h"
+
+namespace taichi::lang {
+namespace gfx {
+
+namespace {
+
+StreamSemaphore make_sema() {
+  return std::make_shared<StreamSemaphoreObject>();
+}
+
+// Only records the copies.
+class MockCommandList : public CommandList {
+ public:
+  void bind_pipeline(Pipeline *p) noexcept override {
+  }
+  RhiResult bind_shader_resources(ShaderResourceSet *res,
+                                  int set_index) noexcept override {
+    return RhiResult::not_supported;
+  }
+  RhiResult bind_raster_resources(RasterResources *res) noexcept override {
+    return RhiResult::not_supported;
+  }
+  void buffer_barrier(DevicePtr ptr, size_t size) noexcept override {
+  }
+  void buffer_barrier(DeviceAllocation alloc) noexcept override {
+  }
+  void memory_barrier() noexcept override {
+  }
+  void buffer_copy(DevicePtr dst,
+                   DevicePtr src,
+                   size_t size) noexcept override {
+    num_copies++;
+  }
+  void buffer_fill(DevicePtr ptr,
+                   size_t size,
+                   uint32_t data) noexcept override {
+  }
+  RhiResult dispatch(uint32_t x, uint32_t y, uint32_t z) noexcept override {
+    return RhiResult::not_supported;
+  }
+
+  int num_copies{0};
+};
+
+// Hands out a semaphore per submission and records what the host waits for.
+class MockStream : public Stream {
+ public:
+  RhiResult new_command_list(CommandList **out_cmdlist) noexcept override {
+    *out_cmdlist = new MockCommandList();
+    return RhiResult::success;
+  }
+  StreamSemaphore submit(
+      CommandList *cmdlist,
+      const std::vector<StreamSemaphore> &wait_semaphores) override {
+    if (cmdlist) {
+      num_copies += static_cast<MockCommandList *>(cmdlist)->num_copies;
+    }
+    submitted.push_back(make_sema());
+    return submitted.back();
+  }
+  StreamSemaphore submit_synced(
+      CommandList *cmdlist,
+      const std::vector<StreamSemaphore> &wait_semaphores) override {
+    num_full_syncs++;
+    return make_sema();
+  }
+  void command_sync() override {
+    num_full_syncs++;
+  }
+  void wait_semaphores(
+      const std::vector<StreamSemaphore> &semaphores) override {
+    waited.insert(waited.end(), semaphores.begin(), semaphores.end());
+  }
+
+  std::vector<StreamSemaphore> submitted;
+  std::vector<StreamSemaphore> waited;
+  int num_copies{0};
+  int num_full_syncs{0};
+};
+
+class MockDevice : public Device {
+ public:
+  RhiResult allocate_memory(const AllocParams &params,
+                            DeviceAllocation *out_devalloc) override {
+    return RhiResult::not_supported;
+  }
+  void dealloc_memory(DeviceAllocation handle) override {
+  }
+  RhiResult create_pipeline(Pipeline **out_pipeline,
+                            const PipelineSourceDesc &src,
+                            std::string name,
+                            PipelineCache *cache) noexcept override {
+    return RhiResult::not_supported;
+  }
+  Stream *get_compute_stream() override {
+    return &stream;
+  }
+  void wait_idle() override {
+    stream.num_full_syncs++;
+  }
+  ShaderResourceSet *create_resource_set() override {
+    return nullptr;
+  }
+  RhiResult map_range(DevicePtr ptr,
+                      uint64_t size,
+                      void **mapped_ptr) override {
+    return RhiResult::not_supported;
+  }
+  RhiResult map(DeviceAllocation alloc, void **mapped_ptr) override {
+    return RhiResult::not_supported;
+  }
+  void unmap(DevicePtr ptr) override {
+  }
+  void unmap(DeviceAllocation alloc) override {
+  }
+  void memcpy_internal(DevicePtr dst, DevicePtr src, uint64_t size) override {
+  }
+  Arch arch() const override {
+    return Arch::vulkan;
+  }
+
+  MockStream stream;
+};
+
+}  // namespace
+
+TEST(SubmissionTrackerTest, ReadbackWaitsOnlyForWriter) {
+  SubmissionTracker tracker;
+  const DeviceAllocationId a = 1, b = 2;
+
+  tracker.record_access(a, /*write=*/true);
+  EXPECT_TRUE(tracker.has_pending_access(a, /*write_only=*/true));
+  EXPECT_FALSE(tracker.has_pending_access(b, /*write_only=*/false));
+  auto sema_a = make_sema();
+  tracker.on_submit(sema_a);
+  EXPECT_FALSE(tracker.has_pending_access(a, /*write_only=*/false));
+
+  tracker.record_access(b, /*write=*/true);
+  tracker.record_access(a, /*write=*/false);
+  auto sema_b = make_sema();
+  tracker.on_submit(sema_b);
+
+  // Reading |a| only depends on the submission that wrote it.
+  auto deps = tracker.get_dependencies({a}, /*host_write=*/false);
+  ASSERT_EQ(deps.size(), 1);
+  EXPECT_EQ(deps[0], sema_a);
+  // Overwriting |a| also has to wait for the submission reading it.
+  deps = tracker.get_dependencies({a}, /*host_write=*/true);
+  EXPECT_EQ(deps.size(), 2);
+
+  deps = tracker.get_dependencies({b}, /*host_write=*/false);
+  ASSERT_EQ(deps.size(), 1);
+  EXPECT_EQ(deps[0], sema_b);
+
+  tracker.retire({a}, /*host_write=*/false);
+  EXPECT_TRUE(tracker.get_dependencies({a}, /*host_write=*/false).empty());
+  EXPECT_EQ(tracker.get_dependencies({a}, /*host_write=*/true).size(), 1);
+
+  EXPECT_FALSE(tracker.requires_full_sync());
+  tracker.retire_all();
+  EXPECT_EQ(tracker.num_tracked_allocations(), 0);
+}
+
+TEST(SubmissionTrackerTest, NewerWriteSupersedes) {
+  SubmissionTracker tracker;
+  const DeviceAllocationId a = 1;
+
+  tracker.record_access(a, /*write=*/false);
+  tracker.on_submit(make_sema());
+  tracker.record_access(a, /*write=*/true);
+  auto sema = make_sema();
+  tracker.on_submit(sema);
+
+  auto deps = tracker.get_dependencies({a}, /*host_write=*/true);
+  ASSERT_EQ(deps.size(), 1);
+  EXPECT_EQ(deps[0], sema);
+}
+
+TEST(SubmissionTrackerTest, OnlyLastReaderIsKept) {
+  SubmissionTracker tracker;
+  const DeviceAllocationId a = 1;
+
+  StreamSemaphore sema;
+  for (int i = 0; i < 100; i++) {
+    tracker.record_access(a, /*write=*/false);
+    sema = make_sema();
+    tracker.on_submit(sema);
+  }
+  EXPECT_EQ(tracker.num_tracked_allocations(), 1);
+  auto deps = tracker.get_dependencies({a}, /*host_write=*/true);
+  ASSERT_EQ(deps.size(), 1);
+  EXPECT_EQ(deps[0], sema);
+}
+
+TEST(SubmissionTrackerTest, WaitOnMockDevice) {
+  SubmissionTracker tracker;
+  MockDevice device;
+  Stream *stream = device.get_compute_stream();
+  const DeviceAllocationId a = 1, b = 2;
+
+  // Readback of |a| after kernels writing |a| then |b|.
+  tracker.record_access(a, /*write=*/true);
+  auto sema_a = stream->submit(nullptr, {});
+  tracker.on_submit(sema_a);
+  tracker.record_access(b, /*write=*/true);
+  tracker.on_submit(stream->submit(nullptr, {}));
+
+  EXPECT_TRUE(tracker.wait_for(stream, {a}, /*host_write=*/false));
+  ASSERT_EQ(device.stream.waited.size(), 1);
+  EXPECT_EQ(device.stream.waited[0], sema_a);
+  EXPECT_EQ(device.stream.num_full_syncs, 0);
+
+  // |a| is retired, reading it again does not wait.
+  EXPECT_TRUE(tracker.wait_for(stream, {a}, /*host_write=*/false));
+  EXPECT_EQ(device.stream.waited.size(), 1);
+
+  // Untracked submissions require a device-wide sync.
+  tracker.record_access(a, /*write=*/true);
+  tracker.on_submit(nullptr);
+  EXPECT_FALSE(tracker.wait_for(stream, {a}, /*host_write=*/false));
+  EXPECT_EQ(device.stream.waited.size(), 1);
+}
+
+TEST(SubmissionTrackerTest, ReadbackSkipsUnrelatedSubmissions) {
+  SubmissionTracker tracker;
+  MockDevice device;
+  Stream *stream = device.get_compute_stream();
+  const DeviceAllocationId a = 1, b = 2;
+  DeviceAllocation staging, alloc_a;
+  staging.device = alloc_a.device = &device;
+  alloc_a.alloc_id = a;
+
+  tracker.record_access(a, /*write=*/true);
+  auto sema_a = stream->submit(nullptr, {});
+  tracker.on_submit(sema_a);
+  // Still in flight while |a| is read back.
+  tracker.record_access(b, /*write=*/true);
+  auto sema_b = stream->submit(nullptr, {});
+  tracker.on_submit(sema_b);
+
+  // As Ndarray::read() does on the gfx backends.
+  EXPECT_TRUE(tracker.wait_for(stream, {a}, /*host_write=*/false));
+  copy_and_wait(stream, staging.get_ptr(), alloc_a.get_ptr(), 4);
+
+  EXPECT_EQ(device.stream.num_copies, 1);
+  ASSERT_EQ(device.stream.waited.size(), 2);
+  EXPECT_EQ(device.stream.waited[0], sema_a);
+  // The copy's own submission.
+  EXPECT_EQ(device.stream.waited[1], device.stream.submitted.back());
+  EXPECT_NE(device.stream.waited[1], sema_b);
+  EXPECT_EQ(device.stream.num_full_syncs, 0);
+}
+
+TEST(SubmissionTrackerTest, UntrackedSubmission) {
+  SubmissionTracker tracker;
+  tracker.record_access(1, /*write=*/true);
+  tracker.on_submit(nullptr);
+  EXPECT_TRUE(tracker.requires_full_sync());
+  tracker.retire_all();
+  EXPECT_FALSE(tracker.requires_full_sync());
+
+  // Command lists the host waited for leave nothing behind.
+  tracker.record_access(1, /*write=*/true);
+  tracker.on_complete();
+  EXPECT_FALSE(tracker.has_pending_access(1, /*write_only=*/false));
+  EXPECT_EQ(tracker.num_tracked_allocations(), 0);
+}
+
+}  // namespace gfx
+}  // namespace taichi::lang
+#endif
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "taichi/rhi/common/host_memory_pool.h"
+
+namespace taichi::lang {
+
+TEST(HostMemoryPool, SharedAllocationsDoNotOverlap) {
+  HostMemoryPool pool;
+  auto *a = (char *)pool.allocate(64, 16);
+  auto *b = (char *)pool.allocate(64, 16);
+  EXPECT_TRUE(a + 64 <= b || b + 64 <= a);
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.num_chunks, 1);
+  EXPECT_EQ(stats.used_bytes, 128);
+}
+
+TEST(HostMemoryPool, ReuseSharedAllocations) {
+  HostMemoryPool pool;
+  void *small = pool.allocate(100, 16);
+  pool.release(100, small, /*exclusive=*/false);
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.num_binned_blocks, 1);
+  EXPECT_EQ(stats.binned_bytes, 112);
+  EXPECT_EQ(stats.used_bytes, 0);
+  // 100 and 112 bytes are in the same size class.
+  EXPECT_EQ(pool.allocate(112, 16), small);
+  EXPECT_NE(pool.allocate(100, 16), small);
+
+  // Larger allocations are reused at the same size.
+  const std::size_t large = (3 << 20) + 5;
+  void *a = pool.allocate(large, 64);
+  pool.release(large, a, /*exclusive=*/false);
+  EXPECT_NE(pool.allocate(large + 1, 64), a);
+  EXPECT_EQ(pool.allocate(large, 64), a);
+  stats = pool.get_stats();
+  EXPECT_EQ(stats.num_binned_blocks, 0);
+  EXPECT_EQ(stats.binned_bytes, 0);
+
+  // The alignment of a reused allocation is checked.
+  auto *b = (char *)pool.allocate(32, 32);
+  auto *c = (char *)pool.allocate(32, 32);
+  EXPECT_EQ((std::size_t)b % 32, 0);
+  pool.release(32, b + 16, /*exclusive=*/false);
+  EXPECT_NE(pool.allocate(32, 32), b + 16);
+  pool.release(32, c, /*exclusive=*/false);
+  EXPECT_EQ(pool.allocate(32, 32), c);
+}
+
+TEST(HostMemoryPool, ReleaseExclusiveAllocations) {
+  HostMemoryPool pool;
+  void *a = pool.allocate(1 << 16, HostMemoryPool::page_size, true);
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.num_exclusive_chunks, 1);
+  EXPECT_EQ(stats.reserved_bytes, 1 << 16);
+  EXPECT_EQ(stats.used_bytes, 1 << 16);
+  pool.release(1 << 16, a);
+  stats = pool.get_stats();
+  EXPECT_EQ(stats.num_chunks, 0);
+  EXPECT_EQ(stats.reserved_bytes, 0);
+}
+
+TEST(HostMemoryPool, ThreadCaches) {
+  auto &pool = HostMemoryPool::get_instance();
+  pool.reset();
+  void *a = pool.allocate(1000, 8);
+  pool.release(1000, a, /*exclusive=*/false);
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.thread_cached_bytes, 1024);
+  EXPECT_EQ(stats.binned_bytes, 0);
+  EXPECT_EQ(pool.allocate(1000, 8), a);
+
+  // The allocations cached by a thread are returned to the pool when it
+  // exits.
+  void *b = nullptr;
+  std::thread([&] {
+    b = pool.allocate(1000, 8);
+    pool.release(1000, b, /*exclusive=*/false);
+  }).join();
+  EXPECT_NE(a, b);
+  stats = pool.get_stats();
+  EXPECT_EQ(stats.thread_cached_bytes, 0);
+  EXPECT_EQ(stats.binned_bytes, 1024);
+  EXPECT_EQ(pool.allocate(1000, 8), b);
+
+  // reset() drops the caches.
+  void *c = pool.allocate(2000, 8);
+  pool.release(2000, c, /*exclusive=*/false);
+  pool.reset();
+  EXPECT_EQ(pool.get_stats().thread_cached_bytes, 0);
+  EXPECT_EQ(pool.get_stats().reserved_bytes, 0);
+}
+
+#if defined(__linux__)
+TEST(HostMemoryPool, HugePages) {
+  HostMemoryPool pool;
+  pool.set_huge_pages(HostMemoryPool::HugePages::kTransparent, 4 << 20);
+  auto *small = (char *)pool.allocate(1 << 20, HostMemoryPool::page_size, true);
+  auto *large = (char *)pool.allocate(5 << 20, HostMemoryPool::page_size, true);
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.huge_page_bytes, 5 << 20);
+  EXPECT_LE(stats.huge_page_backed_bytes, stats.huge_page_bytes);
+  EXPECT_EQ((std::size_t)large % (2 << 20), 0);
+  std::fill(small, small + (1 << 20), 1);
+  std::fill(large, large + (5 << 20), 1);
+  pool.release(5 << 20, large);
+  EXPECT_EQ(pool.get_stats().huge_page_bytes, 0);
+
+  // Falls back to transparent huge pages if none are reserved.
+  pool.set_huge_pages(HostMemoryPool::HugePages::kExplicit2M, 4 << 20);
+  large = (char *)pool.allocate(5 << 20, HostMemoryPool::page_size, true);
+  std::fill(large, large + (5 << 20), 1);
+  EXPECT_GE(pool.get_stats().huge_page_bytes, 5 << 20);
+  pool.release(5 << 20, large);
+  pool.release(1 << 20, small);
+  EXPECT_EQ(pool.get_stats().reserved_bytes, 0);
+}
+#endif
+
+}  // namespace taichi::lang
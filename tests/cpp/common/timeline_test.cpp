@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "taichi/system/timeline.h"
+
+namespace taichi {
+
+namespace {
+
+void record_scopes(int n) {
+  for (int i = 0; i < n; i++) {
+    TI_AUTO_TIMELINE;
+  }
+}
+
+}  // namespace
+
+TEST(Timeline, Guards) {
+  auto &timelines = Timelines::get_instance();
+  auto &timeline = Timeline::get_this_thread_instance();
+  timeline.set_name("timeline_test");
+  timeline.clear();
+  timelines.set_enabled(true);
+  const float64 begin_time = Time::get_time();
+  // More events than the ring holds.
+  const int kScopes = 5000;
+  record_scopes(kScopes);
+  {
+    TI_TIMELINE(std::string("named"));
+  }
+  timeline.insert_event({"explicit", true, 1.5, ""});
+  timeline.insert_event({"gpu", true, 2.5, "cuda"});
+  timelines.set_enabled(false);
+  record_scopes(1);
+  const float64 end_time = Time::get_time();
+
+  auto events = timeline.fetch_events();
+  ASSERT_EQ(events.size(), 2 * kScopes + 4);
+  for (int i = 0; i < 2 * kScopes; i++) {
+    EXPECT_EQ(events[i].name, "record_scopes");
+    EXPECT_EQ(events[i].begin, i % 2 == 0);
+    EXPECT_EQ(events[i].tid, "timeline_test");
+    // The ticks are converted to seconds within the rounding of the clock.
+    EXPECT_GE(events[i].time, begin_time - 1e-3);
+    EXPECT_LE(events[i].time, end_time + 1e-3);
+    if (i > 0) {
+      EXPECT_GE(events[i].time, events[i - 1].time);
+    }
+  }
+  EXPECT_EQ(events[2 * kScopes].name, "named");
+  EXPECT_EQ(events[2 * kScopes + 1].name, "named");
+  EXPECT_FALSE(events[2 * kScopes + 1].begin);
+  EXPECT_EQ(events[2 * kScopes + 2].name, "explicit");
+  EXPECT_EQ(events[2 * kScopes + 2].time, 1.5);
+  EXPECT_EQ(events[2 * kScopes + 2].tid, "timeline_test");
+  // Events of other lanes keep their tid.
+  EXPECT_EQ(events[2 * kScopes + 3].tid, "cuda");
+  EXPECT_TRUE(timeline.fetch_events().empty());
+}
+
+TEST(Timeline, FetchWhileRecording) {
+  auto &timelines = Timelines::get_instance();
+  timelines.set_enabled(true);
+  const int kScopes = 20000;
+  std::atomic<Timeline *> worker_timeline{nullptr};
+  std::atomic<bool> recorded{false}, fetched{false};
+  std::thread worker([&]() {
+    worker_timeline = &Timeline::get_this_thread_instance();
+    record_scopes(kScopes);
+    recorded = true;
+    // Keeps the timeline of the thread alive until it is fetched.
+    while (!fetched) {
+      std::this_thread::yield();
+    }
+  });
+  while (!worker_timeline) {
+    std::this_thread::yield();
+  }
+  std::vector<TimelineEvent> events;
+  while (true) {
+    const bool done = recorded;
+    auto fetched_events = worker_timeline.load()->fetch_events();
+    events.insert(events.end(), fetched_events.begin(), fetched_events.end());
+    if (done) {
+      break;
+    }
+  }
+  fetched = true;
+  worker.join();
+  timelines.set_enabled(false);
+
+  ASSERT_EQ(events.size(), 2 * kScopes);
+  for (int i = 0; i < 2 * kScopes; i++) {
+    EXPECT_EQ(events[i].begin, i % 2 == 0);
+  }
+}
+
+}  // namespace taichi
@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "taichi/ir/mesh_reorder.h"
+
+namespace taichi::lang {
+namespace mesh {
+
+namespace {
+
+// A 2D grid graph of |n| x |n| nodes, labeled in a scrambled order.
+void scrambled_grid(int n,
+                    std::vector<int> &offsets,
+                    std::vector<int> &neighbors) {
+  const int size = n * n;
+  auto label = [&](int i, int j) { return (i * n + j) * 37 % size; };
+  std::vector<std::vector<int>> adjacency(size);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (i + 1 < n) {
+        adjacency[label(i, j)].push_back(label(i + 1, j));
+        adjacency[label(i + 1, j)].push_back(label(i, j));
+      }
+      if (j + 1 < n) {
+        adjacency[label(i, j)].push_back(label(i, j + 1));
+        adjacency[label(i, j + 1)].push_back(label(i, j));
+      }
+    }
+  }
+  offsets.assign(1, 0);
+  neighbors.clear();
+  for (auto &row : adjacency) {
+    neighbors.insert(neighbors.end(), row.begin(), row.end());
+    offsets.push_back((int)neighbors.size());
+  }
+}
+
+int bandwidth(const std::vector<int> &offsets,
+              const std::vector<int> &neighbors,
+              const std::vector<int> &order) {
+  std::vector<int> position(order.size());
+  for (int i = 0; i < (int)order.size(); i++) {
+    position[order[i]] = i;
+  }
+  int result = 0;
+  for (int u = 0; u + 1 < (int)offsets.size(); u++) {
+    for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+      result = std::max(result, std::abs(position[u] - position[neighbors[e]]));
+    }
+  }
+  return result;
+}
+
+bool is_permutation(std::vector<int> order) {
+  std::sort(order.begin(), order.end());
+  for (int i = 0; i < (int)order.size(); i++) {
+    if (order[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(MeshReorder, ReverseCuthillMckee) {
+  std::vector<int> offsets, neighbors;
+  scrambled_grid(20, offsets, neighbors);
+  std::vector<int> identity(20 * 20);
+  for (int i = 0; i < (int)identity.size(); i++) {
+    identity[i] = i;
+  }
+  auto order = reverse_cuthill_mckee(offsets, neighbors);
+  EXPECT_TRUE(is_permutation(order));
+  EXPECT_LE(bandwidth(offsets, neighbors, order), 21);
+  EXPECT_GT(bandwidth(offsets, neighbors, identity), 100);
+}
+
+TEST(MeshReorder, SpaceFillingCurves) {
+  // Points on a line, given backwards.
+  std::vector<float64> points;
+  for (int i = 0; i < 16; i++) {
+    points.insert(points.end(), {float64(15 - i), 0.5 * (15 - i), 0.0});
+  }
+  for (const auto &order : {morton_order(points), hilbert_order(points)}) {
+    ASSERT_TRUE(is_permutation(order));
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(order[i], 15 - i);
+    }
+  }
+}
+
+TEST(MeshReorder, PartitionPatches) {
+  std::vector<int> offsets, neighbors;
+  scrambled_grid(16, offsets, neighbors);
+  auto order = reverse_cuthill_mckee(offsets, neighbors);
+  std::vector<std::vector<int>> patch_nodes;
+  auto patch = partition_patches(offsets, neighbors, order, 32, patch_nodes);
+  int num_nodes = 0;
+  for (int p = 0; p < (int)patch_nodes.size(); p++) {
+    EXPECT_LE(patch_nodes[p].size(), 32);
+    for (int u : patch_nodes[p]) {
+      EXPECT_EQ(patch[u], p);
+    }
+    num_nodes += (int)patch_nodes[p].size();
+  }
+  EXPECT_EQ(num_nodes, 16 * 16);
+  EXPECT_LE(patch_nodes.size(), 16);
+}
+
+TEST(MeshReorder, BuildMeshPatches) {
+  // Two strips of triangles over a 5 x 3 vertex grid.
+  std::vector<float64> positions;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 5; j++) {
+      positions.insert(positions.end(), {float64(j), float64(i), 0.0});
+    }
+  }
+  std::vector<int> cells;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 4; j++) {
+      const int v = i * 5 + j;
+      cells.insert(cells.end(), {v, v + 1, v + 6, v, v + 6, v + 5});
+    }
+  }
+  auto data = build_mesh_patches(
+      MeshTopology::Triangle, cells, positions, "hilbert",
+      /*max_cells_per_patch=*/4, {MeshRelationType::FV, MeshRelationType::VF});
+  EXPECT_GE(data.num_patches, 4);
+  ASSERT_EQ(data.elements.size(), 3);
+  ASSERT_EQ(data.relations.size(), 2);
+  const auto &verts = data.elements[0];
+  const auto &faces = data.elements[2];
+  EXPECT_EQ(verts.num, 15);
+  EXPECT_EQ(data.elements[1].num, 30);
+  EXPECT_EQ(faces.num, 16);
+
+  for (const auto &element : data.elements) {
+    EXPECT_EQ(element.owned_offsets.back(), element.num);
+    for (int p = 0; p < data.num_patches; p++) {
+      // Owned elements come first and are contiguous in the reordered space.
+      const uint32 num_owned =
+          element.owned_offsets[p + 1] - element.owned_offsets[p];
+      for (uint32 i = 0; i < num_owned; i++) {
+        EXPECT_EQ(element.l2r_mapping[element.total_offsets[p] + i],
+                  element.owned_offsets[p] + i);
+      }
+    }
+  }
+
+  // The local face-vertex relation maps back to the input cells.
+  const auto &fv = data.relations[1];
+  ASSERT_EQ(fv.from_order, 2);
+  ASSERT_EQ(fv.to_order, 0);
+  int num_faces = 0;
+  for (int p = 0; p < data.num_patches; p++) {
+    const uint32 num_owned =
+        faces.owned_offsets[p + 1] - faces.owned_offsets[p];
+    for (uint32 i = 0; i < num_owned; i++) {
+      const uint32 local = faces.total_offsets[p] + i;
+      const int face = faces.l2g_mapping[local];
+      for (int k = 0; k < 3; k++) {
+        const uint32 v = fv.value[local * 3 + k];
+        EXPECT_EQ(verts.l2g_mapping[verts.total_offsets[p] + v],
+                  cells[face * 3 + k]);
+      }
+      num_faces++;
+    }
+  }
+  EXPECT_EQ(num_faces, 16);
+}
+
+}  // namespace mesh
+}  // namespace taichi::lang
@@ -0,0 +1,147 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "tests/cpp/program/test_program.h"
+
+namespace taichi::lang {
+
+namespace {
+
+constexpr int kSize = 16;
+
+enum class Op { kAddOne, kTwice, kBroadcastFirst };
+
+// Builds `for i in range(kSize): dst[i] = op(src, i)`.
+std::unique_ptr<Kernel> make_kernel(Program *prog, Op op) {
+  IRBuilder builder;
+  auto *src = builder.create_ndarray_arg_load(/*arg_id=*/{0},
+                                              get_data_type<int>(), 1, 0);
+  auto *dst = builder.create_ndarray_arg_load(/*arg_id=*/{1},
+                                              get_data_type<int>(), 1, 0);
+  auto *loop =
+      builder.create_range_for(builder.get_int32(0), builder.get_int32(kSize));
+  {
+    auto _ = builder.get_loop_guard(loop);
+    auto *i = builder.get_loop_index(loop);
+    Stmt *val = nullptr;
+    if (op == Op::kBroadcastFirst) {
+      val = builder.create_global_load(
+          builder.create_external_ptr(src, {builder.get_int32(0)}));
+    } else {
+      val = builder.create_global_load(builder.create_external_ptr(src, {i}));
+      val = op == Op::kAddOne ? builder.create_add(val, builder.get_int32(1))
+                              : builder.create_mul(val, builder.get_int32(2));
+    }
+    builder.create_global_store(builder.create_external_ptr(dst, {i}), val);
+  }
+  auto ker = std::make_unique<Kernel>(*prog, builder.extract_ir(), "kernel");
+  ker->insert_ndarray_param(get_data_type<int>(), /*ndim=*/1);
+  ker->insert_ndarray_param(get_data_type<int>(), /*ndim=*/1);
+  ker->finalize_params();
+  ker->finalize_rets();
+  return ker;
+}
+
+void launch_lazily(Program *prog, Kernel &ker, Ndarray &src, Ndarray &dst) {
+  auto ctx = ker.make_launch_context();
+  ctx.set_arg_ndarray({0}, src);
+  ctx.set_arg_ndarray({1}, dst);
+  prog->launch_kernel_lazily(ker, ctx);
+}
+
+class KernelFusionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    default_compile_config.lazy_kernel_fusion = true;
+    test_prog_.setup();
+    prog_ = test_prog_.prog();
+    for (auto *arr : {&x_, &y_, &z_}) {
+      *arr = std::make_unique<Ndarray>(prog_, PrimitiveType::i32,
+                                       std::vector<int>{kSize});
+    }
+    for (int i = 0; i < kSize; i++) {
+      x_->write_int({i}, i);
+    }
+  }
+
+  void TearDown() override {
+    x_.reset();
+    y_.reset();
+    z_.reset();
+    default_compile_config.lazy_kernel_fusion = false;
+  }
+
+  TestProgram test_prog_;
+  Program *prog_{nullptr};
+  std::unique_ptr<Ndarray> x_, y_, z_;
+};
+
+}  // namespace
+
+TEST_F(KernelFusionTest, FuseElementwiseKernels) {
+  auto add_one = make_kernel(prog_, Op::kAddOne);
+  auto twice = make_kernel(prog_, Op::kTwice);
+  auto &queue = prog_->get_kernel_fusion_queue();
+
+  for (int iter = 0; iter < 2; iter++) {
+    launch_lazily(prog_, *add_one, *x_, *y_);
+    launch_lazily(prog_, *twice, *y_, *z_);
+    EXPECT_EQ(queue.num_pending_launches(), 2);
+    prog_->synchronize();
+    EXPECT_TRUE(queue.empty());
+    for (int i = 0; i < kSize; i++) {
+      EXPECT_EQ(y_->read_int({i}), i + 1);
+      EXPECT_EQ(z_->read_int({i}), (i + 1) * 2);
+    }
+  }
+  // The fused kernel is reused.
+  EXPECT_EQ(queue.num_fused_kernels(), 1);
+}
+
+TEST_F(KernelFusionTest, CrossIterationDependency) {
+  auto add_one = make_kernel(prog_, Op::kAddOne);
+  auto broadcast = make_kernel(prog_, Op::kBroadcastFirst);
+  auto &queue = prog_->get_kernel_fusion_queue();
+
+  launch_lazily(prog_, *add_one, *x_, *y_);
+  // Every iteration of |broadcast| reads y[0], which is written by iteration 0
+  // of |add_one|.
+  launch_lazily(prog_, *broadcast, *y_, *z_);
+  EXPECT_EQ(queue.num_pending_launches(), 1);
+  prog_->synchronize();
+  for (int i = 0; i < kSize; i++) {
+    EXPECT_EQ(z_->read_int({i}), 1);
+  }
+  EXPECT_EQ(queue.num_fused_kernels(), 0);
+}
+
+TEST_F(KernelFusionTest, IndependentReads) {
+  auto add_one = make_kernel(prog_, Op::kAddOne);
+  auto broadcast = make_kernel(prog_, Op::kBroadcastFirst);
+  auto &queue = prog_->get_kernel_fusion_queue();
+
+  // Both kernels only read |x_|.
+  launch_lazily(prog_, *add_one, *x_, *y_);
+  launch_lazily(prog_, *broadcast, *x_, *z_);
+  EXPECT_EQ(queue.num_pending_launches(), 2);
+  // Reading an ndarray flushes the pending launches.
+  EXPECT_EQ(z_->read_int({kSize - 1}), 0);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(y_->read_int({kSize - 1}), kSize);
+}
+
+TEST_F(KernelFusionTest, HostWriteAfterPendingLaunch) {
+  auto add_one = make_kernel(prog_, Op::kAddOne);
+  auto &queue = prog_->get_kernel_fusion_queue();
+
+  launch_lazily(prog_, *add_one, *x_, *y_);
+  EXPECT_EQ(queue.num_pending_launches(), 1);
+  // Writing an ndarray flushes the pending launches before the write.
+  y_->write_int({3}, 100);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(y_->read_int({3}), 100);
+  EXPECT_EQ(y_->read_int({4}), 5);
+}
+
+}  // namespace taichi::lang
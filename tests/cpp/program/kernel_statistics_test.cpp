@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+
+#include "taichi/program/kernel_statistics.h"
+
+namespace taichi::lang {
+
+TEST(KernelLatencyStatistics, Percentiles) {
+  KernelLatencyStatistics statistics("kernel");
+  EXPECT_EQ(statistics.percentile(0.5), 0);
+
+  // Log-uniform times from 1 us to 1 s.
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> exponent(-3, 3);
+  std::vector<double> times;
+  for (int i = 0; i < 100000; i++) {
+    times.push_back(std::pow(10.0, exponent(rng)));
+    statistics.insert_record(times.back());
+  }
+  std::sort(times.begin(), times.end());
+  EXPECT_EQ(statistics.counter, (int64)times.size());
+  EXPECT_EQ(statistics.min, times.front());
+  EXPECT_EQ(statistics.max, times.back());
+  for (double q : {0.0, 0.01, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+    const auto rank = std::max<std::size_t>(
+        1, (std::size_t)std::ceil(q * times.size()));
+    const double expected = times[rank - 1];
+    EXPECT_NEAR(statistics.percentile(q), expected, expected * 0.01) << q;
+  }
+
+  statistics.reset();
+  EXPECT_EQ(statistics.counter, 0);
+  statistics.insert_record(2.0);
+  EXPECT_EQ(statistics.percentile(0.999), 2.0);
+}
+
+TEST(KernelLatencyStatistics, Tail) {
+  KernelLatencyStatistics statistics("kernel");
+  for (int i = 0; i < 999; i++) {
+    statistics.insert_record(0.1);
+  }
+  statistics.insert_record(50.0);
+  EXPECT_NEAR(statistics.percentile(0.5), 0.1, 1e-3);
+  EXPECT_NEAR(statistics.percentile(0.999), 0.1, 1e-3);
+  EXPECT_EQ(statistics.percentile(1.0), 50.0);
+  // Times of less than a nanosecond and longer than the histogram.
+  statistics.insert_record(1e-8);
+  statistics.insert_record(1e12);
+  EXPECT_EQ(statistics.percentile(0.0), 1e-8);
+  EXPECT_EQ(statistics.percentile(1.0), 1e12);
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/type_factory.h"
+#include "taichi/system/timer.h"
+#include "tests/cpp/program/test_program.h"
+
+#ifdef TI_WITH_CUDA
+#include "taichi/platform/cuda/detect_cuda.h"
+#endif
+
+namespace taichi::lang {
+
+namespace {
+
+// Measures the host-side cost of launching empty kernels. Kernel bodies are
+// empty so that the timings only reflect |Kernel::make_launch_context|,
+// argument setting, |Program::launch_kernel| and |Program::synchronize|.
+//
+// These are benchmarks rather than unit tests, and are disabled by default.
+// Run them with --gtest_also_run_disabled_tests
+// --gtest_filter='*LaunchOverhead*'.
+constexpr int kWarmupIterations = 16;
+constexpr int kIterations = 1000;
+constexpr int kArgCounts[] = {0, 1, 4, 8};
+constexpr int kNdarraySize = 128;
+
+enum class LaunchArgKind { kScalar, kNdarray, kArgPack };
+
+struct LaunchTimings {
+  double make_launch_context{0.0};
+  double set_args{0.0};
+  double launch_kernel{0.0};
+  double synchronize{0.0};
+};
+
+std::unique_ptr<Kernel> make_empty_kernel(Program *prog,
+                                          LaunchArgKind kind,
+                                          int num_args) {
+  IRBuilder builder;
+  auto ker = std::make_unique<Kernel>(*prog, builder.extract_ir(),
+                                      fmt::format("launch_x{}", num_args));
+  if (kind == LaunchArgKind::kArgPack) {
+    if (num_args > 0) {
+      ker->insert_argpack_param_and_push("pack");
+      for (int i = 0; i < num_args; i++) {
+        ker->insert_scalar_param(get_data_type<int>());
+      }
+      ker->pop_argpack_stack();
+    }
+  } else {
+    for (int i = 0; i < num_args; i++) {
+      if (kind == LaunchArgKind::kScalar) {
+        ker->insert_scalar_param(get_data_type<int>());
+      } else {
+        ker->insert_ndarray_param(get_data_type<int>(), /*ndim=*/1);
+      }
+    }
+  }
+  ker->finalize_params();
+  ker->finalize_rets();
+  return ker;
+}
+
+LaunchTimings measure_launch_overhead(Program *prog,
+                                      LaunchArgKind kind,
+                                      int num_args) {
+  auto ker = make_empty_kernel(prog, kind, num_args);
+  const auto &compiled_kernel_data = prog->compile_kernel(
+      prog->compile_config(), prog->get_device_caps(), *ker);
+
+  std::vector<std::unique_ptr<Ndarray>> ndarrays;
+  ArgPack *argpack{nullptr};
+  if (kind == LaunchArgKind::kNdarray) {
+    for (int i = 0; i < num_args; i++) {
+      ndarrays.push_back(std::make_unique<Ndarray>(prog, PrimitiveType::i32,
+                                                   std::vector<int>{
+                                                       kNdarraySize}));
+    }
+  } else if (kind == LaunchArgKind::kArgPack && num_args > 0) {
+    std::vector<AbstractDictionaryMember> members;
+    for (int i = 0; i < num_args; i++) {
+      members.push_back({PrimitiveType::i32, fmt::format("m{}", i)});
+    }
+    argpack = prog->create_argpack(
+        DataType(TypeFactory::get_instance().get_argpack_type(members)));
+    for (int i = 0; i < num_args; i++) {
+      argpack->set_arg_int({i}, i);
+    }
+  }
+
+  LaunchTimings timings;
+  for (int iter = 0; iter < kWarmupIterations + kIterations; iter++) {
+    const bool record = iter >= kWarmupIterations;
+    double t0 = Time::get_time();
+    auto launch_ctx = ker->make_launch_context();
+    double t1 = Time::get_time();
+    if (kind == LaunchArgKind::kScalar) {
+      for (int i = 0; i < num_args; i++) {
+        launch_ctx.set_arg_int({i}, i);
+      }
+    } else if (kind == LaunchArgKind::kNdarray) {
+      for (int i = 0; i < num_args; i++) {
+        launch_ctx.set_arg_ndarray({i}, *ndarrays[i]);
+      }
+    } else if (argpack) {
+      launch_ctx.set_arg_argpack({0}, *argpack);
+    }
+    double t2 = Time::get_time();
+    prog->launch_kernel(compiled_kernel_data, launch_ctx);
+    double t3 = Time::get_time();
+    prog->synchronize();
+    double t4 = Time::get_time();
+    if (record) {
+      timings.make_launch_context += t1 - t0;
+      timings.set_args += t2 - t1;
+      timings.launch_kernel += t3 - t2;
+      timings.synchronize += t4 - t3;
+    }
+  }
+  if (argpack) {
+    prog->delete_argpack(argpack);
+  }
+  return timings;
+}
+
+void run_launch_overhead_benchmark(Arch arch) {
+  TestProgram test_prog;
+  test_prog.setup(arch);
+  auto *prog = test_prog.prog();
+
+  const std::pair<LaunchArgKind, std::string> kinds[] = {
+      {LaunchArgKind::kScalar, "scalar"},
+      {LaunchArgKind::kNdarray, "ndarray"},
+      {LaunchArgKind::kArgPack, "argpack"},
+  };
+  for (const auto &[kind, kind_name] : kinds) {
+    for (int num_args : kArgCounts) {
+      if (num_args == 0 && kind != LaunchArgKind::kScalar) {
+        // A kernel without arguments is only measured once.
+        continue;
+      }
+      auto timings = measure_launch_overhead(prog, kind, num_args);
+      // Microseconds per launch.
+      auto us = [](double t) { return t * 1e6 / kIterations; };
+      const double total =
+          us(timings.make_launch_context) + us(timings.set_args) +
+          us(timings.launch_kernel) + us(timings.synchronize);
+      const auto name =
+          fmt::format("{}_{}_x{}", arch_name(arch), kind_name, num_args);
+      TI_INFO(
+          "[launch] {}: make_launch_context={:.3f}us set_args={:.3f}us "
+          "launch_kernel={:.3f}us synchronize={:.3f}us total={:.3f}us",
+          name, us(timings.make_launch_context), us(timings.set_args),
+          us(timings.launch_kernel), us(timings.synchronize), total);
+      ::testing::Test::RecordProperty(name + "_us", fmt::format("{}", total));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(LaunchOverhead, DISABLED_Cpu) {
+  run_launch_overhead_benchmark(host_arch());
+}
+
+TEST(LaunchOverhead, DISABLED_Cuda) {
+#ifdef TI_WITH_CUDA
+  if (is_cuda_api_available()) {
+    run_launch_overhead_benchmark(Arch::cuda);
+  }
+#endif
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "taichi/program/tile_stream.h"
+
+namespace taichi::lang {
+
+namespace {
+
+constexpr int kHeader = 16;
+
+std::string write_rows(const std::string &name, int num_rows, int row_size) {
+  const std::string path = std::string(::testing::TempDir()) + name;
+  std::ofstream file(path, std::ios::binary);
+  const std::string header(kHeader, 'h');
+  file.write(header.data(), header.size());
+  for (int i = 0; i < num_rows * row_size; i++) {
+    const int32 value = i;
+    file.write((const char *)&value, sizeof(value));
+  }
+  return path;
+}
+
+}  // namespace
+
+TEST(TileStream, ReadWithHalo) {
+  const int kRows = 10, kRowSize = 3;
+  auto path = write_rows("tile_stream_read.bin", kRows, kRowSize);
+  TileStream stream(path, kHeader, kRowSize * sizeof(int32), kRows,
+                    /*tile_rows=*/4, /*halo=*/1, TileStreamMode::read);
+  ASSERT_EQ(stream.num_tiles(), 3);
+  for (int t = 0; t < stream.num_tiles(); t++) {
+    auto tile = stream.acquire(t);
+    EXPECT_EQ(tile.begin, t * 4);
+    EXPECT_EQ(tile.rows, t == 2 ? 2 : 4);
+    const int32 *data = (const int32 *)tile.data;
+    for (int r = -1; r <= tile.rows; r++) {
+      const int64 row = tile.begin + r;
+      for (int k = 0; k < kRowSize; k++) {
+        const int32 expected =
+            row < 0 || row >= kRows ? 0 : int32(row * kRowSize + k);
+        EXPECT_EQ(data[(r + 1) * kRowSize + k], expected);
+      }
+    }
+    stream.release(t);
+  }
+  stream.flush();
+  std::remove(path.c_str());
+}
+
+TEST(TileStream, ReadWrite) {
+  const int kRows = 7, kRowSize = 2;
+  auto path = write_rows("tile_stream_rw.bin", kRows, kRowSize);
+  auto out_path = std::string(::testing::TempDir()) + "tile_stream_out.bin";
+  {
+    TileStream in(path, kHeader, kRowSize * sizeof(int32), kRows, 3, 0,
+                  TileStreamMode::read_write);
+    TileStream out(out_path, 0, kRowSize * sizeof(int32), kRows, 3, 0,
+                   TileStreamMode::write);
+    for (int t = 0; t < in.num_tiles(); t++) {
+      auto a = in.acquire(t);
+      auto b = out.acquire(t);
+      for (int i = 0; i < a.rows * kRowSize; i++) {
+        ((int32 *)b.data)[i] = ((int32 *)a.data)[i] + 1;
+        ((int32 *)a.data)[i] *= 2;
+      }
+      in.release(t);
+      out.release(t);
+    }
+    in.flush();
+    out.flush();
+  }
+  std::ifstream in(path, std::ios::binary), out(out_path, std::ios::binary);
+  in.seekg(kHeader);
+  for (int i = 0; i < kRows * kRowSize; i++) {
+    int32 a = 0, b = 0;
+    in.read((char *)&a, sizeof(a));
+    out.read((char *)&b, sizeof(b));
+    EXPECT_EQ(a, 2 * i);
+    EXPECT_EQ(b, i + 1);
+  }
+  in.close();
+  out.close();
+  std::remove(path.c_str());
+  std::remove(out_path.c_str());
+}
+
+TEST(TileStream, Errors) {
+  auto path = write_rows("tile_stream_errors.bin", 4, 1);
+  EXPECT_ANY_THROW(
+      TileStream(path, kHeader, sizeof(int32), 5, 2, 0, TileStreamMode::read));
+  EXPECT_ANY_THROW(TileStream(path, kHeader, sizeof(int32), 4, 2, 1,
+                              TileStreamMode::read_write));
+  TileStream stream(path, kHeader, sizeof(int32), 4, 2, 0,
+                    TileStreamMode::read);
+  EXPECT_ANY_THROW(stream.acquire(1));
+  std::remove(path.c_str());
+}
+
+}  // namespace taichi::lang
@@ -1,3 +1,5 @@
+import math
+
 import taichi as ti
 from tests import test_utils
 
@@ -1037,3 +1039,67 @@ def test_for_loop_index():
     for i in range(N):
         for j in range(M):
             assert test_utils.allclose(x.grad[i, j], my_x_grad[i, j])
+
+
+@test_utils.test(require=ti.extension.adstack, ad_stack_size=0, ad_stack_memory_budget=4096)
+def test_ad_long_inner_loop_checkpointed():
+    N = 1000
+    x = ti.field(ti.f32, shape=4, needs_grad=True)
+    loss = ti.field(ti.f32, shape=4, needs_grad=True)
+
+    @ti.kernel
+    def simulate():
+        for i in x:
+            v = x[i]
+            for t in range(N):
+                v += 0.002 * ti.sin(v + 0.001 * t)
+            loss[i] = v
+
+    for i in range(4):
+        x[i] = 0.3 * i - 0.4
+    simulate()
+    loss.grad.fill(1)
+    simulate.grad()
+
+    for i in range(4):
+        v = 0.3 * i - 0.4
+        grad = 1.0
+        for t in range(N):
+            grad *= 1.0 + 0.002 * math.cos(v + 0.001 * t)
+            v += 0.002 * math.sin(v + 0.001 * t)
+        assert loss[i] == test_utils.approx(v, rel=1e-4)
+        assert x.grad[i] == test_utils.approx(grad, rel=1e-3)
+
+
+@test_utils.test(require=ti.extension.adstack, ad_stack_size=0, ad_stack_memory_budget=2048)
+def test_ad_long_inner_loop_checkpointed_tape():
+    N = 500
+    x = ti.field(ti.f32, shape=(), needs_grad=True)
+    y = ti.field(ti.f32, shape=N)
+    loss = ti.field(ti.f32, shape=(), needs_grad=True)
+
+    @ti.kernel
+    def simulate():
+        for _ in range(1):
+            p = x[None]
+            q = 0.0
+            for t in range(N):
+                p, q = q, p + 0.01 * ti.sin(q) + y[t]
+            loss[None] += p * q
+
+    def reference(x0):
+        p, q = x0, 0.0
+        for t in range(N):
+            p, q = q, p + 0.01 * math.sin(q) + 0.001 * (t % 7)
+        return p * q
+
+    x[None] = 0.7
+    for t in range(N):
+        y[t] = 0.001 * (t % 7)
+    with ti.ad.Tape(loss=loss):
+        simulate()
+
+    eps = 1e-4
+    grad = (reference(0.7 + eps) - reference(0.7 - eps)) / (2 * eps)
+    assert loss[None] == test_utils.approx(reference(0.7), rel=1e-3)
+    assert x.grad[None] == test_utils.approx(grad, rel=1e-2)
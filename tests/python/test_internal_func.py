@@ -40,6 +40,19 @@ def test_list_manager():
     test()
 
 
+@test_utils.test(exclude=[ti.metal, ti.opengl, ti.gles, ti.cuda, ti.vulkan, ti.amdgpu])
+def test_ad_stack_growth():
+    @ti.kernel
+    def test():
+        impl.call_internal("test_stack")
+
+    test()
+    requested = ti.profiler.query_memory_usage().total_requested_memory
+    # The segments chained by the first run are reused from the cache
+    test()
+    assert ti.profiler.query_memory_usage().total_requested_memory == requested
+
+
 @test_utils.test(exclude=[ti.metal, ti.opengl, ti.gles, ti.cuda, ti.vulkan, ti.amdgpu])
 def test_node_manager():
     @ti.kernel
@@ -0,0 +1,93 @@
+import json
+
+import taichi as ti
+from tests import test_utils
+
+
+@test_utils.test(arch=ti.cpu, kernel_profiler=True)
+def test_perf_toolkit():
+    x = ti.field(ti.f32, shape=4096)
+
+    @ti.kernel
+    def fill():
+        for i in x:
+            x[i] = i * 2.0
+
+    if not ti.profiler.set_kernel_profiler_toolkit("perf"):
+        # Hardware counters are unavailable, e.g. in a VM.
+        assert not ti.profiler.set_kernel_profiler_toolkit("unknown")
+        return
+    ti.profiler.clear_kernel_profiler_info()
+    fill()
+    profiler = ti.profiler.get_default_kernel_profiler()
+    profiler._update_records()
+    assert profiler._traced_records
+    for record in profiler._traced_records:
+        assert len(record.metric_values) == 4
+    # Counters the CPU cannot count alone are NaN.
+    assert any(v > 0 for v in profiler._traced_records[-1].metric_values if v == v)
+    ti.profiler.print_kernel_profiler_info("trace")
+    assert ti.profiler.set_kernel_profiler_toolkit("default")
+
+
+@test_utils.test(arch=ti.cpu, kernel_profiler=True, timeline=True, cpu_max_num_threads=4)
+def test_load_balance(tmp_path):
+    x = ti.field(ti.f32, shape=1 << 16)
+
+    @ti.kernel
+    def fill():
+        for i in x:
+            x[i] = ti.sin(i * 0.01)
+
+    assert ti.profiler.set_kernel_profiler_load_balance(True)
+    ti.profiler.clear_kernel_profiler_info()
+    fill()
+    profiler = ti.profiler.get_default_kernel_profiler()
+    profiler._update_records()
+    record = profiler._traced_records[-1]
+    assert 1 <= len(record.tasks_per_thread) <= 4
+    assert sum(record.tasks_per_thread) > 0
+    assert record.thread_imbalance_ratio >= 1.0
+    assert record.thread_idle_time >= 0.0
+    ti.profiler.print_kernel_profiler_info("trace")
+
+    path = tmp_path / "timeline.json"
+    ti.lang.misc.timeline_save(str(path))
+    assert "cpu_worker_" in path.read_text()
+    assert ti.profiler.set_kernel_profiler_load_balance(False)
+
+
+@test_utils.test(arch=[ti.cpu, ti.cuda], kernel_profiler=True)
+def test_streaming_statistics(tmp_path):
+    x = ti.field(ti.f32, shape=1024)
+
+    @ti.kernel
+    def fill():
+        for i in x:
+            x[i] = i
+
+    ti.profiler.clear_kernel_profiler_info()
+    ti.profiler.set_kernel_profiler_streaming(True)
+    for _ in range(20):
+        fill()
+    statistics = [s for s in ti.profiler.get_kernel_profiler_statistics() if s.name.startswith("fill")]
+    assert len(statistics) == 1
+    s = statistics[0]
+    assert s.counter == 20
+    assert s.min <= s.percentile(0.5) <= s.percentile(0.99) <= s.max
+    assert len(ti.profiler.get_default_kernel_profiler()._traced_records) <= 1
+
+    ti.profiler.export_kernel_profiler_statistics(str(tmp_path / "kernels.json"))
+    rows = json.loads((tmp_path / "kernels.json").read_text())
+    assert any(row["name"] == s.name and row["count"] == 20 for row in rows)
+    ti.profiler.export_kernel_profiler_statistics(str(tmp_path / "kernels.csv"))
+    assert (tmp_path / "kernels.csv").read_text().startswith("name,count,")
+    ti.profiler.export_kernel_profiler_statistics(str(tmp_path / "kernels.prom"), reset=True)
+    text = (tmp_path / "kernels.prom").read_text()
+    assert f'taichi_kernel_time_seconds_count{{kernel="{s.name}"}} 20' in text
+    assert 'quantile="0.999"' in text
+
+    fill()
+    statistics = [s for s in ti.profiler.get_kernel_profiler_statistics() if s.name.startswith("fill")]
+    assert statistics[0].counter == 1
+    ti.profiler.set_kernel_profiler_streaming(False)
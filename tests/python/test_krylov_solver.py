@@ -0,0 +1,103 @@
+import numpy as np
+import pytest
+from taichi.linalg import LinearOperator
+
+import taichi as ti
+from tests import test_utils
+
+
+def _poisson_2d(n):
+    # 5-point Laplacian on an n x n grid, with a stiff diagonal shift.
+    size = n * n
+    A = np.zeros((size, size))
+    for i in range(n):
+        for j in range(n):
+            row = i * n + j
+            A[row, row] = 4.01
+            if i > 0:
+                A[row, row - n] = -1.0
+            if i < n - 1:
+                A[row, row + n] = -1.0
+            if j > 0:
+                A[row, row - 1] = -1.0
+            if j < n - 1:
+                A[row, row + 1] = -1.0
+    return A
+
+
+@pytest.mark.parametrize("method", ["cg", "bicgstab"])
+@pytest.mark.parametrize("preconditioner", ["none", "jacobi", "block_jacobi", "ic0"])
+@pytest.mark.parametrize("storage_format", ["col_major", "row_major"])
+@pytest.mark.parametrize("ti_dtype", [ti.f32, ti.f64])
+@test_utils.test(arch=ti.cpu)
+def test_krylov_solver(method, preconditioner, storage_format, ti_dtype):
+    n = 12
+    A_np = _poisson_2d(n)
+    size = n * n
+    Abuilder = ti.linalg.SparseMatrixBuilder(
+        size, size, max_num_triplets=5 * size, dtype=ti_dtype, storage_format=storage_format
+    )
+
+    @ti.kernel
+    def fill(Abuilder: ti.types.sparse_matrix_builder(), InputArray: ti.types.ndarray()):
+        for i, j in ti.ndrange(size, size):
+            if InputArray[i, j] != 0:
+                Abuilder[i, j] += InputArray[i, j]
+
+    fill(Abuilder, A_np)
+    A = Abuilder.build(dtype=ti_dtype)
+    b = ti.ndarray(dtype=ti_dtype, shape=size)
+    x = ti.ndarray(dtype=ti_dtype, shape=size)
+    b_np = np.random.rand(size)
+    b.from_numpy(b_np)
+
+    solver = ti.linalg.KrylovSolver(method=method, preconditioner=preconditioner, max_iter=1000, atol=1e-5)
+    assert solver.solve(A, b, x)
+    assert np.allclose(x.to_numpy(), np.linalg.solve(A_np, b_np), atol=1e-3)
+    iterations = solver.num_iterations()
+    if preconditioner == "ic0":
+        plain = ti.linalg.KrylovSolver(method=method, preconditioner="none", max_iter=1000, atol=1e-5)
+        x.fill(0)
+        assert plain.solve(A, b, x)
+        assert iterations < plain.num_iterations()
+
+
+@pytest.mark.parametrize("preconditioner", ["none", "jacobi"])
+@test_utils.test(arch=ti.cpu)
+def test_krylov_solver_matrix_free(preconditioner):
+    n = 16
+
+    @ti.kernel
+    def compute_Ax(v: ti.types.ndarray(ndim=2), mv: ti.types.ndarray(ndim=2)):
+        for i, j in ti.ndrange(n, n):
+            l = v[i - 1, j] if i - 1 >= 0 else 0.0
+            r = v[i + 1, j] if i + 1 <= n - 1 else 0.0
+            t = v[i, j + 1] if j + 1 <= n - 1 else 0.0
+            b = v[i, j - 1] if j - 1 >= 0 else 0.0
+            mv[i, j] = 4.01 * v[i, j] - l - r - t - b
+
+    b = ti.ndarray(dtype=ti.f64, shape=(n, n))
+    x = ti.ndarray(dtype=ti.f64, shape=(n, n))
+    diagonal = ti.ndarray(dtype=ti.f64, shape=(n, n))
+    b_np = np.random.rand(n, n)
+    b.from_numpy(b_np)
+    diagonal.fill(4.01)
+
+    solver = ti.linalg.KrylovSolver(preconditioner=preconditioner, max_iter=1000, atol=1e-8)
+    assert solver.solve(LinearOperator(compute_Ax), b, x, diagonal=diagonal)
+    res = np.linalg.solve(_poisson_2d(n), b_np.reshape(-1)).reshape(n, n)
+    assert np.allclose(x.to_numpy(), res, atol=1e-6)
+
+
+@test_utils.test(arch=ti.cpu)
+def test_krylov_solver_matrix_free_ic0():
+    @ti.kernel
+    def identity(v: ti.types.ndarray(), mv: ti.types.ndarray()):
+        for i in v:
+            mv[i] = v[i]
+
+    b = ti.ndarray(dtype=ti.f32, shape=4)
+    x = ti.ndarray(dtype=ti.f32, shape=4)
+    solver = ti.linalg.KrylovSolver(preconditioner="ic0")
+    with pytest.raises(RuntimeError, match="only support the Jacobi"):
+        solver.solve(LinearOperator(identity), b, x)
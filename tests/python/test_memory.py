@@ -1,5 +1,6 @@
 import gc
 import os
+import sys
 
 import psutil
 import pytest
@@ -80,3 +81,79 @@ def test_cuda_memory_reuse():
 
     ti.init(arch=ti.cuda)
     ad_sum_vector()
+
+
+@test_utils.test(require=ti.extension.sparse, exclude=[ti.metal])
+def test_query_memory_usage():
+    x = ti.field(ti.f32)
+    ti.root.pointer(ti.i, 16).dense(ti.i, 4).place(x)
+    arr = ti.ndarray(ti.f32, shape=(8, 3))
+
+    @ti.kernel
+    def activate():
+        for i in range(3):
+            x[i * 4] = 1
+
+    ti.profiler.set_memory_sampling(True)
+    activate()
+    ti.profiler.set_memory_sampling(False)
+    samples = ti.profiler.take_memory_samples()
+    assert len(samples) == 1 and samples[0].label.startswith("activate")
+
+    usage = ti.profiler.query_memory_usage()
+    allocated = [s for s in usage.snodes if s.has_node_allocator]
+    assert len(allocated) == 1
+    assert allocated[0].num_live_cells == 3
+    assert 0 < allocated[0].used_bytes <= allocated[0].reserved_bytes
+    assert samples[0].snodes[0].used_bytes == usage.snodes[0].used_bytes
+    assert [a.shape for a in usage.ndarrays] == [[8, 3]]
+    assert usage.ndarrays[0].bytes == 8 * 3 * 4
+    assert usage.total_requested_memory > 0
+
+
+@pytest.mark.skipif(not sys.platform.startswith("linux"), reason="Huge pages are Linux only")
+@test_utils.test(arch=ti.cpu, cpu_huge_pages="transparent", cpu_huge_page_min_size=1 << 20)
+def test_cpu_huge_pages():
+    arr = ti.ndarray(ti.f32, shape=(1 << 20))
+    arr.fill(1)
+    pool = ti.profiler.query_memory_usage().host_memory_pool
+    assert pool.huge_page_bytes >= 4 << 20
+    assert pool.huge_page_backed_bytes <= pool.huge_page_bytes
+
+
+@test_utils.test(arch=[ti.cpu, ti.cuda])
+def test_ndarray_allocation_cache():
+    arr = ti.ndarray(ti.f32, shape=(1 << 20))
+    arr.fill(1)
+    del arr
+    gc.collect()
+    cache = ti.profiler.query_memory_usage().device_allocation_cache
+    assert cache.cached_bytes >= 4 << 20 and cache.num_cached_blocks == 1
+
+    # Recycled, and zeroed as a fresh allocation.
+    arr = ti.ndarray(ti.f32, shape=(1 << 20) - 16)
+    assert arr[123] == 0
+    cache = ti.profiler.query_memory_usage().device_allocation_cache
+    assert cache.num_cached_blocks == 0 and cache.num_hits >= 1
+
+
+@test_utils.test(arch=ti.cpu, device_allocation_cache_size=0)
+def test_ndarray_allocation_cache_disabled():
+    arr = ti.ndarray(ti.f32, shape=(1 << 20))
+    del arr
+    gc.collect()
+    assert ti.profiler.query_memory_usage().device_allocation_cache.cached_bytes == 0
+
+
+@test_utils.test(arch=ti.cpu)
+def test_ndarray_zero_fill_recycled():
+    # Above CpuDevice::kMinParallelZeroFillSize, zeroed by the thread pool.
+    n = (5 << 20) + 3
+    arr = ti.ndarray(ti.f32, shape=n)
+    arr.fill(1)
+    del arr
+    gc.collect()
+
+    arr = ti.ndarray(ti.f32, shape=n)
+    assert ti.profiler.query_memory_usage().device_allocation_cache.num_hits >= 1
+    assert not arr.to_numpy().any()
@@ -1,6 +1,7 @@
 import os
 
 import numpy as np
+import pytest
 
 import taichi as ti
 from tests import test_utils
@@ -86,6 +87,62 @@ def test_mesh_for():
     _test_mesh_for(False, True)
 
 
+def _tet_grid(n):
+    # n^3 cubes, each split into 6 tetrahedra around the main diagonal.
+    x = np.stack(np.meshgrid(*[np.arange(n + 1)] * 3, indexing="ij"), axis=-1).reshape(-1, 3)
+    idx = np.arange((n + 1) ** 3).reshape(n + 1, n + 1, n + 1)
+    cells = []
+    for i in range(n):
+        for j in range(n):
+            for k in range(n):
+                for p in [(0, 1, 2), (0, 2, 1), (1, 0, 2), (1, 2, 0), (2, 0, 1), (2, 1, 0)]:
+                    corner = [0, 0, 0]
+                    cell = [idx[i, j, k]]
+                    for axis in p:
+                        corner[axis] = 1
+                        cell.append(idx[i + corner[0], j + corner[1], k + corner[2]])
+                    cells.append(cell)
+    # Shuffle the cells and vertices, as exported by external tools.
+    rng = np.random.default_rng(0)
+    cells = rng.permutation(np.array(cells))
+    vert_perm = rng.permutation(len(x))
+    return np.argsort(vert_perm)[cells], x[vert_perm].astype(np.float64)
+
+
+@pytest.mark.parametrize("reorder", ["none", "rcm", "morton", "hilbert"])
+@test_utils.test(require=ti.extension.mesh)
+def test_mesh_build_meta(reorder):
+    cells, x = _tet_grid(4)
+    meta = ti.Mesh.build_meta(cells, x, reorder=reorder, max_cells_per_patch=64)
+    assert meta.num_patches > 1
+
+    mesh_builder = ti.lang.mesh._TetMesh()
+    mesh_builder.verts.place({"t": ti.i32, "w": ti.i32}, reorder=True)
+    mesh_builder.cells.place({"t": ti.i32})
+    model = mesh_builder.build(meta)
+    assert len(model.cells) == len(cells)
+    model.verts.w.from_numpy(np.arange(len(x)) ** 2)
+
+    @ti.kernel
+    def cell_vert():
+        for c in model.cells:
+            for j in range(c.verts.size):
+                c.t += c.verts[j].w
+
+    @ti.kernel
+    def vert_cell():
+        for v in model.verts:
+            for j in range(v.cells.size):
+                v.t += v.cells[j].id + 1
+
+    cell_vert()
+    vert_cell()
+    assert np.array_equal(model.cells.t.to_numpy(), (cells**2).sum(axis=1))
+    expected = np.zeros(len(x), dtype=np.int64)
+    np.add.at(expected, cells, np.arange(1, len(cells) + 1)[:, None])
+    assert np.array_equal(model.verts.t.to_numpy(), expected)
+
+
 @test_utils.test(require=ti.extension.mesh, optimize_mesh_reordered_mapping=False)
 def test_mesh_reordered_opt():
     _test_mesh_for(True, True, False)
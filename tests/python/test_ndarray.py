@@ -1161,3 +1161,68 @@ def test_real_func_write_ndarray_cfg():
     a = ti.Vector.ndarray(3, float, shape=(2,))
     foo(a)
     assert (a[0] == vec3(3)).all()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_memmap(tmp_path):
+    path = tmp_path / "data.bin"
+    header = b"HEADER01"
+    data = np.arange(6 * 12, dtype=np.float32).reshape(6, 12)
+    path.write_bytes(header + data.tobytes())
+
+    @ti.kernel
+    def total(x: ti.types.ndarray(dtype=ti.f32, ndim=2)) -> ti.f32:
+        s = 0.0
+        for i, j in x:
+            s += x[i, j]
+        return s
+
+    @ti.kernel
+    def double(x: ti.types.ndarray(dtype=ti.f32, ndim=2)):
+        for i, j in x:
+            x[i, j] *= 2
+
+    x = ti.memmap(path, ti.f32, shape=(6, 12), offset=len(header), access="sequential")
+    assert total(x) == pytest.approx(data.sum())
+    assert (x.to_numpy() == data).all()
+
+    y = ti.memmap(path, ti.f32, shape=(6, 12), mode="c", offset=len(header))
+    double(y)
+    assert (y.to_numpy() == data * 2).all()
+    assert path.read_bytes() == header + data.tobytes()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_memmap_read_only(tmp_path):
+    path = tmp_path / "data.bin"
+    data = np.arange(16, dtype=np.int32)
+    path.write_bytes(data.tobytes())
+
+    @ti.kernel
+    def negate(x: ti.types.ndarray(dtype=ti.i32, ndim=1)):
+        for i in x:
+            x[i] = -x[i]
+
+    x = ti.memmap(path, ti.i32, shape=16)
+    with pytest.raises(RuntimeError, match="read-only memory-mapped ndarray"):
+        x.fill(1)
+    with pytest.raises(RuntimeError, match="read-only memory-mapped ndarray"):
+        x[3] = 1
+    with pytest.raises(RuntimeError, match="read-only memory-mapped ndarray"):
+        x.from_numpy(data)
+    # Kernels write private copies of the pages
+    negate(x)
+    assert (x.to_numpy() == -data).all()
+    assert path.read_bytes() == data.tobytes()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_memmap_vector(tmp_path):
+    path = tmp_path / "points.bin"
+    data = np.arange(8 * 3, dtype=np.int32).reshape(8, 3)
+    path.write_bytes(data.tobytes())
+
+    x = ti.memmap(path, ti.types.vector(3, ti.i32), shape=8, access="random")
+    assert (x.to_numpy() == data).all()
+    with pytest.raises(TaichiRuntimeError, match="Unsupported memmap mode"):
+        ti.memmap(path, ti.i32, shape=24, mode="w+")
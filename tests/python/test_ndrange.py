@@ -338,3 +338,69 @@ def test_dimension_error():
                 pass
 
         func()
+
+
+@test_utils.test()
+def test_tiled_2d():
+    x = ti.field(ti.i32, shape=(13, 37))
+    count = ti.field(ti.i32, shape=(13, 37))
+
+    @ti.kernel
+    def func(n: ti.i32):
+        ti.loop_config(tile=(4, 16))
+        for i, j in ti.ndrange((1, n), (2, 35)):
+            x[i, j] = i * 100 + j
+            count[i, j] += 1
+
+    func(12)
+    x_np = x.to_numpy()
+    count_np = count.to_numpy()
+    for i in range(13):
+        for j in range(37):
+            inside = 1 <= i < 12 and 2 <= j < 35
+            assert x_np[i, j] == (i * 100 + j if inside else 0)
+            assert count_np[i, j] == (1 if inside else 0)
+
+
+@test_utils.test()
+def test_tiled_grouped_3d():
+    x = ti.field(ti.i32, shape=(5, 6, 7))
+
+    @ti.kernel
+    def func():
+        ti.loop_config(tile=(2, 4, 4))
+        for I in ti.grouped(ti.ndrange(5, 6, 7)):
+            x[I] += I[0] * 100 + I[1] * 10 + I[2]
+
+    func()
+    for i in range(5):
+        for j in range(6):
+            for k in range(7):
+                assert x[i, j, k] == i * 100 + j * 10 + k
+
+
+@test_utils.test(arch=ti.cpu, auto_tile_ndrange=True)
+def test_auto_tiled_2d():
+    x = ti.field(ti.i32, shape=(70, 130))
+
+    @ti.kernel
+    def func():
+        for i, j in ti.ndrange(70, 130):
+            x[i, j] = i - j
+
+    func()
+    i, j = np.meshgrid(np.arange(70), np.arange(130), indexing="ij")
+    assert (x.to_numpy() == i - j).all()
+
+
+@test_utils.test()
+def test_tile_non_ndrange():
+    with pytest.raises(ti.TaichiSyntaxError, match="only applies to ti.ndrange"):
+
+        @ti.kernel
+        def func():
+            ti.loop_config(tile=(4, 4))
+            for i in range(16):
+                pass
+
+        func()
@@ -594,3 +594,35 @@ def test_offline_cache_for_kernels_calling_real_func(curr_arch):
 
     ti.reset()
     assert added_files() == expected_num_cache_files(2)
+
+
+@pytest.mark.parametrize("curr_arch", supported_llvm_archs & supported_archs_offline_cache)
+@_test_offline_cache_dec
+def test_launch_trace_replay(curr_arch):
+    trace_file = join(tmp_offline_cache_file_path(), "launches.titrace")
+
+    @ti.kernel
+    def scale(x: ti.types.ndarray(dtype=ti.f32, ndim=1), k: ti.f32):
+        for i in x:
+            x[i] *= k
+
+    @ti.kernel
+    def fill(x: ti.types.ndarray(dtype=ti.f32, ndim=1)):
+        for i in x:
+            x[i] = i
+
+    ti.init(arch=curr_arch, enable_fallback=False, **current_thread_ext_options())
+    x = ti.ndarray(ti.f32, shape=1000)
+    ti.profiler.start_launch_trace()
+    fill(x)
+    for _ in range(3):
+        scale(x, 2.0)
+    assert ti.profiler.stop_launch_trace(trace_file) == 4
+    assert x[999] == test_utils.approx(999 * 8)
+
+    ti.init(arch=curr_arch, enable_fallback=False, **current_thread_ext_options())
+    result = ti.profiler.replay_launch_trace(trace_file, repeats=2)
+    assert result.num_launches == 8
+    assert result.total_time > 0
+    counters = {s.name: s.counter for s in result.kernels}
+    assert sorted(counters.values()) == [2, 6]
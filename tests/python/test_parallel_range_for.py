@@ -1,3 +1,5 @@
+import numpy as np
+
 import taichi as ti
 from tests import test_utils
 
@@ -87,3 +89,43 @@ def test_loop_config_block_dim_adaptive():
     val_np = val.to_numpy()
     for i in range(n):
         assert val_np[i] == i
+
+
+def _test_cpu_range_for_body():
+    n = 1000
+    x = ti.ndarray(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+    z = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def compute(x: ti.types.ndarray(), m: ti.i32):
+        ti.loop_config(block_dim=64)
+        for i in range(3, m):
+            if i % 7 == 0:
+                continue
+            # Contiguous, strided and indirect accesses
+            y[i] = x[i] * 2.0 + x[(i * 5) % n]
+            z[(i * 3) % n] += i
+
+    x.from_numpy(np.arange(n, dtype=np.float32))
+    compute(x, n - 1)
+    y_np = y.to_numpy()
+    z_np = z.to_numpy()
+    z_expected = np.zeros(n, dtype=np.int32)
+    for i in range(3, n - 1):
+        if i % 7 == 0:
+            assert y_np[i] == 0
+            continue
+        assert y_np[i] == i * 2.0 + (i * 5) % n
+        z_expected[(i * 3) % n] += i
+    assert (z_np == z_expected).all()
+
+
+@test_utils.test(arch=ti.cpu, cpu_vectorize_range_for=True)
+def test_cpu_vectorized_range_for():
+    _test_cpu_range_for_body()
+
+
+@test_utils.test(arch=ti.cpu, cpu_vectorize_range_for=False)
+def test_cpu_scalar_range_for():
+    _test_cpu_range_for_body()
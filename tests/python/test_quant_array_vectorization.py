@@ -1,3 +1,5 @@
+import pytest
+
 import taichi as ti
 from tests import test_utils
 
@@ -106,6 +108,93 @@ def test_offset_load():
     verify(-1, 1)
 
 
+@pytest.mark.parametrize("signed", [True, False])
+@test_utils.test(require=ti.extension.quant)
+def test_vectorized_multi_bit_int(signed):
+    qi4 = ti.types.quant.int(4, signed)
+
+    x = ti.field(dtype=qi4)
+    y = ti.field(dtype=ti.i32, shape=(16, 64))
+    ti.root.dense(ti.ij, (16, 8)).quant_array(ti.j, 8, max_num_bits=32).place(x)
+    lowest = -8 if signed else 0
+
+    @ti.kernel
+    def init():
+        for i, j in ti.ndrange(16, 64):
+            x[i, j] = (i * 7 + j * 3) % 16 + lowest
+
+    @ti.kernel
+    def step_vectorized():
+        ti.loop_config(bit_vectorize=True)
+        for i, j in x:
+            y[i, j] = x[i, j]
+            x[i, j] += 2
+
+    init()
+    step_vectorized()
+    x_np = x.to_numpy()
+    y_np = y.to_numpy()
+    for i in range(16):
+        for j in range(64):
+            value = (i * 7 + j * 3) % 16
+            assert y_np[i, j] == value + lowest
+            assert x_np[i, j] == (value + 2) % 16 + lowest
+
+
+@test_utils.test(require=ti.extension.quant)
+def test_vectorized_multi_bit_fixed():
+    qfxt = ti.types.quant.fixed(8, True, max_value=2.0)
+
+    x = ti.field(dtype=qfxt)
+    z = ti.field(dtype=qfxt)
+    y = ti.field(dtype=ti.f32, shape=(8, 32))
+    ti.root.dense(ti.ij, (8, 8)).quant_array(ti.j, 4, max_num_bits=32).place(x)
+    ti.root.dense(ti.ij, (8, 8)).quant_array(ti.j, 4, max_num_bits=32).place(z)
+
+    @ti.kernel
+    def init():
+        for i, j in ti.ndrange(8, 32):
+            x[i, j] = ti.sin(i * 32 + j) * 1.5
+            z[i, j] = x[i, j]
+
+    @ti.kernel
+    def scale_vectorized():
+        ti.loop_config(bit_vectorize=True)
+        for i, j in x:
+            y[i, j] = x[i, j]
+            x[i, j] = x[i, j] * -0.7
+
+    @ti.kernel
+    def scale():
+        for i, j in z:
+            z[i, j] = z[i, j] * -0.7
+
+    init()
+    expected = z.to_numpy()
+    scale_vectorized()
+    scale()
+    assert (y.to_numpy() == expected).all()
+    assert (x.to_numpy() == z.to_numpy()).all()
+
+
+@test_utils.test(require=ti.extension.quant)
+def test_vectorized_multi_bit_neighbor():
+    qi4 = ti.types.quant.int(4)
+
+    x = ti.field(dtype=qi4)
+    y = ti.field(dtype=ti.i32, shape=(4, 32))
+    ti.root.dense(ti.ij, (4, 4)).quant_array(ti.j, 8, max_num_bits=32).place(x)
+
+    @ti.kernel
+    def shift_vectorized():
+        ti.loop_config(bit_vectorize=True)
+        for i, j in x:
+            y[i, j] = x[i, j + 1]
+
+    with pytest.raises(RuntimeError, match="at the loop indices"):
+        shift_vectorized()
+
+
 # FIXME:
 #   this test fails after we introduced type u1. Actually before we introduced u1 to taichi, this test has already
 #   appeared to be problematic. All problems are related to this code:
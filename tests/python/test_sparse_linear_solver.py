@@ -14,7 +14,7 @@ Therefore, A_psd is modified from A * A^T to A * A^T + np.eye(n) to improve stab
 
 
 @pytest.mark.parametrize("dtype", [ti.f32, ti.f64])
-@pytest.mark.parametrize("solver_type", ["LLT", "LDLT", "LU"])
+@pytest.mark.parametrize("solver_type", ["LLT", "LDLT", "LU", "SupernodalLLT"])
 @pytest.mark.parametrize("ordering", ["AMD", "COLAMD"])
 @test_utils.test(arch=ti.x64)
 def test_sparse_LLT_solver(dtype, solver_type, ordering):
@@ -49,7 +49,7 @@ def test_sparse_LLT_solver(dtype, solver_type, ordering):
 
 
 @pytest.mark.parametrize("dtype", [ti.f32])
-@pytest.mark.parametrize("solver_type", ["LLT", "LDLT", "LU"])
+@pytest.mark.parametrize("solver_type", ["LLT", "LDLT", "LU", "SupernodalLLT"])
 @pytest.mark.parametrize("ordering", ["AMD", "COLAMD"])
 @test_utils.test(arch=ti.cpu)
 def test_sparse_solver_ndarray_vector(dtype, solver_type, ordering):
@@ -83,6 +83,60 @@ def test_sparse_solver_ndarray_vector(dtype, solver_type, ordering):
         assert x[i] == test_utils.approx(res[i], rel=1.0)
 
 
+@pytest.mark.parametrize("solver_type", ["LLT", "LU", "SupernodalLLT"])
+@test_utils.test(arch=ti.cpu)
+def test_sparse_solver_reuse_pattern(solver_type):
+    n = 64
+
+    def build(A_np):
+        Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=n * n, dtype=ti.f64)
+
+        @ti.kernel
+        def fill(Abuilder: ti.types.sparse_matrix_builder(), InputArray: ti.types.ndarray()):
+            for i, j in ti.ndrange(n, n):
+                if InputArray[i, j] != 0:
+                    Abuilder[i, j] += InputArray[i, j]
+
+        fill(Abuilder, A_np)
+        return Abuilder.build(dtype=ti.f64)
+
+    def laplacian(bandwidth, scale):
+        A_np = np.zeros((n, n))
+        for i in range(n):
+            A_np[i, i] = 2 * bandwidth + scale
+            for k in range(1, bandwidth + 1):
+                if i >= k:
+                    A_np[i, i - k] = A_np[i - k, i] = -1.0
+        return A_np
+
+    b_np = np.random.rand(n)
+    b = ti.ndarray(ti.f64, shape=n)
+    b.from_numpy(b_np)
+    solver = ti.linalg.SparseSolver(dtype=ti.f64, solver_type=solver_type)
+
+    A1_np = laplacian(2, 0.5)
+    A1 = build(A1_np)
+    solver.compute(A1)
+    assert solver.info()
+    assert np.allclose(solver.solve(b).to_numpy(), np.linalg.solve(A1_np, b_np))
+
+    # Same pattern: only the numerical factorization is redone.
+    A2_np = laplacian(2, 4.0)
+    A2 = build(A2_np)
+    assert A2.pattern_fingerprint() == A1.pattern_fingerprint()
+    solver.factorize(A2)
+    assert solver.info()
+    assert np.allclose(solver.solve(b).to_numpy(), np.linalg.solve(A2_np, b_np))
+
+    # A new pattern is analyzed before the factorization.
+    A3_np = laplacian(3, 1.0)
+    A3 = build(A3_np)
+    assert A3.pattern_fingerprint() != A1.pattern_fingerprint()
+    solver.factorize(A3)
+    assert solver.info()
+    assert np.allclose(solver.solve(b).to_numpy(), np.linalg.solve(A3_np, b_np))
+
+
 @test_utils.test(arch=ti.cuda)
 def test_gpu_sparse_solver():
     from scipy.sparse import coo_matrix
@@ -56,6 +56,40 @@ def test_sparse_matrix_builder(dtype, storage_format):
             assert A[i, j] == i + j
 
 
+@pytest.mark.parametrize(
+    "dtype, storage_format",
+    [
+        (ti.f32, "col_major"),
+        (ti.f32, "row_major"),
+        (ti.f64, "col_major"),
+        (ti.f64, "row_major"),
+    ],
+)
+@test_utils.test(arch=ti.cpu)
+def test_sparse_matrix_builder_reassemble(dtype, storage_format):
+    n = 64
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=10000, dtype=dtype, storage_format=storage_format)
+
+    @ti.kernel
+    def fill(Abuilder: ti.types.sparse_matrix_builder(), scale: ti.f32, width: ti.i32):
+        # Each diagonal band entry is added several times
+        for k, i, j in ti.ndrange(3, n, (-width, width + 1)):
+            if 0 <= i + j < n:
+                Abuilder[i, i + j] += scale * (i + 1)
+
+    fill(Abuilder, 1.0, 2)
+    A = Abuilder.build()
+    for scale, width in [(2.0, 2), (3.0, 1), (4.0, 3)]:
+        # Fits in the pattern of A, except for the last one which widens the band
+        fill(Abuilder, scale, width)
+        B = Abuilder.build(out=A)
+        assert B is A
+        for i in range(n):
+            for j in range(n):
+                expected = 3 * scale * (i + 1) if abs(i - j) <= width else 0
+                assert A[i, j] == test_utils.approx(expected)
+
+
 @pytest.mark.parametrize(
     "dtype, storage_format",
     [
@@ -409,6 +443,52 @@ def test_sparse_matrix_ndarray_vector_multiplication(dtype, storage_format):
     assert res_n[1] == 3.0
 
 
+@pytest.mark.parametrize(
+    "dtype, storage_format",
+    [
+        (ti.f32, "col_major"),
+        (ti.f32, "row_major"),
+        (ti.f64, "col_major"),
+        (ti.f64, "row_major"),
+    ],
+)
+@pytest.mark.parametrize("sell_chunk_size", [0, 8])
+@test_utils.test(arch=ti.cpu)
+def test_sparse_matrix_large_products(dtype, storage_format, sell_chunk_size):
+    import numpy as np
+
+    n = 3000
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=40000, dtype=dtype, storage_format=storage_format)
+
+    @ti.kernel
+    def fill(Abuilder: ti.types.sparse_matrix_builder()):
+        for i in range(n):
+            # Rows of varying lengths
+            for k in range(i % 13):
+                Abuilder[i, (i * 7 + k * 131) % n] += (k + 1) * 0.25
+
+    fill(Abuilder)
+    A = Abuilder.build()
+    A.use_sell_c_sigma(sell_chunk_size, 64)
+    dense = np.zeros((n, n))
+    for i in range(n):
+        for k in range(i % 13):
+            dense[i, (i * 7 + k * 131) % n] += (k + 1) * 0.25
+
+    x_np = np.random.rand(n)
+    x = ti.ndarray(dtype, n)
+    x.from_numpy(x_np)
+    np.testing.assert_allclose((A @ x).to_numpy(), dense @ x.to_numpy(), rtol=1e-4)
+    np.testing.assert_allclose(A @ x.to_numpy(), dense @ x.to_numpy(), rtol=1e-4)
+
+    C = A @ A
+    C_dense = dense @ dense
+    for i in range(0, n, 97):
+        for j in range(n):
+            if C_dense[i, j] != 0:
+                assert C[i, j] == test_utils.approx(C_dense[i, j], rel=1e-4)
+
+
 @test_utils.test(arch=ti.cuda)
 def test_gpu_sparse_matrix():
     import numpy as np
@@ -0,0 +1,61 @@
+import numpy as np
+import pytest
+from taichi.lang.exception import TaichiRuntimeError
+
+import taichi as ti
+from tests import test_utils
+
+
+@test_utils.test(arch=ti.cpu)
+def test_stream_stencil(tmp_path):
+    src_path = tmp_path / "src.bin"
+    dst_path = tmp_path / "dst.bin"
+    header = b"HEADER01"
+    data = np.random.rand(37, 5).astype(np.float32)
+    src_path.write_bytes(header + data.tobytes())
+
+    @ti.kernel
+    def smooth(src: ti.types.ndarray(ndim=2), dst: ti.types.ndarray(ndim=2), begin: int, scale: float):
+        for i, j in dst:
+            dst[i, j] = (src[i, j] + src[i + 1, j] + src[i + 2, j]) * scale
+
+    src = ti.StreamedArray(src_path, ti.f32, shape=(37, 5), offset=len(header))
+    dst = ti.StreamedArray(dst_path, ti.f32, shape=(37, 5), mode="w+")
+    ti.stream(smooth, [src, dst], tile_rows=8, halo=1, args=(0.5,))
+
+    padded = np.pad(data, ((1, 1), (0, 0)))
+    expected = (padded[:-2] + padded[1:-1] + padded[2:]) * 0.5
+    result = np.fromfile(dst_path, dtype=np.float32).reshape(37, 5)
+    np.testing.assert_allclose(result, expected, rtol=1e-6)
+
+
+@test_utils.test(arch=ti.cpu)
+def test_stream_in_place(tmp_path):
+    path = tmp_path / "points.bin"
+    data = np.arange(20 * 3, dtype=np.int32).reshape(20, 3)
+    path.write_bytes(data.tobytes())
+
+    @ti.kernel
+    def shift(x: ti.types.ndarray(dtype=ti.math.ivec3, ndim=1), begin: int):
+        for i in x:
+            x[i] += begin + i
+
+    points = ti.StreamedArray(path, ti.math.ivec3, shape=20, mode="r+")
+    ti.stream(shift, [points], tile_rows=6)
+    rows = np.arange(20, dtype=np.int32)[:, None]
+    assert (np.fromfile(path, dtype=np.int32).reshape(20, 3) == data + rows).all()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_stream_errors(tmp_path):
+    path = tmp_path / "small.bin"
+    path.write_bytes(np.zeros(4, dtype=np.float32).tobytes())
+
+    @ti.kernel
+    def noop(x: ti.types.ndarray(ndim=1), begin: int):
+        pass
+
+    with pytest.raises(TaichiRuntimeError, match="Unsupported stream mode"):
+        ti.StreamedArray(path, ti.f32, shape=4, mode="w")
+    with pytest.raises(RuntimeError, match="too few"):
+        ti.stream(noop, [ti.StreamedArray(path, ti.f32, shape=8)], tile_rows=2)